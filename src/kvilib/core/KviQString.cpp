@@ -263,8 +263,9 @@ namespace KviQString
 		const QChar * pC2 = sz2.unicode();
 		const QChar * pC1e = pC1 + sz1.length();
 
-		if(!pC1 || !pC2)
+		if(!pC1 || !pC2 || (pC1 == pC2))
 		{
+			// null, or shared data (interned nicknames and hash keys)
 			return (pC1 == pC2);
 		}
 
@@ -291,8 +292,9 @@ namespace KviQString
 		const QChar * pC2 = sz2.unicode();
 		const QChar * pC1e = pC1 + sz1.length();
 
-		if(!pC1 || !pC2)
+		if(!pC1 || !pC2 || (pC1 == pC2))
 		{
+			// null, or shared data (interned nicknames and hash keys)
 			return (pC1 == pC2);
 		}
 
@@ -0,0 +1,176 @@
+//=============================================================================
+//
+//   File : KviUtf8.cpp
+//   Creation date : Mon 19 Oct 2026 18:20:41 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviUtf8.h"
+
+// SSE2 is part of the x86-64 baseline: no runtime check is needed
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define COMPILE_UTF8_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Same as UNICODE_VALID() from GLib's gutf8.c
+#define KVI_UTF8_CODEPOINT_VALID(Char) \
+	((Char) < 0x110000 && (((Char)&0xFFFFF800) != 0xD800) && ((Char) < 0xFDD0 || (Char) > 0xFDEF) && ((Char)&0xFFFE) != 0xFFFE)
+
+namespace KviUtf8
+{
+#ifdef COMPILE_UTF8_SSE2
+	static inline int firstBitSet(int iMask)
+	{
+#ifdef _MSC_VER
+		unsigned long uIdx;
+		_BitScanForward(&uIdx, (unsigned long)iMask);
+		return (int)uIdx;
+#else
+		return __builtin_ctz((unsigned int)iMask);
+#endif
+	}
+#endif
+
+	bool isAscii(const char * pcData, int iLen)
+	{
+		const unsigned char * p = (const unsigned char *)pcData;
+		const unsigned char * e = p + iLen;
+
+#ifdef COMPILE_UTF8_SSE2
+		while((e - p) >= 16)
+		{
+			if(_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p)) != 0)
+				return false;
+			p += 16;
+		}
+#endif
+
+		while(p < e)
+		{
+			if(*p & 0x80)
+				return false;
+			p++;
+		}
+		return true;
+	}
+
+	bool decode(const char * pcData, int iLen, QString & szBuffer)
+	{
+		const unsigned char * p = (const unsigned char *)pcData;
+		const unsigned char * e = p + iLen;
+
+		if((iLen >= 3) && (p[0] == 0xEF) && (p[1] == 0xBB) && (p[2] == 0xBF))
+			return false;
+
+		// UTF-16 never needs more code units than there are UTF-8 bytes
+		szBuffer = QString(iLen, Qt::Uninitialized);
+		ushort * pBegin = (ushort *)szBuffer.data();
+		ushort * d = pBegin;
+
+		while(p < e)
+		{
+#ifdef COMPILE_UTF8_SSE2
+			// Since d never runs ahead of p there is always room
+			// for 16 code units when 16 bytes are left
+			bool bMultiByte = false;
+			while((e - p) >= 16)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i *)p);
+				int iMask = _mm_movemask_epi8(v);
+				__m128i zero = _mm_setzero_si128();
+				_mm_storeu_si128((__m128i *)d, _mm_unpacklo_epi8(v, zero));
+				_mm_storeu_si128((__m128i *)(d + 8), _mm_unpackhi_epi8(v, zero));
+				if(iMask == 0)
+				{
+					p += 16;
+					d += 16;
+					continue;
+				}
+				// keep the ASCII prefix and decode the sequence below
+				int iAscii = firstBitSet(iMask);
+				p += iAscii;
+				d += iAscii;
+				bMultiByte = true;
+				break;
+			}
+			if(!bMultiByte && (p >= e))
+				break;
+#endif
+
+			unsigned int c = *p;
+
+			if(c < 0x80)
+			{
+				*d++ = (ushort)c;
+				p++;
+				continue;
+			}
+
+			unsigned int uVal;
+
+			if((c & 0xe0) == 0xc0) // 110xxxxx
+			{
+				if((c & 0x1e) == 0)
+					return false; // overlong
+				if(((e - p) < 2) || ((p[1] & 0xc0) != 0x80))
+					return false;
+				*d++ = (ushort)(((c & 0x1f) << 6) | (p[1] & 0x3f));
+				p += 2;
+				continue;
+			}
+
+			if((c & 0xf0) == 0xe0) // 1110xxxx
+			{
+				if(((e - p) < 3) || ((p[1] & 0xc0) != 0x80) || ((p[2] & 0xc0) != 0x80))
+					return false;
+				uVal = ((c & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+				if((uVal < 0x800) || !KVI_UTF8_CODEPOINT_VALID(uVal))
+					return false;
+				*d++ = (ushort)uVal;
+				p += 3;
+				continue;
+			}
+
+			if((c & 0xf8) == 0xf0) // 11110xxx
+			{
+				if(((e - p) < 4) || ((p[1] & 0xc0) != 0x80) || ((p[2] & 0xc0) != 0x80) || ((p[3] & 0xc0) != 0x80))
+					return false;
+				uVal = ((c & 0x07) << 18) | ((p[1] & 0x3f) << 12) | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+				if((uVal < 0x10000) || !KVI_UTF8_CODEPOINT_VALID(uVal))
+					return false;
+				// surrogate pair: 4 bytes become 2 code units
+				uVal -= 0x10000;
+				*d++ = (ushort)(0xD800 | (uVal >> 10));
+				*d++ = (ushort)(0xDC00 | (uVal & 0x3ff));
+				p += 4;
+				continue;
+			}
+
+			return false;
+		}
+
+		szBuffer.resize((int)(d - pBegin));
+		return true;
+	}
+}
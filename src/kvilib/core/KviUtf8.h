@@ -0,0 +1,71 @@
+#ifndef _KVI_UTF8_H_
+#define _KVI_UTF8_H_
+//=============================================================================
+//
+//   File : KviUtf8.h
+//   Creation date : Mon 19 Oct 2026 18:20:41 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviUtf8.h
+* \author The KVIrc development team
+* \brief UTF-8 validation and decoding
+*/
+
+#include "kvi_settings.h"
+
+#include <QString>
+
+/**
+* \namespace KviUtf8
+* \brief Fast UTF-8 to UTF-16 conversion for the network input
+*
+* Most of what comes from an IRC server is plain ASCII. The runs of ASCII
+* bytes are checked and widened 16 bytes at a time with SSE2 (where
+* available): only the multibyte sequences are handled one by one.
+*/
+namespace KviUtf8
+{
+	/**
+	* \brief Returns true if the buffer contains only 7 bit characters
+	* \param pcData The buffer
+	* \param iLen The length of the buffer in bytes
+	* \return bool
+	*/
+	extern KVILIB_API bool isAscii(const char * pcData, int iLen);
+
+	/**
+	* \brief Validates and decodes a UTF-8 buffer in a single pass
+	*
+	* The validation rules are the ones of g_utf8_validate() (GLib) that the
+	* smart codecs have always used: overlong forms, surrogates and
+	* non-characters are rejected.
+	* A buffer starting with a byte order mark is rejected too: the Qt codec,
+	* that strips it, must take care of it.
+	* \param pcData The buffer
+	* \param iLen The length of the buffer in bytes
+	* \param szBuffer Gets the decoded text, left in an undefined state on failure
+	* \return true if the buffer is valid UTF-8 and has been decoded
+	*/
+	extern KVILIB_API bool decode(const char * pcData, int iLen, QString & szBuffer);
+}
+
+#endif //_KVI_UTF8_H_
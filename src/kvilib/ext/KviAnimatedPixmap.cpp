@@ -25,14 +25,18 @@
 #include "KviAnimatedPixmap.h"
 
 #include <QImageReader>
+#include <QMetaMethod>
 
 KviAnimatedPixmap::KviAnimatedPixmap(QString fileName, int iWidth, int iHeight)
     : QObject(),
       m_szFileName(fileName),
       m_uCurrentFrameNumber(0),
-      m_iStarted(0)
+      m_iStarted(0),
+      m_bTicking(false)
 {
 	m_pFrameData = KviAnimatedPixmapCache::load(fileName, iWidth, iHeight);
+	if(!m_pFrameData->ready)
+		KviAnimatedPixmapCache::notifyWhenReady(m_pFrameData, this);
 }
 
 KviAnimatedPixmap::KviAnimatedPixmap(const KviAnimatedPixmap & source)
@@ -40,9 +44,12 @@ KviAnimatedPixmap::KviAnimatedPixmap(const KviAnimatedPixmap & source)
       m_szFileName(source.m_szFileName),
       m_pFrameData(source.m_pFrameData),
       m_uCurrentFrameNumber(source.m_uCurrentFrameNumber),
-      m_iStarted(0)
+      m_iStarted(0),
+      m_bTicking(false)
 {
 	m_pFrameData->refs++;
+	if(!m_pFrameData->ready)
+		KviAnimatedPixmapCache::notifyWhenReady(m_pFrameData, this);
 }
 
 KviAnimatedPixmap::~KviAnimatedPixmap()
@@ -58,12 +65,9 @@ void KviAnimatedPixmap::start()
 	if(m_iStarted > 1)
 		return; // was already started
 
-	if(m_pFrameData->count() < 2)
-		return;
-
 	m_uCurrentFrameNumber = 0;
 
-	KviAnimatedPixmapCache::scheduleFrameChange(m_pFrameData->at(m_uCurrentFrameNumber).delay, this);
+	scheduleNextFrame();
 }
 
 void KviAnimatedPixmap::stop()
@@ -76,11 +80,39 @@ void KviAnimatedPixmap::stop()
 		m_iStarted = 0;
 }
 
+void KviAnimatedPixmap::scheduleNextFrame()
+{
+	if(m_bTicking || (m_iStarted < 1))
+		return;
+
+	if(m_pFrameData->count() < 2)
+		return;
+
+	// nobody would see the next frame: stay paused until someone connects
+	if(!isSignalConnected(QMetaMethod::fromSignal(&KviAnimatedPixmap::frameChanged)))
+		return;
+
+	m_bTicking = true;
+	KviAnimatedPixmapCache::scheduleFrameChange(m_pFrameData->at(m_uCurrentFrameNumber).delay, this);
+}
+
+void KviAnimatedPixmap::connectNotify(const QMetaMethod & signal)
+{
+	if(signal == QMetaMethod::fromSignal(&KviAnimatedPixmap::frameChanged))
+		scheduleNextFrame();
+}
+
 void KviAnimatedPixmap::nextFrame(bool bEmitSignalAndScheduleNext)
 {
+	if(bEmitSignalAndScheduleNext)
+		m_bTicking = false;
+
 	if(m_iStarted < 1)
 		return;
 
+	if(m_pFrameData->count() < 1)
+		return;
+
 	m_uCurrentFrameNumber++;
 	//Ensure, that we are not out of bounds
 	m_uCurrentFrameNumber %= m_pFrameData->count();
@@ -88,10 +120,19 @@ void KviAnimatedPixmap::nextFrame(bool bEmitSignalAndScheduleNext)
 	if(!bEmitSignalAndScheduleNext)
 		return;
 
-	if(m_iStarted)
-		emit frameChanged();
+	emit frameChanged();
 
-	KviAnimatedPixmapCache::scheduleFrameChange(m_pFrameData->at(m_uCurrentFrameNumber).delay, this);
+	scheduleNextFrame();
+}
+
+void KviAnimatedPixmap::framesReady()
+{
+	m_uCurrentFrameNumber = 0;
+
+	// repaint with the real image
+	emit frameChanged();
+
+	scheduleNextFrame();
 }
 
 void KviAnimatedPixmap::resize(QSize newSize, Qt::AspectRatioMode ratioMode)
@@ -99,5 +140,14 @@ void KviAnimatedPixmap::resize(QSize newSize, Qt::AspectRatioMode ratioMode)
 	QSize curSize(size());
 	curSize.scale(newSize, ratioMode);
 
+	if(!m_pFrameData->ready)
+		KviAnimatedPixmapCache::cancelNotifyWhenReady(m_pFrameData, this);
+
 	m_pFrameData = KviAnimatedPixmapCache::resize(m_pFrameData, curSize);
+
+	// the new frame set may be shorter (or a placeholder)
+	m_uCurrentFrameNumber = 0;
+
+	if(!m_pFrameData->ready)
+		KviAnimatedPixmapCache::notifyWhenReady(m_pFrameData, this);
 }
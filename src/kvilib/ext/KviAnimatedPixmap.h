@@ -63,6 +63,13 @@ class QPixmap;
  *
  * You should use pixmap() methd to access the current frame.
  *
+ * The frames are decoded in background: until they are ready pixmap()
+ * returns a placeholder of the right size and frameChanged() is emitted
+ * when the real frames arrive.
+ *
+ * The animation ticks only while something is connected to frameChanged():
+ * widgets that aren't visible should disconnect to pause it.
+ *
  * This class owns all pixmaps. Do not store links to them.
  */
 
@@ -75,6 +82,7 @@ protected:
 
 	uint m_uCurrentFrameNumber;
 	int m_iStarted;
+	bool m_bTicking; // a frame change is scheduled
 
 public:
 	/*
@@ -163,7 +171,16 @@ public:
 	/*
 	 * Called when the frame changes
 	 */
-	void nextFrame(bool bEmitSignalAndScheduleNext);
+	void nextFrame(bool bEmitSignalAndScheduleNext) override;
+
+	/*
+	 * Called when the decoded frames replace the placeholder
+	 */
+	void framesReady() override;
+
+protected:
+	void scheduleNextFrame();
+	void connectNotify(const QMetaMethod & signal) override;
 
 signals:
 
@@ -25,23 +25,89 @@
 #include "KviAnimatedPixmapCache.h"
 #include "KviTimeUtils.h"
 
+#include <QCoreApplication>
+#include <QEvent>
 #include <QImageReader>
 #include <QImage>
+#include <QRunnable>
 
 #define FRAME_DELAY 100
 
 KviAnimatedPixmapCache * KviAnimatedPixmapCache::m_pInstance = nullptr;
 static QPixmap * g_pDummyPixmap = nullptr;
 
+//
+// Thread safe: reads all the frames of szFile, scaling them to size (if valid)
+//
+static void animated_pixmap_decode_frames(const QString & szFile, const QSize & size, QList<QImage> & lFrames, QList<uint> & lDelays)
+{
+	QImageReader reader(szFile);
+	QImage buffer;
+	while(reader.canRead())
+	{
+		uint delay = reader.nextImageDelay();
+		reader.read(&buffer);
+		if(!buffer.isNull())
+		{
+			if(size.isValid() && (buffer.size() != size))
+				lFrames.append(buffer.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+			else
+				lFrames.append(buffer);
+			lDelays.append(delay);
+		}
+	}
+}
+
+class KviAnimatedPixmapDecodedEvent : public QEvent
+{
+public:
+	KviAnimatedPixmapDecodedEvent(KviAnimatedPixmapCache::Data * pData)
+	    : QEvent(QEvent::User), m_pData(pData)
+	{
+	}
+
+	KviAnimatedPixmapCache::Data * m_pData;
+	QList<QImage> m_lFrames;
+	QList<uint> m_lDelays;
+};
+
+class KviAnimatedPixmapDecoder : public QRunnable
+{
+public:
+	KviAnimatedPixmapDecoder(QObject * pCache, KviAnimatedPixmapCache::Data * pData, const QString & szFile, const QSize & size)
+	    : m_pCache(pCache), m_pData(pData), m_szFile(szFile), m_size(size)
+	{
+	}
+
+protected:
+	QObject * m_pCache; // waits for us before dying
+	KviAnimatedPixmapCache::Data * m_pData; // never touched here: the cache keeps it alive until we report back
+	QString m_szFile;
+	QSize m_size;
+
+public:
+	void run() override
+	{
+		KviAnimatedPixmapDecodedEvent * e = new KviAnimatedPixmapDecodedEvent(m_pData);
+		animated_pixmap_decode_frames(m_szFile, m_size, e->m_lFrames, e->m_lDelays);
+		// QPixmap objects can be created only in the GUI thread
+		QCoreApplication::postEvent(m_pCache, e);
+	}
+};
+
 KviAnimatedPixmapCache::KviAnimatedPixmapCache()
 {
 	m_pInstance = this;
 	m_animationTimer.setInterval(FRAME_DELAY);
 	connect(&m_animationTimer, SIGNAL(timeout()), this, SLOT(timeoutEvent()));
+	m_decoderPool.setMaxThreadCount(2);
 }
 
 KviAnimatedPixmapCache::~KviAnimatedPixmapCache()
 {
+	m_decoderPool.clear();
+	m_decoderPool.waitForDone();
+
 	if(g_pDummyPixmap)
 	{
 		delete g_pDummyPixmap;
@@ -70,10 +136,14 @@ KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalLoad(const QStrin
 	m_cacheMutex.lock();
 	Data * newData = nullptr;
 
+	QSize requestedSize;
+	if(iHeight && iWidth)
+		requestedSize = QSize(iWidth, iHeight);
+
 	QMultiHash<QString, Data *>::iterator i = m_hCache.find(szFile);
 	while(i != m_hCache.end() && i.key() == szFile && !newData)
 	{
-		if(!i.value()->resized)
+		if(!i.value()->resized && (i.value()->requestedSize == requestedSize))
 			newData = i.value();
 		++i;
 	}
@@ -81,23 +151,42 @@ KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalLoad(const QStrin
 	if(!newData)
 	{
 		newData = new Data(szFile);
-		QImageReader reader(szFile);
-		newData->size = reader.size();
+		newData->requestedSize = requestedSize;
+
+		// reading the header is cheap: we need the geometry now
+		QSize size = QImageReader(szFile).size();
+		if(size.isValid())
+		{
+			if(requestedSize.isValid())
+				size.scale(requestedSize, Qt::KeepAspectRatio);
+			newData->size = size;
 
-		QImage buffer;
-		QPixmap * framePixmap;
-		while(reader.canRead())
+			QPixmap * placeholder = new QPixmap(size);
+			placeholder->fill(Qt::transparent);
+			newData->append(FrameInfo(placeholder, 0));
+
+			startDecoder(newData);
+		}
+		else
 		{
-			uint delay = reader.nextImageDelay();
-			reader.read(&buffer);
-			if(!buffer.isNull())
+			// the format can't tell the size without decoding: do it now
+			QList<QImage> lFrames;
+			QList<uint> lDelays;
+			animated_pixmap_decode_frames(szFile, QSize(), lFrames, lDelays);
+			if(!lFrames.isEmpty())
 			{
-				if(iHeight && iWidth)
-					framePixmap = new QPixmap(QPixmap::fromImage(buffer).scaled(iWidth, iHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-				else
-					framePixmap = new QPixmap(QPixmap::fromImage(buffer));
-				newData->append(FrameInfo(framePixmap, delay));
+				size = lFrames.first().size();
+				if(requestedSize.isValid())
+				{
+					size.scale(requestedSize, Qt::KeepAspectRatio);
+					for(auto & f : lFrames)
+						f = f.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+				}
 			}
+
+			newData->size = size;
+			for(int f = 0; f < lFrames.count(); f++)
+				newData->append(FrameInfo(new QPixmap(QPixmap::fromImage(lFrames.at(f))), lDelays.at(f)));
 		}
 		m_hCache.insert(szFile, newData);
 	}
@@ -112,8 +201,6 @@ KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalResize(Data * dat
 {
 	m_cacheMutex.lock();
 
-	bool hasToBeResized = false;
-
 	Data * newData = nullptr;
 	QMultiHash<QString, Data *>::iterator i = m_hCache.find(data->file);
 	while(i != m_hCache.end() && i.key() == data->file && !newData)
@@ -127,11 +214,26 @@ KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalResize(Data * dat
 
 	if(!newData)
 	{
-		newData = new Data(*data);
+		// the frames are decoded again from the file at the new size:
+		// meanwhile show the current frame, roughly scaled
+		newData = new Data(data->file);
 		newData->size = size;
-		m_hCache.insert(newData->file, newData);
-		hasToBeResized = true;
 		newData->resized = true;
+
+		QPixmap * placeholder;
+		if(data->count() > 0)
+		{
+			placeholder = new QPixmap(data->first().pixmap->scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+		}
+		else
+		{
+			placeholder = new QPixmap(size);
+			placeholder->fill(Qt::transparent);
+		}
+		newData->append(FrameInfo(placeholder, 0));
+
+		m_hCache.insert(newData->file, newData);
+		startDecoder(newData);
 	}
 
 	newData->refs++;
@@ -140,16 +242,6 @@ KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalResize(Data * dat
 
 	internalFree(data);
 
-	if(hasToBeResized)
-	{
-		for(int i = 0; i < newData->count(); i++)
-		{
-			QPixmap * old = newData->at(i).pixmap;
-			newData->operator[](i).pixmap = new QPixmap(old->scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-			delete old;
-		}
-	}
-
 	return newData;
 }
 
@@ -166,9 +258,73 @@ void KviAnimatedPixmapCache::internalFree(Data * data)
 		{
 			delete data->operator[](i).pixmap;
 		}
+		if(data->ready)
+		{
+			delete data;
+		}
+		else
+		{
+			// the decoder still refers to it
+			data->clear();
+			data->orphan = true;
+		}
+	}
+	m_cacheMutex.unlock();
+}
+
+void KviAnimatedPixmapCache::startDecoder(Data * data)
+{
+	data->ready = false;
+	m_decoderPool.start(new KviAnimatedPixmapDecoder(this, data, data->file, data->size));
+}
+
+void KviAnimatedPixmapCache::customEvent(QEvent * e)
+{
+	if(e->type() != QEvent::User)
+		return;
+
+	KviAnimatedPixmapDecodedEvent * ev = static_cast<KviAnimatedPixmapDecodedEvent *>(e);
+	Data * data = ev->m_pData;
+
+	QList<KviAnimatedPixmapInterface *> lReceivers = m_hWaitingForFrames.values(data);
+	m_hWaitingForFrames.remove(data);
+
+	m_cacheMutex.lock();
+
+	if(data->orphan)
+	{
 		delete data;
+		m_cacheMutex.unlock();
+		return;
 	}
+
+	// replace the placeholder
+	for(int i = 0; i < data->count(); i++)
+		delete data->operator[](i).pixmap;
+	data->clear();
+
+	for(int i = 0; i < ev->m_lFrames.count(); i++)
+		data->append(FrameInfo(new QPixmap(QPixmap::fromImage(ev->m_lFrames.at(i))), ev->m_lDelays.at(i)));
+
+	data->ready = true;
+
 	m_cacheMutex.unlock();
+
+	for(auto r : lReceivers)
+		r->framesReady();
+}
+
+void KviAnimatedPixmapCache::internalNotifyWhenReady(Data * data, KviAnimatedPixmapInterface * receiver, bool bNotify)
+{
+	if(bNotify)
+	{
+		if(!data->ready)
+			m_hWaitingForFrames.insert(data, receiver);
+	}
+	else
+	{
+		m_hWaitingForFrames.remove(data, receiver);
+	}
 }
 
 void KviAnimatedPixmapCache::internalScheduleFrameChange(uint delay, KviAnimatedPixmapInterface * receiver)
@@ -268,4 +424,13 @@ void KviAnimatedPixmapCache::internalNotifyDelete(
 	}
 
 	m_timerMutex.unlock();
+
+	QMultiHash<Data *, KviAnimatedPixmapInterface *>::iterator w = m_hWaitingForFrames.begin();
+	while(w != m_hWaitingForFrames.end())
+	{
+		if(w.value() == receiver)
+			w = m_hWaitingForFrames.erase(w);
+		else
+			++w;
+	}
 }
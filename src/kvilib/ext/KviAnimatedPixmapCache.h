@@ -32,6 +32,7 @@
 #include <QMutex>
 #include <QObject>
 #include <QPixmap>
+#include <QThreadPool>
 #include <QTimer>
 
 class KVILIB_API KviAnimatedPixmapCache : public QObject
@@ -77,6 +78,9 @@ public:
 	 *
 	 * It adds references counter and
 	 * mutex, to provide thread-safety.
+	 *
+	 * While the frames are being decoded by the worker threads
+	 * it contains a single placeholder frame of the final size.
 	 */
 	class Data : public QList<FrameInfo>
 	{
@@ -85,12 +89,15 @@ public:
 		QSize size;   //size of the pixmaps
 		QString file; //just to speedup the cache
 		bool resized;
+		QSize requestedSize; //bounding size passed to load(), invalid if none
+		bool ready;          //false while the frames are being decoded
+		bool orphan;         //freed while being decoded: deleted when the decoder finishes
 
-		Data(QString szFile) : QList<FrameInfo>(), refs(0), file(szFile), resized(false)
+		Data(QString szFile) : QList<FrameInfo>(), refs(0), file(szFile), resized(false), ready(true), orphan(false)
 		{
 		}
 
-		Data(Data & other) : QList<FrameInfo>(other), refs(0), file(other.file), resized(false)
+		Data(Data & other) : QList<FrameInfo>(other), refs(0), file(other.file), resized(false), ready(true), orphan(false)
 		{
 			for(int i = 0; i < count(); i++)
 			{
@@ -113,7 +120,9 @@ protected:
 
 	QMultiHash<QString, Data *> m_hCache;
 	QMultiMap<long long, KviAnimatedPixmapInterface *> m_timerData;
+	QMultiHash<Data *, KviAnimatedPixmapInterface *> m_hWaitingForFrames;
 	QTimer m_animationTimer;
+	QThreadPool m_decoderPool;
 
 	static KviAnimatedPixmapCache * m_pInstance;
 
@@ -124,6 +133,10 @@ protected:
 
 	void internalScheduleFrameChange(uint delay, KviAnimatedPixmapInterface * receiver);
 	void internalNotifyDelete(KviAnimatedPixmapInterface * receiver);
+	void internalNotifyWhenReady(Data * data, KviAnimatedPixmapInterface * receiver, bool bNotify);
+
+	void startDecoder(Data * data);
+	void customEvent(QEvent * e) override;
 
 protected slots:
 	virtual void timeoutEvent();
@@ -158,6 +171,20 @@ public:
 	{
 		m_pInstance->internalNotifyDelete(receiver);
 	}
+
+	/*
+	 * Calls receiver->framesReady() when the frames of data
+	 * have been decoded (only if data->ready is false)
+	 */
+	static void notifyWhenReady(Data * data, KviAnimatedPixmapInterface * receiver)
+	{
+		m_pInstance->internalNotifyWhenReady(data, receiver, true);
+	}
+
+	static void cancelNotifyWhenReady(Data * data, KviAnimatedPixmapInterface * receiver)
+	{
+		m_pInstance->internalNotifyWhenReady(data, receiver, false);
+	}
 };
 
 #endif /* KVI_ANIMATEDPIXMAPCACHE_H_ */
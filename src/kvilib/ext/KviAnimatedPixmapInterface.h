@@ -30,6 +30,8 @@ class KviAnimatedPixmapInterface
 {
 public:
 	virtual void nextFrame(bool) = 0;
+	// the frames decoded in background have replaced the placeholder
+	virtual void framesReady() = 0;
 	virtual ~KviAnimatedPixmapInterface(){};
 };
 
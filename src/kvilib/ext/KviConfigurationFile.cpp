@@ -33,10 +33,56 @@
 #include <QColor>
 #include <QRect>
 #include <QSaveFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QRunnable>
+
+struct KviConfigurationFilePreload
+{
+	KviPointerHashTable<QString, KviConfigurationFileGroup> * pDict = nullptr; // nullptr until parsed
+	bool bLocal8Bit = false;
+	bool bDone = false;
+};
+
+static QMutex g_preloadMutex;
+static QWaitCondition g_preloadDone;
+static QHash<QString, KviConfigurationFilePreload *> g_hPreloads;
+static QThreadPool * g_pPreloadPool = nullptr;
+
+class KviConfigurationFilePreloadJob : public QRunnable
+{
+public:
+	KviConfigurationFilePreloadJob(const QString & szFileName, KviConfigurationFilePreload * pPreload)
+	    : m_szFileName(szFileName), m_pPreload(pPreload)
+	{
+	}
+
+	void run() override
+	{
+		// Write mode doesn't touch the file: load() is called explicitly
+		KviConfigurationFile cfg(m_szFileName, KviConfigurationFile::Write, m_pPreload->bLocal8Bit);
+		cfg.load();
+		KviPointerHashTable<QString, KviConfigurationFileGroup> * pDict = cfg.m_pDict;
+		cfg.m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
+
+		QMutexLocker locker(&g_preloadMutex);
+		m_pPreload->pDict = pDict;
+		m_pPreload->bDone = true;
+		g_preloadDone.wakeAll();
+	}
+
+private:
+	QString m_szFileName;
+	KviConfigurationFilePreload * m_pPreload;
+};
 
-KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f, bool bLocal8Bit)
+KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f, bool bLocal8Bit, LoadMode eLoadMode)
 {
 	m_bLocal8Bit = bLocal8Bit;
+	m_bLazy = (eLoadMode == Lazy) && (f != KviConfigurationFile::Write);
 	m_szFileName = filename;
 	m_bDirty = false;
 	m_szGroup = KVI_CONFIG_DEFAULT_GROUP;
@@ -44,13 +90,19 @@ KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f,
 	m_bReadOnly = (f == KviConfigurationFile::Read);
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
-	if(f != KviConfigurationFile::Write)
-		load();
+	if(m_bLazy)
+		mapAndIndex();
+	else if(f != KviConfigurationFile::Write)
+	{
+		if(!takePreloaded())
+			load();
+	}
 }
 
-KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bool bLocal8Bit)
+KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bool bLocal8Bit, LoadMode eLoadMode)
 {
 	m_bLocal8Bit = bLocal8Bit;
+	m_bLazy = (eLoadMode == Lazy) && (f != KviConfigurationFile::Write);
 	m_szFileName = QString::fromUtf8(filename);
 	m_bDirty = false;
 	m_szGroup = KVI_CONFIG_DEFAULT_GROUP;
@@ -58,19 +110,27 @@ KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bo
 	m_bReadOnly = (f == KviConfigurationFile::Read);
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
-	if(f != KviConfigurationFile::Write)
-		load();
+	if(m_bLazy)
+		mapAndIndex();
+	else if(f != KviConfigurationFile::Write)
+	{
+		if(!takePreloaded())
+			load();
+	}
 }
 
 KviConfigurationFile::~KviConfigurationFile()
 {
 	if(m_bDirty)
 		save();
+	unmap();
 	delete m_pDict;
 }
 
 void KviConfigurationFile::clear()
 {
+	unmap();
+	m_DirtyGroups.clear();
 	delete m_pDict;
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
@@ -82,19 +142,381 @@ void KviConfigurationFile::clearGroup(const QString & szGroup)
 {
 	m_bDirty = true;
 	m_pDict->remove(szGroup);
-	if(!m_pDict->find(m_szGroup))
+	if(m_bLazy)
+	{
+		m_hLazyGroups.remove(szGroup.toLower());
+		m_DirtyGroups.remove(szGroup.toLower());
+	}
+	if(!hasGroup(m_szGroup))
 		m_szGroup = KVI_CONFIG_DEFAULT_GROUP; //removed the current one
 }
 
 void KviConfigurationFile::clearKey(const QString & szKey)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	p_group->remove(szKey);
 	if(p_group->count() == 0)
 		clearGroup(m_szGroup);
 }
 
+void KviConfigurationFile::preload(const QString & szFileName, bool bLocal8Bit)
+{
+	QMutexLocker locker(&g_preloadMutex);
+	if(g_hPreloads.contains(szFileName))
+		return;
+
+	if(!g_pPreloadPool)
+		g_pPreloadPool = new QThreadPool();
+
+	KviConfigurationFilePreload * pPreload = new KviConfigurationFilePreload();
+	pPreload->bLocal8Bit = bLocal8Bit;
+	g_hPreloads.insert(szFileName, pPreload);
+	g_pPreloadPool->start(new KviConfigurationFilePreloadJob(szFileName, pPreload));
+}
+
+void KviConfigurationFile::discardPreloaded()
+{
+	if(!g_pPreloadPool)
+		return;
+
+	// the jobs need the mutex to finish
+	g_pPreloadPool->waitForDone();
+	delete g_pPreloadPool;
+	g_pPreloadPool = nullptr;
+
+	QMutexLocker locker(&g_preloadMutex);
+	for(auto pPreload : g_hPreloads)
+	{
+		delete pPreload->pDict;
+		delete pPreload;
+	}
+	g_hPreloads.clear();
+}
+
+bool KviConfigurationFile::takePreloaded()
+{
+	QMutexLocker locker(&g_preloadMutex);
+	if(g_hPreloads.isEmpty())
+		return false;
+
+	KviConfigurationFilePreload * pPreload = g_hPreloads.value(m_szFileName, nullptr);
+	if(!pPreload)
+		return false;
+
+	while(!pPreload->bDone)
+		g_preloadDone.wait(&g_preloadMutex);
+
+	// one shot: whoever opens the file later must see the current contents
+	g_hPreloads.remove(m_szFileName);
+
+	bool bTaken = pPreload->pDict && (pPreload->bLocal8Bit == m_bLocal8Bit);
+	if(bTaken)
+	{
+		delete m_pDict;
+		m_pDict = pPreload->pDict;
+	}
+	else
+	{
+		delete pPreload->pDict;
+	}
+	delete pPreload;
+	return bTaken;
+}
+
+bool KviConfigurationFile::parseGroupName(char * begin, KviCString & tmp, QString & szGroup)
+{
+	// begin points just after the '[' of a trimmed, zero terminated line
+	if(!(*begin) || (*begin == ']'))
+		return false;
+
+	char * z = begin;
+#define COMPAT_WITH_OLD_CONFIGS
+#ifdef COMPAT_WITH_OLD_CONFIGS
+	// run to the end of the string
+	while(*z)
+		z++;
+	// run back to the trailing ']'
+	while((z > begin) && (*z != ']'))
+		z--;
+	// if it is not there just run back to the end of the string
+	if(*z != ']')
+		while(*z)
+			z++;
+#else
+	// new configs have it always encoded properly
+	while(*z && (*z != ']'))
+		z++;
+#endif
+	*z = 0;
+	tmp.hexDecode(begin);
+	tmp.stripRightWhiteSpace(); // no external spaces in group names
+
+	if(tmp.isEmpty())
+		return false;
+
+	szGroup = m_bLocal8Bit ? QString::fromLocal8Bit(tmp.ptr(), tmp.len()) : QString::fromUtf8(tmp.ptr(), tmp.len());
+	return true;
+}
+
+void KviConfigurationFile::parseEntry(char * begin, KviConfigurationFileGroup *& p_group, KviCString & tmp)
+{
+	char * z = begin;
+	while(*z && (*z != '='))
+		z++;
+	if(!(*z) || (z == begin))
+		return;
+
+	*z = 0;
+	tmp.hexDecode(begin);
+	tmp.stripRightWhiteSpace(); // No external spaces at all in keys
+	if(tmp.isEmpty())
+		return;
+
+	QString szKey = m_bLocal8Bit ? QString::fromLocal8Bit(tmp.ptr(), tmp.len()) : QString::fromUtf8(tmp.ptr(), tmp.len());
+	z++;
+	while(*z && ((*z == ' ') || (*z == '\t')))
+		z++;
+
+	if(!p_group)
+	{
+		// ops...we're missing a group
+		// use the default one
+		p_group = m_pDict->find(KVI_CONFIG_DEFAULT_GROUP);
+		if(!p_group)
+		{
+			p_group = new KviConfigurationFileGroup(17, false);
+			p_group->setAutoDelete(true);
+			m_pDict->insert(KVI_CONFIG_DEFAULT_GROUP, p_group);
+		}
+	}
+
+	if(*z)
+	{
+		tmp.hexDecode(z);
+		p_group->replace(szKey, new QString(m_bLocal8Bit ? QString::fromLocal8Bit(tmp.ptr(), tmp.len()) : QString::fromUtf8(tmp.ptr(), tmp.len())));
+	}
+	else
+	{
+		// we in fact need this (mercy :D)
+		// otherwise the empty options will be treated as non-existing ones
+		// and will get the defaults (which is bad)
+		p_group->replace(szKey, new QString(QString()));
+	}
+}
+
+//
+// Lazy mode: the file is mapped in memory and load() only records where
+// the body of each group is. A group is parsed when it's accessed for the first time
+// and save() copies the bytes of the groups that haven't been modified.
+//
+
+// trims a line like load() does: returns false if nothing is left
+static bool config_trim_line(const char * pLine, const char * pLineEnd, const char *& pBegin, const char *& pEnd)
+{
+	pBegin = pLine;
+	while((pBegin < pLineEnd) && ((*pBegin == '\t') || (*pBegin == ' ')))
+		pBegin++;
+	pEnd = pLineEnd;
+	while((pEnd > pBegin) && ((*(pEnd - 1) == '\r') || (*(pEnd - 1) == '\t') || (*(pEnd - 1) == ' ')))
+		pEnd--;
+	return pEnd > pBegin;
+}
+
+bool KviConfigurationFile::mapAndIndex()
+{
+	m_pMappedFile = new QFile(m_szFileName);
+	if(!m_pMappedFile->open(QFile::ReadOnly) || (m_pMappedFile->size() < 1))
+	{
+		unmap();
+		return false;
+	}
+
+	m_iMappedSize = m_pMappedFile->size();
+	m_pMappedData = (const char *)m_pMappedFile->map(0, m_iMappedSize);
+	if(!m_pMappedData)
+	{
+		unmap();
+		return false;
+	}
+
+	KviCString tmp;
+	QByteArray line;
+	KviConfigurationFileLazyGroup * pCurrent = nullptr;
+	const char * pDataEnd = m_pMappedData + m_iMappedSize;
+	const char * p = m_pMappedData;
+
+	while(p < pDataEnd)
+	{
+		const char * pLine = p;
+		while((p < pDataEnd) && (*p != '\n'))
+			p++;
+		const char * pLineEnd = p;
+		if(p < pDataEnd)
+			p++; // skip the newline
+
+		const char * pBegin;
+		const char * pEnd;
+		if(!config_trim_line(pLine, pLineEnd, pBegin, pEnd))
+			continue;
+
+		if(*pBegin == '[')
+		{
+			line = QByteArray(pBegin + 1, pEnd - pBegin - 1); // zero terminated copy
+			QString szGroup;
+			if(parseGroupName(line.data(), tmp, szGroup))
+			{
+				pCurrent = &(m_hLazyGroups[szGroup.toLower()]);
+				if(pCurrent->szName.isEmpty())
+					pCurrent->szName = szGroup;
+				pCurrent->ranges.append(qMakePair((qint64)(p - m_pMappedData), (qint64)(p - m_pMappedData)));
+				continue;
+			}
+		}
+		else if(*pBegin != '#')
+		{
+			if(!pCurrent)
+			{
+				// entries before the first group go to the default one
+				pCurrent = &(m_hLazyGroups[QString(KVI_CONFIG_DEFAULT_GROUP).toLower()]);
+				if(pCurrent->szName.isEmpty())
+					pCurrent->szName = KVI_CONFIG_DEFAULT_GROUP;
+				pCurrent->ranges.append(qMakePair((qint64)(pLine - m_pMappedData), (qint64)(pLine - m_pMappedData)));
+			}
+			pCurrent->bHasEntries = true;
+		}
+
+		if(pCurrent)
+			pCurrent->ranges.last().second = p - m_pMappedData;
+	}
+
+	return true;
+}
+
+void KviConfigurationFile::unmap()
+{
+	if(m_pMappedFile)
+	{
+		if(m_pMappedData)
+			m_pMappedFile->unmap((uchar *)m_pMappedData);
+		delete m_pMappedFile;
+		m_pMappedFile = nullptr;
+	}
+	m_pMappedData = nullptr;
+	m_iMappedSize = 0;
+	m_hLazyGroups.clear();
+}
+
+KviConfigurationFileGroup * KviConfigurationFile::parseLazyGroup(const QString & szGroup)
+{
+	QHash<QString, KviConfigurationFileLazyGroup>::const_iterator it = m_hLazyGroups.constFind(szGroup.toLower());
+	if(it == m_hLazyGroups.constEnd())
+		return nullptr;
+
+	KviConfigurationFileGroup * p_group = new KviConfigurationFileGroup(17, false);
+	p_group->setAutoDelete(true);
+	m_pDict->insert(it->szName, p_group);
+	parseLazyGroupBody(*it, p_group);
+	return p_group;
+}
+
+void KviConfigurationFile::parseLazyGroupBody(const KviConfigurationFileLazyGroup & g, KviConfigurationFileGroup * p_group)
+{
+	KviCString tmp;
+	QByteArray line;
+	for(auto & r : g.ranges)
+	{
+		const char * p = m_pMappedData + r.first;
+		const char * pDataEnd = m_pMappedData + r.second;
+		while(p < pDataEnd)
+		{
+			const char * pLine = p;
+			while((p < pDataEnd) && (*p != '\n'))
+				p++;
+			const char * pLineEnd = p;
+			if(p < pDataEnd)
+				p++;
+
+			const char * pBegin;
+			const char * pEnd;
+			if(!config_trim_line(pLine, pLineEnd, pBegin, pEnd))
+				continue;
+			if((*pBegin == '#') || (*pBegin == '['))
+				continue;
+
+			line = QByteArray(pBegin, pEnd - pBegin); // parseEntry() needs a writable, zero terminated copy
+			parseEntry(line.data(), p_group, tmp);
+		}
+	}
+}
+
+bool KviConfigurationFile::peekEntry(const QString & szGroup, const QString & szKey, QString & szValue)
+{
+	KviConfigurationFileGroup * p_group = m_pDict->find(szGroup);
+	if(!p_group && m_bLazy)
+	{
+		QHash<QString, KviConfigurationFileLazyGroup>::const_iterator it = m_hLazyGroups.constFind(szGroup.toLower());
+		if(it == m_hLazyGroups.constEnd())
+			return false;
+
+		// parse the group aside: it doesn't end up in the dictionary
+		KviConfigurationFileGroup tmpGroup(17, false);
+		tmpGroup.setAutoDelete(true);
+		parseLazyGroupBody(*it, &tmpGroup);
+		QString * pVal = tmpGroup.find(szKey);
+		if(!pVal)
+			return false;
+		szValue = *pVal;
+		return true;
+	}
+
+	if(!p_group)
+		return false;
+	QString * pVal = p_group->find(szKey);
+	if(!pVal)
+		return false;
+	szValue = *pVal;
+	return true;
+}
+
+QStringList KviConfigurationFile::groupNames()
+{
+	QStringList lGroups;
+	KviPointerHashTableIterator<QString, KviConfigurationFileGroup> it(*m_pDict);
+	while(it.current())
+	{
+		lGroups.append(it.currentKey());
+		++it;
+	}
+	for(auto & g : m_hLazyGroups)
+	{
+		if(!m_pDict->find(g.szName))
+			lGroups.append(g.szName);
+	}
+	return lGroups;
+}
+
+KviPointerHashTable<QString, KviConfigurationFileGroup> * KviConfigurationFile::dict()
+{
+	// the caller may iterate anything: parse the groups that are still pending
+	for(auto & g : m_hLazyGroups)
+	{
+		if(!m_pDict->find(g.szName))
+			parseLazyGroup(g.szName);
+	}
+	return m_pDict;
+}
+
+unsigned int KviConfigurationFile::groupsCount()
+{
+	unsigned int uCount = m_pDict->count();
+	for(auto & g : m_hLazyGroups)
+	{
+		if(!m_pDict->find(g.szName))
+			uCount++;
+	}
+	return uCount;
+}
+
 #define LOAD_BLOCK_SIZE 32768
 
 bool KviConfigurationFile::load()
@@ -230,88 +652,25 @@ bool KviConfigurationFile::load()
 					// comment: just skip it
 					break;
 				case '[':
-					// group ?
-					begin++;
-					if(*begin && (*begin != ']'))
-					{
-						char * z = begin;
-#define COMPAT_WITH_OLD_CONFIGS
-#ifdef COMPAT_WITH_OLD_CONFIGS
-						// run to the end of the string
-						while(*z)
-							z++;
-						// run back to the trailing ']'
-						while((z > begin) && (*z != ']'))
-							z--;
-						// if it is not there just run back to the end of the string
-						if(*z != ']')
-							while(*z)
-								z++;
-#else
-						// new configs have it always encoded properly
-						while(*z && (*z != ']'))
-							z++;
-#endif
-						*z = 0;
-						tmp.hexDecode(begin);
-						tmp.stripRightWhiteSpace(); // no external spaces in group names
-
-						if(!tmp.isEmpty())
-						{
-							QString szGroup = m_bLocal8Bit ? QString::fromLocal8Bit(tmp.ptr(), tmp.len()) : QString::fromUtf8(tmp.ptr(), tmp.len());
-							p_group = m_pDict->find(szGroup);
-							if(!p_group)
-							{
-								p_group = new KviConfigurationFileGroup(17, false);
-								p_group->setAutoDelete(true);
-								m_pDict->insert(szGroup, p_group);
-							}
-						}
-					}
-					break;
-				default:
 				{
-					// real data ?
-					char * z = begin;
-					while(*z && (*z != '='))
-						z++;
-					if(*z && (z != begin))
+					// group ?
+					QString szGroup;
+					if(parseGroupName(begin + 1, tmp, szGroup))
 					{
-						*z = 0;
-						tmp.hexDecode(begin);
-						tmp.stripRightWhiteSpace(); // No external spaces at all in keys
-						if(!tmp.isEmpty())
+						p_group = m_pDict->find(szGroup);
+						if(!p_group)
 						{
-							QString szKey = m_bLocal8Bit ? QString::fromLocal8Bit(tmp.ptr(), tmp.len()) : QString::fromUtf8(tmp.ptr(), tmp.len());
-							z++;
-							while(*z && ((*z == ' ') || (*z == '\t')))
-								z++;
-							if(*z)
-							{
-								tmp.hexDecode(z);
-								QString * pVal = new QString(m_bLocal8Bit ? QString::fromLocal8Bit(tmp.ptr(), tmp.len()) : QString::fromUtf8(tmp.ptr(), tmp.len()));
-								if(!p_group)
-								{
-									// ops...we're missing a group
-									// use the default one
-									p_group = new KviConfigurationFileGroup(17, false);
-									p_group->setAutoDelete(true);
-									m_pDict->insert(KVI_CONFIG_DEFAULT_GROUP, p_group);
-								}
-								p_group->replace(szKey, pVal);
-							}
-							else
-							{
-								// we in fact need this (mercy :D)
-								// otherwise the empty options will be treated as non-existing ones
-								// and will get the defaults (which is bad)
-								QString * pVal = new QString(QString());
-								p_group->replace(szKey, pVal);
-							}
+							p_group = new KviConfigurationFileGroup(17, false);
+							p_group->setAutoDelete(true);
+							m_pDict->insert(szGroup, p_group);
 						}
 					}
 				}
 				break;
+				default:
+					// real data ?
+					parseEntry(begin, p_group, tmp);
+					break;
 			}
 			begin = p;
 		}
@@ -343,60 +702,75 @@ bool KviConfigurationFile::saveIfDirty()
 	return save();
 }
 
+static unsigned char config_encode_table[256] = {
+	// clang-format off
+	//	000 001 002 003 004 005 006 007   008 009 010 011 012 013 014 015
+	//	NUL SOH STX ETX EOT ENQ ACK BEL   BS  HT  LF  VT  FF  CR  SO  SI
+		1  ,1  ,1  ,1  ,1  ,1  ,1  ,1    ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,
+	//	016 017 018 019 020 021 022 023   024 025 026 027 028 029 030 031
+	//	DLE DC1 DC2 DC3 DC4 NAK SYN ETB   CAN EM  SUB ESC FS  GS  RS  US
+		1  ,1  ,1  ,1  ,1  ,1  ,1  ,1    ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,
+	//	032 033 034 035 036 037 038 039   040 041 042 043 044 045 046 047
+	//	    !   "   #   $   %   &   '     (   )   *   +   ,   -   .   /
+		1  ,0  ,0  ,1  ,0  ,1  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	048 049 050 051 052 053 054 055   056 057 058 059 060 061 062 063
+	//	0   1   2   3   4   5   6   7     8   9   :   ;   <   =   >   ?
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,1  ,0  ,0  ,
+	//	064 065 066 067 068 069 070 071   072 073 074 075 076 077 078 079
+	//	@   A   B   C   D   E   F   G     H   I   J   K   L   M   N   O
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	080 081 082 083 084 085 086 087   088 089 090 091 092 093 094 095
+	//	P   Q   R   S   T   U   V   W     X   Y   Z   [   \   ]   ^   _
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,1  ,0  ,1  ,0  ,0  ,
+	//	096 097 098 099 100 101 102 103   104 105 106 107 108 109 110 111
+	//	`   a   b   c   d   e   f   g     h   i   j   k   l   m   n   o
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	112 113 114 115 116 117 118 119   120 121 122 123 124 125 126 127
+	//	p   q   r   s   t   u   v   w     x   y   z   {   |   }   ~   
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	128 129 130 131 132 133 134 135   136 137 138 139 140 141 142 143
+	//
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	144 145 146 147 148 149 150 151   152 153 154 155 156 157 158 159
+	//
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	160 161 162 163 164 165 166 167   168 169 170 171 172 173 174 175
+	//
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	176 177 178 179 180 181 182 183   184 185 186 187 188 189 190 191
+	//
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	192 193 194 195 196 197 198 199   200 201 202 203 204 205 206 207
+	//	�  �  �  �  �  �  �  �    �  �  �  �  �  �  �  �
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	208 209 210 211 212 213 214 215   216 217 218 219 220 221 222 223
+	//	�  �  �  �  �  �  �  �    �  �  �  �  �  �  �  �
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	224 225 226 227 228 229 230 231   232 233 234 235 236 237 238 239
+	//	�  �  �  �  �  �  �  �    �  �  �  �  �  �  �  �
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
+	//	240 241 242 243 244 245 246 247   248 249 250 251 252 253 254 255
+	//	�  �  �  �  �  �  �  �
+		0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0
+	// clang-format on
+};
+
+bool KviConfigurationFile::writeGroupHeader(QSaveFile & f, const QString & szGroup)
+{
+	KviCString group(m_bLocal8Bit ? szGroup.toLocal8Bit() : szGroup.toUtf8());
+	group.hexEncodeWithTable(config_encode_table);
+
+	if(!f.putChar('['))
+		return false;
+	if(f.write(group.ptr(), group.len()) < (unsigned int)group.len())
+		return false;
+	if(f.write("]\n", 2) < 2)
+		return false;
+	return true;
+}
+
 bool KviConfigurationFile::save()
 {
-	static unsigned char encode_table[256] = {
-		// clang-format off
-		//	000 001 002 003 004 005 006 007   008 009 010 011 012 013 014 015
-		//	NUL SOH STX ETX EOT ENQ ACK BEL   BS  HT  LF  VT  FF  CR  SO  SI
-			1  ,1  ,1  ,1  ,1  ,1  ,1  ,1    ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,
-		//	016 017 018 019 020 021 022 023   024 025 026 027 028 029 030 031
-		//	DLE DC1 DC2 DC3 DC4 NAK SYN ETB   CAN EM  SUB ESC FS  GS  RS  US
-			1  ,1  ,1  ,1  ,1  ,1  ,1  ,1    ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,1  ,
-		//	032 033 034 035 036 037 038 039   040 041 042 043 044 045 046 047
-		//	    !   "   #   $   %   &   '     (   )   *   +   ,   -   .   /
-			1  ,0  ,0  ,1  ,0  ,1  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	048 049 050 051 052 053 054 055   056 057 058 059 060 061 062 063
-		//	0   1   2   3   4   5   6   7     8   9   :   ;   <   =   >   ?
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,1  ,0  ,0  ,
-		//	064 065 066 067 068 069 070 071   072 073 074 075 076 077 078 079
-		//	@   A   B   C   D   E   F   G     H   I   J   K   L   M   N   O
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	080 081 082 083 084 085 086 087   088 089 090 091 092 093 094 095
-		//	P   Q   R   S   T   U   V   W     X   Y   Z   [   \   ]   ^   _
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,1  ,0  ,1  ,0  ,0  ,
-		//	096 097 098 099 100 101 102 103   104 105 106 107 108 109 110 111
-		//	`   a   b   c   d   e   f   g     h   i   j   k   l   m   n   o
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	112 113 114 115 116 117 118 119   120 121 122 123 124 125 126 127
-		//	p   q   r   s   t   u   v   w     x   y   z   {   |   }   ~   
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	128 129 130 131 132 133 134 135   136 137 138 139 140 141 142 143
-		//
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	144 145 146 147 148 149 150 151   152 153 154 155 156 157 158 159
-		//
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	160 161 162 163 164 165 166 167   168 169 170 171 172 173 174 175
-		//
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	176 177 178 179 180 181 182 183   184 185 186 187 188 189 190 191
-		//
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	192 193 194 195 196 197 198 199   200 201 202 203 204 205 206 207
-		//	�  �  �  �  �  �  �  �    �  �  �  �  �  �  �  �
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	208 209 210 211 212 213 214 215   216 217 218 219 220 221 222 223
-		//	�  �  �  �  �  �  �  �    �  �  �  �  �  �  �  �
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	224 225 226 227 228 229 230 231   232 233 234 235 236 237 238 239
-		//	�  �  �  �  �  �  �  �    �  �  �  �  �  �  �  �
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,
-		//	240 241 242 243 244 245 246 247   248 249 250 251 252 253 254 255
-		//	�  �  �  �  �  �  �  �
-			0  ,0  ,0  ,0  ,0  ,0  ,0  ,0    ,0  ,0  ,0  ,0  ,0  ,0  ,0  ,0
-		// clang-format on
-	};
 
 	if(m_bReadOnly)
 		return false;
@@ -409,19 +783,38 @@ bool KviConfigurationFile::save()
 	if(f.write("# KVIrc configuration file\n", 27) != 27)
 		return false;
 
+	// lazy mode: the groups that have not been modified are copied as they are
+	for(auto & g : m_hLazyGroups)
+	{
+		if(m_DirtyGroups.contains(g.szName.toLower()))
+			continue;
+		if(!g.bHasEntries && !m_bPreserveEmptyGroups)
+			continue;
+		if(!writeGroupHeader(f, g.szName))
+			return false;
+		for(auto & r : g.ranges)
+		{
+			if(f.write(m_pMappedData + r.first, r.second - r.first) < (r.second - r.first))
+				return false;
+			// the last line of the file may have no trailing newline
+			if((r.second > r.first) && (m_pMappedData[r.second - 1] != '\n') && !f.putChar('\n'))
+				return false;
+		}
+	}
+
 	KviPointerHashTableIterator<QString, KviConfigurationFileGroup> it(*m_pDict);
 	while(it.current())
 	{
-		if((it.current()->count() != 0) || (m_bPreserveEmptyGroups))
+		if(m_bLazy && m_hLazyGroups.contains(it.currentKey().toLower()) && !m_DirtyGroups.contains(it.currentKey().toLower()))
 		{
-			KviCString group(m_bLocal8Bit ? it.currentKey().toLocal8Bit() : it.currentKey().toUtf8());
-			group.hexEncodeWithTable(encode_table);
+			// already copied above
+			++it;
+			continue;
+		}
 
-			if(!f.putChar('['))
-				return false;
-			if(f.write(group.ptr(), group.len()) < (unsigned int)group.len())
-				return false;
-			if(f.write("]\n", 2) < 2)
+		if((it.current()->count() != 0) || (m_bPreserveEmptyGroups))
+		{
+			if(!writeGroupHeader(f, it.currentKey()))
 				return false;
 
 			KviConfigurationFileGroup * dict = (KviConfigurationFileGroup *)it.current();
@@ -432,7 +825,7 @@ bool KviConfigurationFile::save()
 			{
 				szName = m_bLocal8Bit ? it2.currentKey().toLocal8Bit() : it2.currentKey().toUtf8();
 				szValue = m_bLocal8Bit ? (*p_str).toLocal8Bit() : (*p_str).toUtf8();
-				szName.hexEncodeWithTable(encode_table);
+				szName.hexEncodeWithTable(config_encode_table);
 				szValue.hexEncodeWhiteSpace();
 
 				if(f.write(szName.ptr(), szName.len()) < (unsigned int)szName.len())
@@ -449,9 +842,24 @@ bool KviConfigurationFile::save()
 		++it;
 	}
 
-	if(!f.commit())
+	if(!m_bLazy)
+	{
+		if(!f.commit())
+			return false;
+
+		m_bDirty = false;
+		return true;
+	}
+
+	// the file can't be replaced while it's mapped on some platforms:
+	// the parsed groups stay in m_pDict, the others are indexed again from the new file
+	unmap();
+	bool bCommitted = f.commit();
+	mapAndIndex();
+	if(!bCommitted)
 		return false;
 
+	m_DirtyGroups.clear();
 	m_bDirty = false;
 	return true;
 }
@@ -462,10 +870,7 @@ void KviConfigurationFile::setGroup(const QString & szGroup)
 	if(m_bPreserveEmptyGroups)
 	{
 		if(!hasGroup(szGroup))
-		{
-			getCurrentGroup(); // we need it to be created.
-			m_bDirty = true;
-		}
+			getCurrentGroupForWriting(); // we need it to be created.
 	}
 }
 
@@ -477,7 +882,9 @@ bool KviConfigurationFile::hasKey(const QString & szKey)
 
 bool KviConfigurationFile::hasGroup(const QString & szGroup)
 {
-	return (m_pDict->find(szGroup) != nullptr);
+	if(m_pDict->find(szGroup))
+		return true;
+	return m_bLazy && m_hLazyGroups.contains(szGroup.toLower());
 }
 
 KviConfigurationFileGroup * KviConfigurationFile::getCurrentGroup()
@@ -485,6 +892,8 @@ KviConfigurationFileGroup * KviConfigurationFile::getCurrentGroup()
 	if(m_szGroup.isEmpty())
 		m_szGroup = KVI_CONFIG_DEFAULT_GROUP;
 	KviConfigurationFileGroup * p_group = m_pDict->find(m_szGroup);
+	if(!p_group && m_bLazy)
+		p_group = parseLazyGroup(m_szGroup);
 	if(!p_group)
 	{
 		//create the group
@@ -495,14 +904,22 @@ KviConfigurationFileGroup * KviConfigurationFile::getCurrentGroup()
 	return p_group;
 }
 
+KviConfigurationFileGroup * KviConfigurationFile::getCurrentGroupForWriting()
+{
+	m_bDirty = true;
+	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	if(m_bLazy)
+		m_DirtyGroups.insert(m_szGroup.toLower());
+	return p_group;
+}
+
 //
 // QString
 //
 
 void KviConfigurationFile::writeEntry(const QString & szKey, const QString & szValue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString(szValue);
 	p_group->replace(szKey, p_data);
 }
@@ -540,8 +957,7 @@ QStringList KviConfigurationFile::readStringListEntry(const QString & szKey, con
 
 void KviConfigurationFile::writeEntry(const QString & szKey, const QStringList & list)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString(list.join(g_szConfigStringListSeparator));
 	p_group->replace(szKey, p_data);
 }
@@ -578,8 +994,7 @@ QList<int> KviConfigurationFile::readIntListEntry(const QString & szKey, const Q
 
 void KviConfigurationFile::writeEntry(const QString & szKey, const QList<int> & list)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	KviCString szData;
 	for(int it : list)
 	{
@@ -599,8 +1014,7 @@ void KviConfigurationFile::writeEntry(const QString & szKey, const QList<int> &
 // FIXME: #warning "Spaces in image names ?"
 void KviConfigurationFile::writeEntry(const QString & szKey, const KviPixmap & pixmap)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	KviStringConversion::toString(pixmap, *p_data);
 	p_group->replace(szKey, p_data);
@@ -627,8 +1041,7 @@ KviPixmap KviConfigurationFile::readPixmapEntry(const QString & szKey, const Kvi
 
 void KviConfigurationFile::writeEntry(const QString & szKey, const KviMessageTypeSettings & msg)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString szData;
 	KviStringConversion::toString(msg, szData);
 	p_group->replace(szKey, new QString(szData));
@@ -651,8 +1064,7 @@ KviMessageTypeSettings KviConfigurationFile::readMsgTypeEntry(const QString & sz
 
 void KviConfigurationFile::writeEntry(const QString & szKey, const QColor & clr)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	KviCString szData(KviCString::Format, "%d,%d,%d,%d", clr.red(), clr.green(), clr.blue(), clr.alpha());
 	p_group->replace(szKey, new QString(szData.ptr()));
 }
@@ -714,8 +1126,7 @@ void KviConfigurationFile::getFontProperties(KviCString & buffer, QFont * fnt)
 
 void KviConfigurationFile::writeEntry(const QString & szKey, QFont & fnt)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	KviStringConversion::toString(fnt, *p_data);
 	p_group->replace(szKey, p_data);
@@ -747,8 +1158,7 @@ QFont KviConfigurationFile::readFontEntry(const QString & szKey, const QFont & f
 
 void KviConfigurationFile::writeEntry(const QString & szKey, bool bTrue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString(bTrue ? "true" : "false");
 	p_group->replace(szKey, p_data);
 }
@@ -768,8 +1178,7 @@ bool KviConfigurationFile::readBoolEntry(const QString & szKey, bool bTrue)
 
 void KviConfigurationFile::writeEntry(const QString & szKey, const QRect & rct)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString szBuf;
 	KviStringConversion::toString(rct, szBuf);
 	p_group->replace(szKey, new QString(szBuf));
@@ -791,8 +1200,7 @@ QRect KviConfigurationFile::readRectEntry(const QString & szKey, const QRect & r
 
 void KviConfigurationFile::writeEntry(const QString & szKey, unsigned short int usValue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	p_data->setNum(usValue);
 	p_group->replace(szKey, p_data);
@@ -815,8 +1223,7 @@ unsigned short int KviConfigurationFile::readUShortEntry(const QString & szKey,
 
 void KviConfigurationFile::writeEntry(const QString & szKey, int iValue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	p_data->setNum(iValue);
 	p_group->replace(szKey, p_data);
@@ -839,8 +1246,7 @@ int KviConfigurationFile::readIntEntry(const QString & szKey, int iDefault)
 
 void KviConfigurationFile::writeEntry(const QString & szKey, unsigned int iValue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	p_data->setNum(iValue);
 	p_group->replace(szKey, p_data);
@@ -863,8 +1269,7 @@ unsigned int KviConfigurationFile::readUIntEntry(const QString & szKey, unsigned
 
 void KviConfigurationFile::writeEntry(const QString & szKey, char iValue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	p_data->setNum(iValue);
 	p_group->replace(szKey, p_data);
@@ -887,8 +1292,7 @@ char KviConfigurationFile::readCharEntry(const QString & szKey, char iDefault)
 
 void KviConfigurationFile::writeEntry(const QString & szKey, unsigned char iValue)
 {
-	m_bDirty = true;
-	KviConfigurationFileGroup * p_group = getCurrentGroup();
+	KviConfigurationFileGroup * p_group = getCurrentGroupForWriting();
 	QString * p_data = new QString();
 	p_data->setNum(iValue);
 	p_group->replace(szKey, p_data);
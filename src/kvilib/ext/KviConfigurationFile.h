@@ -34,6 +34,10 @@
 #include <QFont>
 #include <QString>
 #include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QPair>
 
 #define KVI_CONFIG_DEFAULT_GROUP "KVIrc"
 
@@ -41,13 +45,25 @@ class KviPixmap;
 class KviMessageTypeSettings;
 class QColor;
 class QRect;
+class QFile;
+class QSaveFile;
 
 typedef KviPointerHashTable<QString, QString> KviConfigurationFileGroup;
 typedef KviPointerHashTableIterator<QString, QString> KviConfigurationFileGroupIterator;
 typedef KviPointerHashTableIterator<QString, KviConfigurationFileGroup> KviConfigurationFileIterator;
 
+// A group of a lazily loaded file that lives in the mapped data
+struct KviConfigurationFileLazyGroup
+{
+	QString szName;
+	QVector<QPair<qint64, qint64>> ranges; // [begin,end) offsets of the group body (a group may appear more than once)
+	bool bHasEntries = false;
+};
+
 class KVILIB_API KviConfigurationFile : public KviHeapObject
 {
+	friend class KviConfigurationFilePreloadJob;
+
 public:
 	enum FileMode
 	{
@@ -56,9 +72,15 @@ public:
 		ReadWrite = 3
 	};
 
+	enum LoadMode
+	{
+		Eager, // parse the whole file in the constructor
+		Lazy   // map the file, index the groups and parse each group on first access (saves rewrite only the modified groups)
+	};
+
 public:
-	KviConfigurationFile(const QString & filename, FileMode f /* = ReadWrite*/, bool bLocal8Bit = false);
-	KviConfigurationFile(const char * filename, FileMode f /* = ReadWrite*/, bool bLocal8Bit = false);
+	KviConfigurationFile(const QString & filename, FileMode f /* = ReadWrite*/, bool bLocal8Bit = false, LoadMode eLoadMode = Eager);
+	KviConfigurationFile(const char * filename, FileMode f /* = ReadWrite*/, bool bLocal8Bit = false, LoadMode eLoadMode = Eager);
 	~KviConfigurationFile();
 
 private:
@@ -70,11 +92,41 @@ private:
 	QString m_szGroup;
 	bool m_bPreserveEmptyGroups;
 	bool m_bReadOnly;
+	bool m_bLazy;
+	QFile * m_pMappedFile = nullptr;
+	const char * m_pMappedData = nullptr;
+	qint64 m_iMappedSize = 0;
+	QHash<QString, KviConfigurationFileLazyGroup> m_hLazyGroups; // keyed by the lowercase group name
+	QSet<QString> m_DirtyGroups;                                 // lowercase names of the groups modified since the last save
 
 private:
 	bool load();
 	bool save();
+	bool takePreloaded();
+	bool parseGroupName(char * begin, KviCString & tmp, QString & szGroup);
+	void parseEntry(char * begin, KviConfigurationFileGroup *& p_group, KviCString & tmp);
+	bool mapAndIndex();
+	void unmap();
+	KviConfigurationFileGroup * parseLazyGroup(const QString & szGroup);
+	void parseLazyGroupBody(const KviConfigurationFileLazyGroup & g, KviConfigurationFileGroup * p_group);
+	bool writeGroupHeader(QSaveFile & f, const QString & szGroup);
 	KviConfigurationFileGroup * getCurrentGroup();
+	KviConfigurationFileGroup * getCurrentGroupForWriting();
+
+public:
+	//
+	// Starts reading and parsing szFileName on a worker thread.
+	// The next KviConfigurationFile opened (not in Write mode) on the same file
+	// picks up the parsed data instead of reading the file again, waiting
+	// for the worker if it's still running.
+	// This is used at startup to overlap the I/O of the independent databases.
+	//
+	static void preload(const QString & szFileName, bool bLocal8Bit = false);
+	//
+	// Waits for the running preloads and throws away the data that nobody
+	// picked up so later reads always go to the disk.
+	//
+	static void discardPreloaded();
 
 public:
 	//
@@ -101,16 +153,21 @@ public:
 	// as default configuration, alter its settings and save it to the
 	// user local configuration directory
 	void setSavePath(const QString & savePath) { m_szFileName = savePath; };
-	KviPointerHashTable<QString, KviConfigurationFileGroup> * dict() { return m_pDict; };
+	// In lazy mode this parses all the groups: use groupNames() if you just need the names
+	KviPointerHashTable<QString, KviConfigurationFileGroup> * dict();
+	QStringList groupNames();
 
 	void clearDirtyFlag() { m_bDirty = false; };
 	void clear();
 	void clearGroup(const QString & szGroup);
 	void clearKey(const QString & szKey);
-	unsigned int groupsCount() { return m_pDict->count(); };
+	unsigned int groupsCount();
 	bool sync() { return save(); };
 	bool hasKey(const QString & szKey);
 	bool hasGroup(const QString & szGroup);
+	// Reads szKey from szGroup without touching the current group.
+	// In lazy mode a group that hasn't been accessed yet is not kept parsed.
+	bool peekEntry(const QString & szGroup, const QString & szKey, QString & szValue);
 	void setGroup(const QString & szGroup);
 	//void getContentsString(KviCString &buffer);
 	const QString & group() { return m_szGroup; };
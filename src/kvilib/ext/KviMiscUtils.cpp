@@ -27,6 +27,18 @@
 #include <QString>
 #include <QStringList>
 
+#ifdef COMPILE_SSL_SUPPORT
+#include <openssl/evp.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100005L
+#define EVP_MD_CTX_new EVP_MD_CTX_create
+#define EVP_MD_CTX_free EVP_MD_CTX_destroy
+#endif
+
+#else
+#include <QCryptographicHash>
+#endif
+
 namespace KviMiscUtils
 {
 	int compareVersions(const QString & szVersion1, const QString & szVersion2)
@@ -83,4 +95,41 @@ namespace KviMiscUtils
 		}
 		return true;
 	}
+
+	KviError::Code digest(const QString & szData, const QString & szAlgorithm, QString & szResult)
+	{
+		QString szType = szAlgorithm.isEmpty() ? QString("md5") : szAlgorithm.toLower();
+		QByteArray data = szData.toUtf8();
+
+#if defined(COMPILE_SSL_SUPPORT)
+		OpenSSL_add_all_digests();
+
+		const EVP_MD * md = EVP_get_digestbyname(szType.toUtf8().data());
+		if(!md)
+			return KviError::FeatureNotAvailable;
+
+		unsigned char md_value[EVP_MAX_MD_SIZE];
+		unsigned int md_len;
+		EVP_MD_CTX * mdctx = EVP_MD_CTX_new();
+		EVP_DigestInit_ex(mdctx, md, nullptr);
+		EVP_DigestUpdate(mdctx, data.data(), data.length());
+		EVP_DigestFinal_ex(mdctx, md_value, &md_len);
+		EVP_MD_CTX_free(mdctx);
+
+		szResult = QString(QByteArray((const char *)md_value, md_len).toHex());
+#else // fall back to QCryptographicHash
+		QCryptographicHash::Algorithm qAlgo;
+		if(szType == "sha1")
+			qAlgo = QCryptographicHash::Sha1;
+		else if(szType == "md4")
+			qAlgo = QCryptographicHash::Md4;
+		else if(szType == "md5")
+			qAlgo = QCryptographicHash::Md5;
+		else
+			return KviError::FeatureNotAvailable;
+
+		szResult = QString(QCryptographicHash::hash(data, qAlgo).toHex()).toUpper();
+#endif
+		return KviError::Success;
+	}
 }
@@ -31,6 +31,7 @@
 */
 
 #include "kvi_settings.h"
+#include "KviError.h"
 
 class QString;
 
@@ -58,6 +59,18 @@ namespace KviMiscUtils
 	* \return bool
 	*/
 	extern KVILIB_API bool isValidVersionString(const QString & szVersion);
+
+	/**
+	* \brief Computes the hex digest of the UTF-8 representation of szData
+	* With SSL support any digest known to OpenSSL can be used, otherwise
+	* only MD4, MD5 and SHA1 are available. An empty szAlgorithm means MD5.
+	* This function can be called outside of the GUI thread.
+	* \param szData The data to hash
+	* \param szAlgorithm The name of the digest algorithm
+	* \param szResult The string where to store the digest
+	* \return KviError::Code
+	*/
+	extern KVILIB_API KviError::Code digest(const QString & szData, const QString & szAlgorithm, QString & szResult);
 }
 
 #endif // _KVI_MISCUTILS_H_
@@ -23,8 +23,10 @@
 //=============================================================================
 
 #include "KviSharedFile.h"
+#include "KviQString.h"
 
 KviSharedFile::KviSharedFile(const QString & szName, const QString & szAbsPath, const QString & szUserMask, time_t expireTime, unsigned int uFileSize)
+    : m_parsedUserMask(szUserMask)
 {
 	m_szName = szName;
 	m_szAbsFilePath = szAbsPath;
@@ -34,6 +36,9 @@ KviSharedFile::KviSharedFile(const QString & szName, const QString & szAbsPath,
 
 	m_uWildCount = m_szUserMask.count('*');
 	m_uNonWildCount = m_szUserMask.length() - m_uWildCount;
+
+	m_bMatchesEverybody = KviQString::equalCS(m_szUserMask, "*!*@*");
+	m_iExpiryHeapIndex = -1;
 }
 
 KviSharedFile::~KviSharedFile()
@@ -28,6 +28,7 @@
 
 #include "kvi_settings.h"
 #include "KviHeapObject.h"
+#include "KviIrcMask.h"
 #include "KviPointerList.h"
 
 #include <QString>
@@ -36,6 +37,8 @@
 
 class KVILIB_API KviSharedFile : public KviHeapObject
 {
+	friend class KviSharedFilesManager;
+
 public:
 	KviSharedFile(const QString & szName, const QString & szAbsPath, const QString & szUserMask, time_t expireTime, unsigned int uFileSize);
 	~KviSharedFile();
@@ -48,6 +51,11 @@ private:
 	unsigned int m_uFileSize;
 	unsigned int m_uWildCount;
 	unsigned int m_uNonWildCount;
+	// the user mask parsed only once: it's matched on every lookup
+	KviIrcMask m_parsedUserMask;
+	bool m_bMatchesEverybody;
+	// position in the expiry heap of KviSharedFilesManager, -1 if not there
+	int m_iExpiryHeapIndex;
 
 public:
 	const QString & name() { return m_szName; };
@@ -55,6 +63,9 @@ public:
 	const QString & absFilePath() { return m_szAbsFilePath; };
 
 	const QString & userMask() { return m_szUserMask; };
+	const KviIrcMask & parsedUserMask() { return m_parsedUserMask; };
+	// true if the user mask is exactly *!*@*
+	bool matchesEverybody() { return m_bMatchesEverybody; };
 
 	time_t expireTime() { return m_expireTime; };
 	bool expires() { return (m_expireTime != 0); };
@@ -77,12 +77,16 @@
 		Please don't send complaints if someone steals your /etc/passwd : it is because you have permitted that.[br]
 */
 
+// Longer intervals are split: the cleanup reschedules itself
+#define KVI_SHARED_FILES_MAX_CLEANUP_DELAY_MSECS 3600000
+
 KviSharedFilesManager::KviSharedFilesManager()
     : QObject()
 {
 	m_pSharedListDict = new KviPointerHashTable<QString, KviSharedFileList>();
 	m_pSharedListDict->setAutoDelete(true);
 	m_pCleanupTimer = new QTimer();
+	m_pCleanupTimer->setSingleShot(true);
 	connect(m_pCleanupTimer, SIGNAL(timeout()), this, SLOT(cleanup()));
 }
 
@@ -94,58 +98,153 @@ KviSharedFilesManager::~KviSharedFilesManager()
 	delete m_pSharedListDict;
 }
 
-void KviSharedFilesManager::cleanup()
+void KviSharedFilesManager::expiryHeapSwap(int iIdx1, int iIdx2)
 {
-	KviPointerHashTableIterator<QString, KviSharedFileList> it(*m_pSharedListDict);
-	time_t curTime = time(nullptr);
+	KviSharedFile * pTmp = m_vExpiryHeap[iIdx1];
+	m_vExpiryHeap[iIdx1] = m_vExpiryHeap[iIdx2];
+	m_vExpiryHeap[iIdx2] = pTmp;
+	m_vExpiryHeap[iIdx1]->m_iExpiryHeapIndex = iIdx1;
+	m_vExpiryHeap[iIdx2]->m_iExpiryHeapIndex = iIdx2;
+}
+
+void KviSharedFilesManager::expiryHeapSiftUp(int iIdx)
+{
+	while(iIdx > 0)
+	{
+		int iParent = (iIdx - 1) / 2;
+		if(m_vExpiryHeap[iParent]->expireTime() <= m_vExpiryHeap[iIdx]->expireTime())
+			return;
+		expiryHeapSwap(iIdx, iParent);
+		iIdx = iParent;
+	}
+}
+
+void KviSharedFilesManager::expiryHeapSiftDown(int iIdx)
+{
+	int iCount = (int)m_vExpiryHeap.size();
+	for(;;)
+	{
+		int iSmallest = iIdx;
+		int iLeft = (2 * iIdx) + 1;
+		int iRight = iLeft + 1;
+		if((iLeft < iCount) && (m_vExpiryHeap[iLeft]->expireTime() < m_vExpiryHeap[iSmallest]->expireTime()))
+			iSmallest = iLeft;
+		if((iRight < iCount) && (m_vExpiryHeap[iRight]->expireTime() < m_vExpiryHeap[iSmallest]->expireTime()))
+			iSmallest = iRight;
+		if(iSmallest == iIdx)
+			return;
+		expiryHeapSwap(iIdx, iSmallest);
+		iIdx = iSmallest;
+	}
+}
+
+void KviSharedFilesManager::expiryHeapPush(KviSharedFile * o)
+{
+	o->m_iExpiryHeapIndex = (int)m_vExpiryHeap.size();
+	m_vExpiryHeap.push_back(o);
+	expiryHeapSiftUp(o->m_iExpiryHeapIndex);
+}
+
+void KviSharedFilesManager::expiryHeapRemove(KviSharedFile * o)
+{
+	int iIdx = o->m_iExpiryHeapIndex;
+	if(iIdx < 0)
+		return;
+	o->m_iExpiryHeapIndex = -1;
+
+	int iLast = (int)m_vExpiryHeap.size() - 1;
+	if(iIdx != iLast)
+	{
+		// move the last file in the hole and restore the heap order around it
+		KviSharedFile * pMoved = m_vExpiryHeap[iLast];
+		m_vExpiryHeap[iIdx] = pMoved;
+		pMoved->m_iExpiryHeapIndex = iIdx;
+		m_vExpiryHeap.pop_back();
+		expiryHeapSiftUp(iIdx);
+		expiryHeapSiftDown(pMoved->m_iExpiryHeapIndex);
+	}
+	else
+	{
+		m_vExpiryHeap.pop_back();
+	}
+}
+
+void KviSharedFilesManager::scheduleCleanup()
+{
+	if(m_vExpiryHeap.empty())
+	{
+		if(m_pCleanupTimer->isActive())
+			m_pCleanupTimer->stop();
+		return;
+	}
 
-	bool bOtherStuffToCleanup = false;
+	time_t delay = m_vExpiryHeap.front()->expireTime() - time(nullptr);
+	int iMSecs = 0;
+	if(delay > 0)
+		iMSecs = (delay > (KVI_SHARED_FILES_MAX_CLEANUP_DELAY_MSECS / 1000)) ? KVI_SHARED_FILES_MAX_CLEANUP_DELAY_MSECS : (int)(delay * 1000);
+	m_pCleanupTimer->start(iMSecs);
+}
 
-	KviPointerList<QString> lDying;
-	lDying.setAutoDelete(true);
+void KviSharedFilesManager::cleanup()
+{
+	time_t curTime = time(nullptr);
 
-	while(KviSharedFileList * l = it.current())
+	// the heap top is always the first file to expire
+	while(!m_vExpiryHeap.empty() && (m_vExpiryHeap.front()->expireTime() <= curTime))
 	{
-		KviPointerList<KviSharedFile> tmp;
-		tmp.setAutoDelete(false);
-		for(KviSharedFile * o = l->first(); o; o = l->next())
+		KviSharedFile * o = m_vExpiryHeap.front();
+		KviSharedFileList * l = m_pSharedListDict->find(o->name());
+		if(l)
 		{
-			if(o->expireTime() > 0)
-			{
-				if(((int)o->expireTime()) <= ((int)curTime))
-				{
-					tmp.append(o);
-				}
-				else
-				{
-					bOtherStuffToCleanup = true;
-				}
-			}
+			dropSharedFile(l, o);
 		}
-		for(KviSharedFile * fo = tmp.first(); fo; fo = tmp.next())
+		else
 		{
-			l->removeRef(fo);
-			emit sharedFileRemoved(fo);
+			// should never happen
+			expiryHeapRemove(o);
 		}
-		if(l->count() == 0)
-			lDying.append(new QString(it.currentKey()));
-
-		++it;
 	}
 
-	for(QString * pDyingKey = lDying.first(); pDyingKey; pDyingKey = lDying.next())
-		m_pSharedListDict->remove(*pDyingKey);
-
-	if(!bOtherStuffToCleanup)
-		m_pCleanupTimer->stop();
+	scheduleCleanup();
 }
 
 void KviSharedFilesManager::clear()
 {
+	for(auto & o : m_vExpiryHeap)
+		o->m_iExpiryHeapIndex = -1;
+	m_vExpiryHeap.clear();
+	m_hSizeIndex.clear();
+	m_mNameIndex.clear();
+	m_hNameTrigramIndex.clear();
+	scheduleCleanup();
+
 	m_pSharedListDict->clear();
 	emit sharedFilesChanged();
 }
 
+void KviSharedFilesManager::addNameToIndex(const QString & szName)
+{
+	QString szLower = szName.toLower();
+	m_mNameIndex.insert(szLower, szName);
+	for(int i = 0; i + 3 <= szLower.length(); i++)
+		m_hNameTrigramIndex[szLower.mid(i, 3)].insert(szName);
+}
+
+void KviSharedFilesManager::removeNameFromIndex(const QString & szName)
+{
+	QString szLower = szName.toLower();
+	m_mNameIndex.remove(szLower, szName);
+	for(int i = 0; i + 3 <= szLower.length(); i++)
+	{
+		QHash<QString, QSet<QString>>::iterator it = m_hNameTrigramIndex.find(szLower.mid(i, 3));
+		if(it == m_hNameTrigramIndex.end())
+			continue; // the trigram was repeated in the name
+		it.value().remove(szName);
+		if(it.value().isEmpty())
+			m_hNameTrigramIndex.erase(it);
+	}
+}
+
 void KviSharedFilesManager::doInsert(KviSharedFileList * l, KviSharedFile * o)
 {
 	int index = 0;
@@ -203,26 +302,52 @@ void KviSharedFilesManager::doInsert(KviSharedFileList * l, KviSharedFile * o)
 	l->append(o);
 }
 
-void KviSharedFilesManager::addSharedFile(KviSharedFile * f)
+void KviSharedFilesManager::insertSharedFile(KviSharedFile * o)
 {
 	// First find the list
-	KviSharedFileList * l = m_pSharedListDict->find(f->name());
+	KviSharedFileList * l = m_pSharedListDict->find(o->name());
 	if(!l)
 	{
 		l = new KviSharedFileList;
 		l->setAutoDelete(true);
-		m_pSharedListDict->replace(f->name(), l);
+		m_pSharedListDict->replace(o->name(), l);
+		addNameToIndex(o->name());
 	}
 
-	doInsert(l, f);
+	// Now insert
+	doInsert(l, o);
+
+	m_hSizeIndex.insert(o->fileSize(), o);
 
-	if(((int)f->expireTime()) > 0)
+	if(((int)o->expireTime()) > 0)
 	{
-		if(!m_pCleanupTimer->isActive())
-			m_pCleanupTimer->start(60000);
+		expiryHeapPush(o);
+		// reschedule only if the new file is the first one to expire
+		if(m_vExpiryHeap.front() == o)
+			scheduleCleanup();
 	}
 
-	emit sharedFileAdded(f);
+	emit sharedFileAdded(o);
+}
+
+void KviSharedFilesManager::dropSharedFile(KviSharedFileList * l, KviSharedFile * o)
+{
+	m_hSizeIndex.remove(o->fileSize(), o);
+	expiryHeapRemove(o);
+
+	QString szName = o->name(); // o is deleted by removeRef()
+	l->removeRef(o);
+	if(l->count() == 0)
+	{
+		removeNameFromIndex(szName);
+		m_pSharedListDict->remove(szName);
+	}
+	emit sharedFileRemoved(o);
+}
+
+void KviSharedFilesManager::addSharedFile(KviSharedFile * f)
+{
+	insertSharedFile(f);
 }
 
 KviSharedFile * KviSharedFilesManager::addSharedFile(const QString & szName, const QString & szAbsPath, const QString & szMask, int timeoutInSecs)
@@ -230,27 +355,9 @@ KviSharedFile * KviSharedFilesManager::addSharedFile(const QString & szName, con
 	QFileInfo inf(szAbsPath);
 	if(inf.exists() && inf.isFile() && inf.isReadable() && (inf.size() > 0))
 	{
-		// First find the list
-		KviSharedFileList * l = m_pSharedListDict->find(szName);
-		if(!l)
-		{
-			l = new KviSharedFileList;
-			l->setAutoDelete(true);
-			m_pSharedListDict->replace(szName, l);
-		}
-
-		// Now insert
 		KviSharedFile * o = new KviSharedFile(szName, szAbsPath, szMask, timeoutInSecs > 0 ? (((int)(time(nullptr))) + timeoutInSecs) : 0, inf.size());
 
-		doInsert(l, o);
-
-		if(((int)o->expireTime()) > 0)
-		{
-			if(!m_pCleanupTimer->isActive())
-				m_pCleanupTimer->start(60000);
-		}
-
-		emit sharedFileAdded(o);
+		insertSharedFile(o);
 
 		return o;
 	}
@@ -269,28 +376,16 @@ KviSharedFile * KviSharedFilesManager::lookupSharedFile(const QString & szName,
 
 	for(KviSharedFile * o = l->first(); o; o = l->next())
 	{
-		bool bMatch;
-		if(mask)
-		{
-			KviIrcMask umask(o->userMask());
-			bMatch = mask->matchedBy(umask);
-		}
-		else
-			bMatch = KviQString::equalCS(o->userMask(), "*!*@*");
-		if(bMatch)
-		{
-			if(uFileSize > 0)
-			{
-				if(uFileSize == o->fileSize())
-					return o;
-			}
-			else
-				return o;
-		}
+		// the size is cheaper to check than the mask
+		if((uFileSize > 0) && (uFileSize != o->fileSize()))
+			continue;
+		if(mask ? mask->matchedBy(o->parsedUserMask()) : o->matchesEverybody())
+			return o;
 	}
 
 	return nullptr;
 }
+
 bool KviSharedFilesManager::removeSharedFile(const QString & szName, const QString & szMask, unsigned int uFileSize)
 {
 	KviSharedFileList * l = m_pSharedListDict->find(szName);
@@ -303,11 +398,7 @@ bool KviSharedFilesManager::removeSharedFile(const QString & szName, const QStri
 			bool bMatch = uFileSize > 0 ? uFileSize == o->fileSize() : true;
 			if(bMatch)
 			{
-				QString save = szName; // <-- szName MAY Be a pointer to o->name()
-				l->removeRef(o);
-				if(l->count() == 0)
-					m_pSharedListDict->remove(save);
-				emit sharedFileRemoved(o);
+				dropSharedFile(l, o);
 				return true;
 			}
 		}
@@ -324,17 +415,78 @@ bool KviSharedFilesManager::removeSharedFile(const QString & szName, KviSharedFi
 	{
 		if(off == o)
 		{
-			QString save = szName; // <-- szName MAY Be a pointer to o->name()
-			l->removeRef(o);
-			if(l->count() == 0)
-				m_pSharedListDict->remove(save);
-			emit sharedFileRemoved(off);
+			dropSharedFile(l, o);
 			return true;
 		}
 	}
 	return false;
 }
 
+void KviSharedFilesManager::appendFilesWithName(const QString & szName, KviPointerList<KviSharedFile> * pList)
+{
+	KviSharedFileList * l = m_pSharedListDict->find(szName);
+	if(!l)
+		return;
+	for(KviSharedFile * o = l->first(); o; o = l->next())
+		pList->append(o);
+}
+
+void KviSharedFilesManager::findSharedFilesBySize(unsigned int uFileSize, KviPointerList<KviSharedFile> * pList)
+{
+	QMultiHash<unsigned int, KviSharedFile *>::const_iterator it = m_hSizeIndex.constFind(uFileSize);
+	while((it != m_hSizeIndex.constEnd()) && (it.key() == uFileSize))
+	{
+		pList->append(it.value());
+		++it;
+	}
+}
+
+void KviSharedFilesManager::findSharedFilesByNamePrefix(const QString & szPrefix, KviPointerList<KviSharedFile> * pList)
+{
+	QString szLower = szPrefix.toLower();
+	// the names are sorted: the ones with the prefix are all together
+	QMultiMap<QString, QString>::const_iterator it = m_mNameIndex.lowerBound(szLower);
+	while((it != m_mNameIndex.constEnd()) && it.key().startsWith(szLower))
+	{
+		appendFilesWithName(it.value(), pList);
+		++it;
+	}
+}
+
+void KviSharedFilesManager::findSharedFilesByNameSubstring(const QString & szText, KviPointerList<KviSharedFile> * pList)
+{
+	QString szLower = szText.toLower();
+
+	if(szLower.length() < 3)
+	{
+		// too short to have a trigram: look at all the names
+		for(QMultiMap<QString, QString>::const_iterator it = m_mNameIndex.constBegin(); it != m_mNameIndex.constEnd(); ++it)
+		{
+			if(it.key().contains(szLower))
+				appendFilesWithName(it.value(), pList);
+		}
+		return;
+	}
+
+	// every matching name contains all the trigrams of the text:
+	// check the candidates of the rarest one
+	const QSet<QString> * pCandidates = nullptr;
+	for(int i = 0; i + 3 <= szLower.length(); i++)
+	{
+		QHash<QString, QSet<QString>>::const_iterator it = m_hNameTrigramIndex.constFind(szLower.mid(i, 3));
+		if(it == m_hNameTrigramIndex.constEnd())
+			return; // no name has this trigram
+		if(!pCandidates || (it.value().count() < pCandidates->count()))
+			pCandidates = &(it.value());
+	}
+
+	for(const auto & szName : *pCandidates)
+	{
+		if(szName.toLower().contains(szLower))
+			appendFilesWithName(szName, pList);
+	}
+}
+
 void KviSharedFilesManager::load(const QString & szFilename)
 {
 	KviConfigurationFile cfg(szFilename, KviConfigurationFile::Read);
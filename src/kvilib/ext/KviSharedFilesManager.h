@@ -28,7 +28,12 @@
 #include "KviPointerHashTable.h"
 #include "KviSharedFile.h"
 
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QSet>
+
+#include <vector>
 
 class KviIrcMask;
 class QString;
@@ -44,6 +49,13 @@ public:
 private:
 	QTimer * m_pCleanupTimer;
 	KviPointerHashTable<QString, KviSharedFileList> * m_pSharedListDict;
+	// secondary indexes: the files by size and the visible names by their lowercase form
+	// (sorted, for the prefix searches) and by the trigrams of it (for the substring searches)
+	QMultiHash<unsigned int, KviSharedFile *> m_hSizeIndex;
+	QMultiMap<QString, QString> m_mNameIndex;
+	QHash<QString, QSet<QString>> m_hNameTrigramIndex;
+	// the expiring files, as a binary heap ordered by expire time
+	std::vector<KviSharedFile *> m_vExpiryHeap;
 
 public:
 	void addSharedFile(KviSharedFile * f);
@@ -55,8 +67,23 @@ public:
 	void save(const QString & filename);
 	void clear();
 	KviPointerHashTable<QString, KviSharedFileList> * sharedFileListDict() { return m_pSharedListDict; };
+	// the lookups below append the matching files to pList (that must not delete them)
+	void findSharedFilesBySize(unsigned int uFileSize, KviPointerList<KviSharedFile> * pList);
+	void findSharedFilesByNamePrefix(const QString & szPrefix, KviPointerList<KviSharedFile> * pList);
+	void findSharedFilesByNameSubstring(const QString & szText, KviPointerList<KviSharedFile> * pList);
 private:
 	void doInsert(KviSharedFileList * l, KviSharedFile * o);
+	void insertSharedFile(KviSharedFile * o);
+	void dropSharedFile(KviSharedFileList * l, KviSharedFile * o);
+	void addNameToIndex(const QString & szName);
+	void removeNameFromIndex(const QString & szName);
+	void appendFilesWithName(const QString & szName, KviPointerList<KviSharedFile> * pList);
+	void expiryHeapPush(KviSharedFile * o);
+	void expiryHeapRemove(KviSharedFile * o);
+	void expiryHeapSiftUp(int iIdx);
+	void expiryHeapSiftDown(int iIdx);
+	void expiryHeapSwap(int iIdx1, int iIdx2);
+	void scheduleCleanup();
 private slots:
 	void cleanup();
 signals:
@@ -29,6 +29,7 @@
 #include "KviFile.h"
 #include "KviMemory.h"
 
+#include <QByteArray>
 #include <QDir>
 #include <QFileInfo>
 #include <QString>
@@ -348,19 +349,108 @@ namespace KviFileUtils
 		for(int i = 0; i < iStartLine; i++)
 			stream.readLine();
 
-		if(iCount > 0)
+		if(iCount <= 0)
+			iCount = -1;
+
+		while(iCount != 0)
+		{
+			QString szLine = stream.readLine();
+			if(szLine.isNull())
+				break; // EOF (atEnd() is unreliable on files in /proc)
+			buffer.append(szLine);
+			if(iCount > 0)
+				iCount--;
+		}
+		return buffer.count() != 0;
+	}
+
+	KviError::Code readLines(const QString & szPath, QStringList & buffer, int iStartLine, int iCount, bool bUtf8)
+	{
+		QFile f(szPath);
+		if(!f.open(QIODevice::ReadOnly))
+			return KviError::CantOpenFileForReading;
+		readLines(&f, buffer, iStartLine, iCount, bUtf8);
+		return KviError::Success;
+	}
+
+	KviError::Code readFileData(const QString & szPath, QByteArray & oData, unsigned int uMaxSize)
+	{
+		QFile f(szPath);
+		if(!f.open(QIODevice::ReadOnly))
+			return KviError::CantOpenFileForReading;
+
+		oData.resize(uMaxSize);
+		unsigned int uRead = 0;
+		unsigned int uRetries = 0;
+
+		while((uRead < uMaxSize) && (!f.atEnd()))
 		{
-			for(; (iCount > 0 && !stream.atEnd()); iCount--)
-				buffer.append(stream.readLine());
+			// have been unable to read the requested size in 1000 retries
+			if(uRetries > 1000)
+				return KviError::FileIOError;
+
+			qint64 iReadNow = f.read(oData.data() + uRead, uMaxSize - uRead);
+			if(iReadNow < 0)
+				return KviError::FileIOError;
+
+			uRead += iReadNow;
+			uRetries++;
+		}
+
+		oData.resize(uRead);
+		return KviError::Success;
+	}
+
+	KviError::Code listDirectory(const QString & szPath, QStringList & lEntries, const QString & szFlags, const QString & szNameFilter)
+	{
+		QDir d(szPath);
+		if(!d.exists())
+			return KviError::NoSuchFile;
+
+		QDir::Filters iFlags = QDir::NoFilter;
+		QDir::SortFlags iSort = QDir::NoSort;
+		if(szFlags.isEmpty())
+		{
+			iFlags = QDir::Dirs | QDir::Files | QDir::NoSymLinks | QDir::Readable | QDir::Writable | QDir::Executable | QDir::Hidden | QDir::System;
+			iSort = QDir::Unsorted;
 		}
 		else
 		{
-			while(!stream.atEnd())
-			{
-				buffer.append(stream.readLine());
-			}
+			if(szFlags.indexOf('d', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::Dirs;
+			if(szFlags.indexOf('f', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::Files;
+			if(szFlags.indexOf('l', 0, Qt::CaseInsensitive) == -1)
+				iFlags |= QDir::NoSymLinks;
+			if(szFlags.indexOf('r', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::Readable;
+			if(szFlags.indexOf('w', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::Writable;
+			if(szFlags.indexOf('x', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::Executable;
+			if(szFlags.indexOf('h', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::Hidden;
+			if(szFlags.indexOf('s', 0, Qt::CaseInsensitive) != -1)
+				iFlags |= QDir::System;
+			if(szFlags.indexOf('n', 0, Qt::CaseInsensitive) != -1)
+				iSort |= QDir::Name;
+			if(szFlags.indexOf('t', 0, Qt::CaseInsensitive) != -1)
+				iSort |= QDir::Time;
+			if(szFlags.indexOf('b', 0, Qt::CaseInsensitive) != -1)
+				iSort |= QDir::Size;
+			if(szFlags.indexOf('z', 0, Qt::CaseInsensitive) != -1)
+				iSort |= QDir::DirsFirst;
+			if(szFlags.indexOf('k', 0, Qt::CaseInsensitive) != -1)
+				iSort |= QDir::Reversed;
+			if(szFlags.indexOf('i', 0, Qt::CaseInsensitive) != -1)
+				iSort |= QDir::IgnoreCase;
 		}
-		return buffer.count() != 0;
+
+		if(szNameFilter.isEmpty())
+			lEntries = d.entryList(iFlags, iSort);
+		else
+			lEntries = d.entryList(QStringList(szNameFilter), iFlags, iSort);
+		return KviError::Success;
 	}
 
 	bool directoryExists(const QString & szPath)
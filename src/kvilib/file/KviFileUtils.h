@@ -34,6 +34,7 @@
 */
 
 #include "kvi_settings.h"
+#include "KviError.h"
 
 #include <QFile>
 
@@ -278,6 +279,46 @@ namespace KviFileUtils
 	*/
 	KVILIB_API bool readLines(QFile * pFile, QStringList & buffer, int iStartLine = 0, int iCount = -1, bool bUtf8 = true);
 
+	/**
+	* \brief Reads text lines from the file at szPath
+	*
+	* A non positive iCount reads up to the end of the file.
+	* This function can be called outside of the GUI thread.
+	* \param szPath The path to the file
+	* \param buffer The buffer where to store the lines read
+	* \param iStartLine The number of the first line to read
+	* \param iCount The number of lines to read
+	* \param bUtf8 If we want to convert from UTF-8
+	* \return KviError::Code
+	*/
+	KVILIB_API KviError::Code readLines(const QString & szPath, QStringList & buffer, int iStartLine = 0, int iCount = -1, bool bUtf8 = true);
+
+	/**
+	* \brief Reads at most uMaxSize bytes from the beginning of the file at szPath
+	*
+	* Unlike readFile() the file may be larger than uMaxSize.
+	* This function can be called outside of the GUI thread.
+	* \param szPath The path to the file
+	* \param oData The buffer where to store the data read
+	* \param uMaxSize The maximum number of bytes to read
+	* \return KviError::Code
+	*/
+	KVILIB_API KviError::Code readFileData(const QString & szPath, QByteArray & oData, unsigned int uMaxSize);
+
+	/**
+	* \brief Lists the entries of the directory at szPath
+	*
+	* szFlags is a combination of the $file.ls() flag characters: an empty
+	* string lists everything but the symbolic links, unsorted.
+	* This function can be called outside of the GUI thread.
+	* \param szPath The path to the directory
+	* \param lEntries The list where to store the entry names
+	* \param szFlags The filter and sort flags
+	* \param szNameFilter An optional wildcard the entries must match
+	* \return KviError::Code
+	*/
+	KVILIB_API KviError::Code listDirectory(const QString & szPath, QStringList & lEntries, const QString & szFlags, const QString & szNameFilter);
+
 	/**
 	* \brief Returns true if the file is readable, false otherwise
 	* \param szFname The source file
@@ -34,6 +34,232 @@
 #include <QLayout>
 #include <QMessageBox>
 #include <QCheckBox>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QVector>
+
+//
+// Binary snapshot of the server database
+//
+// header | string entries | list items | nickserv rules | networks | servers | string data
+//
+// All the records are made of 32 bit fields and refer to strings by their index
+// in the string table (KVI_SERVERDB_SNAPSHOT_NO_STRING for a null string).
+// A list (auto join channels, rules, servers) is a range [first,first+count) in its array.
+// The string data is UTF-16: the strings are materialized only when referenced
+// and each one only once, so the duplicates (encodings, ports, domains...) are shared.
+//
+
+#define KVI_SERVERDB_SNAPSHOT_MAGIC 0x42445653 // "SVDB"
+#define KVI_SERVERDB_SNAPSHOT_VERSION 1
+#define KVI_SERVERDB_SNAPSHOT_NO_STRING 0xffffffff
+#define KVI_SERVERDB_SNAPSHOT_NO_SERVER 0xffffffff
+
+#define KVI_SERVERDB_SNAPSHOT_NETWORK_AUTOCONNECT 1
+#define KVI_SERVERDB_SNAPSHOT_NETWORK_NICKSERV 2
+#define KVI_SERVERDB_SNAPSHOT_NETWORK_NICKSERV_ENABLED 4
+
+#define KVI_SERVERDB_SNAPSHOT_SERVER_AUTOCONNECT 1
+#define KVI_SERVERDB_SNAPSHOT_SERVER_IPV6 2
+#define KVI_SERVERDB_SNAPSHOT_SERVER_CACHEIP 4
+#define KVI_SERVERDB_SNAPSHOT_SERVER_SSL 8
+#define KVI_SERVERDB_SNAPSHOT_SERVER_CAP 16
+#define KVI_SERVERDB_SNAPSHOT_SERVER_STARTTLS 32
+#define KVI_SERVERDB_SNAPSHOT_SERVER_SASL 64
+#define KVI_SERVERDB_SNAPSHOT_SERVER_FAVORITE 128
+
+struct KviIrcServerDataBaseSnapshotHeader
+{
+	quint32 uMagic;
+	quint32 uVersion;
+	qint64 iSourceSize;             // size of the text file this snapshot was made from
+	qint64 iSourceModificationTime; // msecs since epoch
+	quint32 uStringCount;
+	quint32 uListItemCount;
+	quint32 uRuleCount;
+	quint32 uNetworkCount;
+	quint32 uServerCount;
+	quint32 uCurrentNetwork;
+	quint64 uStringDataLength; // in QChars
+};
+
+struct KviIrcServerDataBaseSnapshotString
+{
+	quint32 uOffset; // in QChars, from the beginning of the string data
+	quint32 uLength;
+};
+
+struct KviIrcServerDataBaseSnapshotRule
+{
+	quint32 uRegisteredNick;
+	quint32 uNickServMask;
+	quint32 uMessageRegexp;
+	quint32 uIdentifyCommand;
+	quint32 uServerMask;
+};
+
+struct KviIrcServerDataBaseSnapshotNetwork
+{
+	quint32 uName;
+	quint32 uDescription;
+	quint32 uEncoding;
+	quint32 uTextEncoding;
+	quint32 uNickName;
+	quint32 uAlternativeNickName;
+	quint32 uUserName;
+	quint32 uRealName;
+	quint32 uPass;
+	quint32 uOnConnectCommand;
+	quint32 uOnLoginCommand;
+	quint32 uUserIdentityId;
+	quint32 uFirstChannel;
+	quint32 uChannelCount;
+	quint32 uFirstRule;
+	quint32 uRuleCount;
+	quint32 uFirstServer;
+	quint32 uServerCount;
+	quint32 uCurrentServer; // relative to uFirstServer
+	quint32 uFlags;
+};
+
+struct KviIrcServerDataBaseSnapshotServer
+{
+	quint32 uHostName;
+	quint32 uIp;
+	quint32 uDescription;
+	quint32 uUserName;
+	quint32 uPass;
+	quint32 uNickName;
+	quint32 uAlternativeNickName;
+	quint32 uSaslPass;
+	quint32 uSaslNick;
+	quint32 uSaslMethod;
+	quint32 uRealName;
+	quint32 uInitUMode;
+	quint32 uEncoding;
+	quint32 uTextEncoding;
+	quint32 uOnConnectCommand;
+	quint32 uOnLoginCommand;
+	quint32 uLinkFilter;
+	quint32 uId;
+	quint32 uUserIdentityId;
+	quint32 uFirstChannel;
+	quint32 uChannelCount;
+	quint32 uPort;
+	qint32 iProxy;
+	quint32 uFlags;
+};
+
+class KviIrcServerDataBaseSnapshotWriter
+{
+public:
+	QVector<KviIrcServerDataBaseSnapshotString> m_Strings;
+	QVector<quint32> m_ListItems;
+	QVector<KviIrcServerDataBaseSnapshotRule> m_Rules;
+	QVector<KviIrcServerDataBaseSnapshotNetwork> m_Networks;
+	QVector<KviIrcServerDataBaseSnapshotServer> m_Servers;
+	QString m_szStringData;
+
+protected:
+	QHash<QString, quint32> m_hStringIndex;
+
+public:
+	quint32 string(const QString & szString)
+	{
+		if(szString.isNull())
+			return KVI_SERVERDB_SNAPSHOT_NO_STRING;
+		QHash<QString, quint32>::const_iterator it = m_hStringIndex.constFind(szString);
+		if(it != m_hStringIndex.constEnd())
+			return it.value();
+		KviIrcServerDataBaseSnapshotString e;
+		e.uOffset = m_szStringData.length();
+		e.uLength = szString.length();
+		m_szStringData.append(szString);
+		quint32 uIndex = m_Strings.count();
+		m_Strings.append(e);
+		m_hStringIndex.insert(szString, uIndex);
+		return uIndex;
+	}
+
+	void list(QStringList * pList, quint32 & uFirst, quint32 & uCount)
+	{
+		uFirst = m_ListItems.count();
+		uCount = pList ? pList->count() : 0;
+		if(!pList)
+			return;
+		for(auto & szItem : *pList)
+			m_ListItems.append(string(szItem));
+	}
+};
+
+class KviIrcServerDataBaseSnapshotReader
+{
+public:
+	KviIrcServerDataBaseSnapshotReader(const KviIrcServerDataBaseSnapshotHeader * pHeader, const uchar * pData)
+	    : m_pHeader(pHeader), m_Cache(pHeader->uStringCount)
+	{
+		m_pStrings = (const KviIrcServerDataBaseSnapshotString *)pData;
+		pData += sizeof(KviIrcServerDataBaseSnapshotString) * pHeader->uStringCount;
+		m_pListItems = (const quint32 *)pData;
+		pData += sizeof(quint32) * pHeader->uListItemCount;
+		m_pRules = (const KviIrcServerDataBaseSnapshotRule *)pData;
+		pData += sizeof(KviIrcServerDataBaseSnapshotRule) * pHeader->uRuleCount;
+		m_pNetworks = (const KviIrcServerDataBaseSnapshotNetwork *)pData;
+		pData += sizeof(KviIrcServerDataBaseSnapshotNetwork) * pHeader->uNetworkCount;
+		m_pServers = (const KviIrcServerDataBaseSnapshotServer *)pData;
+		pData += sizeof(KviIrcServerDataBaseSnapshotServer) * pHeader->uServerCount;
+		m_pStringData = (const QChar *)pData;
+	}
+
+	static qint64 dataSize(const KviIrcServerDataBaseSnapshotHeader * pHeader)
+	{
+		return sizeof(KviIrcServerDataBaseSnapshotString) * (qint64)pHeader->uStringCount
+		    + sizeof(quint32) * (qint64)pHeader->uListItemCount
+		    + sizeof(KviIrcServerDataBaseSnapshotRule) * (qint64)pHeader->uRuleCount
+		    + sizeof(KviIrcServerDataBaseSnapshotNetwork) * (qint64)pHeader->uNetworkCount
+		    + sizeof(KviIrcServerDataBaseSnapshotServer) * (qint64)pHeader->uServerCount
+		    + sizeof(QChar) * (qint64)pHeader->uStringDataLength;
+	}
+
+	const KviIrcServerDataBaseSnapshotHeader * m_pHeader;
+	const KviIrcServerDataBaseSnapshotString * m_pStrings;
+	const quint32 * m_pListItems;
+	const KviIrcServerDataBaseSnapshotRule * m_pRules;
+	const KviIrcServerDataBaseSnapshotNetwork * m_pNetworks;
+	const KviIrcServerDataBaseSnapshotServer * m_pServers;
+	const QChar * m_pStringData;
+
+protected:
+	QVector<QString> m_Cache; // materialized strings (null until referenced)
+
+public:
+	QString string(quint32 uIndex)
+	{
+		if(uIndex >= m_pHeader->uStringCount)
+			return QString();
+		QString & szCached = m_Cache[uIndex];
+		if(szCached.isNull())
+		{
+			const KviIrcServerDataBaseSnapshotString & e = m_pStrings[uIndex];
+			if(((quint64)e.uOffset + e.uLength) > m_pHeader->uStringDataLength)
+				return QString();
+			szCached = e.uLength ? QString(m_pStringData + e.uOffset, e.uLength) : QString(""); // "" is not null
+		}
+		return szCached;
+	}
+
+	QStringList * list(quint32 uFirst, quint32 uCount)
+	{
+		if((uCount == 0) || (((quint64)uFirst + uCount) > m_pHeader->uListItemCount))
+			return nullptr;
+		QStringList * pList = new QStringList();
+		for(quint32 u = uFirst; u < uFirst + uCount; u++)
+			pList->append(string(m_pListItems[u]));
+		return pList;
+	}
+};
 
 KviIrcServerDataBase::KviIrcServerDataBase()
 {
@@ -74,11 +300,88 @@ void KviIrcServerDataBase::clear()
 {
 	m_pRecords->clear();
 	m_szCurrentNetwork = "";
+	m_bServerIndexValid = false;
 }
 
 void KviIrcServerDataBase::addNetwork(KviIrcNetwork * pNet)
 {
 	m_pRecords->replace(pNet->name(), pNet);
+	m_bServerIndexValid = false;
+}
+
+void KviIrcServerDataBase::rebuildServerIndex()
+{
+	m_hNetworksByServerHostName.clear();
+	m_hNetworksByServerId.clear();
+
+	KviPointerHashTableIterator<QString, KviIrcNetwork> it(*m_pRecords);
+	while(KviIrcNetwork * pNet = it.current())
+	{
+		for(KviIrcServer * pServ = pNet->serverList()->first(); pServ; pServ = pNet->serverList()->next())
+		{
+			m_hNetworksByServerHostName.insert(pServ->hostName().toLower(), pNet->name());
+			if(!pServ->id().isEmpty())
+				m_hNetworksByServerId.insert(pServ->id().toLower(), pNet->name());
+		}
+		++it;
+	}
+	m_bServerIndexValid = true;
+}
+
+static bool server_matches_definition(KviIrcServer * pServ, KviIrcServerDefinition * pDef)
+{
+	if(!KviQString::equalCI(pServ->hostName(), pDef->szServer))
+		return false;
+	if(!(pDef->szId.isEmpty() || KviQString::equalCI(pServ->id(), pDef->szId)))
+		return false;
+	if(pDef->bIPv6 != pServ->isIPv6())
+		return false;
+	if(pDef->bSSL != pServ->useSSL())
+		return false;
+	// must match the port if specified
+	if(pDef->bPortIsValid && (pDef->uPort != pServ->port()))
+		return false;
+	// must match the link filter if specified
+	if(!pDef->szLinkFilter.isEmpty() && !KviQString::equalCI(pDef->szLinkFilter, pServ->linkFilter()))
+		return false;
+	return true;
+}
+
+KviIrcServer * KviIrcServerDataBase::findServer(KviIrcServerDefinition * pDef, const QString & szId, KviIrcNetwork ** ppNet)
+{
+	QString szKey = pDef ? pDef->szServer.toLower() : szId.toLower();
+	bool bRebuilt = false;
+
+	for(;;)
+	{
+		if(!m_bServerIndexValid)
+		{
+			rebuildServerIndex();
+			bRebuilt = true;
+		}
+
+		QList<QString> lNetworks = pDef ? m_hNetworksByServerHostName.values(szKey) : m_hNetworksByServerId.values(szKey);
+		for(auto & szNet : lNetworks)
+		{
+			KviIrcNetwork * pNet = m_pRecords->find(szNet);
+			if(!pNet)
+				continue;
+			for(KviIrcServer * pServ = pNet->serverList()->first(); pServ; pServ = pNet->serverList()->next())
+			{
+				if(pDef ? server_matches_definition(pServ, pDef) : KviQString::equalCI(pServ->id(), szId))
+				{
+					*ppNet = pNet;
+					return pServ;
+				}
+			}
+		}
+
+		if(bRebuilt)
+			return nullptr;
+
+		// the servers may have been changed since the index was built
+		m_bServerIndexValid = false;
+	}
 }
 
 KviIrcNetwork * KviIrcServerDataBase::findNetwork(const QString & szName)
@@ -147,10 +450,7 @@ bool KviIrcServerDataBase::makeCurrentBestServerInNetwork(const QString & szNetN
 bool KviIrcServerDataBase::makeCurrentServer(KviIrcServerDefinition * pDef, QString & szError)
 {
 	KviIrcServer * pServer = nullptr;
-
-	KviPointerHashTableIterator<QString, KviIrcNetwork> it(*m_pRecords);
 	KviIrcNetwork * pNet = nullptr;
-	KviIrcServer * pServ;
 
 	if(KviQString::equalCIN(pDef->szServer, "net:", 4))
 	{
@@ -170,90 +470,18 @@ bool KviIrcServerDataBase::makeCurrentServer(KviIrcServerDefinition * pDef, QStr
 		QString szId = pDef->szServer;
 		szId.remove(0, 3);
 
-		while((pNet = it.current()))
+		pServer = findServer(nullptr, szId, &pNet);
+		if(!pServer)
 		{
-			for(pServ = pNet->serverList()->first(); pServ && (!pServer); pServ = pNet->serverList()->next())
-			{
-				if(KviQString::equalCI(pServ->id(), szId))
-				{
-					pServer = pServ;
-					goto search_finished;
-				}
-			}
-			++it;
+			szError = __tr2qs("The server specification seems to be in the id:<string> form but the identifier couldn't be found in the database");
+			return false;
 		}
-		szError = __tr2qs("The server specification seems to be in the id:<string> form but the identifier couldn't be found in the database");
-		return false;
 	}
-
-	it.toFirst();
-
-	while((pNet = it.current()))
+	else
 	{
-		for(pServ = pNet->serverList()->first(); pServ && (!pServer); pServ = pNet->serverList()->next())
-		{
-			if(KviQString::equalCI(pServ->hostName(), pDef->szServer))
-			{
-				if(pDef->szId.isEmpty() || KviQString::equalCI(pServ->id(), pDef->szId))
-				{
-					if(pDef->bIPv6 == pServ->isIPv6())
-					{
-						if(pDef->bSSL == pServ->useSSL())
-						{
-							if(pDef->bPortIsValid)
-							{
-								// must match the port
-								if(pDef->uPort == pServ->port())
-								{
-									// port matches
-									if(!pDef->szLinkFilter.isEmpty())
-									{
-										// must match the link filter
-										if(KviQString::equalCI(pDef->szLinkFilter, pServ->linkFilter()))
-										{
-											// link filter matches
-											pServer = pServ;
-											goto search_finished;
-										} // else link filter doesn't match
-									}
-									else
-									{
-										// no need to match the link filter
-										pServer = pServ;
-										goto search_finished;
-									}
-								} // else port doesn't match
-							}
-							else
-							{
-								// no need to match the port
-								if(!pDef->szLinkFilter.isEmpty())
-								{
-									// must match the link filter
-									if(KviQString::equalCI(pDef->szLinkFilter, pServ->linkFilter()))
-									{
-										// link filter matches
-										pServer = pServ;
-										goto search_finished;
-									} // else link filter doesn't match
-								}
-								else
-								{
-									// no need to match the link filter
-									pServer = pServ;
-									goto search_finished;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
-		++it;
+		pServer = findServer(pDef, QString(), &pNet);
 	}
 
-search_finished:
-
 	if(pNet && pServer)
 	{
 		m_szCurrentNetwork = pNet->name();
@@ -453,9 +681,300 @@ void KviIrcServerDataBase::importFromMircIni(const QString & szFilename, const Q
 	}
 }
 
+QString KviIrcServerDataBase::snapshotFileName(const QString & szFilename)
+{
+	return szFilename + QString(".snapshot");
+}
+
+void KviIrcServerDataBase::addAutoConnectNetwork(KviIrcNetwork * pNet)
+{
+	if(!m_pAutoConnectOnStartupNetworks)
+	{
+		m_pAutoConnectOnStartupNetworks = new KviPointerList<KviIrcNetwork>;
+		m_pAutoConnectOnStartupNetworks->setAutoDelete(false);
+	}
+	m_pAutoConnectOnStartupNetworks->append(pNet);
+}
+
+void KviIrcServerDataBase::addAutoConnectServer(KviIrcServer * pServ)
+{
+	if(!m_pAutoConnectOnStartupServers)
+	{
+		m_pAutoConnectOnStartupServers = new KviPointerList<KviIrcServer>;
+		m_pAutoConnectOnStartupServers->setAutoDelete(false);
+	}
+	m_pAutoConnectOnStartupServers->append(pServ);
+}
+
 void KviIrcServerDataBase::load(const QString & szFilename)
 {
 	clear();
+	if(loadSnapshot(szFilename))
+		return;
+
+	// the snapshot is missing or stale
+	loadText(szFilename);
+	saveSnapshot(szFilename);
+}
+
+bool KviIrcServerDataBase::loadSnapshot(const QString & szFilename)
+{
+	QFileInfo inf(szFilename);
+	if(!inf.exists())
+		return false;
+
+	QFile f(snapshotFileName(szFilename));
+	if(!f.open(QFile::ReadOnly))
+		return false;
+
+	qint64 iSize = f.size();
+	if(iSize < (qint64)sizeof(KviIrcServerDataBaseSnapshotHeader))
+		return false;
+
+	const uchar * pData = f.map(0, iSize);
+	if(!pData)
+		return false;
+
+	const KviIrcServerDataBaseSnapshotHeader * pHeader = (const KviIrcServerDataBaseSnapshotHeader *)pData;
+	if(
+	    (pHeader->uMagic != KVI_SERVERDB_SNAPSHOT_MAGIC) || (pHeader->uVersion != KVI_SERVERDB_SNAPSHOT_VERSION) || (pHeader->iSourceSize != inf.size()) || (pHeader->iSourceModificationTime != inf.lastModified().toMSecsSinceEpoch()) || ((qint64)sizeof(KviIrcServerDataBaseSnapshotHeader) + KviIrcServerDataBaseSnapshotReader::dataSize(pHeader) != iSize))
+	{
+		f.unmap((uchar *)pData);
+		return false;
+	}
+
+	KviIrcServerDataBaseSnapshotReader r(pHeader, pData + sizeof(KviIrcServerDataBaseSnapshotHeader));
+
+	for(quint32 n = 0; n < pHeader->uNetworkCount; n++)
+	{
+		const KviIrcServerDataBaseSnapshotNetwork & rn = r.m_pNetworks[n];
+		if(((quint64)rn.uFirstServer + rn.uServerCount > pHeader->uServerCount) || ((quint64)rn.uFirstRule + rn.uRuleCount > pHeader->uRuleCount))
+			break; // corrupted: what we have so far is still consistent
+
+		KviIrcNetwork * pNet = new KviIrcNetwork(r.string(rn.uName));
+		addNetwork(pNet);
+		pNet->m_szDescription = r.string(rn.uDescription);
+		pNet->m_szEncoding = r.string(rn.uEncoding);
+		pNet->m_szTextEncoding = r.string(rn.uTextEncoding);
+		pNet->m_szNickName = r.string(rn.uNickName);
+		pNet->m_szAlternativeNickName = r.string(rn.uAlternativeNickName);
+		pNet->m_szUserName = r.string(rn.uUserName);
+		pNet->m_szRealName = r.string(rn.uRealName);
+		pNet->m_szPass = r.string(rn.uPass);
+		pNet->m_szOnConnectCommand = r.string(rn.uOnConnectCommand);
+		pNet->m_szOnLoginCommand = r.string(rn.uOnLoginCommand);
+		pNet->m_szUserIdentityId = r.string(rn.uUserIdentityId);
+		pNet->m_bAutoConnect = rn.uFlags & KVI_SERVERDB_SNAPSHOT_NETWORK_AUTOCONNECT;
+		if(pNet->m_bAutoConnect)
+			addAutoConnectNetwork(pNet);
+
+		QStringList * pChannels = r.list(rn.uFirstChannel, rn.uChannelCount);
+		if(pChannels)
+			pNet->setAutoJoinChannelList(pChannels);
+
+		if((rn.uFlags & KVI_SERVERDB_SNAPSHOT_NETWORK_NICKSERV) && rn.uRuleCount)
+		{
+			KviNickServRuleSet * pSet = new KviNickServRuleSet();
+			pSet->setEnabled(rn.uFlags & KVI_SERVERDB_SNAPSHOT_NETWORK_NICKSERV_ENABLED);
+			for(quint32 u = rn.uFirstRule; u < rn.uFirstRule + rn.uRuleCount; u++)
+			{
+				const KviIrcServerDataBaseSnapshotRule & rr = r.m_pRules[u];
+				pSet->addRule(new KviNickServRule(r.string(rr.uRegisteredNick), r.string(rr.uNickServMask), r.string(rr.uMessageRegexp), r.string(rr.uIdentifyCommand), r.string(rr.uServerMask)));
+			}
+			pNet->m_pNickServRuleSet = pSet;
+		}
+
+		for(quint32 u = 0; u < rn.uServerCount; u++)
+		{
+			const KviIrcServerDataBaseSnapshotServer & rs = r.m_pServers[rn.uFirstServer + u];
+			KviIrcServer * pServ = new KviIrcServer();
+			pServ->setHostName(r.string(rs.uHostName));
+			pServ->setIp(r.string(rs.uIp));
+			pServ->setDescription(r.string(rs.uDescription));
+			pServ->setUserName(r.string(rs.uUserName));
+			pServ->setPassword(r.string(rs.uPass));
+			pServ->setNickName(r.string(rs.uNickName));
+			pServ->setAlternativeNickName(r.string(rs.uAlternativeNickName));
+			pServ->setSaslPass(r.string(rs.uSaslPass));
+			pServ->setSaslNick(r.string(rs.uSaslNick));
+			pServ->setSaslMethod(r.string(rs.uSaslMethod));
+			pServ->setRealName(r.string(rs.uRealName));
+			pServ->setInitUMode(r.string(rs.uInitUMode));
+			pServ->setEncoding(r.string(rs.uEncoding));
+			pServ->setTextEncoding(r.string(rs.uTextEncoding));
+			pServ->setOnConnectCommand(r.string(rs.uOnConnectCommand));
+			pServ->setOnLoginCommand(r.string(rs.uOnLoginCommand));
+			pServ->setLinkFilter(r.string(rs.uLinkFilter));
+			pServ->setId(r.string(rs.uId));
+			pServ->setUserIdentityId(r.string(rs.uUserIdentityId));
+			QStringList * pServerChannels = r.list(rs.uFirstChannel, rs.uChannelCount);
+			if(pServerChannels)
+				pServ->setAutoJoinChannelList(pServerChannels);
+			pServ->setPort(rs.uPort);
+			pServ->setProxy(rs.iProxy);
+			pServ->setAutoConnect(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_AUTOCONNECT);
+			pServ->setIPv6(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_IPV6);
+			pServ->setCacheIp(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_CACHEIP);
+			pServ->setUseSSL(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_SSL);
+			pServ->setEnabledCAP(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_CAP);
+			pServ->setEnabledSTARTTLS(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_STARTTLS);
+			pServ->setEnabledSASL(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_SASL);
+			pServ->setFavorite(rs.uFlags & KVI_SERVERDB_SNAPSHOT_SERVER_FAVORITE);
+			pNet->m_pServerList->append(pServ);
+			if(u == rn.uCurrentServer)
+				pNet->m_pCurrentServer = pServ;
+			if(pServ->autoConnect())
+				addAutoConnectServer(pServ);
+		}
+		if(!pNet->m_pCurrentServer)
+			pNet->m_pCurrentServer = pNet->m_pServerList->first();
+	}
+
+	m_szCurrentNetwork = r.string(pHeader->uCurrentNetwork);
+	if(m_szCurrentNetwork.isNull())
+		m_szCurrentNetwork = "";
+
+	f.unmap((uchar *)pData);
+	return true;
+}
+
+void KviIrcServerDataBase::saveSnapshot(const QString & szFilename)
+{
+	QFileInfo inf(szFilename);
+	if(!inf.exists())
+		return;
+
+	KviIrcServerDataBaseSnapshotWriter w;
+
+	KviPointerHashTableIterator<QString, KviIrcNetwork> it(*m_pRecords);
+	while(KviIrcNetwork * pNet = it.current())
+	{
+		KviIrcServerDataBaseSnapshotNetwork rn;
+		rn.uName = w.string(pNet->m_szName);
+		rn.uDescription = w.string(pNet->m_szDescription);
+		rn.uEncoding = w.string(pNet->m_szEncoding);
+		rn.uTextEncoding = w.string(pNet->m_szTextEncoding);
+		rn.uNickName = w.string(pNet->m_szNickName);
+		rn.uAlternativeNickName = w.string(pNet->m_szAlternativeNickName);
+		rn.uUserName = w.string(pNet->m_szUserName);
+		rn.uRealName = w.string(pNet->m_szRealName);
+		rn.uPass = w.string(pNet->m_szPass);
+		rn.uOnConnectCommand = w.string(pNet->m_szOnConnectCommand);
+		rn.uOnLoginCommand = w.string(pNet->m_szOnLoginCommand);
+		rn.uUserIdentityId = w.string(pNet->m_szUserIdentityId);
+		w.list(pNet->autoJoinChannelList(), rn.uFirstChannel, rn.uChannelCount);
+
+		rn.uFlags = pNet->m_bAutoConnect ? KVI_SERVERDB_SNAPSHOT_NETWORK_AUTOCONNECT : 0;
+		rn.uFirstRule = w.m_Rules.count();
+		rn.uRuleCount = 0;
+		if(pNet->m_pNickServRuleSet && pNet->m_pNickServRuleSet->rules())
+		{
+			rn.uFlags |= KVI_SERVERDB_SNAPSHOT_NETWORK_NICKSERV;
+			if(pNet->m_pNickServRuleSet->isEnabled())
+				rn.uFlags |= KVI_SERVERDB_SNAPSHOT_NETWORK_NICKSERV_ENABLED;
+			KviPointerList<KviNickServRule> * pRules = pNet->m_pNickServRuleSet->rules();
+			for(KviNickServRule * pRule = pRules->first(); pRule; pRule = pRules->next())
+			{
+				KviIrcServerDataBaseSnapshotRule rr;
+				rr.uRegisteredNick = w.string(pRule->registeredNick());
+				rr.uNickServMask = w.string(pRule->nickServMask());
+				rr.uMessageRegexp = w.string(pRule->messageRegexp());
+				rr.uIdentifyCommand = w.string(pRule->identifyCommand());
+				rr.uServerMask = w.string(pRule->serverMask());
+				w.m_Rules.append(rr);
+				rn.uRuleCount++;
+			}
+		}
+
+		rn.uFirstServer = w.m_Servers.count();
+		rn.uServerCount = 0;
+		rn.uCurrentServer = KVI_SERVERDB_SNAPSHOT_NO_SERVER;
+		for(KviIrcServer * pServ = pNet->m_pServerList->first(); pServ; pServ = pNet->m_pServerList->next())
+		{
+			// the text loader drops these too
+			if(pServ->hostName().isEmpty() && pServ->ip().isEmpty())
+				continue;
+
+			KviIrcServerDataBaseSnapshotServer rs;
+			rs.uHostName = w.string(pServ->hostName());
+			rs.uIp = w.string(pServ->ip());
+			rs.uDescription = w.string(pServ->description());
+			rs.uUserName = w.string(pServ->userName());
+			rs.uPass = w.string(pServ->password());
+			rs.uNickName = w.string(pServ->nickName());
+			rs.uAlternativeNickName = w.string(pServ->alternativeNickName());
+			rs.uSaslPass = w.string(pServ->saslPass());
+			rs.uSaslNick = w.string(pServ->saslNick());
+			rs.uSaslMethod = w.string(pServ->saslMethod());
+			rs.uRealName = w.string(pServ->realName());
+			rs.uInitUMode = w.string(pServ->initUMode());
+			rs.uEncoding = w.string(pServ->encoding());
+			rs.uTextEncoding = w.string(pServ->textEncoding());
+			rs.uOnConnectCommand = w.string(pServ->onConnectCommand());
+			rs.uOnLoginCommand = w.string(pServ->onLoginCommand());
+			rs.uLinkFilter = w.string(pServ->linkFilter());
+			rs.uId = w.string(pServ->id());
+			rs.uUserIdentityId = w.string(pServ->userIdentityId());
+			w.list(pServ->autoJoinChannelList(), rs.uFirstChannel, rs.uChannelCount);
+			rs.uPort = pServ->port();
+			rs.iProxy = pServ->proxy();
+			rs.uFlags = 0;
+			if(pServ->autoConnect())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_AUTOCONNECT;
+			if(pServ->isIPv6())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_IPV6;
+			if(pServ->cacheIp())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_CACHEIP;
+			if(pServ->useSSL())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_SSL;
+			if(pServ->enabledCAP())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_CAP;
+			if(pServ->enabledSTARTTLS())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_STARTTLS;
+			if(pServ->enabledSASL())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_SASL;
+			if(pServ->favorite())
+				rs.uFlags |= KVI_SERVERDB_SNAPSHOT_SERVER_FAVORITE;
+
+			if(pServ == pNet->m_pCurrentServer)
+				rn.uCurrentServer = rn.uServerCount;
+			w.m_Servers.append(rs);
+			rn.uServerCount++;
+		}
+
+		w.m_Networks.append(rn);
+		++it;
+	}
+
+	KviIrcServerDataBaseSnapshotHeader hdr;
+	hdr.uMagic = KVI_SERVERDB_SNAPSHOT_MAGIC;
+	hdr.uVersion = KVI_SERVERDB_SNAPSHOT_VERSION;
+	hdr.iSourceSize = inf.size();
+	hdr.iSourceModificationTime = inf.lastModified().toMSecsSinceEpoch();
+	hdr.uCurrentNetwork = w.string(m_szCurrentNetwork);
+	hdr.uStringCount = w.m_Strings.count();
+	hdr.uListItemCount = w.m_ListItems.count();
+	hdr.uRuleCount = w.m_Rules.count();
+	hdr.uNetworkCount = w.m_Networks.count();
+	hdr.uServerCount = w.m_Servers.count();
+	hdr.uStringDataLength = w.m_szStringData.length();
+
+	QSaveFile f(snapshotFileName(szFilename));
+	if(!f.open(QFile::WriteOnly | QFile::Truncate))
+		return; // read only directory: we'll just parse the text file next time
+
+	f.write((const char *)&hdr, sizeof(hdr));
+	f.write((const char *)w.m_Strings.constData(), sizeof(KviIrcServerDataBaseSnapshotString) * w.m_Strings.count());
+	f.write((const char *)w.m_ListItems.constData(), sizeof(quint32) * w.m_ListItems.count());
+	f.write((const char *)w.m_Rules.constData(), sizeof(KviIrcServerDataBaseSnapshotRule) * w.m_Rules.count());
+	f.write((const char *)w.m_Networks.constData(), sizeof(KviIrcServerDataBaseSnapshotNetwork) * w.m_Networks.count());
+	f.write((const char *)w.m_Servers.constData(), sizeof(KviIrcServerDataBaseSnapshotServer) * w.m_Servers.count());
+	f.write((const char *)w.m_szStringData.constData(), sizeof(QChar) * w.m_szStringData.length());
+	f.commit();
+}
+
+void KviIrcServerDataBase::loadText(const QString & szFilename)
+{
 	KviConfigurationFile cfg(szFilename, KviConfigurationFile::Read);
 
 	KviConfigurationFileIterator it(*(cfg.dict()));
@@ -483,14 +1002,7 @@ void KviIrcServerDataBase::load(const QString & szFilename)
 			pNewNet->m_bAutoConnect = cfg.readBoolEntry("AutoConnect", false);
 			pNewNet->m_szUserIdentityId = cfg.readEntry("UserIdentityId");
 			if(pNewNet->m_bAutoConnect)
-			{
-				if(!m_pAutoConnectOnStartupNetworks)
-				{
-					m_pAutoConnectOnStartupNetworks = new KviPointerList<KviIrcNetwork>;
-					m_pAutoConnectOnStartupNetworks->setAutoDelete(false);
-				}
-				m_pAutoConnectOnStartupNetworks->append(pNewNet);
-			}
+				addAutoConnectNetwork(pNewNet);
 			QStringList l = cfg.readStringListEntry("AutoJoinChannels", QStringList());
 			if(l.count() > 0)
 				pNewNet->setAutoJoinChannelList(new QStringList(l));
@@ -510,14 +1022,7 @@ void KviIrcServerDataBase::load(const QString & szFilename)
 					if(cfg.readBoolEntry(szTmp, false))
 						pNewNet->m_pCurrentServer = pServ;
 					if(pServ->autoConnect())
-					{
-						if(!m_pAutoConnectOnStartupServers)
-						{
-							m_pAutoConnectOnStartupServers = new KviPointerList<KviIrcServer>;
-							m_pAutoConnectOnStartupServers->setAutoDelete(false);
-						}
-						m_pAutoConnectOnStartupServers->append(pServ);
-					}
+						addAutoConnectServer(pServ);
 				}
 				else
 					delete pServ;
@@ -589,4 +1094,8 @@ void KviIrcServerDataBase::save(const QString & szFilename)
 		}
 		++it;
 	}
+
+	// flush the text file first: the snapshot is keyed on its size and modification time
+	cfg.sync();
+	saveSnapshot(szFilename);
 }
@@ -35,6 +35,7 @@
 #include "KviPointerHashTable.h"
 
 #include <QString>
+#include <QMultiHash>
 
 class KviIrcNetwork;
 class KviIrcServer;
@@ -82,6 +83,12 @@ private:
 	QString m_szCurrentNetwork;
 	KviPointerList<KviIrcServer> * m_pAutoConnectOnStartupServers;
 	KviPointerList<KviIrcNetwork> * m_pAutoConnectOnStartupNetworks;
+	// Lowercase server hostnames and ids to the names of the networks containing them.
+	// The hits are always checked against the real servers and a miss rebuilds
+	// the index, so it doesn't need to follow the changes made through the networks.
+	QMultiHash<QString, QString> m_hNetworksByServerHostName;
+	QMultiHash<QString, QString> m_hNetworksByServerId;
+	bool m_bServerIndexValid = false;
 
 public:
 	/**
@@ -173,6 +180,10 @@ public:
 
 	/**
 	* \brief Loads the database data
+	*
+	* The text file is the source of truth: if the binary snapshot stored next to it
+	* (see snapshotFileName()) was made from the same version of the file it's used
+	* instead of parsing the text, otherwise the snapshot is rebuilt.
 	* \param szFilename The filename of the database data to load
 	* \return void
 	*/
@@ -185,6 +196,13 @@ public:
 	*/
 	void save(const QString & szFilename);
 
+	/**
+	* \brief Returns the name of the binary snapshot of the database file szFilename
+	* \param szFilename The filename of the database data
+	* \return QString
+	*/
+	static QString snapshotFileName(const QString & szFilename);
+
 	/**
 	* \brief Import servers and networks from a mirc ini file
 	* \param filename The database file where to add new servers
@@ -210,6 +228,16 @@ public:
 	* \return bool
 	*/
 	bool makeCurrentBestServerInNetwork(const QString & szNetName, KviIrcNetwork * pNet, QString & szError);
+
+private:
+	void loadText(const QString & szFilename);
+	bool loadSnapshot(const QString & szFilename);
+	void saveSnapshot(const QString & szFilename);
+	void addAutoConnectNetwork(KviIrcNetwork * pNet);
+	void addAutoConnectServer(KviIrcServer * pServ);
+	void rebuildServerIndex();
+	// Finds the server matching pDef or, if pDef is nullptr, the server with the id szId
+	KviIrcServer * findServer(KviIrcServerDefinition * pDef, const QString & szId, KviIrcNetwork ** ppNet);
 };
 
 #endif //_KVI_IRCSERVERDB_H_
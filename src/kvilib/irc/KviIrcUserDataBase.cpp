@@ -152,7 +152,8 @@ KviIrcUserEntry * KviIrcUserDataBase::insertUser(const QString & szNick, const Q
 	else
 	{
 		pEntry = new KviIrcUserEntry(szUser, szHost);
-		m_pDict->insert(szNick, pEntry);
+		pEntry->m_szNick = szNick;
+		m_pDict->insert(pEntry->m_szNick, pEntry);
 	}
 	return pEntry;
 }
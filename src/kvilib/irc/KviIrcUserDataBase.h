@@ -70,6 +70,9 @@ public:
 
 	/**
 	* \brief Adds the user to the database
+	*
+	* If the user is already there then its reference count is incremented.
+	* The entry keeps the interned copy of the nickname: see KviIrcUserEntry::nick().
 	* \param szNick The nickname of the user
 	* \param szUser The username of the user
 	* \param szHost The hostname of the user
@@ -81,6 +81,9 @@ public:
 	KviIrcUserEntry(const QString & user, const QString & host);
 
 protected:
+	// The nickname this entry was inserted with. It's the interned copy of the nick
+	// for the connection: the database key and the user list entries share its data.
+	QString m_szNick;
 	QString m_szUser;
 	QString m_szHost;
 
@@ -110,6 +113,15 @@ protected:
 	QString m_szAccountName;
 
 public:
+	/**
+	* \brief Returns the interned nickname of the user
+	*
+	* Copies of this string share its data and compare equal
+	* without looking at the characters.
+	* \return const QString &
+	*/
+	const QString & nick() const { return m_szNick; };
+
 	/**
 	* \brief Returns the ircview smart nick color of the user
 	* \return int
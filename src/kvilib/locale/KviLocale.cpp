@@ -37,6 +37,7 @@
 #include "KviFile.h"
 #include "KviPointerHashTable.h"
 #include "KviTranslator.h"
+#include "KviUtf8.h"
 
 #include <QApplication>
 #include <QByteArray>
@@ -53,198 +54,6 @@ static KviPointerHashTable<const char *, KviMessageCatalogue> * g_pCatalogueDict
 static QTextCodec * g_pUtf8TextCodec = nullptr;
 static QString g_szDefaultLocalePath; // FIXME: Convert this to a search path list
 
-//
-// The following code was extracted and adapted from gutf8.c
-// from the GNU GLIB2 package.
-//
-// gutf8.c - Operations on UTF-8 strings.
-//
-// Copyright (C) 1999 Tom Tromey
-// Copyright (C) 2000 Red Hat, Inc.
-//
-// This library is free software; you can redistribute it and/or
-// modify it under the terms of the GNU Lesser General Public
-// License as published by the Free Software Foundation; either
-// version 2 of the License, or (at your option) any later version.
-//
-// This library is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-// Lesser General Public License for more details.
-//
-// You should have received a copy of the GNU Lesser General Public
-// License along with this library; if not, write to the
-// Free Software Foundation, Inc., 59 Temple Place - Suite 330,
-// Boston, MA 02111-1307, USA.
-//
-
-#define UNICODE_VALID(Char) \
-	((Char) < 0x110000 && (((Char)&0xFFFFF800) != 0xD800) && ((Char) < 0xFDD0 || (Char) > 0xFDEF) && ((Char)&0xFFFE) != 0xFFFE)
-
-#define CONTINUATION_CHAR                                   \
-	if((*(unsigned char *)p & 0xc0) != 0x80) /* 10xxxxxx */ \
-		goto error;                                         \
-	val <<= 6;                                              \
-	val |= (*(unsigned char *)p) & 0x3f;
-
-static const char * fast_validate(const char * str)
-{
-	unsigned int val = 0;
-	unsigned int min = 0;
-	const char * p;
-
-	for(p = str; *p; p++)
-	{
-		if(*(unsigned char *)p < 128)
-			/* done */;
-		else
-		{
-			const char * last;
-
-			last = p;
-			if((*(unsigned char *)p & 0xe0) == 0xc0) /* 110xxxxx */
-			{
-				if((*(unsigned char *)p & 0x1e) == 0)
-					goto error;
-				p++;
-				if((*(unsigned char *)p & 0xc0) != 0x80) /* 10xxxxxx */
-					goto error;
-			}
-			else
-			{
-				if((*(unsigned char *)p & 0xf0) == 0xe0) /* 1110xxxx */
-				{
-					min = (1 << 11);
-					val = *(unsigned char *)p & 0x0f;
-					goto TWO_REMAINING;
-				}
-				else if((*(unsigned char *)p & 0xf8) == 0xf0) /* 11110xxx */
-				{
-					min = (1 << 16);
-					val = *(unsigned char *)p & 0x07;
-				}
-				else
-					goto error;
-
-				p++;
-				CONTINUATION_CHAR;
-			TWO_REMAINING:
-				p++;
-				CONTINUATION_CHAR;
-				p++;
-				CONTINUATION_CHAR;
-
-				if(val < min)
-					goto error;
-
-				if(!UNICODE_VALID(val))
-					goto error;
-			}
-
-			continue;
-
-		error:
-			return last;
-		}
-	}
-
-	return p;
-}
-
-static const char * fast_validate_len(const char * str, int max_len)
-{
-	unsigned int val = 0;
-	unsigned int min = 0;
-	const char * p;
-
-	for(p = str; (max_len < 0 || (p - str) < max_len) && *p; p++)
-	{
-		if(*(unsigned char *)p < 128)
-			/* done */;
-		else
-		{
-			const char * last;
-
-			last = p;
-			if((*(unsigned char *)p & 0xe0) == 0xc0) /* 110xxxxx */
-			{
-				if(max_len >= 0 && max_len - (p - str) < 2)
-					goto error;
-
-				if((*(unsigned char *)p & 0x1e) == 0)
-					goto error;
-				p++;
-				if((*(unsigned char *)p & 0xc0) != 0x80) /* 10xxxxxx */
-					goto error;
-			}
-			else
-			{
-				if((*(unsigned char *)p & 0xf0) == 0xe0) /* 1110xxxx */
-				{
-					if(max_len >= 0 && max_len - (p - str) < 3)
-						goto error;
-
-					min = (1 << 11);
-					val = *(unsigned char *)p & 0x0f;
-					goto TWO_REMAINING;
-				}
-				else if((*(unsigned char *)p & 0xf8) == 0xf0) /* 11110xxx */
-				{
-					if(max_len >= 0 && max_len - (p - str) < 4)
-						goto error;
-
-					min = (1 << 16);
-					val = *(unsigned char *)p & 0x07;
-				}
-				else
-					goto error;
-
-				p++;
-				CONTINUATION_CHAR;
-			TWO_REMAINING:
-				p++;
-				CONTINUATION_CHAR;
-				p++;
-				CONTINUATION_CHAR;
-
-				if(val < min)
-					goto error;
-				if(!UNICODE_VALID(val))
-					goto error;
-			}
-
-			continue;
-
-		error:
-			return last;
-		}
-	}
-
-	return p;
-}
-
-static bool g_utf8_validate(const char * str, int max_len, const char ** end)
-{
-	const char * p;
-
-	if(max_len < 0)
-		p = fast_validate(str);
-	else
-		p = fast_validate_len(str, max_len);
-
-	if(end)
-		*end = p;
-
-	if((max_len >= 0 && p != str + max_len) || (max_len < 0 && *p != '\0'))
-		return false;
-	else
-		return true;
-}
-
-//
-//   End of gutf8.c
-//
-
 class KviSmartTextCodec : public QTextCodec
 {
 private:
@@ -289,8 +98,14 @@ protected:
 	}
 	QString convertToUnicode(const char * chars, int len, ConverterState * state) const override
 	{
-		if(g_utf8_validate(chars, len, nullptr))
-			return g_pUtf8TextCodec->toUnicode(chars, len, state);
+		// valid UTF-8 is decoded straight away, unless a multibyte
+		// sequence is pending from a previous chunk
+		if(!state || (state->remainingChars == 0))
+		{
+			QString szRet;
+			if(KviUtf8::decode(chars, len, szRet))
+				return szRet;
+		}
 
 		return m_pRecvCodec->toUnicode(chars, len, state);
 	}
@@ -573,6 +388,18 @@ void KviLocale::done()
 		delete m_pSelf;
 }
 
+QString KviLocale::decodeText(QTextCodec * pCodec, const char * pcText)
+{
+	// 106 is the MIB of UTF-8; the smart codecs take the same path by themselves
+	if(pCodec->mibEnum() == 106)
+	{
+		QString szRet;
+		if(KviUtf8::decode(pcText, (int)strlen(pcText), szRet))
+			return szRet;
+	}
+	return pCodec->toUnicode(pcText);
+}
+
 QTextCodec * KviLocale::codecForName(const char * pcName)
 {
 	KviCString szTmp = pcName;
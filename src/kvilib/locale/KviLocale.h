@@ -159,6 +159,17 @@ public:
 	*/
 	QTextCodec * codecForName(const char * pcName);
 
+	/**
+	* \brief Decodes a null terminated string with the given codec
+	*
+	* When the codec is UTF-8 valid text is decoded by KviUtf8 without
+	* going through QTextCodec: the codec is used only for the rest.
+	* \param pCodec The codec
+	* \param pcText The text to decode
+	* \return QString
+	*/
+	static QString decodeText(QTextCodec * pCodec, const char * pcText);
+
 	/**
 	* \brief Finds the catalogue
 	*
@@ -36,6 +36,8 @@
 #include <openssl/err.h>
 #include <openssl/dh.h>
 
+#include <QHash>
+
 #include <cstdio>
 
 #if !(defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW))
@@ -56,6 +58,44 @@ static inline void my_ssl_unlock()
 	g_pSSLMutex->unlock();
 }
 
+// The contexts shared by all the sockets with the same method and certificate setup.
+// Each entry holds one reference to the context: the sockets hold the others.
+static QHash<QString, SSL_CTX *> * g_pSSLSharedContexts = nullptr;
+// The client sessions available for resumption, keyed by KviSSL::sessionCacheKey()
+static QHash<QString, SSL_SESSION *> * g_pSSLClientSessions = nullptr;
+static unsigned int g_uSSLFullHandshakes = 0;
+static unsigned int g_uSSLResumedHandshakes = 0;
+
+static inline void my_ssl_ctx_ref(SSL_CTX * pCtx)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10100005L
+	SSL_CTX_up_ref(pCtx);
+#else
+	CRYPTO_add(&(pCtx->references), 1, CRYPTO_LOCK_SSL_CTX);
+#endif
+}
+
+static int my_ssl_new_session_callback(SSL * pSSL, SSL_SESSION * pSession)
+{
+	KviSSL * s = (KviSSL *)SSL_get_app_data(pSSL);
+	if(!s || s->sessionCacheKey().isEmpty())
+		return 0; // not interested: OpenSSL keeps ownership
+
+	my_ssl_lock();
+	if(!g_pSSLClientSessions)
+	{
+		my_ssl_unlock();
+		return 0;
+	}
+	SSL_SESSION * pOld = g_pSSLClientSessions->value(s->sessionCacheKey(), nullptr);
+	if(pOld)
+		SSL_SESSION_free(pOld);
+	// TLS 1.3 servers may send several tickets: we keep only the most recent one
+	g_pSSLClientSessions->insert(s->sessionCacheKey(), pSession);
+	my_ssl_unlock();
+	return 1; // we own the reference now
+}
+
 // THIS PART OF OpenSSL SUCKS
 
 static DH * dh_512 = nullptr;
@@ -241,6 +281,8 @@ void KviSSL::globalInit()
 	if(g_pSSLMutex)
 		return;
 	g_pSSLMutex = new KviMutex();
+	g_pSSLSharedContexts = new QHash<QString, SSL_CTX *>();
+	g_pSSLClientSessions = new QHash<QString, SSL_SESSION *>();
 }
 
 void KviSSL::globalDestroy()
@@ -255,6 +297,19 @@ void KviSSL::globalDestroy()
 		DH_free(dh_2048);
 	if(dh_4096)
 		DH_free(dh_4096);
+
+	my_ssl_lock();
+	for(auto pSession : *g_pSSLClientSessions)
+		SSL_SESSION_free(pSession);
+	delete g_pSSLClientSessions;
+	g_pSSLClientSessions = nullptr;
+	// sockets still alive keep their own reference
+	for(auto pCtx : *g_pSSLSharedContexts)
+		SSL_CTX_free(pCtx);
+	delete g_pSSLSharedContexts;
+	g_pSSLSharedContexts = nullptr;
+	my_ssl_unlock();
+
 	globalSSLDestroy();
 	delete g_pSSLMutex;
 	g_pSSLMutex = nullptr;
@@ -343,6 +398,7 @@ void KviSSL::shutdown()
 	}
 	if(m_pSSLCtx)
 	{
+		// for shared contexts this just drops our reference
 		SSL_CTX_free(m_pSSLCtx);
 		m_pSSLCtx = nullptr;
 	}
@@ -383,6 +439,130 @@ bool KviSSL::initContext(Method m)
 	return true;
 }
 
+bool KviSSL::initSharedContext(Method m, const QString & szConfigKey, bool * pbCreated)
+{
+	if(m_pSSL || m_pSSLCtx)
+		return false;
+
+	QString szKey = QString("%1:%2").arg(m == Client ? "client" : "server", szConfigKey);
+
+	my_ssl_lock();
+	SSL_CTX * pCtx = g_pSSLSharedContexts ? g_pSSLSharedContexts->value(szKey, nullptr) : nullptr;
+	if(pCtx)
+		my_ssl_ctx_ref(pCtx);
+	my_ssl_unlock();
+
+	if(pCtx)
+	{
+		m_pSSLCtx = pCtx;
+		if(pbCreated)
+			*pbCreated = false;
+		return true;
+	}
+
+	if(!initContext(m))
+		return false;
+
+	if(m == Server)
+	{
+		// required for the server side session cache to work with client certificates
+		SSL_CTX_set_session_id_context(m_pSSLCtx, (const unsigned char *)"KVIrc", 5);
+	}
+	else
+	{
+		// sessions are stored in g_pSSLClientSessions by my_ssl_new_session_callback
+		SSL_CTX_set_session_cache_mode(m_pSSLCtx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(m_pSSLCtx, my_ssl_new_session_callback);
+	}
+
+	// published by shareContext() once the certificate setup is loaded
+	m_szSharedContextKey = szKey;
+
+	if(pbCreated)
+		*pbCreated = true;
+	return true;
+}
+
+void KviSSL::shareContext()
+{
+	if(!m_pSSLCtx || m_szSharedContextKey.isEmpty())
+		return;
+
+	my_ssl_lock();
+	// another socket might have published an equivalent context in the meantime: keep that one
+	if(g_pSSLSharedContexts && !g_pSSLSharedContexts->contains(m_szSharedContextKey))
+	{
+		my_ssl_ctx_ref(m_pSSLCtx);
+		g_pSSLSharedContexts->insert(m_szSharedContextKey, m_pSSLCtx);
+	}
+	my_ssl_unlock();
+
+	m_szSharedContextKey = QString();
+}
+
+void KviSSL::flushSharedState()
+{
+	my_ssl_lock();
+	if(g_pSSLClientSessions)
+	{
+		for(auto pSession : *g_pSSLClientSessions)
+			SSL_SESSION_free(pSession);
+		g_pSSLClientSessions->clear();
+	}
+	if(g_pSSLSharedContexts)
+	{
+		for(auto pCtx : *g_pSSLSharedContexts)
+			SSL_CTX_free(pCtx);
+		g_pSSLSharedContexts->clear();
+	}
+	my_ssl_unlock();
+}
+
+void KviSSL::setSessionCacheKey(const QString & szKey)
+{
+	if(!m_pSSL)
+		return;
+	m_szSessionCacheKey = szKey;
+	SSL_set_app_data(m_pSSL, this);
+	if(szKey.isEmpty())
+		return;
+
+	my_ssl_lock();
+	SSL_SESSION * pSession = g_pSSLClientSessions ? g_pSSLClientSessions->value(szKey, nullptr) : nullptr;
+	if(pSession)
+		SSL_set_session(m_pSSL, pSession); // takes its own reference
+	my_ssl_unlock();
+}
+
+void KviSSL::forgetSession(const QString & szKey)
+{
+	my_ssl_lock();
+	if(g_pSSLClientSessions)
+	{
+		SSL_SESSION * pSession = g_pSSLClientSessions->take(szKey);
+		if(pSession)
+			SSL_SESSION_free(pSession);
+	}
+	my_ssl_unlock();
+}
+
+bool KviSSL::sessionReused()
+{
+	if(!m_pSSL)
+		return false;
+	return SSL_session_reused(m_pSSL);
+}
+
+unsigned int KviSSL::fullHandshakeCount()
+{
+	return g_uSSLFullHandshakes;
+}
+
+unsigned int KviSSL::resumedHandshakeCount()
+{
+	return g_uSSLResumedHandshakes;
+}
+
 bool KviSSL::initSocket(kvi_socket_t fd)
 {
 	if(!m_pSSLCtx)
@@ -390,6 +570,8 @@ bool KviSSL::initSocket(kvi_socket_t fd)
 	m_pSSL = SSL_new(m_pSSLCtx);
 	if(!m_pSSL)
 		return false;
+	// the irc socket retries a write from its send ring, which may be reallocated meanwhile
+	SSL_set_mode(m_pSSL, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 	if(!SSL_set_fd(m_pSSL, fd))
 		return false;
 	return true;
@@ -511,6 +693,10 @@ KviSSL::Result KviSSL::connectOrAcceptError(int ret)
 	switch(SSL_get_error(m_pSSL, ret))
 	{
 		case SSL_ERROR_NONE:
+			if(SSL_session_reused(m_pSSL))
+				g_uSSLResumedHandshakes++;
+			else
+				g_uSSLFullHandshakes++;
 			return Success;
 			break;
 		case SSL_ERROR_WANT_READ:
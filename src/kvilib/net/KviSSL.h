@@ -32,6 +32,8 @@
 #include "KviPointerHashTable.h"
 #include "kvi_sockettype.h"
 
+#include <QString>
+
 // Apple deprecated openssl since osx 10.7:
 
 #ifdef DEPRECATED_IN_MAC_OS_X_VERSION_10_7_AND_LATER
@@ -181,6 +183,8 @@ public:
 	SSL * m_pSSL;
 	SSL_CTX * m_pSSLCtx;
 	KviCString m_szPass;
+	QString m_szSessionCacheKey;
+	QString m_szSharedContextKey;
 
 public:
 	static void globalInit();
@@ -191,6 +195,29 @@ public:
 public:
 	bool initSocket(kvi_socket_t fd);
 	bool initContext(KviSSL::Method m);
+	// Attaches this object to the process wide context identified by m and szConfigKey,
+	// creating it if needed. *pbCreated is set to true if the context is brand new
+	// and thus still needs the certificate and the private key to be loaded.
+	// A brand new context stays private to this object until shareContext() is called.
+	bool initSharedContext(KviSSL::Method m, const QString & szConfigKey, bool * pbCreated = nullptr);
+	// Publishes the context created by initSharedContext(): call it only
+	// after the certificate and the private key have been loaded successfully
+	void shareContext();
+	// Drops the shared contexts and all the cached sessions (e.g. when the certificate setup changes).
+	// The living sockets keep their own context.
+	static void flushSharedState();
+	// Client side only: call after initSocket() and before connect().
+	// A session previously negotiated with the same key is offered for resumption
+	// and the new session is stored under the key when the handshake completes.
+	void setSessionCacheKey(const QString & szKey);
+	const QString & sessionCacheKey() const { return m_szSessionCacheKey; }
+	// Drops the cached session stored under szKey (e.g. if the peer rejected it)
+	static void forgetSession(const QString & szKey);
+	// Valid after a successful connect() or accept()
+	bool sessionReused();
+	// Process wide counters of the completed handshakes
+	static unsigned int fullHandshakeCount();
+	static unsigned int resumedHandshakeCount();
 	void shutdown();
 	KviSSL::Result connect();
 	KviSSL::Result accept();
@@ -67,6 +67,7 @@ extern KVILIB_API kvi_u64_t g_uIncomingTraffic;
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/tcp.h>
 #include <netinet/in.h>
 #include <fcntl.h>
@@ -280,6 +281,44 @@ inline int kvi_socket_send(kvi_socket_t sock, const void * buf, int size)
 #endif
 }
 
+//
+// kvi_socket_sendv
+//
+//   Gather version of kvi_socket_send(): sends the two buffers with a single call.
+//   The second buffer may be empty. On UNIX this is sendmsg() (writev() with
+//   the send() flags). Returns the number of bytes sent or -1 in case of failure.
+//   You should check kvi_socket_errno() then.
+//
+
+inline int kvi_socket_sendv(kvi_socket_t sock, const void * buf1, int size1, const void * buf2, int size2)
+{
+	if(size2 <= 0)
+		return kvi_socket_send(sock, buf1, size1);
+
+	g_uOutgoingTraffic += size1 + size2;
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+	WSABUF bufs[2];
+	bufs[0].buf = (char *)buf1;
+	bufs[0].len = size1;
+	bufs[1].buf = (char *)buf2;
+	bufs[1].len = size2;
+	DWORD uSent = 0;
+	if(::WSASend(sock, bufs, 2, &uSent, 0, nullptr, nullptr) != 0)
+		return -1;
+	return (int)uSent;
+#else
+	struct iovec vec[2];
+	vec[0].iov_base = (void *)buf1;
+	vec[0].iov_len = size1;
+	vec[1].iov_base = (void *)buf2;
+	vec[1].iov_len = size2;
+	struct msghdr msg = {};
+	msg.msg_iov = vec;
+	msg.msg_iovlen = 2;
+	return ::sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
+}
+
 //
 // kvi_socket_recv
 // kvi_socket_read
@@ -247,6 +247,8 @@ void KviApplication::setup()
 	// on each other and we must activate them in the right order.
 	// Don't move stuff around unless you really know what you're doing.
 
+	m_StartupTimer.start();
+
 	// Initialize the random number generator
 	::srand(::time(nullptr));
 
@@ -305,6 +307,13 @@ void KviApplication::setup()
 	else
 		qDebug("Aaargh... have no UTF-8 codec?");
 
+	startupPhaseDone("early init");
+
+	// Read the configuration databases on worker threads (this must follow the
+	// codec setup above). The subsystems below are still created and filled
+	// in order on this thread: they just find their files already parsed.
+	preloadConfigurationFiles();
+
 	QString szTmp;
 
 	// Initialize the scripting engine
@@ -320,12 +329,14 @@ void KviApplication::setup()
 
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_USERACTIONS))
 		KviActionManager::instance()->load(szTmp);
+	startupPhaseDone("actions");
 
 	// Initialize and load the identities
 	KviUserIdentityManager::init();
 
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_IDENTITIES))
 		KviUserIdentityManager::instance()->load(szTmp);
+	startupPhaseDone("identities");
 
 	KviAnimatedPixmapCache::init();
 
@@ -343,20 +354,23 @@ void KviApplication::setup()
 
 	// enforce our "icon in popups" option - this is done also in each updateGui() call
 	setAttribute(Qt::AA_DontShowIconsInMenus, !KVI_OPTION_BOOL(KviOption_boolShowIconsInPopupMenus));
+	startupPhaseDone("options");
 
 	// Load the win properties config
 	getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_WINPROPERTIES);
-	g_pWinPropertiesConfig = new KviConfigurationFile(szTmp, KviConfigurationFile::ReadWrite);
+	g_pWinPropertiesConfig = new KviConfigurationFile(szTmp, KviConfigurationFile::ReadWrite, false, KviConfigurationFile::Lazy);
 
 	// Load the server database
 	g_pServerDataBase = new KviIrcServerDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SERVERDB))
 		g_pServerDataBase->load(szTmp);
+	startupPhaseDone("server database");
 
 	// Load the proxy database
 	g_pProxyDataBase = new KviProxyDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_PROXYDB))
 		g_pProxyDataBase->load(szTmp);
+	startupPhaseDone("proxy database");
 
 	// Event manager
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_EVENTS))
@@ -364,26 +378,32 @@ void KviApplication::setup()
 
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_RAWEVENTS))
 		KviKvs::loadRawEvents(szTmp);
+	startupPhaseDone("events");
 
 	// Popup manager
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_POPUPS))
 		KviKvs::loadPopups(szTmp);
+	startupPhaseDone("popups");
 
 	KviCustomToolBarManager::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_CUSTOMTOOLBARS))
 		KviCustomToolBarManager::instance()->load(szTmp);
+	startupPhaseDone("toolbars");
 
 	// Alias manager
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_ALIASES))
 		KviKvs::loadAliases(szTmp);
+	startupPhaseDone("aliases");
 
 	// Script addons manager (this in fact has delayed loading, so we don't even care
 	// about showing up an entry in the splash screen)
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SCRIPTADDONS))
 		KviKvs::loadScriptAddons(szTmp);
+	startupPhaseDone("script addons");
 
 	g_pTextIconManager = new KviTextIconManager();
 	g_pTextIconManager->load();
+	startupPhaseDone("text icons");
 
 	// load the recent data lists
 	g_pRecentTopicList = new QStringList();
@@ -396,45 +416,57 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_MEDIATYPES))
 		g_pMediaManager->load(szTmp);
 	g_pMediaManager->unlock();
+	startupPhaseDone("media types");
 
 	// registered user data base
 	g_pRegisteredUserDataBase = new KviRegisteredUserDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_REGUSERDB))
 		g_pRegisteredUserDataBase->load(szTmp);
+	startupPhaseDone("registered users");
 
 	// registered channel data base
 	g_pRegisteredChannelDataBase = new KviRegisteredChannelDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_REGCHANDB))
 		g_pRegisteredChannelDataBase->load(szTmp);
+	startupPhaseDone("registered channels");
 
 	// file trader
 	g_pSharedFilesManager = new KviSharedFilesManager();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SHAREDFILES))
 		g_pSharedFilesManager->load(szTmp);
+	startupPhaseDone("shared files");
 
 	// nick serv data base
 	g_pNickServRuleSet = new KviNickServRuleSet();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_NICKSERVDATABASE))
 		g_pNickServRuleSet->load(szTmp);
+	startupPhaseDone("nickserv rules");
 
 	// Identity profiles database
 	KviIdentityProfileSet::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_PROFILESDATABASE))
 		KviIdentityProfileSet::instance()->load(szTmp);
+	startupPhaseDone("identity profiles");
 
 	KviAvatarCache::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_AVATARCACHE))
 		KviAvatarCache::instance()->load(szTmp);
+	startupPhaseDone("avatars");
 
 	KviInputHistory::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_INPUTHISTORY))
 		KviInputHistory::instance()->load(szTmp);
+	startupPhaseDone("input history");
 
 	KviDefaultScriptManager::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_DEFAULTSCRIPT))
 		KviDefaultScriptManager::instance()->load(szTmp);
 	else
 		KviDefaultScriptManager::instance()->loadEmptyConfig();
+	startupPhaseDone("default script");
+
+	// whatever has not been picked up by now would be stale later
+	KviConfigurationFile::discardPreloaded();
 
 // Eventually initialize the crypt engine manager
 #ifdef COMPILE_CRYPT_SUPPORT
@@ -455,6 +487,7 @@ void KviApplication::setup()
 
 	// create the frame window, we're almost up and running...
 	createFrame();
+	startupPhaseDone("main window");
 
 	// ok, we also have an UI now
 
@@ -481,6 +514,57 @@ void KviApplication::setup()
 
 	// start our heartbeat now
 	m_iHeartbeatTimerId = startTimer(1000);
+
+	m_lStartupTimings.append(QString("total: %1 ms").arg(m_StartupTimer.elapsed()));
+#ifdef COMPILE_DEBUG_MODE
+	qDebug("Startup timings: %s", m_lStartupTimings.join(", ").toUtf8().data());
+#endif
+}
+
+void KviApplication::startupPhaseDone(const char * szPhase)
+{
+	qint64 iNow = m_StartupTimer.elapsed();
+	m_lStartupTimings.append(QString("%1: %2 ms").arg(QString::fromUtf8(szPhase)).arg(iNow - m_iStartupPhaseStart));
+	m_iStartupPhaseStart = iNow;
+}
+
+void KviApplication::preloadConfigurationFiles()
+{
+	// These files are independent from each other: the only dependencies
+	// are between the subsystems that consume them and that's handled
+	// by the order of setup().
+	// The server database isn't listed: it's normally restored from
+	// its snapshot and the text file is read only when that is stale.
+	static const char * pszConfigFiles[] = {
+		KVI_CONFIGFILE_USERACTIONS,
+		KVI_CONFIGFILE_IDENTITIES,
+		KVI_CONFIGFILE_MAIN,
+		KVI_CONFIGFILE_PROXYDB,
+		KVI_CONFIGFILE_EVENTS,
+		KVI_CONFIGFILE_RAWEVENTS,
+		KVI_CONFIGFILE_POPUPS,
+		KVI_CONFIGFILE_CUSTOMTOOLBARS,
+		KVI_CONFIGFILE_ALIASES,
+		KVI_CONFIGFILE_SCRIPTADDONS,
+		KVI_CONFIGFILE_MEDIATYPES,
+		KVI_CONFIGFILE_REGUSERDB,
+		KVI_CONFIGFILE_REGCHANDB,
+		KVI_CONFIGFILE_SHAREDFILES,
+		KVI_CONFIGFILE_NICKSERVDATABASE,
+		KVI_CONFIGFILE_PROFILESDATABASE,
+		KVI_CONFIGFILE_AVATARCACHE,
+		KVI_CONFIGFILE_INPUTHISTORY,
+		KVI_CONFIGFILE_DEFAULTSCRIPT
+	};
+
+	QString szTmp;
+	for(auto pszConfigFile : pszConfigFiles)
+	{
+		if(getReadOnlyConfigPath(szTmp, pszConfigFile))
+			KviConfigurationFile::preload(szTmp);
+	}
+
+	startupPhaseDone("preload start");
 }
 
 void KviApplication::frameDestructorCallback()
@@ -34,6 +34,7 @@
 
 #include <QFont>
 #include <QStringList>
+#include <QElapsedTimer>
 
 #include <memory>
 #include <unordered_map>
@@ -167,6 +168,9 @@ protected:
 	bool m_bUpdateGuiPending;
 	std::unordered_map<KviPendingAvatarChange *, std::unique_ptr<KviPendingAvatarChange>> m_PendingAvatarChanges;
 	bool m_bSetupDone;
+	QElapsedTimer m_StartupTimer;
+	qint64 m_iStartupPhaseStart = 0;
+	QStringList m_lStartupTimings; // "phase: N ms" for each step of setup()
 	KviPointerHashTable<QString, QStringList> * m_pRecentChannelDict;
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
 	bool m_bUpdatePseudoTransparencyPending = false;
@@ -191,6 +195,7 @@ public:
 	static int getGloballyUniqueId(); // returns an unique integer identifier across the application
 
 	bool firstTimeRun() const { return m_bFirstTimeRun; }
+	const QStringList & startupTimings() const { return m_lStartupTimings; }
 	bool kviClosingDown() const { return m_bClosingDown; }
 	void setKviClosingDown() { m_bClosingDown = true; }
 
@@ -366,6 +371,8 @@ private:
 
 	// KviApplication.cpp : parts of setup()
 	void loadRecentEntries();
+	void preloadConfigurationFiles();
+	void startupPhaseDone(const char * szPhase);
 #ifndef COMPILE_NO_IPC
 	void createIpcSentinel();
 	void destroyIpcSentinel();
@@ -38,9 +38,11 @@
 #include <QDrag>
 #include <QEvent>
 #include <QIcon>
+#include <QImageReader>
 #include <QLabel>
 #include <QLayout>
 #include <QMimeData>
+#include <QTimer>
 
 /*
 	@doc: image_id
@@ -533,6 +535,31 @@ void KviCachedPixmap::updateLastAccessTime()
 	m_tLastAccess = kvi_unixTime();
 }
 
+// Loads the image and scales it to fit iMaxWidth x iMaxHeight (if both are not 0)
+static QImage icon_manager_decode_image(const QString & szPath, int iMaxWidth, int iMaxHeight)
+{
+	QImageReader r(szPath);
+	QImage img = r.read();
+	if(img.isNull() || (iMaxWidth <= 0) || (iMaxHeight <= 0))
+		return img;
+
+	if((img.width() > iMaxWidth) || (img.height() > iMaxHeight))
+	{
+		// scale to fit
+		int scaleW = iMaxWidth;
+		int scaleH;
+		scaleH = (img.height() * iMaxWidth) / img.width();
+		if(scaleH > iMaxHeight)
+		{
+			scaleH = iMaxHeight;
+			scaleW = (scaleH * img.width()) / img.height();
+		}
+
+		img = img.scaled(scaleW, scaleH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	}
+	return img;
+}
+
 KviIconManager::KviIconManager()
 {
 	initQResourceBackend();
@@ -1677,6 +1704,11 @@ void KviIconManager::iconWidgetClosed()
 }
 
 KviCachedPixmap * KviIconManager::getPixmapWithCache(const QString & szName)
+{
+	return getPixmapWithCacheScaleOnLoad(szName, 0, 0);
+}
+
+KviCachedPixmap * KviIconManager::getPixmapWithCacheScaleOnLoad(const QString & szName, int iMaxWidth, int iMaxHeight)
 {
 	if(szName.isEmpty())
 		return nullptr;
@@ -1685,87 +1717,117 @@ KviCachedPixmap * KviIconManager::getPixmapWithCache(const QString & szName)
 
 	if(pCache)
 	{
-		pCache->updateLastAccessTime();
+		m_uCacheHits++;
+		touchCacheEntry(pCache);
 		return pCache;
 	}
 
-	QPixmap * pPix = nullptr;
+	m_uCacheMisses++;
 
 	QString szRetPath;
 
 	if(!g_pApp->findImage(szRetPath, szName))
 		return nullptr;
 
-	pPix = new QPixmap(szRetPath);
-	if(pPix->isNull())
-	{
-		delete pPix; // it is not an valid image!!! (really bad situation...)
-		pPix = nullptr;
-		return nullptr;
-	}
+	QImage img = icon_manager_decode_image(szRetPath, iMaxWidth, iMaxHeight);
+	if(img.isNull())
+		return nullptr; // it is not an valid image!!! (really bad situation...)
 
-	pCache = new KviCachedPixmap(pPix, QString(szRetPath));
+	pCache = new KviCachedPixmap(new QPixmap(QPixmap::fromImage(img)), szRetPath);
 	addToCache(szName, pCache);
 
 	return pCache;
 }
 
-KviCachedPixmap * KviIconManager::getPixmapWithCacheScaleOnLoad(const QString & szName, int iMaxWidth, int iMaxHeight)
+void KviIconManager::touchCacheEntry(KviCachedPixmap * pCache)
 {
-	if(szName.isEmpty())
-		return nullptr;
+	pCache->updateLastAccessTime();
 
-	KviCachedPixmap * pCache = m_pCachedImages->find(szName);
+	if(pCache == m_pLruHead)
+		return;
 
-	if(pCache)
-	{
-		pCache->updateLastAccessTime();
-		return pCache;
-	}
+	unlinkCacheEntry(pCache);
 
-	QPixmap * pPix = nullptr;
+	pCache->m_pLruNext = m_pLruHead;
+	if(m_pLruHead)
+		m_pLruHead->m_pLruPrev = pCache;
+	else
+		m_pLruTail = pCache;
+	m_pLruHead = pCache;
+}
 
-	QString szRetPath;
+void KviIconManager::unlinkCacheEntry(KviCachedPixmap * pCache)
+{
+	if(pCache->m_pLruPrev)
+		pCache->m_pLruPrev->m_pLruNext = pCache->m_pLruNext;
+	else if(m_pLruHead == pCache)
+		m_pLruHead = pCache->m_pLruNext;
+
+	if(pCache->m_pLruNext)
+		pCache->m_pLruNext->m_pLruPrev = pCache->m_pLruPrev;
+	else if(m_pLruTail == pCache)
+		m_pLruTail = pCache->m_pLruPrev;
+
+	pCache->m_pLruPrev = nullptr;
+	pCache->m_pLruNext = nullptr;
+}
 
-	if(!g_pApp->findImage(szRetPath, szName))
-		return nullptr;
+void KviIconManager::pinCacheEntry(KviCachedPixmap * pCache)
+{
+	if(pCache->m_bPinned)
+		return;
+	pCache->m_bPinned = true;
+	m_uCacheTotalSize -= pCache->size();
+}
 
-	pPix = new QPixmap(szRetPath);
-	if(pPix->isNull())
+void KviIconManager::addToCache(const QString & szName, KviCachedPixmap * pCache)
+{
+	KviCachedPixmap * pOld = m_pCachedImages->find(szName);
+	if(pOld)
 	{
-		delete pPix; // it is not an valid image!!! (really bad situation...)
-		pPix = nullptr;
-		return nullptr;
+		// will be deleted by insert()
+		unlinkCacheEntry(pOld);
+		if(!pOld->isPinned())
+			m_uCacheTotalSize -= pOld->size();
 	}
-	if((pPix->width() > iMaxWidth) || (pPix->height() > iMaxHeight))
-	{
-		// scale to fit
-		int scaleW = iMaxWidth;
-		int scaleH;
-		scaleH = (pPix->height() * iMaxWidth) / pPix->width();
-		if(scaleH > iMaxHeight)
-		{
-			scaleH = iMaxHeight;
-			scaleW = (scaleH * pPix->width()) / pPix->height();
-		}
 
-		QImage img = pPix->toImage();
-		*pPix = QPixmap::fromImage(img.scaled(scaleW, scaleH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-	}
+	pCache->m_szName = szName;
+	m_pCachedImages->insert(szName, pCache);
+	touchCacheEntry(pCache);
 
-	pCache = new KviCachedPixmap(pPix, QString(szRetPath));
-	addToCache(szName, pCache);
+	if(pCache->isPinned())
+		return;
 
-	return pCache;
+	m_uCacheTotalSize += pCache->size();
+
+	// The callers may still hold pointers to cached pixmaps they got a while ago:
+	// evict only when we're back in the main loop.
+	if((m_uCacheTotalSize > (KVI_OPTION_UINT(KviOption_uintImageCacheMaxSize) * 1024)) && !m_bCacheCleanupScheduled)
+	{
+		m_bCacheCleanupScheduled = true;
+		QTimer::singleShot(0, this, SLOT(cacheCleanup()));
+	}
 }
 
-void KviIconManager::addToCache(const QString & szName, KviCachedPixmap * pCache)
+void KviIconManager::cacheCleanup()
 {
-	//if((m_uCacheTotalSize + pCache->size()) >= m_uCacheMaxSize)
-	//	cacheCleanup();
+	m_bCacheCleanupScheduled = false;
 
-	m_pCachedImages->insert(szName, pCache);
-	m_uCacheTotalSize += pCache->size();
+	unsigned int uMaxSize = KVI_OPTION_UINT(KviOption_uintImageCacheMaxSize) * 1024;
+
+	KviCachedPixmap * pCache = m_pLruTail;
+	while(pCache && (m_uCacheTotalSize > uMaxSize))
+	{
+		KviCachedPixmap * pPrev = pCache->m_pLruPrev;
+		if(!pCache->isPinned())
+		{
+			unlinkCacheEntry(pCache);
+			m_uCacheTotalSize -= pCache->size();
+			m_uCacheEvictions++;
+			m_pCachedImages->remove(pCache->m_szName); // deletes it
+		}
+		pCache = pPrev;
+	}
 }
 
 QPixmap * KviIconManager::getImage(const QString & szId, bool bCanBeNumber, QString * pszRetPath)
@@ -1811,9 +1873,15 @@ QPixmap * KviIconManager::getImage(const QString & szId, bool bCanBeNumber, QStr
 
 QPixmap * KviIconManager::getBigIcon(const QString & szName)
 {
-	QPixmap * pPix = getPixmap(szName);
-	if(pPix)
-		return pPix;
+	// big icons are kept by toolbars and actions: they must never be evicted
+	KviCachedPixmap * pCache = getPixmapWithCache(szName);
+	if(pCache)
+	{
+		pinCacheEntry(pCache);
+		return pCache->pixmap();
+	}
+
+	QPixmap * pPix;
 
 	bool bOk;
 	int iIdx = szName.toInt(&bOk);
@@ -1823,9 +1891,9 @@ QPixmap * KviIconManager::getBigIcon(const QString & szName)
 		// it was a small icon: scale it and cache it
 		QString szTmpName = szName;
 		szTmpName += ".scaled16to32";
-		pPix = getPixmap(szTmpName);
-		if(pPix)
-			return pPix;
+		pCache = getPixmapWithCache(szTmpName);
+		if(pCache)
+			return pCache->pixmap();
 		pPix = getSmallIcon(iIdx % KviIconManager::IconCount);
 		if(pPix)
 		{
@@ -1833,17 +1901,22 @@ QPixmap * KviIconManager::getBigIcon(const QString & szName)
 			QImage tmp2 = tmp.scaled(32, 32, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 			QPixmap * pPix2 = new QPixmap();
 			*pPix2 = QPixmap::fromImage(tmp2);
-			KviCachedPixmap * pCache = new KviCachedPixmap(pPix2, QString());
+			pCache = new KviCachedPixmap(pPix2, QString());
 			addToCache(szTmpName, pCache);
+			pinCacheEntry(pCache);
 			return pCache->pixmap();
 		}
 	}
 
-	pPix = getPixmap("kvi_bigicon_unknown.png");
-	if(pPix)
-		return pPix;
-	KviCachedPixmap * pCache = new KviCachedPixmap(new QPixmap(32, 32), QString());
+	pCache = getPixmapWithCache("kvi_bigicon_unknown.png");
+	if(pCache)
+	{
+		pinCacheEntry(pCache);
+		return pCache->pixmap();
+	}
+	pCache = new KviCachedPixmap(new QPixmap(32, 32), QString());
 	addToCache(szName, pCache);
+	pinCacheEntry(pCache);
 	return pCache->pixmap();
 }
 
@@ -1935,6 +2008,9 @@ KviAvatar * KviIconManager::getAvatar(const QString & szLocalPath, const QString
 void KviIconManager::clearCache()
 {
 	m_pCachedImages->clear();
+	m_pLruHead = nullptr;
+	m_pLruTail = nullptr;
+	m_uCacheTotalSize = 0;
 }
 
 void KviIconManager::reloadImages()
@@ -1964,38 +2040,3 @@ QPixmap * KviIconManager::loadSmallIcon(int iIdx)
 
 	return m_smallIcons[iIdx];
 }
-
-#ifdef __GNUC__
-//#warning IMPLEMENT CLEANUP
-#endif
-/*
-void KviIconManager::cacheCleanup()
-{
-	QStringList l;
-	KviPointerHashTableIterator<QString,KviCachedPixmap> it(*m_pCachedImages);
-
-	while(it.current())
-	{
-		kvi_time_t curTime = kvi_unixTime();
-
-		if((((unsigned int)it.current()->timestamp) - ((unsigned int)curTime)) > 120)
-		{
-			// unused since 2 minutes
-			// time to cleanup it...
-			l.append(new KviCString(it.currentKey()));
-		}
-		++it;
-	}
-
-	for(QStringList::Iterator it = l.begin();it != l.end();++it)
-	{
-		m_pCachedImages->remove(*it);
-	}
-
-	for(KviCString * p =l.first();p;p = l.next())
-	{
-		m_pCachedImages->remove(p->ptr());
-	}
-	if(m_pCachedImages->isEmpty())m_pCleanupTimer->stop();
-}
-*/
@@ -90,6 +90,8 @@ class KVIRC_API KviIconWidget;
 */
 class KVIRC_API KviCachedPixmap
 {
+	friend class KviIconManager;
+
 public:
 	/**
 	* \brief Constructs the KviCachedPixmap object
@@ -110,6 +112,11 @@ private:
 	kvi_time_t m_tLastAccess;
 	QPixmap * m_pPixmap = nullptr;
 	unsigned int m_uSize;
+	bool m_bPinned = false;
+	// the name this pixmap is cached under and its place in the LRU list (managed by KviIconManager)
+	QString m_szName;
+	KviCachedPixmap * m_pLruPrev = nullptr;
+	KviCachedPixmap * m_pLruNext = nullptr;
 
 public:
 	/**
@@ -136,6 +143,12 @@ public:
 	*/
 	kvi_time_t lastAccessTime() const { return m_tLastAccess; }
 
+	/**
+	* \brief Returns true if the image is never evicted from the cache
+	* \return bool
+	*/
+	bool isPinned() const { return m_bPinned; }
+
 	/**
 	* \brief Updates the time the image was last accessed
 	* \return void
@@ -529,8 +542,15 @@ private:
 	KviIconWidget * m_pIconWidget = nullptr;
 	KviPointerHashTable<QString, KviCachedPixmap> * m_pCachedImages = nullptr;
 	KviPointerHashTable<QString, int> * m_pIconNames = nullptr;
-	unsigned int m_uCacheTotalSize = 0;
-	unsigned int m_uCacheMaxSize = 1024 * 1024; // 1 MiB
+	// least recently used list: the head is the most recently used image
+	KviCachedPixmap * m_pLruHead = nullptr;
+	KviCachedPixmap * m_pLruTail = nullptr;
+	unsigned int m_uCacheTotalSize = 0; // bytes of the not pinned images
+	bool m_bCacheCleanupScheduled = false;
+	// statistics
+	unsigned int m_uCacheHits = 0;
+	unsigned int m_uCacheMisses = 0;
+	unsigned int m_uCacheEvictions = 0;
 
 public:
 	/**
@@ -551,7 +571,8 @@ public:
 	* \brief Returns the cached pixmap of the image
 	* \param szName The name of the image
 	* \warning Don't store this pointer!
-	* The returned pointer is owned by the icon manager and can be deleted at any time
+	* The returned pointer is owned by the icon manager and stays valid only until
+	* the control returns to the main event loop
 	* \return KviCachedPixmap *
 	*/
 	KviCachedPixmap * getPixmapWithCache(const QString & szName);
@@ -562,7 +583,8 @@ public:
 	* \param iMaxWidth The max width to scale
 	* \param iMaxHeight The max height to scale
 	* \warning Don't store this pointer!
-	* The returned pointer is owned by the icon manager and can be deleted at any time
+	* The returned pointer is owned by the icon manager and stays valid only until
+	* the control returns to the main event loop
 	* \return KviCachedPixmap *
 	*/
 	KviCachedPixmap * getPixmapWithCacheScaleOnLoad(const QString & szName, int iMaxWidth, int iMaxHeight);
@@ -667,16 +689,61 @@ public:
 	*/
 	void clearCache();
 
+	/**
+	* \brief Returns the number of lookups satisfied by the cache
+	* \return unsigned int
+	*/
+	unsigned int cacheHits() const { return m_uCacheHits; }
+
+	/**
+	* \brief Returns the number of lookups that had to load the image
+	* \return unsigned int
+	*/
+	unsigned int cacheMisses() const { return m_uCacheMisses; }
+
+	/**
+	* \brief Returns the number of images dropped to stay within the cache size limit
+	* \return unsigned int
+	*/
+	unsigned int cacheEvictions() const { return m_uCacheEvictions; }
+
+	/**
+	* \brief Returns the memory used by the evictable cached images, in bytes
+	* \return unsigned int
+	*/
+	unsigned int cacheResidentSize() const { return m_uCacheTotalSize; }
+
 	/**
 	* \brief Reloads all images
 	* \return void
 	*/
 	void reloadImages();
 
-	//void cacheCleanup();
 protected:
 	void addToCache(const QString & szName, KviCachedPixmap * pPix);
 
+	/**
+	* \brief Marks the image as the most recently used one
+	* \param pCache The cached image
+	* \return void
+	*/
+	void touchCacheEntry(KviCachedPixmap * pCache);
+
+	/**
+	* \brief Removes the image from the LRU list
+	* \param pCache The cached image
+	* \return void
+	*/
+	void unlinkCacheEntry(KviCachedPixmap * pCache);
+
+	/**
+	* \brief Keeps the image in the cache forever
+	* Pinned images don't count against the cache size limit and are never evicted
+	* \param pCache The cached image
+	* \return void
+	*/
+	void pinCacheEntry(KviCachedPixmap * pCache);
+
 	/**
 	* \brief Returns the icon
 	* \param iIdx The ID of the icon
@@ -701,6 +768,12 @@ protected slots:
 	* \return void
 	*/
 	void iconWidgetClosed();
+
+	/**
+	* \brief Drops the least recently used images until the cache fits the size limit
+	* \return void
+	*/
+	void cacheCleanup();
 };
 
 /**
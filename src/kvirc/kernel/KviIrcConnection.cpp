@@ -32,6 +32,7 @@
 #include "KviIrcConnectionAsyncWhoisData.h"
 #include "KviIrcConnectionRequestQueue.h"
 #include "KviIrcConnectionStatistics.h"
+#include "KviIrcUserDataBase.h"
 #include "KviIrcLink.h"
 #include "KviIrcSocket.h"
 #include "KviLocale.h"
@@ -67,6 +68,7 @@
 #include "KviNickColors.h"
 #include "KviIrcNetwork.h"
 
+#include <QElapsedTimer>
 #include <QTimer>
 #include <QTextCodec>
 #include <QtGlobal>
@@ -248,7 +250,7 @@ QString KviIrcConnection::decodeText(const char * pcText)
 {
 	if(!m_pSrvCodec)
 		return QString(pcText);
-	return m_pSrvCodec->toUnicode(pcText);
+	return KviLocale::decodeText(m_pSrvCodec, pcText);
 }
 
 void KviIrcConnection::serverInfoReceived(const QString & szServerName, const QString & szUserModes, const QString & szChanModes)
@@ -289,6 +291,7 @@ void KviIrcConnection::linkEstablished()
 	// setup reasonable defaults before notifying anyone
 	m_pStatistics->setConnectionStartTime(kvi_unixTime());
 	m_pStatistics->setLastMessageTime(kvi_unixTime());
+	m_pStatistics->setSSLHandshake(m_pLink->socket()->sslHandshakeTime(), m_pLink->socket()->sslSessionReused());
 	m_pServerInfo->setName(target()->server()->hostName());
 	m_pServerInfo->setNetworkName(target()->network()->name());
 
@@ -566,38 +569,72 @@ void KviIrcConnection::linkAttemptFailed(int iError)
 
 KviChannelWindow * KviIrcConnection::findChannel(const QString & szName)
 {
+	return m_hChannelsByName.value(m_pServerInfo->caseMapped(szName), nullptr);
+}
+
+std::vector<KviChannelWindow *> KviIrcConnection::commonChannels(const QString & szNick) const
+{
+	KviIrcUserEntry * pUser = m_pUserDataBase->find(szNick);
+	if(!pUser)
+		return std::vector<KviChannelWindow *>();
+	return m_hChannelsByNick.value(pUser);
+}
+
+void KviIrcConnection::channelUserJoined(KviChannelWindow * c, KviIrcUserEntry * pUser)
+{
+	// user lists of dead or not yet registered channels are not indexed
+	if(findChannel(c->windowName()) != c)
+		return;
+	std::vector<KviChannelWindow *> & v = m_hChannelsByNick[pUser];
+	if(std::find(v.begin(), v.end(), c) == v.end())
+		v.push_back(c);
+}
+
+void KviIrcConnection::channelUserParted(KviChannelWindow * c, KviIrcUserEntry * pUser)
+{
+	QHash<KviIrcUserEntry *, std::vector<KviChannelWindow *>>::iterator it = m_hChannelsByNick.find(pUser);
+	if(it == m_hChannelsByNick.end())
+		return;
+	it.value().erase(std::remove(it.value().begin(), it.value().end(), c), it.value().end());
+	if(it.value().empty())
+		m_hChannelsByNick.erase(it);
+}
+
+void KviIrcConnection::setCaseMapping(const QString & szCaseMapping)
+{
+	if(!m_pServerInfo->setCaseMapping(szCaseMapping))
+		return;
+
+	m_hChannelsByName.clear();
 	for(auto & c : m_pChannelList)
-	{
-		if(KviQString::equalCI(szName, c->windowName()))
-			return c;
-	}
-	return nullptr;
+		m_hChannelsByName.insert(m_pServerInfo->caseMapped(c->windowName()), c);
+
+	m_hQueriesByName.clear();
+	for(auto & q : m_pQueryList)
+		m_hQueriesByName.insert(m_pServerInfo->caseMapped(q->windowName()), q);
 }
 
 int KviIrcConnection::getCommonChannels(const QString & szNick, QString & szChansBuffer, bool bAddEscapeSequences)
 {
 	int iCount = 0;
-	for(auto & c : m_pChannelList)
+	for(auto & c : commonChannels(szNick))
 	{
-		if(c->isOn(szNick))
-		{
-			if(!szChansBuffer.isEmpty())
-				szChansBuffer.append(", ");
+		if(!szChansBuffer.isEmpty())
+			szChansBuffer.append(", ");
 
-			char uFlag = c->getUserFlag(szNick);
-			if(uFlag)
-			{
-				KviQString::appendFormatted(szChansBuffer, bAddEscapeSequences ? "%c\r!c\r%Q\r" : "%c%Q", uFlag, &(c->windowName()));
-			}
+		char uFlag = c->getUserFlag(szNick);
+		if(uFlag)
+		{
+			KviQString::appendFormatted(szChansBuffer, bAddEscapeSequences ? "%c\r!c\r%Q\r" : "%c%Q", uFlag, &(c->windowName()));
+		}
+		else
+		{
+			if(bAddEscapeSequences)
+				KviQString::appendFormatted(szChansBuffer, "\r!c\r%Q\r", &(c->windowName()));
 			else
-			{
-				if(bAddEscapeSequences)
-					KviQString::appendFormatted(szChansBuffer, "\r!c\r%Q\r", &(c->windowName()));
-				else
-					szChansBuffer.append(c->windowName());
-			}
-			iCount++;
+				szChansBuffer.append(c->windowName());
 		}
+		iCount++;
 	}
 	return iCount;
 }
@@ -698,17 +735,13 @@ KviQueryWindow * KviIrcConnection::createQuery(const QString & szNick, CreateQue
 
 KviQueryWindow * KviIrcConnection::findQuery(const QString & szName)
 {
-	for(auto & q : m_pQueryList)
-	{
-		if(KviQString::equalCI(szName, q->windowName()))
-			return q;
-	}
-	return nullptr;
+	return m_hQueriesByName.value(m_pServerInfo->caseMapped(szName), nullptr);
 }
 
 void KviIrcConnection::registerChannel(KviChannelWindow * c)
 {
 	m_pChannelList.push_back(c);
+	m_hChannelsByName.insert(m_pServerInfo->caseMapped(c->windowName()), c);
 	if(KVI_OPTION_BOOL(KviOption_boolLogChannelHistory))
 		g_pApp->addRecentChannel(c->windowName(), m_pServerInfo->networkName());
 	emit(channelRegistered(c));
@@ -718,6 +751,14 @@ void KviIrcConnection::registerChannel(KviChannelWindow * c)
 void KviIrcConnection::unregisterChannel(KviChannelWindow * c)
 {
 	m_pChannelList.erase(std::remove(m_pChannelList.begin(), m_pChannelList.end(), c), m_pChannelList.end());
+
+	QString szKey = m_pServerInfo->caseMapped(c->windowName());
+	if(m_hChannelsByName.value(szKey, nullptr) == c)
+		m_hChannelsByName.remove(szKey);
+
+	// the user list may still be populated (when the window is being destroyed)
+	for(KviUserListEntry * e = c->userListView()->firstItem(); e; e = e->next())
+		channelUserParted(c, e->globalData());
 	requestQueue()->dequeueChannel(c);
 	emit(channelUnregistered(c));
 	emit(chanListChanged());
@@ -726,11 +767,25 @@ void KviIrcConnection::unregisterChannel(KviChannelWindow * c)
 void KviIrcConnection::registerQuery(KviQueryWindow * q)
 {
 	m_pQueryList.push_back(q);
+	m_hQueriesByName.insert(m_pServerInfo->caseMapped(q->windowName()), q);
 }
 
 void KviIrcConnection::unregisterQuery(KviQueryWindow * q)
 {
 	m_pQueryList.erase(std::remove(m_pQueryList.begin(), m_pQueryList.end(), q), m_pQueryList.end());
+
+	QString szKey = m_pServerInfo->caseMapped(q->windowName());
+	if(m_hQueriesByName.value(szKey, nullptr) == q)
+		m_hQueriesByName.remove(szKey);
+}
+
+void KviIrcConnection::queryRenamed(KviQueryWindow * q, const QString & szOldName)
+{
+	QString szKey = m_pServerInfo->caseMapped(szOldName);
+	if(m_hQueriesByName.value(szKey, nullptr) == q)
+		m_hQueriesByName.remove(szKey);
+	if(std::find(m_pQueryList.begin(), m_pQueryList.end(), q) != m_pQueryList.end())
+		m_hQueriesByName.insert(m_pServerInfo->caseMapped(q->windowName()), q);
 }
 
 void KviIrcConnection::keepChannelsOpenAfterDisconnect()
@@ -1935,7 +1990,20 @@ void KviIrcConnection::incomingMessage(const char * pcMessage)
 	// set the last message time
 	m_pStatistics->setLastMessageTime(kvi_unixTime());
 	// and pass it to the server parser for processing
+	if(context()->monitorList().empty())
+	{
+		g_pServerParser->parseMessage(pcMessage, this);
+		return;
+	}
+
+	// someone is watching: tell them how long it took
+	KviIrcContext * pContext = context(); // the context survives a disconnection in parseMessage()
+	QElapsedTimer processingTime;
+	processingTime.start();
 	g_pServerParser->parseMessage(pcMessage, this);
+	qint64 iNanoseconds = processingTime.nsecsElapsed();
+	for(auto & m : pContext->monitorList())
+		m->incomingMessageProcessed(pcMessage, iNanoseconds);
 }
 
 void KviIrcConnection::incomingMessageNoFilter(const char * pcMessage)
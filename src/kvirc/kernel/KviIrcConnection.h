@@ -35,6 +35,7 @@
 #include "KviTimeUtils.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QObject>
 #include <QStringList>
 
@@ -57,6 +58,7 @@ class KviChannelWindow;
 class KviQueryWindow;
 class KviIrcConnectionTarget;
 class KviIrcUserDataBase;
+class KviIrcUserEntry;
 class KviIrcConnectionUserInfo;
 class KviIrcConnectionServerInfo;
 class KviIrcConnectionStateData;
@@ -164,6 +166,14 @@ private:
 	std::vector<KviChannelWindow *> m_pChannelList; // elements are borrowed and never null
 	std::vector<KviQueryWindow *> m_pQueryList;     // elements are borrowed and never null
 
+	// Lookup indexes for the two lists above, keyed by the server case mapped name
+	// (see KviIrcConnectionServerInfo::caseMapped()). Rebuilt when CASEMAPPING changes.
+	QHash<QString, KviChannelWindow *> m_hChannelsByName;
+	QHash<QString, KviQueryWindow *> m_hQueriesByName;
+	// User database entry (the interned nickname) -> registered channels whose user list contains it.
+	// The entries are kept alive by the user lists themselves.
+	QHash<KviIrcUserEntry *, std::vector<KviChannelWindow *>> m_hChannelsByNick;
+
 	KviIrcUserDataBase * m_pUserDataBase; // owned, never null
 
 	KviNotifyListManager * m_pNotifyListManager = nullptr; // owned, see restartNotifyList()
@@ -422,6 +432,24 @@ public:
 	*/
 	int getCommonChannels(const QString & szNick, QString & szChansBuffer, bool bAddEscapeSequences = true);
 
+	/**
+	* \brief Returns the channels that the specified user is on
+	*
+	* This is an indexed lookup: it doesn't scan the channel list.
+	* The returned vector is a copy, so it is safe to part the user from
+	* the channels while iterating it.
+	* \param szNick The nickname of the user
+	* \return std::vector<KviChannelWindow *>
+	*/
+	std::vector<KviChannelWindow *> commonChannels(const QString & szNick) const;
+
+	///
+	/// These are called by the channel user lists to keep the commonChannels() index
+	/// up to date. You shouldn't need to call them.
+	///
+	void channelUserJoined(KviChannelWindow * c, KviIrcUserEntry * pUser);
+	void channelUserParted(KviChannelWindow * c, KviIrcUserEntry * pUser);
+
 	/**
 	* \brief Creates a new channel with the specified name.
 	*
@@ -540,6 +568,11 @@ public:
 	///
 	void unregisterQuery(KviQueryWindow * q);
 
+	///
+	/// This is called by KviQueryWindow when its target nickname changes, you shouldn't need to use it.
+	///
+	void queryRenamed(KviQueryWindow * q, const QString & szOldName);
+
 	/**
 	* \brief Marks all the currently open queries as DEAD
 	*
@@ -713,6 +746,15 @@ public:
 	QByteArray encodeText(const QString & szText);
 
 protected:
+	/**
+	* \brief Sets the server case mapping (from the CASEMAPPING ISUPPORT token)
+	*
+	* Rebuilds the channel and query name indexes if the mapping changes.
+	* \param szCaseMapping The value of the token
+	* \return void
+	*/
+	void setCaseMapping(const QString & szCaseMapping);
+
 	//
 	// Notify list management
 	//
@@ -27,14 +27,20 @@
 #include "KviChannelWindow.h"
 #include "KviOptions.h"
 #include "KviLagMeter.h"
+#include "KviIrcConnection.h"
 #include "KviIrcConnectionStateData.h"
 #include "KviIrcConnectionServerInfo.h"
+#include "KviIrcLink.h"
+#include "KviIrcSocket.h"
 
 #include <QByteArray>
+#include <QPointer>
 
 KviIrcConnectionRequestQueue::KviIrcConnectionRequestQueue()
 {
+	m_timer.setSingleShot(true);
 	connect(&m_timer, SIGNAL(timeout()), this, SLOT(timerSlot()));
+	m_tPenaltyClock.start();
 }
 
 KviIrcConnectionRequestQueue::~KviIrcConnectionRequestQueue()
@@ -42,145 +48,437 @@ KviIrcConnectionRequestQueue::~KviIrcConnectionRequestQueue()
 	disconnect(&m_timer, SIGNAL(timeout()), this, SLOT(timerSlot()));
 }
 
-void KviIrcConnectionRequestQueue::enqueueChannel(KviChannelWindow * pChan)
+int KviIrcConnectionRequestQueue::findChannel(KviChannelWindow * pChan) const
 {
-	if(!m_channels.contains(pChan))
+	for(int i = 0; i < m_channels.count(); i++)
 	{
-		m_channels.enqueue(pChan);
-		if(!m_timer.isActive())
-			m_timer.start(KVI_OPTION_UINT(KviOption_uintOnJoinRequestsDelay) * 1000);
+		if(m_channels.at(i).pChan == pChan)
+			return i;
 	}
+	return -1;
+}
+
+void KviIrcConnectionRequestQueue::enqueueChannel(KviChannelWindow * pChan)
+{
+	if(findChannel(pChan) != -1)
+		return;
+
+	ChannelRequests chan;
+	chan.pChan = pChan;
+	chan.bPlanned = false;
+	chan.iTotal = 0;
+	chan.iDone = 0;
+	m_channels.append(chan);
+
+	// the option is the delay before the first request:
+	// while the requests are running the timer polls for the replies
+	if(!m_timer.isActive())
+		m_timer.start(KVI_OPTION_UINT(KviOption_uintOnJoinRequestsDelay) * 1000);
 }
 
 void KviIrcConnectionRequestQueue::dequeueChannel(KviChannelWindow * pChan)
 {
-	if(m_channels.contains(pChan))
+	int iChan = findChannel(pChan);
+	if(iChan == -1)
+		return;
+
+	m_channels.removeAt(iChan);
+	for(int i = 0; i < m_sent.count();)
 	{
-		m_channels.removeOne(pChan);
-		if(m_channels.isEmpty())
-			m_timer.stop();
+		if(m_sent.at(i).pChan == pChan)
+			m_sent.removeAt(i);
+		else
+			i++;
 	}
+
+	if(m_channels.isEmpty())
+		m_timer.stop();
 }
 
 void KviIrcConnectionRequestQueue::clearAll()
 {
 	m_timer.stop();
 	m_channels.clear();
-	m_curType = Mode;
+	m_sent.clear();
+	m_iWindow = KVI_IRCCONNECTIONREQUESTQUEUE_INITIAL_WINDOW;
+	m_iMinLatency = -1;
+	m_iPenaltyTimer = 0;
 }
 
-void KviIrcConnectionRequestQueue::timerSlot()
+int KviIrcConnectionRequestQueue::channelProgress(KviChannelWindow * pChan) const
 {
-	if(m_channels.isEmpty())
+	int iChan = findChannel(pChan);
+	if(iChan == -1)
+		return 100;
+
+	const ChannelRequests & chan = m_channels.at(iChan);
+	if(!chan.bPlanned || (chan.iTotal == 0))
+		return 0;
+	return (chan.iDone * 100) / chan.iTotal;
+}
+
+void KviIrcConnectionRequestQueue::planRequests(ChannelRequests & chan)
+{
+	/* The channel's "MODE" request is the only mandatory request:
+	 * the others are skipped if disabled or not available on the server.
+	 * They are planned just before the first one is sent, so the
+	 * user modes we got on join are known.
+	 */
+	KviChannelWindow * pChan = chan.pChan;
+	bool bCanListModeseI = !(pChan->serverInfo()->getNeedsOpToListModeseI() && !pChan->isMeOp());
+
+	chan.lPending.append(Mode);
+	if(pChan->serverInfo()->supportedListModes().contains('e') && !KVI_OPTION_BOOL(KviOption_boolDisableBanExceptionListRequestOnJoin) && bCanListModeseI)
+		chan.lPending.append(BanException);
+	if(pChan->serverInfo()->supportedListModes().contains('I') && !KVI_OPTION_BOOL(KviOption_boolDisableInviteListRequestOnJoin) && bCanListModeseI)
+		chan.lPending.append(Invite);
+	if(pChan->serverInfo()->supportedListModes().contains('q') && !KVI_OPTION_BOOL(KviOption_boolDisableQuietBanListRequestOnJoin))
+		chan.lPending.append(QuietBan);
+	if(!KVI_OPTION_BOOL(KviOption_boolDisableWhoRequestOnJoin))
+		chan.lPending.append(Who);
+	if(!KVI_OPTION_BOOL(KviOption_boolDisableBanListRequestOnJoin))
+		chan.lPending.append(Ban);
+
+	chan.bPlanned = true;
+	chan.iTotal = chan.lPending.count();
+}
+
+char KviIrcConnectionRequestQueue::listModeOfRequest(RequestTypes eType)
+{
+	switch(eType)
 	{
+		case BanException:
+			return 'e';
+		case Invite:
+			return 'I';
+		case QuietBan:
+			return 'q';
+		case Ban:
+			return 'b';
+		default:
+			return 0;
+	}
+}
+
+bool KviIrcConnectionRequestQueue::isReplied(const SentRequest & req) const
+{
+	switch(req.eType)
+	{
+		case Mode:
+			return req.bReplied;
+		case Who:
+			return req.pChan->hasWhoList();
+		default:
+			// the list is done when the end of list numeric has been received
+			return !req.pChan->sentListRequest(listModeOfRequest(req.eType));
+	}
+}
+
+bool KviIrcConnectionRequestQueue::penaltyAllows(qint64 iCost)
+{
+	if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
+		return true; // the Bulk lane follows the flood budget
+
+	qint64 iNow = m_tPenaltyClock.nsecsElapsed() / 1000;
+	if(m_iPenaltyTimer < iNow)
+		m_iPenaltyTimer = iNow;
+
+	// as in KviIrcSocket::flushSendQueue(): a request that costs more
+	// than the whole budget goes when the penalty expires
+	qint64 iExcess = m_iPenaltyTimer + iCost - iNow - KVI_OPTION_UINT(KviOption_uintOutgoingTrafficBurstUSeconds);
+	return (iExcess <= 0) || (m_iPenaltyTimer <= iNow);
+}
+
+void KviIrcConnectionRequestQueue::chargePenalty(qint64 iCost)
+{
+	if(!KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
+		m_iPenaltyTimer += iCost;
+}
+
+void KviIrcConnectionRequestQueue::replyReceived(qint64 iLatency)
+{
+	if((m_iMinLatency < 0) || (iLatency < m_iMinLatency))
+		m_iMinLatency = iLatency;
+
+	// The replies noticed by the poll may look late by up to an interval.
+	// Grow the window while the server is as fast as it can be,
+	// halve it when the replies start to queue up on the server
+	if(iLatency <= ((2 * m_iMinLatency) + KVI_IRCCONNECTIONREQUESTQUEUE_POLL_INTERVAL))
+	{
+		if(m_iWindow < KVI_IRCCONNECTIONREQUESTQUEUE_MAX_WINDOW)
+			m_iWindow++;
+	}
+	else if(iLatency > ((4 * m_iMinLatency) + 1000))
+	{
+		m_iWindow = qMax(m_iWindow / 2, KVI_IRCCONNECTIONREQUESTQUEUE_MIN_WINDOW);
+	}
+}
+
+void KviIrcConnectionRequestQueue::requestTimedOut()
+{
+	m_iWindow = qMax(m_iWindow / 2, KVI_IRCCONNECTIONREQUESTQUEUE_MIN_WINDOW);
+}
+
+bool KviIrcConnectionRequestQueue::collectReplies(KviChannelWindow * pChan, QList<KviChannelWindow *> & lFinished)
+{
+	bool bCollected = false;
+
+	for(int i = 0; i < m_sent.count();)
+	{
+		const SentRequest & req = m_sent.at(i);
+		if(pChan && (req.pChan != pChan))
+		{
+			i++;
+			continue;
+		}
+
+		qint64 iElapsed = req.tSent.elapsed();
+		if(isReplied(req))
+			replyReceived(iElapsed);
+		else if(iElapsed >= KVI_IRCCONNECTIONREQUESTQUEUE_REQUEST_TIMEOUT)
+			requestTimedOut(); // the server ignored it: don't wait for it anymore
+		else
+		{
+			i++;
+			continue;
+		}
+
+		int iChan = findChannel(req.pChan);
+		if(iChan != -1)
+			m_channels[iChan].iDone++;
+		m_sent.removeAt(i);
+		bCollected = true;
+	}
+
+	if(!bCollected)
+		return false;
+
+	// a channel is done when all its requests have been sent and replied
+	for(int i = 0; i < m_channels.count();)
+	{
+		const ChannelRequests & chan = m_channels.at(i);
+		if(chan.bPlanned && chan.lPending.isEmpty() && (chan.iDone >= chan.iTotal))
+		{
+			lFinished.append(chan.pChan);
+			m_channels.removeAt(i);
+		}
+		else
+			i++;
+	}
+
+	if(m_channels.isEmpty())
 		m_timer.stop();
+	return true;
+}
+
+void KviIrcConnectionRequestQueue::channelStateChanged(KviChannelWindow * pChan)
+{
+	// pChan is in the middle of checkChannelSync() and will finish it by itself
+	QList<KviChannelWindow *> lFinished;
+	if(!collectReplies(pChan, lFinished))
+		return;
+
+	// a slot of the window is free: the next requests are sent
+	// from the event loop and not from the middle of the server parser
+	if(!m_channels.isEmpty())
+		m_timer.start(0);
+}
+
+void KviIrcConnectionRequestQueue::channelModeReceived(KviChannelWindow * pChan)
+{
+	for(auto & req : m_sent)
+	{
+		if((req.pChan == pChan) && (req.eType == Mode) && !req.bReplied)
+		{
+			req.bReplied = true;
+			pChan->checkChannelSync();
+			return;
+		}
+	}
+}
+
+bool KviIrcConnectionRequestQueue::sendRequest(ChannelRequests & chan, RequestTypes eType)
+{
+	KviChannelWindow * pChan = chan.pChan;
+	QByteArray encodedChan = pChan->connection()->encodeText(pChan->target());
+	char cMode = listModeOfRequest(eType);
+
+	if(cMode)
+	{
+		if(!pChan->connection()->sendFmtData("MODE %s %c", encodedChan.data(), cMode))
+			return false;
+		pChan->setSentListRequest(cMode);
+	}
+	else
+	{
+		if(!pChan->connection()->sendFmtData("MODE %s", encodedChan.data()))
+			return false;
+	}
+
+	SentRequest req;
+	req.pChan = pChan;
+	req.eType = eType;
+	req.tSent.start();
+	req.bReplied = false;
+	m_sent.append(req);
+	return true;
+}
+
+bool KviIrcConnectionRequestQueue::sendWho(const QList<KviChannelWindow *> & lChans)
+{
+	KviIrcConnection * pConnection = lChans.first()->connection();
+
+	QByteArray szTargets;
+	for(auto & pChan : lChans)
+	{
+		if(!szTargets.isEmpty())
+			szTargets.append(',');
+		szTargets.append(pConnection->encodeText(pChan->target()));
 	}
+
+	// TODO: cleanup
+	pConnection->stateData()->setLastSentChannelWhoRequest(kvi_unixTime());
+	if(pConnection->lagMeter())
+	{
+		KviCString tmp;
+		if(pConnection->serverInfo()->supportsWhox())
+			tmp.sprintf("WHO %s %acdfhlnrsu", szTargets.data());
+		else
+			tmp.sprintf("WHO %s", szTargets.data());
+		pConnection->lagMeter()->lagCheckRegister(tmp.ptr(), 60);
+	}
+
+	bool bSent;
+	if(pConnection->serverInfo()->supportsWhox())
+		bSent = pConnection->sendFmtData("WHO %s %acdfhlnrsu", szTargets.data());
 	else
+		bSent = pConnection->sendFmtData("WHO %s", szTargets.data());
+	if(!bSent)
+		return false;
+
+	for(auto & pChan : lChans)
 	{
-		KviChannelWindow * pChan = m_channels.head();
-		QByteArray encodedChan = pChan->connection()->encodeText(pChan->target()).data();
-		/* The following switch will let the execution flow pass-through if any request type
-		 * is currently disabled (or not available on the server). Channel's "MODE" request is
-		 * the only mandatory request.
-		 */
-		switch(m_curType)
+		pChan->setSentWhoRequest();
+		SentRequest req;
+		req.pChan = pChan;
+		req.eType = Who;
+		req.tSent.start();
+		req.bReplied = false;
+		m_sent.append(req);
+	}
+	return true;
+}
+
+bool KviIrcConnectionRequestQueue::sendRequests()
+{
+	while(!m_channels.isEmpty() && (m_sent.count() < m_iWindow))
+	{
+		KviIrcConnection * pConnection = m_channels.first().pChan->connection();
+		// don't queue more than the flood budget lets through
+		KviIrcSocket * pSocket = pConnection->link() ? pConnection->link()->socket() : nullptr;
+		if(pSocket && pSocket->hasQueuedData(KviIrcSocket::Bulk))
+			break;
+
+		int iChan = 0;
+		while((iChan < m_channels.count()) && m_channels.at(iChan).bPlanned && m_channels.at(iChan).lPending.isEmpty())
+			iChan++;
+		if(iChan >= m_channels.count())
+			break; // all sent: waiting for the replies
+
+		ChannelRequests & chan = m_channels[iChan];
+		if(!chan.bPlanned)
+			planRequests(chan);
+
+		RequestTypes eType = chan.lPending.first();
+		int iLength = pConnection->encodeText(chan.pChan->target()).length();
+
+		if(eType != Who)
 		{
-			case BanException:
-				if(pChan->serverInfo()->supportedListModes().contains('e') && !KVI_OPTION_BOOL(KviOption_boolDisableBanExceptionListRequestOnJoin) && !(pChan->serverInfo()->getNeedsOpToListModeseI() && !pChan->isMeOp()))
-				{
-					if(!pChan->connection()->sendFmtData("MODE %s e", encodedChan.data()))
-						clearAll(); // disconnected
-					else
-						pChan->setSentListRequest('e');
-					m_curType = Invite;
-					break;
-				}
-			case Invite:
-				if(pChan->serverInfo()->supportedListModes().contains('I') && !KVI_OPTION_BOOL(KviOption_boolDisableInviteListRequestOnJoin) && !(pChan->serverInfo()->getNeedsOpToListModeseI() && !pChan->isMeOp()))
-				{
-					if(!pChan->connection()->sendFmtData("MODE %s I", encodedChan.data()))
-						clearAll(); // disconnected
-					else
-						pChan->setSentListRequest('I');
-					m_curType = QuietBan;
-					break;
-				}
-			case QuietBan:
-				if(pChan->serverInfo()->supportedListModes().contains('q') && !KVI_OPTION_BOOL(KviOption_boolDisableQuietBanListRequestOnJoin))
-				{
-					if(!pChan->connection()->sendFmtData("MODE %s q", encodedChan.data()))
-						clearAll(); // disconnected
-					else
-						pChan->setSentListRequest('q');
-					m_curType = Who;
-					break;
-				}
-			case Who:
-				if(!KVI_OPTION_BOOL(KviOption_boolDisableWhoRequestOnJoin))
-				{
-					// TODO: cleanup
-					pChan->connection()->stateData()->setLastSentChannelWhoRequest(kvi_unixTime());
-					if(pChan->connection()->lagMeter())
-					{
-						KviCString tmp;
-						if(pChan->serverInfo()->supportsWhox())
-							tmp.sprintf("WHO %s %acdfhlnrsu", encodedChan.data());
-						else
-							tmp.sprintf("WHO %s", encodedChan.data());
-						pChan->connection()->lagMeter()->lagCheckRegister(tmp.ptr(), 60);
-					}
-					if(pChan->serverInfo()->supportsWhox())
-					{
-						if(!pChan->connection()->sendFmtData("WHO %s %acdfhlnrsu", encodedChan.data()))
-							clearAll(); // disconnected
-						else
-							pChan->setSentWhoRequest();
-					}
-					else
-					{
-						if(!pChan->connection()->sendFmtData("WHO %s", encodedChan.data()))
-							clearAll(); // disconnected
-						else
-							pChan->setSentWhoRequest();
-					}
-					m_curType = Ban;
-					break;
-				}
-			case Ban:
-				if(!KVI_OPTION_BOOL(KviOption_boolDisableBanListRequestOnJoin))
-				{
-					if(!pChan->connection()->sendFmtData("MODE %s b", encodedChan.data()))
-					{
-						clearAll(); // disconnected
-					}
-					else
-					{
-						pChan->setSentListRequest('b');
-						m_channels.dequeue();
-					}
-					m_curType = Mode;
-					break;
-				}
-			default:
-				// we're at the end of the list
-				m_channels.dequeue();
-				pChan->checkChannelSync();
-				m_curType = Mode;
-				if(m_channels.isEmpty())
-				{
-					m_timer.stop();
-					return;
-				}
-				pChan = m_channels.head();
-				encodedChan = pChan->connection()->encodeText(pChan->target());
-			case Mode:
-				if(!pChan->connection()->sendFmtData("MODE %s", encodedChan.data()))
-				{
-					clearAll(); // disconnected
-					break;
-				}
-				m_curType = BanException;
+			// "MODE <channel>[ <mode>]\r\n"
+			qint64 iCost = KviIrcSocket::floodCost("MODE", 7 + iLength + (listModeOfRequest(eType) ? 2 : 0));
+			if(!penaltyAllows(iCost))
 				break;
+			chan.lPending.removeFirst();
+			chargePenalty(iCost);
+			if(!sendRequest(chan, eType))
+				return false;
+			continue;
 		}
+
+		// "WHO <channels>[ %acdfhlnrsu]\r\n"
+		int iExtraLength = 6 + (pConnection->serverInfo()->supportsWhox() ? 12 : 0);
+		qint64 iCost = KviIrcSocket::floodCost("WHO", iExtraLength + iLength);
+		if(!penaltyAllows(iCost))
+			break;
+		chan.lPending.removeFirst();
+
+		// Join the WHO of the next channels too if the server accepts more targets
+		// (maxTargets() is 0 when there is no limit)
+		QList<KviChannelWindow *> lWho;
+		lWho.append(chan.pChan);
+		int iMaxTargets = pConnection->serverInfo()->maxTargets("WHO");
+		for(int i = iChan + 1; (i < m_channels.count()) && (iMaxTargets != 1); i++)
+		{
+			if((iMaxTargets > 0) && (lWho.count() >= iMaxTargets))
+				break;
+			if((m_sent.count() + lWho.count()) >= m_iWindow)
+				break;
+			ChannelRequests & other = m_channels[i];
+			if(!other.bPlanned)
+				planRequests(other);
+			if(!other.lPending.contains(Who))
+				continue;
+			int iOtherLength = pConnection->encodeText(other.pChan->target()).length() + 1;
+			if((iLength + iOtherLength) > KVI_IRCCONNECTIONREQUESTQUEUE_MAX_WHO_TARGETS_LENGTH)
+				break;
+			qint64 iOtherCost = KviIrcSocket::floodCost("WHO", iExtraLength + iLength + iOtherLength);
+			if(!penaltyAllows(iOtherCost))
+				break;
+			iLength += iOtherLength;
+			iCost = iOtherCost;
+			other.lPending.removeOne(Who);
+			lWho.append(other.pChan);
+		}
+
+		chargePenalty(iCost);
+		if(!sendWho(lWho))
+			return false;
 	}
+	return true;
+}
+
+void KviIrcConnectionRequestQueue::timerSlot()
+{
+	QList<KviChannelWindow *> lFinished;
+	collectReplies(nullptr, lFinished);
+
+	if(!lFinished.isEmpty())
+	{
+		// OnChannelSync may close the other windows
+		QList<QPointer<KviChannelWindow>> lSync;
+		for(auto & pChan : lFinished)
+			lSync.append(pChan);
+		for(auto & pChan : lSync)
+		{
+			if(pChan)
+				pChan->checkChannelSync();
+		}
+	}
+
+	if(m_channels.isEmpty())
+		return;
+
+	// the channel requests are sent in the lowest priority lane
+	KviIrcSocket::OutgoingPriority eOldPriority = KviIrcSocket::setOutgoingPriority(KviIrcSocket::Bulk);
+	bool bConnected = sendRequests();
+	KviIrcSocket::setOutgoingPriority(eOldPriority);
+
+	if(!bConnected)
+	{
+		clearAll(); // disconnected
+		return;
+	}
+
+	if(!m_channels.isEmpty())
+		m_timer.start(KVI_IRCCONNECTIONREQUESTQUEUE_POLL_INTERVAL);
 }
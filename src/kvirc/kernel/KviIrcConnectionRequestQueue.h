@@ -32,17 +32,38 @@
 
 #include "kvi_settings.h"
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QTimer>
-#include <QQueue>
 
 class KviChannelWindow;
 
+// Limits of the number of channel requests waiting for a reply
+#define KVI_IRCCONNECTIONREQUESTQUEUE_MIN_WINDOW 1
+#define KVI_IRCCONNECTIONREQUESTQUEUE_INITIAL_WINDOW 2
+#define KVI_IRCCONNECTIONREQUESTQUEUE_MAX_WINDOW 16
+// A request without a reply after this time is given up (msecs)
+#define KVI_IRCCONNECTIONREQUESTQUEUE_REQUEST_TIMEOUT 60000
+// How often the replies are checked while requests are running (msecs)
+#define KVI_IRCCONNECTIONREQUESTQUEUE_POLL_INTERVAL 250
+// Maximum length of the channel list of a WHO with multiple targets
+#define KVI_IRCCONNECTIONREQUESTQUEUE_MAX_WHO_TARGETS_LENGTH 400
+
 /**
 * \class KviIrcConnectionRequestQueue
 * \brief Class to enqueue commands to IRC server
 *
-* This class is designed to delay channel requests like MODE and WHO to avoid
-* excess floods on some servers
+* This class schedules the channel requests like MODE and WHO sent on join.
+* The requests are pipelined: up to a window of them can wait for a reply
+* at the same time. The window grows while the server replies as fast as
+* it did at best and shrinks when the replies slow down or time out.
+* The requests go in the Bulk lane of the socket and no new ones are sent
+* while that lane is still waiting for the flood budget, so the sending
+* rate follows the flood protection. Without the flood protection the queue
+* charges its own requests against the same penalty model and burst budget,
+* so a large window is never sent in a single burst.
+* When the server allows it (TARGMAX ISUPPORT token) the WHO requests
+* of more channels are joined in a single message.
 */
 class KVIRC_API KviIrcConnectionRequestQueue : public QObject
 {
@@ -63,8 +84,8 @@ protected:
 	/**
 	* \enum RequestTypes
 	*
-	* \warning MODE %s b MUST BE THE LAST AUTOMATIC CHANNEL QUERY so we get
-	* RPL_ENDOFBANLIST as the last reply and we know that the channel is in sync
+	* The requests of each channel are sent in this order.
+	* The channel is in sync when all of them have been replied.
 	*/
 	enum RequestTypes
 	{
@@ -76,9 +97,38 @@ protected:
 		Ban = 5           /**< Ban request */
 	};
 
-	QQueue<KviChannelWindow *> m_channels;
+	/**
+	* \struct ChannelRequests
+	* \brief The requests of a queued channel
+	*/
+	struct ChannelRequests
+	{
+		KviChannelWindow * pChan;
+		bool bPlanned;                // lPending has been filled
+		QList<RequestTypes> lPending; // the requests not sent yet
+		int iTotal;                   // the requests planned
+		int iDone;                    // the requests replied (or given up)
+	};
+
+	/**
+	* \struct SentRequest
+	* \brief A request waiting for its reply
+	*/
+	struct SentRequest
+	{
+		KviChannelWindow * pChan;
+		RequestTypes eType;
+		QElapsedTimer tSent;
+		bool bReplied; // set for Mode by channelModeReceived()
+	};
+
+	QList<ChannelRequests> m_channels;
+	QList<SentRequest> m_sent;
 	QTimer m_timer;
-	RequestTypes m_curType = Mode;
+	int m_iWindow = KVI_IRCCONNECTIONREQUESTQUEUE_INITIAL_WINDOW;
+	qint64 m_iMinLatency = -1; // the fastest reply seen (msecs)
+	QElapsedTimer m_tPenaltyClock;
+	qint64 m_iPenaltyTimer = 0; // usecs on m_tPenaltyClock when the penalty of the requests expires
 
 public:
 	/**
@@ -96,20 +146,67 @@ public:
 	void dequeueChannel(KviChannelWindow * pChan);
 
 	/**
-	* \brief Checks if a channel is in the queue stack
+	* \brief Checks if a channel still has requests to send or to be replied
 	* \param pChan The channel to check
 	* \return bool
 	*/
-	bool isQueued(KviChannelWindow * pChan) const { return m_channels.contains(pChan); }
+	bool isQueued(KviChannelWindow * pChan) const { return findChannel(pChan) != -1; }
+
+	/**
+	* \brief Returns the percentage of the requests of the channel that have been replied
+	*
+	* A channel that isn't queued has got all its replies.
+	* \param pChan The channel to check
+	* \return int
+	*/
+	int channelProgress(KviChannelWindow * pChan) const;
+
+	/**
+	* \brief Collects the replies to the requests of the channel
+	*
+	* Called by KviChannelWindow::checkChannelSync() so the channel
+	* is no longer queued as soon as its last reply has arrived.
+	* \param pChan The channel that got a reply
+	* \return void
+	*/
+	void channelStateChanged(KviChannelWindow * pChan);
+
+	/**
+	* \brief Called when the modes of the channel are received (RPL_CHANNELMODEIS)
+	* \param pChan The channel
+	* \return void
+	*/
+	void channelModeReceived(KviChannelWindow * pChan);
 
 	/**
 	* \brief Clears the queue stack
 	* \return void
 	*/
 	void clearAll();
+
+protected:
+	int findChannel(KviChannelWindow * pChan) const;
+	// Returns the mode of a list request, 0 for Mode and Who
+	static char listModeOfRequest(RequestTypes eType);
+	void planRequests(ChannelRequests & chan);
+	bool isReplied(const SentRequest & req) const;
+	// Removes the replied requests of pChan (or of all the channels if null)
+	// and appends the channels that have nothing left to lFinished.
+	// Returns true if any request has been removed
+	bool collectReplies(KviChannelWindow * pChan, QList<KviChannelWindow *> & lFinished);
+	// Returns true if a request with the given cost can be sent now
+	// (always when the socket applies the outgoing traffic limit by itself)
+	bool penaltyAllows(qint64 iCost);
+	void chargePenalty(qint64 iCost);
+	void replyReceived(qint64 iLatency);
+	void requestTimedOut();
+	// Returns false if the connection has been lost
+	bool sendRequests();
+	bool sendRequest(ChannelRequests & chan, RequestTypes eType);
+	bool sendWho(const QList<KviChannelWindow *> & lChans);
 private slots:
 	/**
-	* \brief Performs time based requests
+	* \brief Sends the requests and checks the replies
 	* \return void
 	*/
 	void timerSlot();
@@ -49,6 +49,53 @@ bool KviIrcConnectionServerInfo::isSupportedChannelType(QChar c) const
 	return m_szSupportedChannelTypes.contains(c);
 }
 
+bool KviIrcConnectionServerInfo::setCaseMapping(const QString & szCaseMapping)
+{
+	CaseMapping eMapping;
+	if(KviQString::equalCI(szCaseMapping, "ascii"))
+		eMapping = CaseMappingAscii;
+	else if(KviQString::equalCI(szCaseMapping, "strict-rfc1459"))
+		eMapping = CaseMappingStrictRfc1459;
+	else
+		eMapping = CaseMappingRfc1459; // rfc1459 and anything we don't know about
+
+	if(eMapping == m_eCaseMapping)
+		return false;
+	m_eCaseMapping = eMapping;
+	return true;
+}
+
+QString KviIrcConnectionServerInfo::caseMapped(const QString & szName) const
+{
+	QString szRet = szName.toLower();
+	if(m_eCaseMapping == CaseMappingAscii)
+		return szRet;
+
+	QChar * p = szRet.data();
+	QChar * e = p + szRet.length();
+	while(p < e)
+	{
+		switch(p->unicode())
+		{
+			case '[':
+				*p = QChar('{');
+				break;
+			case ']':
+				*p = QChar('}');
+				break;
+			case '\\':
+				*p = QChar('|');
+				break;
+			case '~':
+				if(m_eCaseMapping == CaseMappingRfc1459)
+					*p = QChar('^');
+				break;
+		}
+		p++;
+	}
+	return szRet;
+}
+
 void KviIrcConnectionServerInfo::addSupportedCaps(const QString & szCapList)
 {
 	m_bSupportsCap = true;
@@ -101,6 +148,31 @@ void KviIrcConnectionServerInfo::setSupportedChannelModes(const QString & szSupp
 	m_szSupportedChannelModes = szSupportedChannelModes;
 }
 
+void KviIrcConnectionServerInfo::setMaxTargets(const QString & szTargMax)
+{
+	// TARGMAX=PRIVMSG:4,NOTICE:4,WHO:,JOIN: (an empty limit means no limit)
+	m_hMaxTargets.clear();
+
+	QStringList lTokens = szTargMax.split(',', QString::SkipEmptyParts);
+	foreach(QString szToken, lTokens)
+	{
+		int iColon = szToken.indexOf(':');
+		if(iColon < 1)
+			continue;
+
+		QString szLimit = szToken.mid(iColon + 1);
+		int iLimit = 0;
+		if(!szLimit.isEmpty())
+		{
+			bool bOk;
+			iLimit = szLimit.toInt(&bOk);
+			if(!bOk || (iLimit < 1))
+				continue;
+		}
+		m_hMaxTargets.insert(szToken.left(iColon).toUpper(), iLimit);
+	}
+}
+
 void KviIrcConnectionServerInfo::setSupportedModePrefixes(const QString & szSupportedModePrefixes, const QString & szSupportedModeFlags)
 {
 	m_szSupportedModeFlags = szSupportedModeFlags;
@@ -28,6 +28,7 @@
 #include "KviQString.h"
 #include "kvi_inttypes.h"
 
+#include <QHash>
 #include <QStringList>
 
 class KviIrcConnectionServerInfo;
@@ -293,6 +294,15 @@ class KVIRC_API KviIrcConnectionServerInfo
 	friend class KviIrcServerParser;
 	friend class KviIrcConnection;
 
+public:
+	// The CASEMAPPING ISUPPORT token: how the server compares nick and channel names
+	enum CaseMapping
+	{
+		CaseMappingAscii,        // A-Z == a-z
+		CaseMappingRfc1459,      // A-Z == a-z, []\~ == {}|^ (the protocol default)
+		CaseMappingStrictRfc1459 // A-Z == a-z, []\ == {}|
+	};
+
 protected:
 	KviIrcConnectionServerInfo();
 	~KviIrcConnectionServerInfo();
@@ -324,6 +334,8 @@ private:
 	bool m_bSupportsCap = false;
 	QStringList m_lSupportedCaps;
 	bool m_bSupportsWhox = false; // supports WHOX
+	QHash<QString, int> m_hMaxTargets; // the TARGMAX ISUPPORT token: upper case command -> max targets (0 = no limit)
+	CaseMapping m_eCaseMapping = CaseMappingRfc1459;
 public:
 	char registerModeChar() const { return m_pServInfo ? m_pServInfo->getRegisterModeChar() : 0; }
 	const char * software() const { return m_pServInfo ? m_pServInfo->getSoftware() : 0; }
@@ -346,9 +358,17 @@ public:
 	bool supportsWatchList() const { return m_bSupportsWatchList; }
 	bool supportsCodePages() const { return m_bSupportsCodePages; }
 	bool supportsWhox() const { return m_bSupportsWhox; }
+	CaseMapping caseMapping() const { return m_eCaseMapping; }
+	// Returns the canonical (case folded) form of a nick or channel name:
+	// two names are equal for the server if their case mapped forms are equal.
+	// Non ASCII characters are folded with QString::toLower() as equalCI() always did.
+	QString caseMapped(const QString & szName) const;
 
 	int maxTopicLen() const { return m_iMaxTopicLen; }
 	int maxModeChanges() const { return m_iMaxModeChanges; }
+	// Returns the number of targets that the command accepts: 0 means no limit.
+	// Commands not listed by the server take only one target
+	int maxTargets(const QString & szCommand) const { return m_hMaxTargets.value(szCommand.toUpper(), 1); }
 
 	void setServerVersion(const QString & version);
 
@@ -381,6 +401,9 @@ protected:
 	void setMaxTopicLen(int iTopLen) { m_iMaxTopicLen = iTopLen; }
 	void setMaxModeChanges(int iModes) { m_iMaxModeChanges = iModes; }
 	void setSupportsWhox(bool bSupportsWhox) { m_bSupportsWhox = bSupportsWhox; }
+	void setMaxTargets(const QString & szTargMax);
+	// returns true if the mapping has actually changed
+	bool setCaseMapping(const QString & szCaseMapping);
 private:
 	void buildModePrefixTable();
 };
@@ -39,12 +39,21 @@ public:
 protected:
 	kvi_time_t m_tConnectionStart = 0; // (valid only when Connected or LoggingIn)
 	kvi_time_t m_tLastMessage = 0;     // last message received from server
+	int m_iSSLHandshakeTime = -1;      // msecs taken by the SSL handshake, -1 if not using SSL
+	bool m_bSSLSessionResumed = false; // true if the SSL handshake resumed a cached session
 public:
 	kvi_time_t connectionStartTime() const { return m_tConnectionStart; }
 	kvi_time_t lastMessageTime() const { return m_tLastMessage; }
+	int sslHandshakeTime() const { return m_iSSLHandshakeTime; }
+	bool sslSessionResumed() const { return m_bSSLSessionResumed; }
 protected:
 	void setLastMessageTime(kvi_time_t t) { m_tLastMessage = t; }
 	void setConnectionStartTime(kvi_time_t t) { m_tConnectionStart = t; }
+	void setSSLHandshake(int iTime, bool bResumed)
+	{
+		m_iSSLHandshakeTime = iTime;
+		m_bSSLSessionResumed = bResumed;
+	}
 };
 
 #endif //!_KVI_IRCCONNECTIONSTATISTICS_H_
@@ -81,7 +81,10 @@ KviIrcContext::~KviIrcContext()
 {
 	killTimer(m_iHeartbeatTimerId);
 
-	for(auto & m : m_pMonitorList)
+	// die() usually unregisters the monitor: don't iterate the list it modifies
+	std::vector<KviIrcDataStreamMonitor *> lMonitors;
+	lMonitors.swap(m_pMonitorList);
+	for(auto & m : lMonitors)
 	{
 		if(m)
 			m->die();
@@ -27,6 +27,8 @@
 #include "kvi_settings.h"
 #include "KviHeapObject.h"
 
+#include <QtGlobal>
+
 class KviIrcContext;
 
 class KVIRC_API KviIrcDataStreamMonitor : public KviHeapObject
@@ -42,6 +44,9 @@ public:
 	virtual bool incomingMessage(const char *) = 0;
 	// For proxy connections it might spit out binary data!
 	virtual bool outgoingMessage(const char *) = 0;
+	// Called after an incoming message that no monitor has eaten has been processed
+	// (parsed, events triggered and output produced) with the time that it took.
+	virtual void incomingMessageProcessed(const char *, qint64 /* iNanoseconds */) {}
 	virtual void connectionInitiated(){}
 	virtual void connectionTerminated(){}
 	virtual void die() { delete this; }
@@ -46,6 +46,7 @@
 #include <QTimer>
 #include <QSocketNotifier>
 #include <memory>
+#include <string.h>
 
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
 #include <unistd.h> //for gettimeofday()
@@ -57,6 +58,9 @@
 
 unsigned int g_uNextIrcLinkId = 1;
 
+// The lane of the packets sent now, see KviIrcSocket::setOutgoingPriority()
+static KviIrcSocket::OutgoingPriority g_eOutgoingPriority = KviIrcSocket::Script;
+
 KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
     : QObject(), m_pLink(pLink)
 {
@@ -65,8 +69,7 @@ KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
 
 	m_pConsole = m_pLink->console();
 
-	m_tAntiFloodLastMessageTime.tv_sec = 0;
-	m_tAntiFloodLastMessageTime.tv_usec = 0;
+	m_tFloodClock.start();
 
 	if(KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout) < 100)
 		KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout) = 100; // this is our minimum, we don't want to lag the app
@@ -131,8 +134,7 @@ void KviIrcSocket::reset()
 	m_uReadBytes = 0;
 	m_uSentBytes = 0;
 	m_uSentPackets = 0;
-	m_tAntiFloodLastMessageTime.tv_sec = 0;
-	m_tAntiFloodLastMessageTime.tv_usec = 0;
+	m_iFloodTimer = 0;
 
 	m_bInProcessData = false;
 
@@ -154,18 +156,9 @@ void KviIrcSocket::clearOutputQueue(bool bPrivateMessagesOnly)
 
 unsigned int KviIrcSocket::outputQueueSize()
 {
-	KviIrcSocketMsgEntry * pMsg = m_pSendQueueTail;
-	if(!pMsg)
-		return 0;
-
 	unsigned int uCount = 0;
-
-	do
-	{
-		uCount++;
-		pMsg = pMsg->next_ptr;
-	} while(pMsg);
-
+	for(auto & lane : m_aSendLanes)
+		uCount += lane.lPacketLengths.count();
 	return uCount;
 }
 
@@ -528,7 +521,8 @@ void KviIrcSocket::enterSSLMode()
 {
 	Q_ASSERT(!m_pSSL); // Don't call this function twice in a session
 
-	m_pSSL = KviSSLMaster::allocSSL(m_pConsole, m_sock, KviSSL::Client);
+	// Reconnecting to the same server resumes the previous session (if the server allows it)
+	m_pSSL = KviSSLMaster::allocSSL(m_pConsole, m_sock, KviSSL::Client, nullptr, QString("irc:%1:%2").arg(m_pIrcServer->hostName()).arg(m_pIrcServer->port()));
 	if(!m_pSSL)
 	{
 		raiseSSLError();
@@ -537,6 +531,9 @@ void KviIrcSocket::enterSSLMode()
 		return;
 	}
 	setState(SSLHandshake);
+	m_iSSLHandshakeTime = -1;
+	m_bSSLSessionReused = false;
+	m_tSSLHandshake.start();
 	doSSLHandshake(0);
 }
 #endif //COMPILE_SSL_SUPPORT
@@ -1360,6 +1357,12 @@ void KviIrcSocket::doSSLHandshake(int)
 	{
 		case KviSSL::Success:
 			// done!
+			m_iSSLHandshakeTime = (int)m_tSSLHandshake.elapsed();
+			m_bSSLSessionReused = m_pSSL->sessionReused();
+			if(m_bSSLSessionReused)
+				outputSSLMessage(__tr2qs("Resumed a previous SSL session, the handshake took %1 msecs").arg(m_iSSLHandshakeTime));
+			else
+				outputSSLMessage(__tr2qs("Negotiated a new SSL session, the handshake took %1 msecs").arg(m_iSSLHandshakeTime));
 			printSSLCipherInfo();
 			printSSLPeerCertificate();
 			linkUp();
@@ -1379,6 +1382,8 @@ void KviIrcSocket::doSSLHandshake(int)
 			reset();
 			break;
 		case KviSSL::SSLError:
+			// don't offer a session that the server may choke on at the next attempt
+			KviSSL::forgetSession(m_pSSL->sessionCacheKey());
 			raiseSSLError();
 			raiseError(KviError::SSLError);
 			reset();
@@ -1535,7 +1540,7 @@ void KviIrcSocket::readData(int)
 	// and the message queue flushing
 	m_bInProcessData = false;
 	// and flush the queue too!
-	if(m_pSendQueueHead)
+	if(queue_nextLane() >= 0)
 		flushSendQueue();
 }
 
@@ -1577,97 +1582,205 @@ void KviIrcSocket::handleInvalidSocketRead(int iReadLength)
 	}
 }
 
-void KviIrcSocket::queue_insertMessage(KviIrcSocketMsgEntry * pMsg)
+// Copies iLen bytes starting at iFrom from a circular buffer of iRingSize bytes
+static void ring_copy(const char * pcRing, int iRingSize, int iFrom, char * pcDest, int iLen)
 {
-	KVI_ASSERT(pMsg);
+	int iFirst = qMin(iLen, iRingSize - iFrom);
+	KviMemory::copy(pcDest, pcRing + iFrom, iFirst);
+	if(iFirst < iLen)
+		KviMemory::copy(pcDest + iFirst, pcRing, iLen - iFirst);
+}
 
-	pMsg->next_ptr = nullptr;
+void KviIrcSocket::queue_resizeRing(int iLane, int iNewSize)
+{
+	KviIrcSocketSendLane & lane = m_aSendLanes[iLane];
+	KVI_ASSERT(iNewSize >= lane.iUsed);
+
+	char * pcNewRing = (char *)KviMemory::allocate(iNewSize);
+	if(lane.iUsed > 0)
+		ring_copy(lane.pcRing, lane.iSize, lane.iHead, pcNewRing, lane.iUsed);
+
+	if(lane.pcRing)
+		KviMemory::free(lane.pcRing);
+	lane.pcRing = pcNewRing;
+	lane.iSize = iNewSize;
+	lane.iHead = 0;
+}
 
-	if(m_pSendQueueHead)
-	{
-		m_pSendQueueTail->next_ptr = pMsg;
-		m_pSendQueueTail = pMsg;
-	}
-	else
+void KviIrcSocket::queue_insertMessage(int iLane, const char * pcData, int iLen)
+{
+	if(iLen <= 0)
+		return;
+
+	KviIrcSocketSendLane & lane = m_aSendLanes[iLane];
+
+	if((lane.iSize - lane.iUsed) < iLen)
 	{
-		m_pSendQueueHead = pMsg;
-		m_pSendQueueTail = pMsg;
+		int iNewSize = (lane.iSize > 0) ? lane.iSize : KVI_IRCSOCKET_SEND_RING_INITIAL_SIZE;
+		while((iNewSize - lane.iUsed) < iLen)
+			iNewSize *= 2;
+		queue_resizeRing(iLane, iNewSize);
 	}
-}
 
-void KviIrcSocket::free_msgEntry(KviIrcSocketMsgEntry * e)
-{
-	if(e->pData)
-		delete e->pData;
+	// the tail may wrap around the end of the ring
+	int iTail = (lane.iHead + lane.iUsed) % lane.iSize;
+	int iFirst = qMin(iLen, lane.iSize - iTail);
+	KviMemory::copy(lane.pcRing + iTail, pcData, iFirst);
+	if(iFirst < iLen)
+		KviMemory::copy(lane.pcRing, pcData + iFirst, iLen - iFirst);
 
-	e->pData = nullptr;
-	KviMemory::free(e);
+	lane.iUsed += iLen;
+	lane.lPacketLengths.enqueue(iLen);
 }
 
-bool KviIrcSocket::queue_removeMessage()
+void KviIrcSocket::queue_removeSentData(int iLane, int iLen)
 {
-	KVI_ASSERT(m_pSendQueueTail);
-	KVI_ASSERT(m_pSendQueueHead);
+	KviIrcSocketSendLane & lane = m_aSendLanes[iLane];
+	KVI_ASSERT(iLen <= lane.iUsed);
 
-	if(m_pSendQueueHead->pData)
-		delete m_pSendQueueHead->pData;
+	m_uSentBytes += iLen;
+	lane.iHead = (lane.iHead + iLen) % lane.iSize;
+	lane.iUsed -= iLen;
 
-	KviIrcSocketMsgEntry * pEntry = m_pSendQueueHead;
-	m_pSendQueueHead = pEntry->next_ptr;
-	KviMemory::free((void *)pEntry);
+	while(iLen > 0)
+	{
+		int & iHeadLen = lane.lPacketLengths.head();
+		if(iLen < iHeadLen)
+		{
+			iHeadLen -= iLen;
+			lane.bHeadPacketStarted = true;
+			break;
+		}
+		iLen -= iHeadLen;
+		lane.lPacketLengths.dequeue();
+		lane.bHeadPacketStarted = false;
+		m_uSentPackets++;
+	}
 
-	if(m_pSendQueueHead == nullptr)
+	// a started packet must be completed before any other lane can be flushed
+	m_iSendActiveLane = lane.bHeadPacketStarted ? iLane : -1;
+
+	if(lane.iUsed == 0)
 	{
-		m_pSendQueueTail = nullptr;
-		return false;
+		// start again from the beginning so the next writes are contiguous
+		lane.iHead = 0;
+		if(lane.iSize > KVI_IRCSOCKET_SEND_RING_MAX_IDLE_SIZE)
+			queue_resizeRing(iLane, KVI_IRCSOCKET_SEND_RING_INITIAL_SIZE);
 	}
-	else
-		return true;
 }
 
 void KviIrcSocket::queue_removeAllMessages()
 {
-	if(m_pSendQueueHead)
-		while(queue_removeMessage())
+	for(auto & lane : m_aSendLanes)
+	{
+		if(lane.pcRing)
 		{
+			KviMemory::free(lane.pcRing);
+			lane.pcRing = nullptr;
 		}
+		lane.iSize = 0;
+		lane.iHead = 0;
+		lane.iUsed = 0;
+		lane.lPacketLengths.clear();
+		lane.bHeadPacketStarted = false;
+	}
+	m_iSendActiveLane = -1;
+	m_iSSLPendingWrite = 0;
 }
 
 void KviIrcSocket::queue_removePrivateMessages()
 {
-	KviIrcSocketMsgEntry * pPrevEntry = nullptr;
-	KviIrcSocketMsgEntry * pEntry = m_pSendQueueHead;
-	while(pEntry)
+	char szCommand[7];
+
+	for(int iLane = 0; iLane < KVI_IRCSOCKET_NUM_SEND_LANES; iLane++)
 	{
-		if(pEntry->pData->size() > 7)
+		KviIrcSocketSendLane & lane = m_aSendLanes[iLane];
+		if(lane.lPacketLengths.isEmpty())
+			continue;
+
+		// The bytes already handed to the socket can't be taken back:
+		// a started packet and the ones covered by an SSL write to be retried stay
+		int iLocked = (iLane == m_iSendActiveLane) ? m_iSSLPendingWrite : 0;
+		char * pcNewRing = (char *)KviMemory::allocate(lane.iSize);
+		QQueue<int> lNewLengths;
+		int iNewUsed = 0;
+		int iOffset = 0;
+
+		for(int i = 0; i < lane.lPacketLengths.count(); i++)
 		{
-			if(kvi_strEqualCIN((char *)(pEntry->pData->data()), "PRIVMSG", 7))
+			int iPacketLen = lane.lPacketLengths.at(i);
+			int iFrom = (lane.iHead + iOffset) % lane.iSize;
+			bool bKeep = true;
+
+			if((iOffset >= iLocked) && !((i == 0) && lane.bHeadPacketStarted) && (iPacketLen > 7))
 			{
-				// remove it
-				if(pPrevEntry)
-				{
-					pPrevEntry->next_ptr = pEntry->next_ptr;
-					if(!pPrevEntry->next_ptr)
-						m_pSendQueueTail = nullptr;
-					free_msgEntry(pEntry);
-					pEntry = pPrevEntry->next_ptr;
-				}
-				else
-				{
-					m_pSendQueueHead = pEntry->next_ptr;
-					if(!m_pSendQueueHead)
-						m_pSendQueueTail = nullptr;
-					free_msgEntry(pEntry);
-					pEntry = m_pSendQueueHead;
-				}
-				continue;
+				ring_copy(lane.pcRing, lane.iSize, iFrom, szCommand, 7);
+				if(kvi_strEqualCIN(szCommand, "PRIVMSG", 7))
+					bKeep = false;
+			}
+
+			if(bKeep)
+			{
+				ring_copy(lane.pcRing, lane.iSize, iFrom, pcNewRing + iNewUsed, iPacketLen);
+				iNewUsed += iPacketLen;
+				lNewLengths.enqueue(iPacketLen);
 			}
+
+			iOffset += iPacketLen;
 		}
-		pPrevEntry = pEntry;
-		pEntry = pEntry->next_ptr;
+
+		KviMemory::free(lane.pcRing);
+		lane.pcRing = pcNewRing;
+		lane.iHead = 0;
+		lane.iUsed = iNewUsed;
+		lane.lPacketLengths = lNewLengths;
 	}
 }
 
+int KviIrcSocket::queue_nextLane()
+{
+	if((m_iSendActiveLane >= 0) && (m_aSendLanes[m_iSendActiveLane].iUsed > 0))
+		return m_iSendActiveLane;
+
+	for(int iLane = 0; iLane < KVI_IRCSOCKET_NUM_SEND_LANES; iLane++)
+	{
+		if(m_aSendLanes[iLane].iUsed > 0)
+			return iLane;
+	}
+	return -1;
+}
+
+qint64 KviIrcSocket::floodCost(const char * pcCommand, int iPacketLen)
+{
+	// This models the message timer of RFC 1459 (section 8.10) as ircu implements it:
+	// every message costs 2 seconds plus one more every 120 bytes. The base cost
+	// is the user option and the commands that make the server work hard cost double.
+	static const char * szExpensiveCommands[] = { "WHO", "LIST", "NAMES", "INVITE", "KICK", nullptr };
+
+	qint64 iBaseCost = KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds);
+	qint64 iCost = iBaseCost + ((iBaseCost * iPacketLen) / 240);
+
+	for(int i = 0; szExpensiveCommands[i]; i++)
+	{
+		if(kvi_strEqualCIN(pcCommand, szExpensiveCommands[i], (int)strlen(szExpensiveCommands[i])))
+			return iCost + iBaseCost;
+	}
+	return iCost;
+}
+
+qint64 KviIrcSocket::queue_packetFloodCost(int iLane)
+{
+	KviIrcSocketSendLane & lane = m_aSendLanes[iLane];
+	int iPacketLen = lane.lPacketLengths.head();
+
+	char szCommand[8];
+	int iCommandLen = qMin(iPacketLen, 7);
+	ring_copy(lane.pcRing, lane.iSize, lane.iHead, szCommand, iCommandLen);
+	szCommand[iCommandLen] = '\0';
+
+	return floodCost(szCommand, iPacketLen);
+}
+
 void KviIrcSocket::flushSendQueue()
 {
 	// If we're called from the flush timer, stop it
@@ -1677,51 +1790,70 @@ void KviIrcSocket::flushSendQueue()
 	// OK...have something to send...
 	KVI_ASSERT(m_state != Idle);
 
-	struct timeval curTime;
-
-	while(m_pSendQueueHead)
+	for(;;)
 	{
+		int iLane = queue_nextLane();
+		if(iLane < 0)
+			return; // flushed completely
+
+		KviIrcSocketSendLane & lane = m_aSendLanes[iLane];
+		int iToSend = lane.iUsed;
+
 		if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
 		{
-			kvi_gettimeofday(&curTime);
+			// the head packet of the active lane has already been paid for
+			if(iLane != m_iSendActiveLane)
+			{
+				qint64 iNow = m_tFloodClock.nsecsElapsed() / 1000;
+				if(m_iFloodTimer < iNow)
+					m_iFloodTimer = iNow;
+
+				// Wait until the penalty of this packet fits in the budget.
+				// A packet that costs more than the whole budget goes when the penalty expires
+				qint64 iCost = queue_packetFloodCost(iLane);
+				qint64 iExcess = m_iFloodTimer + iCost - iNow - KVI_OPTION_UINT(KviOption_uintOutgoingTrafficBurstUSeconds);
+				if((iExcess > 0) && (m_iFloodTimer > iNow))
+				{
+					// need to wait for a while....
+					m_pFlushTimer->start((int)(qMin(iExcess, m_iFloodTimer - iNow) / 1000) + 1);
+					return;
+				} // else can send
 
-			int iTimeDiff = curTime.tv_usec - m_tAntiFloodLastMessageTime.tv_usec;
-			iTimeDiff += (curTime.tv_sec - m_tAntiFloodLastMessageTime.tv_sec) * 1000000;
+				m_iFloodTimer += iCost;
+				m_iSendActiveLane = iLane;
+			}
 
-			if(((unsigned int)iTimeDiff) < KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds))
-			{
-				// need to wait for a while....
-				m_pFlushTimer->start(((KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds) - iTimeDiff) / 1000) + 1);
-				return;
-			} // else can send
+			// release only the head packet
+			iToSend = lane.lPacketLengths.head();
 		}
-		// Write one data buffer...
+
+		// The data is in at most two pieces: up to the end of the ring and from its start
+		int iFirst = qMin(iToSend, lane.iSize - lane.iHead);
 		int iResult;
 #ifdef COMPILE_SSL_SUPPORT
 		if(m_pSSL)
 		{
-			iResult = m_pSSL->write((char *)(m_pSendQueueHead->pData->data()), m_pSendQueueHead->pData->size());
+			// Coalesce the packets in a single record.
+			// A write that failed with WantRead/WantWrite must be retried with the same length
+			if(m_iSSLPendingWrite > 0)
+				iToSend = m_iSSLPendingWrite;
+			else
+				iToSend = qMin(iFirst, KVI_IRCSOCKET_TLS_RECORD_SIZE);
+			m_iSSLPendingWrite = 0;
+			iResult = m_pSSL->write(lane.pcRing + lane.iHead, iToSend);
 		}
 		else
 		{
 #endif
-			iResult = kvi_socket_send(m_sock, (char *)(m_pSendQueueHead->pData->data()), m_pSendQueueHead->pData->size());
+			iResult = kvi_socket_sendv(m_sock, lane.pcRing + lane.iHead, iFirst, lane.pcRing, iToSend - iFirst);
 #ifdef COMPILE_SSL_SUPPORT
 		}
 #endif
-		if(iResult == (int)m_pSendQueueHead->pData->size())
+		if(iResult == iToSend)
 		{
-			// Successful send...remove this data buffer
-			m_uSentPackets++;
-			m_uSentBytes += iResult;
-			//if(m_pConsole->hasMonitors())outgoingMessageNotifyMonitors((char *)(m_pSendQueueHead->pData->data()),result);
-			queue_removeMessage();
-			if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
-			{
-				m_tAntiFloodLastMessageTime.tv_sec = curTime.tv_sec;
-				m_tAntiFloodLastMessageTime.tv_usec = curTime.tv_usec;
-			}
-			// And try next buffer...
+			// Successful send...remove the data from the ring
+			queue_removeSentData(iLane, iResult);
+			// And try the rest...
 			continue;
 		}
 		else
@@ -1738,6 +1870,8 @@ void KviIrcSocket::flushSendQueue()
 						case KviSSL::WantWrite:
 						case KviSSL::WantRead:
 							// Async continue...
+							m_iSSLPendingWrite = iToSend;
+							m_iSendActiveLane = iLane;
 							m_pFlushTimer->start(KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout));
 							return;
 							break;
@@ -1789,9 +1923,8 @@ void KviIrcSocket::flushSendQueue()
 #endif // COMPILE_SSL_SUPPORT
 
 				// Partial send...need to finish it later
-				m_pSendQueueHead->pData->remove(iResult);
+				queue_removeSentData(iLane, iResult);
 
-				m_uSentBytes += iResult;
 				if(_OUTPUT_VERBOSE)
 					outputSocketWarning(__tr2qs("Partial socket write: packet broken into smaller pieces."));
 #ifndef COMPILE_SSL_SUPPORT
@@ -1920,12 +2053,7 @@ bool KviIrcSocket::sendRawData(const char * pcBuffer, int iBuflen)
 	if((m_state == Idle) || (m_state == Connecting))
 		return false;
 
-	//new buffer
-	KviIrcSocketMsgEntry * pEntry = (KviIrcSocketMsgEntry *)KviMemory::allocate(sizeof(KviIrcSocketMsgEntry));
-	pEntry->pData = new KviDataBuffer(iBuflen);
-
-	KviMemory::move(pEntry->pData->data(), pcBuffer, iBuflen);
-	queue_insertMessage(pEntry);
+	queue_insertMessage(g_eOutgoingPriority, pcBuffer, iBuflen);
 
 	if(!m_bInProcessData)
 		flushSendQueue();
@@ -1933,6 +2061,34 @@ bool KviIrcSocket::sendRawData(const char * pcBuffer, int iBuflen)
 	return (m_state != Idle);
 }
 
+// PONG and CTCP replies: the server and the other clients are waiting for them
+static bool is_reply_packet(const char * pcData, int iLen)
+{
+	if((iLen >= 4) && kvi_strEqualCIN(pcData, "PONG", 4))
+		return true;
+
+	if((iLen > 7) && kvi_strEqualCIN(pcData, "NOTICE ", 7))
+	{
+		const char * pcText = (const char *)memchr(pcData + 7, ':', iLen - 7);
+		if(pcText && ((pcText + 1) < (pcData + iLen)) && (pcText[1] == 0x01))
+			return true;
+	}
+
+	return false;
+}
+
+KviIrcSocket::OutgoingPriority KviIrcSocket::setOutgoingPriority(OutgoingPriority ePriority)
+{
+	OutgoingPriority eOld = g_eOutgoingPriority;
+	g_eOutgoingPriority = ePriority;
+	return eOld;
+}
+
+KviIrcSocket::OutgoingPriority KviIrcSocket::outgoingPriority()
+{
+	return g_eOutgoingPriority;
+}
+
 bool KviIrcSocket::sendPacket(KviDataBuffer * pData)
 {
 	if(m_state != Connected)
@@ -1942,9 +2098,10 @@ bool KviIrcSocket::sendPacket(KviDataBuffer * pData)
 		return false;
 	}
 
-	KviIrcSocketMsgEntry * pEntry = (KviIrcSocketMsgEntry *)KviMemory::allocate(sizeof(KviIrcSocketMsgEntry));
-	pEntry->pData = pData;
-	queue_insertMessage(pEntry);
+	const char * pcData = (const char *)(pData->data());
+	int iLane = is_reply_packet(pcData, pData->size()) ? Interactive : g_eOutgoingPriority;
+	queue_insertMessage(iLane, pcData, pData->size());
+	delete pData;
 
 	if(!m_bInProcessData)
 		flushSendQueue();
@@ -39,6 +39,8 @@
 #include "KviTimeUtils.h"
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QQueue>
 
 #include <memory>
 
@@ -53,15 +55,27 @@ class KviSSL;
 class QSocketNotifier;
 class QTimer;
 
+// Initial size of the send ring, it grows by doubling when needed
+#define KVI_IRCSOCKET_SEND_RING_INITIAL_SIZE 4096
+// An empty ring bigger than this is given back to the system
+#define KVI_IRCSOCKET_SEND_RING_MAX_IDLE_SIZE 65536
+// Maximum plaintext size of a TLS record: SSL writes are coalesced up to this size
+#define KVI_IRCSOCKET_TLS_RECORD_SIZE 16384
+// Number of priority lanes of the send queue, see KviIrcSocket::OutgoingPriority
+#define KVI_IRCSOCKET_NUM_SEND_LANES 3
+
 /**
-* \typedef KviIrcSocketMsgEntry
-* \struct _KviIrcSocketMsgEntry
-* \brief Holds the messages entries
+* \struct KviIrcSocketSendLane
+* \brief A circular buffer of outgoing packets with the same priority
 */
-struct KviIrcSocketMsgEntry
+struct KviIrcSocketSendLane
 {
-	KviDataBuffer * pData;
-	KviIrcSocketMsgEntry * next_ptr;
+	char * pcRing = nullptr;         // a circular buffer of iSize bytes
+	int iSize = 0;
+	int iHead = 0;                   // offset of the first byte to send
+	int iUsed = 0;                   // number of bytes waiting in the ring
+	QQueue<int> lPacketLengths;      // unsent bytes of each queued packet, the head one first
+	bool bHeadPacketStarted = false; // the head packet has been partially sent
 };
 
 /**
@@ -106,6 +120,17 @@ public:
 		SSLHandshake             /**< Socket is doing the SSL handshake */
 	};
 
+	/**
+	* \enum OutgoingPriority
+	* \brief The send queue lanes, flushed in this order
+	*/
+	enum OutgoingPriority
+	{
+		Interactive = 0, /**< User input, PONG and CTCP replies */
+		Script = 1,      /**< Script output: the default */
+		Bulk = 2         /**< Slow paste and the automatic channel requests */
+	};
+
 protected:
 	unsigned int m_uId;
 	KviIrcLink * m_pLink;
@@ -121,11 +146,16 @@ protected:
 	unsigned int m_uSentBytes = 0;         // total sent bytes per session
 	unsigned int m_uSentPackets = 0;       // total packets sent per session
 	KviError::Code m_eLastError = KviError::Success;
-	KviIrcSocketMsgEntry * m_pSendQueueHead = nullptr; // data queue
-	KviIrcSocketMsgEntry * m_pSendQueueTail = nullptr;
+	KviIrcSocketSendLane m_aSendLanes[KVI_IRCSOCKET_NUM_SEND_LANES];
+	int m_iSendActiveLane = -1;             // the lane whose head packet must be completed first
+	int m_iSSLPendingWrite = 0;             // length of an SSL write that must be retried as it is
 	std::unique_ptr<QTimer> m_pFlushTimer;
-	struct timeval m_tAntiFloodLastMessageTime;
+	QElapsedTimer m_tFloodClock;
+	qint64 m_iFloodTimer = 0;               // usecs on m_tFloodClock when the modeled server penalty expires
 	bool m_bInProcessData = false;
+	QElapsedTimer m_tSSLHandshake;
+	int m_iSSLHandshakeTime = -1; // msecs, -1 if no SSL handshake has been completed
+	bool m_bSSLSessionReused = false;
 #ifdef COMPILE_SSL_SUPPORT
 	KviSSL * m_pSSL = nullptr;
 #endif
@@ -180,6 +210,18 @@ public:
 	*/
 	KviSSL * getSSL() const { return m_pSSL; }
 #endif
+
+	/**
+	* \brief Returns the duration of the last completed SSL handshake
+	* \return int The time in milliseconds or -1 if no handshake has been completed
+	*/
+	int sslHandshakeTime() const { return m_iSSLHandshakeTime; }
+
+	/**
+	* \brief Returns true if the last SSL handshake resumed a previous session
+	* \return bool
+	*/
+	bool sslSessionReused() const { return m_bSSLSessionReused; }
 	/**
 	* \brief Returns the number of bytes read
 	* \return unsigned int
@@ -226,11 +268,29 @@ public:
 
 	/**
 	* \brief Returns true if the packet is sent to the socket
+	*
+	* PONG and CTCP replies always go in the Interactive lane, the other
+	* packets in the lane set by setOutgoingPriority().
 	* \param pData The source data packet
 	* \return bool
 	*/
 	bool sendPacket(KviDataBuffer * pData);
 
+	/**
+	* \brief Sets the lane of the packets sent from now on, by all the sockets
+	*
+	* The caller should restore the previous value when done.
+	* \param ePriority The new priority
+	* \return OutgoingPriority The previous priority
+	*/
+	static OutgoingPriority setOutgoingPriority(OutgoingPriority ePriority);
+
+	/**
+	* \brief Returns the lane of the packets sent now
+	* \return OutgoingPriority
+	*/
+	static OutgoingPriority outgoingPriority();
+
 	/**
 	* \brief Aborts the connection
 	* \return void
@@ -258,6 +318,27 @@ public:
 	*/
 	unsigned int outputQueueSize();
 
+	/**
+	* \brief Returns true if some packets of the lane are still waiting to be sent
+	*
+	* The senders of bulk traffic use this to follow the flood budget
+	* instead of filling the queue.
+	* \param ePriority The lane to check
+	* \return bool
+	*/
+	bool hasQueuedData(OutgoingPriority ePriority) const { return m_aSendLanes[ePriority].iUsed > 0; }
+
+	/**
+	* \brief Returns the penalty that the server gives to a message
+	*
+	* The model of the outgoing traffic limit: the senders that pace
+	* themselves use it to follow the same budget.
+	* \param pcCommand The beginning of the message (at least the command)
+	* \param iPacketLen The length of the whole message, CRLF included
+	* \return qint64 The cost in usecs
+	*/
+	static qint64 floodCost(const char * pcCommand, int iPacketLen);
+
 protected:
 #ifdef COMPILE_SSL_SUPPORT
 	/**
@@ -405,26 +486,25 @@ protected:
 	virtual void reset();
 
 	/**
-	* \brief Removes the message entry
-	* \param e The entry
+	* \brief Copies a message at the tail of the ring of a lane
+	*
+	* The ring grows if needed.
+	* \param iLane The lane
+	* \param pcData The message data
+	* \param iLen The length of the message
 	* \return void
 	*/
-	void free_msgEntry(KviIrcSocketMsgEntry * e);
+	void queue_insertMessage(int iLane, const char * pcData, int iLen);
 
 	/**
-	* \brief Appends a KviIrcSocketMsgEntry to the tail of the message queue.
+	* \brief Removes the bytes that have been sent from the head of the ring of a lane
 	*
-	* The pMsg for this message is set to 0.
-	* \param pMsg The message to append to the queue
+	* Updates the packet and byte counters.
+	* \param iLane The lane
+	* \param iLen The number of bytes sent
 	* \return void
 	*/
-	virtual void queue_insertMessage(KviIrcSocketMsgEntry * pMsg);
-
-	/**
-	* \brief Removes a message from the head of the queue.
-	* \return bool
-	*/
-	bool queue_removeMessage();
+	void queue_removeSentData(int iLane, int iLen);
 
 	/**
 	* \brief Removes all messages from the queue.
@@ -434,10 +514,36 @@ protected:
 
 	/**
 	* \brief Removes private messages from the queue.
+	*
+	* The packets that have already been partially handed to the socket are kept.
 	* \return void
 	*/
 	void queue_removePrivateMessages();
 
+	/**
+	* \brief Moves the ring contents of a lane to a buffer of iNewSize bytes, starting at offset 0
+	* \param iLane The lane
+	* \param iNewSize The new ring size, at least the used size
+	* \return void
+	*/
+	void queue_resizeRing(int iLane, int iNewSize);
+
+	/**
+	* \brief Returns the lane to flush next
+	*
+	* This is the lane with a started packet, if any, otherwise
+	* the first lane with data.
+	* \return int The lane or -1 if there is nothing to send
+	*/
+	int queue_nextLane();
+
+	/**
+	* \brief Returns the penalty that the server gives to the head packet of a lane
+	* \param iLane The lane
+	* \return qint64 The cost in usecs
+	*/
+	qint64 queue_packetFloodCost(int iLane);
+
 	/**
 	* \brief Sets the state of the socket
 	* \param state The state :)
@@ -528,6 +634,11 @@ protected slots:
 	/**
 	* \brief Attempts to send as much as possible to the server
 	*
+	* The lanes are flushed in priority order. Plain sockets send all the
+	* data of a lane with a single gather write, SSL sockets coalesce the
+	* packets into records of up to KVI_IRCSOCKET_TLS_RECORD_SIZE bytes.
+	* With the outgoing traffic limit active the packets are released one
+	* at a time, as long as the modeled server penalty stays in the budget.
 	* If fails (happens only on really lagged servers) calls itself with a
 	* QTimer shot after KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout)
 	* ms to retry again...
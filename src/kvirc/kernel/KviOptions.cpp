@@ -333,7 +333,9 @@ KviBoolOption g_boolOptionsTable[KVI_NUM_BOOL_OPTIONS] = {
 	BOOL_OPTION("MenuBarVisible", true, KviOption_sectFlagFrame | KviOption_resetUpdateGui),
 	BOOL_OPTION("WarnAboutHidingMenuBar", true, KviOption_sectFlagFrame),
 	BOOL_OPTION("WhoRepliesToActiveWindow", false, KviOption_sectFlagConnection),
-	BOOL_OPTION("DropConnectionOnSaslFailure", false, KviOption_sectFlagConnection)
+	BOOL_OPTION("DropConnectionOnSaslFailure", false, KviOption_sectFlagConnection),
+	BOOL_OPTION("UseDccResumeLedger", true, KviOption_sectFlagDcc),
+	BOOL_OPTION("HashReceivedDccFiles", false, KviOption_sectFlagDcc)
 };
 
 // NOTICE: REUSE EQUIVALENT UNUSED KviOption_bool in KviOptions.h ENTRIES BEFORE ADDING NEW ENTRIES ABOVE
@@ -637,7 +639,9 @@ KviUIntOption g_uintOptionsTable[KVI_NUM_UINT_OPTIONS] = {
 	UINT_OPTION("ToolBarButtonStyle", 0, KviOption_groupTheme), // 0 = Qt::ToolButtonIconOnly
 	UINT_OPTION("MaximumBlowFishKeySize", 56, KviOption_sectFlagNone),
 	UINT_OPTION("CustomCursorWidth", 1, KviOption_resetUpdateGui),
-	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme)
+	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme),
+	UINT_OPTION("ImageCacheMaxSize", 32768, KviOption_sectFlagNone), // in KiB
+	UINT_OPTION("OutgoingTrafficBurstUSeconds", 8000000, KviOption_sectFlagIrcSocket)
 };
 
 #define FONT_OPTION(_name, _face, _size, _flags) \
@@ -355,10 +355,12 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_boolWarnAboutHidingMenuBar 262
 #define KviOption_boolWhoRepliesToActiveWindow 263                             /* irc::output */
 #define KviOption_boolDropConnectionOnSaslFailure 264                          /* connection::advanced */
+#define KviOption_boolUseDccResumeLedger 265                                   /* dcc::send */
+#define KviOption_boolHashReceivedDccFiles 266                                 /* dcc::send */
 
 // NOTICE: REUSE EQUIVALENT UNUSED BOOL_OPTION in KviOptions.cpp ENTRIES BEFORE ADDING NEW ENTRIES ABOVE
 
-#define KVI_NUM_BOOL_OPTIONS 265
+#define KVI_NUM_BOOL_OPTIONS 267
 
 #define KVI_STRING_OPTIONS_PREFIX "string"
 #define KVI_STRING_OPTIONS_PREFIX_LEN 6
@@ -597,8 +599,10 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_uintMaximumBlowFishKeySize 80
 #define KviOption_uintCustomCursorWidth 81                                    /* Interface */
 #define KviOption_uintUserListMinimumWidth 82
+#define KviOption_uintImageCacheMaxSize 83
+#define KviOption_uintOutgoingTrafficBurstUSeconds 84                          /* connection::transport */
 
-#define KVI_NUM_UINT_OPTIONS 83
+#define KVI_NUM_UINT_OPTIONS 85
 
 namespace KviIdentdOutputMode
 {
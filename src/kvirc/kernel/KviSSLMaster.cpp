@@ -33,6 +33,10 @@
 #include "KviLocale.h"
 #include "KviKvsVariant.h"
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+
 #ifdef COMPILE_ON_WINDOWS
 //
 // Since OpenSSL 0.9.8 we need to link in a piece of code from the OpenSSL source.
@@ -50,6 +54,8 @@
 
 namespace KviSSLMaster
 {
+	// The certificate setup used by the last allocSSL() call
+	static QString g_szLastSSLConfigKey;
 
 	KVIRC_API void printSSLCipherInfo(KviWindow * wnd, const char * description, KviSSLCipherInfo * c)
 	{
@@ -112,19 +118,39 @@ namespace KviSSLMaster
 			wnd->outputNoFmt(KVI_OUT_SSL, __tr2qs("[SSL]: Can't find out the current cipher info"));
 	}
 
-	KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString)
+	KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString, const QString & szSessionCacheKey)
 	{
+		// the contexts are shared between all the sockets using the same certificate setup:
+		// a change in the options (or in the files on disk) simply leads to a new context
+		QString szConfigKey;
+		if(KVI_OPTION_BOOL(KviOption_boolUseSSLCertificate))
+			szConfigKey += QString("cert=%1:%2:%3;").arg(KVI_OPTION_STRING(KviOption_stringSSLCertificatePath), KVI_OPTION_STRING(KviOption_stringSSLCertificatePass)).arg(QFileInfo(KVI_OPTION_STRING(KviOption_stringSSLCertificatePath)).lastModified().toMSecsSinceEpoch());
+		if(KVI_OPTION_BOOL(KviOption_boolUseSSLPrivateKey))
+			szConfigKey += QString("key=%1:%2:%3;").arg(KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath), KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPass)).arg(QFileInfo(KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath)).lastModified().toMSecsSinceEpoch());
+
+		if(szConfigKey != g_szLastSSLConfigKey)
+		{
+			// the sessions negotiated with the old certificate must not be resumed
+			KviSSL::flushSharedState();
+			g_szLastSSLConfigKey = szConfigKey;
+		}
+
 		KviSSL * s = new KviSSL();
-		if(!s->initContext(m))
+		bool bCreated = false;
+		if(!s->initSharedContext(m, szConfigKey, &bCreated))
 		{
 			delete s;
 			return nullptr;
 		}
 
+		// a context that failed to load the certificate or the key is not shared
+		bool bShareContext = bCreated;
+
 		if(!contextString)
 			contextString = KviCString::emptyString().ptr();
 
-		if(KVI_OPTION_BOOL(KviOption_boolUseSSLCertificate))
+		// a shared context has the certificate and the key already loaded
+		if(bCreated && KVI_OPTION_BOOL(KviOption_boolUseSSLCertificate))
 		{
 			switch(s->useCertificateFile(
 			    KVI_OPTION_STRING(KviOption_stringSSLCertificatePath),
@@ -137,9 +163,11 @@ namespace KviSSLMaster
 				case KviSSL::FileIoError:
 					if(wnd)
 						wnd->output(KVI_OUT_SSL, __tr2qs("[%s]: [SSL ERROR]: File I/O error while trying to use the certificate file %s"), contextString, KVI_OPTION_STRING(KviOption_stringSSLCertificatePath).toUtf8().data());
+					bShareContext = false;
 					break;
 				default:
 				{
+					bShareContext = false;
 					KviCString buffer;
 					while(s->getLastErrorString(buffer))
 					{
@@ -150,7 +178,7 @@ namespace KviSSLMaster
 				break;
 			}
 		}
-		if(KVI_OPTION_BOOL(KviOption_boolUseSSLPrivateKey))
+		if(bCreated && KVI_OPTION_BOOL(KviOption_boolUseSSLPrivateKey))
 		{
 			switch(s->usePrivateKeyFile(
 			    KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath),
@@ -163,9 +191,11 @@ namespace KviSSLMaster
 				case KviSSL::FileIoError:
 					if(wnd)
 						wnd->output(KVI_OUT_SSL, __tr2qs("[%s]: [SSL ERROR]: File I/O error while trying to use the private key file %s"), contextString, KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath).toUtf8().data());
+					bShareContext = false;
 					break;
 				default:
 				{
+					bShareContext = false;
 					KviCString buffer;
 					while(s->getLastErrorString(buffer))
 					{
@@ -177,12 +207,24 @@ namespace KviSSLMaster
 			}
 		}
 
+		if(bShareContext)
+			s->shareContext();
+
 		if(!s->initSocket(sock))
 		{
 			delete s;
 			return nullptr;
 		}
 
+		if(m == KviSSL::Client)
+		{
+			// a session is bound to the client certificate it was negotiated with
+			QString szKey = szSessionCacheKey;
+			if(!szKey.isEmpty())
+				szKey += QString("#%1").arg(QString::fromLatin1(QCryptographicHash::hash(szConfigKey.toUtf8(), QCryptographicHash::Sha1).toHex()));
+			s->setSessionCacheKey(szKey);
+		}
+
 		return s;
 	}
 
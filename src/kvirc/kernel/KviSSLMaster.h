@@ -41,7 +41,10 @@ namespace KviSSLMaster
 
 	extern KVIRC_API void printSSLConnectionInfo(KviWindow * wnd, KviSSL * s);
 
-	extern KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString = nullptr);
+	// The SSL context is shared with the other sockets using the same method and certificate options.
+	// If szSessionCacheKey is not empty (client mode only) a session previously
+	// negotiated with the same key is offered for resumption.
+	extern KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString = nullptr, const QString & szSessionCacheKey = QString());
 	extern KVIRC_API void freeSSL(KviSSL * s);
 
 	extern KVIRC_API bool getSSLCertInfo(KviSSLCertificate * pCert, QString szQuery, QString szOptionalParam, KviKvsVariant * pRetBuffer);
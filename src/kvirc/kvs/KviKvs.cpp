@@ -25,6 +25,7 @@
 #include "KviKvs.h"
 #include "KviKvsKernel.h"
 #include "KviKvsAliasManager.h"
+#include "KviKvsIdleParser.h"
 #include "KviKvsDnsManager.h"
 #include "KviKvsTimerManager.h"
 #include "KviKvsPopupManager.h"
@@ -45,11 +46,13 @@ namespace KviKvs
 		KviKvsScriptAddonManager::init();
 		KviKvsTimerManager::init();
 		KviKvsDnsManager::init();
+		KviKvsIdleParser::init();
 	}
 
 	void done()
 	{
 		//KviKvsScriptManager::done();
+		KviKvsIdleParser::done();
 		KviKvsEventManager::done();
 		KviKvsPopupManager::done();
 		KviKvsAliasManager::done();
@@ -24,6 +24,7 @@
 
 #include "KviKvsAliasManager.h"
 #include "KviConfigurationFile.h"
+#include "KviKvsIdleParser.h"
 
 KviKvsAliasManager * KviKvsAliasManager::m_pAliasManager = nullptr;
 
@@ -168,6 +169,7 @@ void KviKvsAliasManager::load(const QString & filename)
 		{
 			KviKvsScript * m = new KviKvsScript(*s, szCode);
 			m_pAliasDict->insert(*s, m);
+			KviKvsIdleParser::instance()->enqueue(m);
 		}
 		++it;
 	}
@@ -25,7 +25,11 @@
 #include "KviKvsArray.h"
 #include "KviMemory.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <utility>
+#include <vector>
 
 #define KVI_KVS_ARRAY_ALLOC_CHUNK 8
 
@@ -91,10 +95,87 @@ int KviKvsArray::compare(const void * pV1, const void * pV2)
 	return 0;
 }
 
+unsigned int KviKvsArray::elementTypes(bool & bHoles) const
+{
+	unsigned int uTypes = 0;
+	bHoles = false;
+	for(kvs_uint_t u = 0; u < m_uSize; u++)
+	{
+		if(m_pData[u] && !m_pData[u]->isNothing())
+			uTypes |= m_pData[u]->type();
+		else
+			bHoles = true;
+	}
+	return uTypes;
+}
+
+template <typename Key>
+static void kvs_array_sort_by_key(KviKvsVariant ** pData, std::vector<std::pair<Key, KviKvsVariant *>> & items, bool bReverse)
+{
+	if(bReverse)
+		std::stable_sort(items.begin(), items.end(), [](const std::pair<Key, KviKvsVariant *> & a, const std::pair<Key, KviKvsVariant *> & b) { return b.first < a.first; });
+	else
+		std::stable_sort(items.begin(), items.end(), [](const std::pair<Key, KviKvsVariant *> & a, const std::pair<Key, KviKvsVariant *> & b) { return a.first < b.first; });
+
+	for(size_t u = 0; u < items.size(); u++)
+		pData[u] = items[u].second;
+}
+
+bool KviKvsArray::sortByKey(bool bReverse)
+{
+	// Arrays of nicknames or samples are almost always homogeneous:
+	// extract the keys once and sort them without going through
+	// KviKvsVariant::compare() for each comparison.
+	bool bHoles;
+	unsigned int uTypes = elementTypes(bHoles);
+	if(bHoles)
+		return false;
+
+	if(uTypes == KviKvsVariantData::Integer)
+	{
+		std::vector<std::pair<kvs_int_t, KviKvsVariant *>> items;
+		items.reserve(m_uSize);
+		for(kvs_uint_t u = 0; u < m_uSize; u++)
+			items.emplace_back(m_pData[u]->integer(), m_pData[u]);
+		kvs_array_sort_by_key(m_pData, items, bReverse);
+		return true;
+	}
+
+	if((uTypes & ~(KviKvsVariantData::Integer | KviKvsVariantData::Real)) == 0)
+	{
+		std::vector<std::pair<kvs_real_t, KviKvsVariant *>> items;
+		items.reserve(m_uSize);
+		for(kvs_uint_t u = 0; u < m_uSize; u++)
+		{
+			kvs_real_t dVal = m_pData[u]->isInteger() ? (kvs_real_t)m_pData[u]->integer() : m_pData[u]->real();
+			if(std::isnan(dVal))
+				return false; // no strict ordering
+			items.emplace_back(dVal, m_pData[u]);
+		}
+		kvs_array_sort_by_key(m_pData, items, bReverse);
+		return true;
+	}
+
+	if(uTypes == KviKvsVariantData::String)
+	{
+		// same ordering as the case insensitive QString::compare() used by KviKvsVariant
+		std::vector<std::pair<QString, KviKvsVariant *>> items;
+		items.reserve(m_uSize);
+		for(kvs_uint_t u = 0; u < m_uSize; u++)
+			items.emplace_back(m_pData[u]->string().toCaseFolded(), m_pData[u]);
+		kvs_array_sort_by_key(m_pData, items, bReverse);
+		return true;
+	}
+
+	return false;
+}
+
 void KviKvsArray::sort()
 {
 	if(m_uSize < 2)
 		return; // already sorted
+	if(sortByKey(false))
+		return;
 	qsort(m_pData, m_uSize, sizeof(KviKvsVariant *), compare);
 	findNewSize();
 }
@@ -103,10 +184,202 @@ void KviKvsArray::rsort()
 {
 	if(m_uSize < 2)
 		return; // already sorted
+	if(sortByKey(true))
+		return;
 	qsort(m_pData, m_uSize, sizeof(KviKvsVariant *), compareReverse);
 	findNewSize();
 }
 
+kvs_int_t KviKvsArray::find(const KviKvsVariant * pVal, kvs_uint_t uStart) const
+{
+	if(pVal->isInteger())
+	{
+		// fast path for the common integer lookups:
+		// the empty items match exactly as in the generic loop below
+		kvs_int_t iVal = pVal->integer();
+		bool bMatchesEmpty = pVal->isEqualToNothing();
+		for(kvs_uint_t u = uStart; u < m_uSize; u++)
+		{
+			KviKvsVariant * v = m_pData[u];
+			if(!v)
+			{
+				if(bMatchesEmpty)
+					return u;
+				continue;
+			}
+			if(v->isInteger())
+			{
+				if(v->integer() == iVal)
+					return u;
+			}
+			else if(v->compare(pVal, true) == 0)
+			{
+				return u;
+			}
+		}
+		return -1;
+	}
+
+	for(kvs_uint_t u = uStart; u < m_uSize; u++)
+	{
+		if(m_pData[u])
+		{
+			if(m_pData[u]->compare(pVal, true) == 0)
+				return u;
+		}
+		else
+		{
+			if(pVal->isEqualToNothing())
+				return u;
+		}
+	}
+	return -1;
+}
+
+bool KviKvsArray::sum(KviKvsVariant * pResult) const
+{
+	kvs_int_t iSum = 0;
+	kvs_real_t dSum = 0.0;
+	bool bReal = false;
+
+	for(kvs_uint_t u = 0; u < m_uSize; u++)
+	{
+		KviKvsVariant * v = m_pData[u];
+		if(!v || v->isNothing())
+			continue;
+		if(v->isInteger())
+		{
+			iSum += v->integer();
+		}
+		else if(v->isReal())
+		{
+			dSum += v->real();
+			bReal = true;
+		}
+		else
+		{
+			KviKvsNumber nb;
+			if(!v->asNumber(nb))
+				return false;
+			if(nb.isInteger())
+			{
+				iSum += nb.integer();
+			}
+			else
+			{
+				dSum += nb.real();
+				bReal = true;
+			}
+		}
+	}
+
+	if(bReal)
+		pResult->setReal(dSum + (kvs_real_t)iSum);
+	else
+		pResult->setInteger(iSum);
+	return true;
+}
+
+KviKvsVariant * KviKvsArray::extreme(bool bMaximum) const
+{
+	KviKvsVariant * pBest = nullptr;
+
+	bool bHoles;
+	unsigned int uTypes = elementTypes(bHoles);
+
+	if(uTypes == KviKvsVariantData::Integer)
+	{
+		for(kvs_uint_t u = 0; u < m_uSize; u++)
+		{
+			KviKvsVariant * v = m_pData[u];
+			if(!v || v->isNothing())
+				continue;
+			if(!pBest || (bMaximum ? (v->integer() > pBest->integer()) : (v->integer() < pBest->integer())))
+				pBest = v;
+		}
+		return pBest;
+	}
+
+	if(uTypes && ((uTypes & ~(KviKvsVariantData::Integer | KviKvsVariantData::Real)) == 0))
+	{
+		kvs_real_t dBest = 0.0;
+		for(kvs_uint_t u = 0; u < m_uSize; u++)
+		{
+			KviKvsVariant * v = m_pData[u];
+			if(!v || v->isNothing())
+				continue;
+			kvs_real_t dVal = v->isInteger() ? (kvs_real_t)v->integer() : v->real();
+			if(!pBest || (bMaximum ? (dVal > dBest) : (dVal < dBest)))
+			{
+				pBest = v;
+				dBest = dVal;
+			}
+		}
+		return pBest;
+	}
+
+	for(kvs_uint_t u = 0; u < m_uSize; u++)
+	{
+		KviKvsVariant * v = m_pData[u];
+		if(!v || v->isNothing())
+			continue;
+		if(!pBest)
+		{
+			pBest = v;
+			continue;
+		}
+		// compare() returns a positive value if v is greater than pBest
+		int iCmp = pBest->compare(v, true);
+		if(bMaximum ? (iCmp > 0) : (iCmp < 0))
+			pBest = v;
+	}
+	return pBest;
+}
+
+void KviKvsArray::join(QString & szBuffer, const QString & szSeparator, bool bSkipEmpty) const
+{
+	bool bHoles;
+	if(elementTypes(bHoles) == KviKvsVariantData::String)
+	{
+		// avoid reallocating the buffer over and over
+		int iLen = szBuffer.length();
+		for(kvs_uint_t u = 0; u < m_uSize; u++)
+		{
+			if(m_pData[u])
+				iLen += m_pData[u]->string().length();
+			iLen += szSeparator.length();
+		}
+		szBuffer.reserve(iLen);
+	}
+
+	bool bFirst = true;
+	QString szTmp;
+	for(kvs_uint_t u = 0; u < m_uSize; u++)
+	{
+		KviKvsVariant * v = m_pData[u];
+		if(!v && bSkipEmpty)
+			continue;
+
+		if(bFirst)
+			bFirst = false;
+		else
+			szBuffer.append(szSeparator);
+
+		if(!v)
+			continue;
+
+		if(v->isString())
+		{
+			szBuffer.append(v->string());
+		}
+		else
+		{
+			v->asString(szTmp);
+			szBuffer.append(szTmp);
+		}
+	}
+}
+
 void KviKvsArray::unset(kvs_uint_t uIdx)
 {
 	if(uIdx >= m_uSize)
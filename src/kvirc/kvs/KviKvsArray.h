@@ -144,6 +144,47 @@ public:
 	*/
 	void rsort();
 
+	/**
+	* \brief Finds the first element equal to the given value
+	*
+	* The elements are compared like the == operator does
+	* \param pVal The value to look for
+	* \param uStart The index to start the search from
+	* \return kvs_int_t The index of the element or -1 if it's not found
+	*/
+	kvs_int_t find(const KviKvsVariant * pVal, kvs_uint_t uStart = 0) const;
+
+	/**
+	* \brief Sums the numeric elements of the array
+	*
+	* The result is an integer if all the elements are integers
+	* and a real otherwise. Empty elements are skipped.
+	* \param pResult The variant to store the result in
+	* \return bool False if a non numeric element is found
+	*/
+	bool sum(KviKvsVariant * pResult) const;
+
+	/**
+	* \brief Returns the smallest element of the array
+	* \return KviKvsVariant * The element or nullptr if the array is empty
+	*/
+	KviKvsVariant * minimum() const { return extreme(false); };
+
+	/**
+	* \brief Returns the greatest element of the array
+	* \return KviKvsVariant * The element or nullptr if the array is empty
+	*/
+	KviKvsVariant * maximum() const { return extreme(true); };
+
+	/**
+	* \brief Joins the elements of the array as strings
+	* \param szBuffer The buffer to store the result in
+	* \param szSeparator The string to put between two elements
+	* \param bSkipEmpty Skip the empty elements instead of joining an empty string
+	* \return void
+	*/
+	void join(QString & szBuffer, const QString & szSeparator, bool bSkipEmpty = false) const;
+
 protected:
 	/**
 	* \brief Finds the new size of the array
@@ -152,6 +193,30 @@ protected:
 	void findNewSize();
 
 private:
+	/**
+	* \brief Returns the types of the elements of the array
+	*
+	* This allows picking a typed kernel when all the elements share
+	* the same type (or are all numeric).
+	* \param bHoles Set to true if there are empty elements
+	* \return unsigned int The KviKvsVariantData::Type values or-ed together
+	*/
+	unsigned int elementTypes(bool & bHoles) const;
+
+	/**
+	* \brief Sorts the array by extracting typed sort keys
+	* \param bReverse Sort in descending order
+	* \return bool False if the elements can't be sorted this way
+	*/
+	bool sortByKey(bool bReverse);
+
+	/**
+	* \brief Returns the smallest or greatest element of the array
+	* \param bMaximum Return the greatest element
+	* \return KviKvsVariant *
+	*/
+	KviKvsVariant * extreme(bool bMaximum) const;
+
 	/**
 	* \brief Compares two elements of the array
 	* \param pV1 The first element to compare
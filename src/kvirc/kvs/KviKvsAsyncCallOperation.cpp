@@ -0,0 +1,282 @@
+//=============================================================================
+//
+//   File : KviKvsAsyncCallOperation.cpp
+//   Creation date : Mon 19 Oct 2026 17:42:08 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsAsyncCallOperation.h"
+#include "KviKvsScript.h"
+#include "KviKvsVariant.h"
+#include "KviKvsVariantList.h"
+#include "KviKvsArray.h"
+#include "KviApplication.h"
+#include "KviFileUtils.h"
+#include "KviLocale.h"
+#include "KviMiscUtils.h"
+#include "KviQString.h"
+#include "KviWindow.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+// same default limit as $file.read()
+#define KVI_KVS_ASYNCCALL_DEFAULT_READ_SIZE (1024 * 1024)
+
+//
+// The pure routines. These run in a thread of the global pool.
+//
+
+static KviError::Code asynccall_file_read(const QStringList & lParams, KviKvsVariant * pResult, QString & szErrorParam)
+{
+	QString szFileName = lParams.value(0);
+	if(szFileName.left(2) != "\\\\")
+		KviFileUtils::adjustFilePath(szFileName);
+
+	bool bOk = false;
+	uint uSize = lParams.value(1).toUInt(&bOk);
+	if(!bOk)
+		uSize = KVI_KVS_ASYNCCALL_DEFAULT_READ_SIZE;
+
+	QByteArray data;
+	KviError::Code eError = KviFileUtils::readFileData(szFileName, data, uSize);
+	if(eError != KviError::Success)
+	{
+		szErrorParam = szFileName;
+		return eError;
+	}
+
+	// the string ends at the first null byte, as with $file.read()
+	if(lParams.value(2).indexOf('l', 0, Qt::CaseInsensitive) == -1)
+		pResult->setString(QString::fromUtf8(data.constData()));
+	else
+		pResult->setString(QString::fromLocal8Bit(data.constData()));
+	return KviError::Success;
+}
+
+static KviError::Code asynccall_file_readLines(const QStringList & lParams, KviKvsVariant * pResult, QString & szErrorParam)
+{
+	QString szFileName = lParams.value(0);
+	if(szFileName.left(2) != "\\\\")
+		KviFileUtils::adjustFilePath(szFileName);
+
+	int iStartLine = lParams.value(1).toInt();
+	int iCount = lParams.value(2).toInt();
+	bool bUtf8 = lParams.value(3).indexOf('l', 0, Qt::CaseInsensitive) == -1;
+
+	QStringList sl;
+	KviError::Code eError = KviFileUtils::readLines(szFileName, sl, iStartLine, iCount, bUtf8);
+	if(eError != KviError::Success)
+	{
+		szErrorParam = szFileName;
+		return eError;
+	}
+
+	KviKvsArray * pArray = new KviKvsArray();
+	for(const auto & it : sl)
+		pArray->append(new KviKvsVariant(it));
+	pResult->setArray(pArray);
+	return KviError::Success;
+}
+
+static KviError::Code asynccall_file_ls(const QStringList & lParams, KviKvsVariant * pResult, QString & szErrorParam)
+{
+	QString szDir = lParams.value(0);
+	if(szDir.left(2) != "\\\\")
+		KviFileUtils::adjustFilePath(szDir);
+
+	QStringList sl;
+	KviError::Code eError = KviFileUtils::listDirectory(szDir, sl, lParams.value(1), lParams.value(2));
+	if(eError != KviError::Success)
+	{
+		szErrorParam = szDir;
+		return eError;
+	}
+
+	KviKvsArray * pArray = new KviKvsArray();
+	for(const auto & it : sl)
+		pArray->append(new KviKvsVariant(it));
+	pResult->setArray(pArray);
+	return KviError::Success;
+}
+
+static KviError::Code asynccall_str_digest(const QStringList & lParams, KviKvsVariant * pResult, QString & szErrorParam)
+{
+	QString szDigest;
+	KviError::Code eError = KviMiscUtils::digest(lParams.value(0), lParams.value(1), szDigest);
+	if(eError != KviError::Success)
+	{
+		szErrorParam = lParams.value(1);
+		return eError;
+	}
+
+	pResult->setString(szDigest);
+	return KviError::Success;
+}
+
+struct KviKvsAsyncCallRoutineEntry
+{
+	const char * pcName;
+	KviKvsAsyncCallRoutine pRoutine;
+};
+
+// The functions listed here must be pure: no windows, no connections,
+// no KVS state. Keep the list sorted by name.
+static const KviKvsAsyncCallRoutineEntry g_AsyncCallRoutines[] = {
+	{ "file.ls", asynccall_file_ls },
+	{ "file.read", asynccall_file_read },
+	{ "file.readLines", asynccall_file_readLines },
+	{ "str.digest", asynccall_str_digest },
+	{ nullptr, nullptr }
+};
+
+KviKvsAsyncCallRoutine KviKvsAsyncCallOperation::findRoutine(const QString & szFunction)
+{
+	for(const KviKvsAsyncCallRoutineEntry * e = g_AsyncCallRoutines; e->pcName; e++)
+	{
+		if(KviQString::equalCI(szFunction, e->pcName))
+			return e->pRoutine;
+	}
+	return nullptr;
+}
+
+//
+// The job is shared between the operation (GUI thread) and the pool thread:
+// whoever finishes last deletes it.
+//
+
+class KviKvsAsyncCallJob : public QRunnable
+{
+public:
+	KviKvsAsyncCallJob(KviKvsAsyncCallOperation * pOperation, KviKvsAsyncCallRoutine pRoutine, const QStringList & lParams)
+	    : QRunnable(), m_pOperation(pOperation), m_pRoutine(pRoutine), m_lParams(lParams)
+	{
+		setAutoDelete(false);
+	}
+
+public:
+	KviKvsAsyncCallOperation * m_pOperation; // protected by m_Mutex
+	KviKvsAsyncCallRoutine m_pRoutine;
+	QStringList m_lParams;
+	KviKvsVariant m_Result;
+	KviError::Code m_eError = KviError::Success;
+	QString m_szErrorParam;
+	bool m_bDone = false; // protected by m_Mutex
+	QMutex m_Mutex;
+
+public:
+	void run() override
+	{
+		m_eError = m_pRoutine(m_lParams, &m_Result, m_szErrorParam);
+
+		QMutexLocker locker(&m_Mutex);
+		m_bDone = true;
+		if(m_pOperation)
+		{
+			// the posted event is discarded if the operation dies before it's delivered
+			QMetaObject::invokeMethod(m_pOperation, "jobFinished", Qt::QueuedConnection);
+			return;
+		}
+		locker.unlock();
+		delete this;
+	}
+
+	// called by the operation when it's destroyed
+	void orphan()
+	{
+		QMutexLocker locker(&m_Mutex);
+		if(m_bDone)
+		{
+			locker.unlock();
+			delete this;
+			return;
+		}
+		// still running: the pool thread will delete us
+		m_pOperation = nullptr;
+	}
+};
+
+KviKvsAsyncCallOperation::KviKvsAsyncCallOperation(KviWindow * pWnd, const QString & szFunction, KviKvsAsyncCallRoutine pRoutine, const QStringList & lParams, KviKvsScript * pCallback, KviKvsVariant * pMagic)
+    : KviKvsAsyncOperation(pWnd)
+{
+	m_szFunction = szFunction;
+	m_pCallback = pCallback;
+	m_pMagic = pMagic;
+	m_pJob = new KviKvsAsyncCallJob(this, pRoutine, lParams);
+	QThreadPool::globalInstance()->start(m_pJob);
+}
+
+KviKvsAsyncCallOperation::~KviKvsAsyncCallOperation()
+{
+	m_pJob->orphan();
+	delete m_pMagic;
+	delete m_pCallback;
+}
+
+// the routines don't translate anything: the catalogues must be accessed from the GUI thread only
+QString KviKvsAsyncCallOperation::errorMessage(KviError::Code eError, const QString & szParam)
+{
+	switch(eError)
+	{
+		case KviError::CantOpenFileForReading:
+			return __tr2qs_ctx("Can't open the file '%1' for reading", "kvs").arg(szParam);
+		case KviError::FileIOError:
+			return __tr2qs_ctx("Read error for file '%1'", "kvs").arg(szParam);
+		case KviError::NoSuchFile:
+			return __tr2qs_ctx("The specified directory doesn't exist '%1'", "kvs").arg(szParam);
+		case KviError::FeatureNotAvailable:
+			return __tr2qs_ctx("%1 algorithm is not supported", "kvs").arg(szParam);
+		default:
+			return KviError::getDescription(eError);
+	}
+}
+
+void KviKvsAsyncCallOperation::jobFinished()
+{
+	KviWindow * pWnd = window();
+	if(!g_pApp->windowExists(pWnd))
+		pWnd = g_pActiveWindow;
+
+	if(m_pCallback)
+	{
+		KviKvsVariantList params;
+		params.setAutoDelete(true);
+		params.append(new KviKvsVariant(m_szFunction));
+		if(m_pJob->m_eError == KviError::Success)
+		{
+			params.append(new KviKvsVariant((kvs_int_t)1));
+			KviKvsVariant * pResult = new KviKvsVariant();
+			pResult->takeFrom(m_pJob->m_Result);
+			params.append(pResult);
+		}
+		else
+		{
+			params.append(new KviKvsVariant((kvs_int_t)0));
+			params.append(new KviKvsVariant(errorMessage(m_pJob->m_eError, m_pJob->m_szErrorParam)));
+		}
+		params.append(m_pMagic ? new KviKvsVariant(*m_pMagic) : new KviKvsVariant());
+
+		m_pCallback->run(pWnd, &params, nullptr, KviKvsScript::PreserveParams);
+	}
+
+	delete this;
+}
@@ -0,0 +1,73 @@
+#ifndef _KVI_KVS_ASYNCCALLOPERATION_H_
+#define _KVI_KVS_ASYNCCALLOPERATION_H_
+//=============================================================================
+//
+//   File : KviKvsAsyncCallOperation.h
+//   Creation date : Mon 19 Oct 2026 17:42:08 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+#include "KviKvsAsyncOperation.h"
+#include "KviError.h"
+
+#include <QString>
+#include <QStringList>
+
+class KviWindow;
+class KviKvsScript;
+class KviKvsVariant;
+class KviKvsAsyncCallJob;
+
+//
+// A routine that can be executed outside of the GUI thread.
+// It must not touch any KVS context, window or global object:
+// it gets its parameters as plain strings and builds a brand new result.
+// On failure it returns the error code and sets szErrorParam to the
+// argument of the message (like the file name): the message itself
+// is translated later in the GUI thread.
+//
+typedef KviError::Code (*KviKvsAsyncCallRoutine)(const QStringList & lParams, KviKvsVariant * pResult, QString & szErrorParam);
+
+class KVIRC_API KviKvsAsyncCallOperation : public KviKvsAsyncOperation
+{
+	friend class KviKvsAsyncCallJob;
+	Q_OBJECT
+public:
+	KviKvsAsyncCallOperation(KviWindow * pWnd, const QString & szFunction, KviKvsAsyncCallRoutine pRoutine, const QStringList & lParams, KviKvsScript * pCallback = nullptr, KviKvsVariant * pMagic = nullptr);
+	virtual ~KviKvsAsyncCallOperation();
+
+protected:
+	QString m_szFunction;
+	KviKvsVariant * m_pMagic;
+	KviKvsScript * m_pCallback;
+	KviKvsAsyncCallJob * m_pJob;
+
+public:
+	// returns the routine for the pure function szFunction (like "file.read") or nullptr
+	static KviKvsAsyncCallRoutine findRoutine(const QString & szFunction);
+
+protected:
+	static QString errorMessage(KviError::Code eError, const QString & szParam);
+protected slots:
+	void jobFinished();
+};
+
+#endif //!_KVI_KVS_ASYNCCALLOPERATION_H_
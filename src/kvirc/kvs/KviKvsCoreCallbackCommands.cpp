@@ -28,6 +28,7 @@
 #include "KviKvsTimerManager.h"
 #include "KviKvsAliasManager.h"
 #include "KviKvsVariantList.h"
+#include "KviKvsAsyncCallOperation.h"
 #include "KviKvsAsyncDnsOperation.h"
 #include "KviKvsEventManager.h"
 #include "KviKvsProcessManager.h"
@@ -46,6 +47,88 @@
 
 namespace KviKvsCoreCallbackCommands
 {
+	/*
+		@doc: acall
+		@type:
+			command
+		@title:
+			acall
+		@syntax:
+			acall (<function:string>[,<magicdata:variant>[,<parameter:string>[,<parameter:string>[,...]]]]){ <callback command> }
+		@short:
+			Calls a function without blocking the user interface
+		@description:
+			Calls <function> with the specified parameters in a background thread
+			and reports the result by calling the callback routine.
+			This is useful for functions that may take a long time to complete,
+			like reading a large file: the user interface and the connections keep
+			running while the function is executing.[br]
+			Only the functions that don't depend on any window, connection or script state
+			can be called this way. Currently these are:[br]
+			[fnc]$file.ls[/fnc], [fnc]$file.read[/fnc], [fnc]$file.readLines[/fnc]
+			and [fnc]$str.digest[/fnc].
+			The parameters have the same meaning as in the corresponding function.[br]
+			The callback command gets passed four parameters:[br]
+			$0 contains the name of the function[br]
+			$1 contains the value 1 if the call was successful.[br]
+			$2 contains the return value of the function, or an error message if $1 is 0[br]
+			$3 contains the eventual <magicdata> passed.[br]
+			acall returns immediately: the code that needs the result must be in the callback.
+		@examples:
+			[example]
+			acall("file.read","Hello :)","/var/log/messages",10000000)
+			{
+				if($1)
+				{
+					[cmd]echo[/cmd] "Read "$length($2)" characters (magic: $3)"
+				} else {
+					[cmd]echo[/cmd] "Error: $2"
+				}
+			}
+			acall("str.digest",,%data,"sha256")
+			{
+				[cmd]echo[/cmd] "Digest: $2"
+			}
+			[/example]
+		@seealso:
+			[cmd]ahost[/cmd]
+	*/
+
+	KVSCCC(acall)
+	{
+		QString szFunction;
+		KviKvsVariant * pMagicPtr;
+		QStringList lParams;
+		KVSCCC_PARAMETERS_BEGIN
+		KVSCCC_PARAMETER("function", KVS_PT_NONEMPTYSTRING, 0, szFunction)
+		KVSCCC_PARAMETER("magic", KVS_PT_VARIANT, KVS_PF_OPTIONAL, pMagicPtr)
+		KVSCCC_PARAMETER("parameters", KVS_PT_STRINGLIST, KVS_PF_OPTIONAL, lParams)
+		KVSCCC_PARAMETERS_END
+
+		if(szFunction.startsWith('$'))
+			szFunction.remove(0, 1);
+
+		KviKvsAsyncCallRoutine pRoutine = KviKvsAsyncCallOperation::findRoutine(szFunction);
+		if(!pRoutine)
+		{
+			KVSCCC_pContext->error(__tr2qs_ctx("The function '%Q' can't be called asynchronously", "kvs"), &szFunction);
+			return false;
+		}
+
+		KviKvsVariant * pMagic = pMagicPtr ? new KviKvsVariant(*pMagicPtr) : new KviKvsVariant();
+
+		// the operation deletes itself after running the callback
+		new KviKvsAsyncCallOperation(
+		    KVSCCC_pContext->window(),
+		    szFunction,
+		    pRoutine,
+		    lParams,
+		    new KviKvsScript(*KVSCCC_pCallback),
+		    pMagic);
+
+		return true;
+	}
+
 	/*
 		@doc: ahost
 		@type:
@@ -1222,6 +1305,7 @@ namespace KviKvsCoreCallbackCommands
 		pKern->registerCoreCallbackCommandExecRoutine(QString(__cmdName), r);                \
 	}
 
+		_REGCMD("acall", acall);
 		_REGCMD("ahost", ahost);
 		_REGCMD("awhois", awhois);
 		_REGCMD("alias", alias);
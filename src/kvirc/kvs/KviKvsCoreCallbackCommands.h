@@ -60,6 +60,7 @@
 
 namespace KviKvsCoreCallbackCommands
 {
+	KVSCCC(acall);
 	KVSCCC(ahost);
 	KVSCCC(awhois);
 	KVSCCC(alias);
@@ -79,6 +79,7 @@ namespace KviKvsCoreFunctions
 		_REGFNC("ic", context);
 		_REGFNC("icon", icon);
 		_REGFNC("iconName", iconName);
+		_REGFNC("indexOf", indexOf)
 		_REGFNC("insideAlias", insideAlias)
 		_REGFNC("int", integer)
 		_REGFNC("integer", integer)
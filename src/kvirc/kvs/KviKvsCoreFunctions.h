@@ -85,6 +85,7 @@ namespace KviKvsCoreFunctions
 	KVSCF(i);
 	KVSCF(icon);
 	KVSCF(iconName);
+	KVSCF(indexOf);
 	KVSCF(insideAlias);
 	KVSCF(integer);
 	KVSCF(isAnyConsoleConnected);
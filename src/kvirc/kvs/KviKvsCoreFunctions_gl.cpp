@@ -447,6 +447,50 @@ namespace KviKvsCoreFunctions
 		return true;
 	}
 
+	/*
+		@doc: indexOf
+		@type:
+			function
+		@title:
+			$indexOf
+		@short:
+			Finds an item in an array
+		@syntax:
+			<integer> $indexOf(<data:array>,<value:variant>[,<start:uint>])
+		@description:
+			Returns the index of the first item of <data> that is equal to <value>
+			or -1 if there is no such item.
+			The items are compared like the == operator does.
+			If <start> is specified, the search begins at that index.
+		@examples:
+			[example]
+				%a[] = "alpha"
+				%a[] = "beta"
+				echo $indexOf(%a,"beta")
+			[/example]
+		@seealso:
+			[fnc]$sort[/fnc]
+	*/
+
+	KVSCF(indexOf)
+	{
+		KviKvsArrayCast a;
+		KviKvsVariant * v;
+		kvs_uint_t uStart;
+
+		KVSCF_PARAMETERS_BEGIN
+		KVSCF_PARAMETER("data", KVS_PT_ARRAYCAST, 0, a)
+		KVSCF_PARAMETER("value", KVS_PT_VARIANT, 0, v)
+		KVSCF_PARAMETER("start", KVS_PT_UINT, KVS_PF_OPTIONAL, uStart)
+		KVSCF_PARAMETERS_END
+
+		if(a.array())
+			KVSCF_pRetBuffer->setInteger(a.array()->find(v, uStart));
+		else
+			KVSCF_pRetBuffer->setInteger(-1);
+		return true;
+	}
+
 	/*
 		@doc: insideAlias
 		@type:
@@ -0,0 +1,128 @@
+//=============================================================================
+//
+//   File : KviKvsIdleParser.cpp
+//   Creation date : Mon 19 Oct 2026 14:10:21 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsIdleParser.h"
+#include "KviKvsScript.h"
+
+#include <QElapsedTimer>
+
+// delay before the first slice: let the main window show up first
+#define KVI_KVS_IDLEPARSER_START_DELAY 1500
+// delay between two slices
+#define KVI_KVS_IDLEPARSER_SLICE_DELAY 20
+// maximum time spent parsing in a single slice (msecs)
+#define KVI_KVS_IDLEPARSER_SLICE_DURATION 8
+
+KviKvsIdleParser * KviKvsIdleParser::m_pInstance = nullptr;
+
+KviKvsIdleParser::KviKvsIdleParser()
+    : QObject()
+{
+	m_pQueue = new KviPointerList<KviKvsScript>;
+	m_pQueue->setAutoDelete(true);
+	m_uParsed = 0;
+	m_uFailed = 0;
+
+	m_Timer.setSingleShot(true);
+	connect(&m_Timer, SIGNAL(timeout()), this, SLOT(processQueue()));
+}
+
+KviKvsIdleParser::~KviKvsIdleParser()
+{
+	m_Timer.stop();
+	delete m_pQueue;
+}
+
+void KviKvsIdleParser::init()
+{
+	if(KviKvsIdleParser::m_pInstance)
+	{
+		qDebug("Trying to double init() the idle parser!");
+		return;
+	}
+	KviKvsIdleParser::m_pInstance = new KviKvsIdleParser();
+}
+
+void KviKvsIdleParser::done()
+{
+	if(!KviKvsIdleParser::m_pInstance)
+	{
+		qDebug("Trying to call done() on a non existing idle parser!");
+		return;
+	}
+	delete KviKvsIdleParser::m_pInstance;
+	KviKvsIdleParser::m_pInstance = nullptr;
+}
+
+void KviKvsIdleParser::enqueue(const KviKvsScript * pScript)
+{
+	if(!pScript || pScript->isParsed())
+		return;
+
+	// shallow copy: shares the data (and thus the tree) with the original
+	m_pQueue->append(new KviKvsScript(*pScript));
+
+	if(!m_Timer.isActive())
+		m_Timer.start((m_uParsed + m_uFailed) ? KVI_KVS_IDLEPARSER_SLICE_DELAY : KVI_KVS_IDLEPARSER_START_DELAY);
+}
+
+void KviKvsIdleParser::clear()
+{
+	m_Timer.stop();
+	m_pQueue->clear();
+}
+
+void KviKvsIdleParser::processQueue()
+{
+	QElapsedTimer t;
+	t.start();
+
+	while(KviKvsScript * s = m_pQueue->first())
+	{
+		// If the original script has already been run (and thus parsed)
+		// or destroyed in the meantime this is a cheap no-op.
+		if(!s->isParsed())
+		{
+			if(s->preparse())
+				m_uParsed++;
+			else
+				m_uFailed++; // will be reported when the script is really run
+		}
+
+		m_pQueue->removeFirst();
+
+		if(t.elapsed() >= KVI_KVS_IDLEPARSER_SLICE_DURATION)
+			break;
+	}
+
+	if(!m_pQueue->isEmpty())
+	{
+		m_Timer.start(KVI_KVS_IDLEPARSER_SLICE_DELAY);
+		return;
+	}
+
+#ifdef COMPILE_DEBUG_MODE
+	qDebug("KviKvsIdleParser: queue drained (%u scripts parsed, %u failed)", m_uParsed, m_uFailed);
+#endif
+}
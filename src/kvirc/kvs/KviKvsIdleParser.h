@@ -0,0 +1,97 @@
+#ifndef _KVI_KVS_IDLEPARSER_H_
+#define _KVI_KVS_IDLEPARSER_H_
+//=============================================================================
+//
+//   File : KviKvsIdleParser.h
+//   Creation date : Mon 19 Oct 2026 14:10:21 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsIdleParser.h
+* \brief Builds the syntax trees of loaded scripts while the application is idle
+*
+* Aliases and event handlers are loaded as plain source code and parsed
+* only when they run for the first time. Right after connecting this means
+* that the first burst of events pays for parsing hundreds of handlers.
+* This queue parses them in small time-bounded slices from the event loop
+* so that they are usually ready by the time they are triggered.
+*/
+
+#include "kvi_settings.h"
+#include "KviPointerList.h"
+
+#include <QObject>
+#include <QTimer>
+
+class KviKvsScript;
+
+/**
+* \class KviKvsIdleParser
+* \brief Parse-ahead queue for KviKvsScript objects
+*
+* The queue holds shallow copies of the scripts so the originals may be
+* safely destroyed or replaced while they are waiting: in that case
+* the copy is the only owner of the data and it's simply dropped.
+*/
+class KVIRC_API KviKvsIdleParser : public QObject
+{
+	Q_OBJECT
+protected: // it only can be created and destroyed by KviKvsIdleParser::init()/done()
+	KviKvsIdleParser();
+	~KviKvsIdleParser();
+
+protected:
+	static KviKvsIdleParser * m_pInstance;
+	KviPointerList<KviKvsScript> * m_pQueue;
+	QTimer m_Timer;
+	unsigned int m_uParsed;
+	unsigned int m_uFailed;
+
+public:
+	static KviKvsIdleParser * instance() { return m_pInstance; };
+	static void init(); // called by KviKvs::init()
+	static void done(); // called by KviKvs::done()
+
+	/**
+	* \brief Schedules the script for parsing
+	*
+	* Scripts that already have a syntax tree are ignored.
+	* \param pScript The script to parse
+	* \return void
+	*/
+	void enqueue(const KviKvsScript * pScript);
+
+	/**
+	* \brief Drops all the pending scripts
+	* \return void
+	*/
+	void clear();
+
+	/**
+	* \brief Returns the number of scripts waiting to be parsed
+	* \return unsigned int
+	*/
+	unsigned int pendingCount() const { return m_pQueue->count(); };
+protected slots:
+	void processQueue();
+};
+
+#endif //!_KVI_KVS_IDLEPARSER_H_
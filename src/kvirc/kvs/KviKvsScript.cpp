@@ -110,6 +110,19 @@ bool KviKvsScript::locked() const
 	return m_pData->m_uLock > 0;
 }
 
+bool KviKvsScript::isParsed() const
+{
+	return m_pData->m_pTree != nullptr;
+}
+
+bool KviKvsScript::preparse()
+{
+	if(m_pData->m_pTree)
+		return true;
+	// no tree: nobody can be locked inside
+	return parse(nullptr, Quiet);
+}
+
 void KviKvsScript::dump(const char * prefix)
 {
 	if(m_pData->m_pTree)
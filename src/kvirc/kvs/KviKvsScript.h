@@ -159,6 +159,22 @@ public:
 	*/
 	bool locked() const;
 
+	/**
+	* \brief Returns true if the script has already a syntax tree
+	* \return bool
+	*/
+	bool isParsed() const;
+
+	/**
+	* \brief Builds the syntax tree without running the script
+	*
+	* This is used to parse scripts ahead of time (see KviKvsIdleParser).
+	* Errors are not reported here: the script will be parsed again
+	* (and the errors shown) when it's actually run.
+	* \return bool
+	*/
+	bool preparse();
+
 	/**
 	* \brief Sets the name of the script context
 	* \param szName The name of the context
@@ -34,17 +34,17 @@ int KviKvsVariantComparison::compareIntString(const KviKvsVariant * pV1, const K
 {
 	kvs_real_t dReal;
 
-	if(pV1->m_pData->m_u.iInt == 0)
+	if(pV1->m_u.iInt == 0)
 	{
-		if(pV2->m_pData->m_u.pString->isEmpty())
+		if(pV2->m_szString.isEmpty())
 			return KviKvsVariantComparison::Equal;
 	}
 
 	if(pV2->asReal(dReal))
 	{
-		if(((kvs_real_t)pV1->m_pData->m_u.iInt) == dReal)
+		if(((kvs_real_t)pV1->m_u.iInt) == dReal)
 			return KviKvsVariantComparison::Equal;
-		if(((kvs_real_t)pV1->m_pData->m_u.iInt) > dReal)
+		if(((kvs_real_t)pV1->m_u.iInt) > dReal)
 			return KviKvsVariantComparison::FirstGreater;
 		return KviKvsVariantComparison::SecondGreater;
 	}
@@ -52,50 +52,50 @@ int KviKvsVariantComparison::compareIntString(const KviKvsVariant * pV1, const K
 	// compare as strings instead
 	QString szString;
 	pV1->asString(szString);
-	return -1 * szString.compare(*(pV2->m_pData->m_u.pString), Qt::CaseInsensitive);
+	return -1 * szString.compare(pV2->m_szString, Qt::CaseInsensitive);
 }
 
 int KviKvsVariantComparison::compareIntReal(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(((kvs_real_t)pV1->m_pData->m_u.iInt) == *(pV2->m_pData->m_u.pReal))
+	if(((kvs_real_t)pV1->m_u.iInt) == pV2->m_u.dReal)
 		return KviKvsVariantComparison::Equal;
-	if(((kvs_real_t)pV1->m_pData->m_u.iInt) > *(pV2->m_pData->m_u.pReal))
+	if(((kvs_real_t)pV1->m_u.iInt) > pV2->m_u.dReal)
 		return KviKvsVariantComparison::FirstGreater;
 	return KviKvsVariantComparison::SecondGreater;
 }
 
 int KviKvsVariantComparison::compareIntBool(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.iInt == 0)
-		return pV2->m_pData->m_u.bBoolean ? KviKvsVariantComparison::SecondGreater : KviKvsVariantComparison::Equal;
-	return pV2->m_pData->m_u.bBoolean ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
+	if(pV1->m_u.iInt == 0)
+		return pV2->m_u.bBoolean ? KviKvsVariantComparison::SecondGreater : KviKvsVariantComparison::Equal;
+	return pV2->m_u.bBoolean ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareIntHash(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.iInt == 0)
-		return pV2->m_pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+	if(pV1->m_u.iInt == 0)
+		return pV2->m_u.pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 	return KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareIntArray(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.iInt == 0)
-		return pV2->m_pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+	if(pV1->m_u.iInt == 0)
+		return pV2->m_u.pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 	return KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareIntHObject(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.iInt == 0.0)
-		return (pV2->m_pData->m_u.hObject == (kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
+	if(pV1->m_u.iInt == 0.0)
+		return (pV2->m_u.hObject == (kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
 	return KviKvsVariantComparison::SecondGreater;
 }
 
 int KviKvsVariantComparison::compareRealHObject(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(*(pV1->m_pData->m_u.pReal) == 0.0)
-		return (pV2->m_pData->m_u.hObject == (kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
+	if(pV1->m_u.dReal == 0.0)
+		return (pV2->m_u.hObject == (kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
 	return KviKvsVariantComparison::SecondGreater;
 }
 
@@ -103,17 +103,17 @@ int KviKvsVariantComparison::compareRealString(const KviKvsVariant * pV1, const
 {
 	kvs_real_t dReal;
 
-	if(*(pV1->m_pData->m_u.pReal) == 0.0)
+	if(pV1->m_u.dReal == 0.0)
 	{
-		if(pV2->m_pData->m_u.pString->isEmpty())
+		if(pV2->m_szString.isEmpty())
 			return KviKvsVariantComparison::Equal;
 	}
 
 	if(pV2->asReal(dReal))
 	{
-		if(*(pV1->m_pData->m_u.pReal) == dReal)
+		if(pV1->m_u.dReal == dReal)
 			return KviKvsVariantComparison::Equal;
-		if(*(pV1->m_pData->m_u.pReal) > dReal)
+		if(pV1->m_u.dReal > dReal)
 			return KviKvsVariantComparison::FirstGreater;
 		return KviKvsVariantComparison::SecondGreater;
 	}
@@ -121,44 +121,44 @@ int KviKvsVariantComparison::compareRealString(const KviKvsVariant * pV1, const
 	// compare as strings instead
 	QString szString;
 	pV1->asString(szString);
-	return -1 * szString.compare(*(pV2->m_pData->m_u.pString), Qt::CaseInsensitive);
+	return -1 * szString.compare(pV2->m_szString, Qt::CaseInsensitive);
 }
 
 int KviKvsVariantComparison::compareRealBool(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(*(pV1->m_pData->m_u.pReal) == 0.0)
-		return pV2->m_pData->m_u.bBoolean ? KviKvsVariantComparison::SecondGreater : KviKvsVariantComparison::Equal;
-	return pV2->m_pData->m_u.bBoolean ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
+	if(pV1->m_u.dReal == 0.0)
+		return pV2->m_u.bBoolean ? KviKvsVariantComparison::SecondGreater : KviKvsVariantComparison::Equal;
+	return pV2->m_u.bBoolean ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareRealHash(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(*(pV1->m_pData->m_u.pReal) == 0)
-		return pV2->m_pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+	if(pV1->m_u.dReal == 0)
+		return pV2->m_u.pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 	return KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareRealArray(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(*(pV1->m_pData->m_u.pReal) == 0)
-		return pV2->m_pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+	if(pV1->m_u.dReal == 0)
+		return pV2->m_u.pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 	return KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareStringHash(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.pString->isEmpty())
+	if(pV1->m_szString.isEmpty())
 	{
-		return pV2->m_pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+		return pV2->m_u.pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 	}
 	return KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareStringArray(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.pString->isEmpty())
+	if(pV1->m_szString.isEmpty())
 	{
-		return pV2->m_pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+		return pV2->m_u.pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 	}
 	return KviKvsVariantComparison::FirstGreater;
 }
@@ -167,9 +167,9 @@ int KviKvsVariantComparison::compareStringHObject(const KviKvsVariant * pV1, con
 {
 	kvs_real_t dReal;
 
-	if(pV2->m_pData->m_u.hObject == (kvs_hobject_t) nullptr)
+	if(pV2->m_u.hObject == (kvs_hobject_t) nullptr)
 	{
-		if(pV1->m_pData->m_u.pString->isEmpty())
+		if(pV1->m_szString.isEmpty())
 			return KviKvsVariantComparison::Equal;
 
 		if(pV1->asReal(dReal))
@@ -185,314 +185,340 @@ int KviKvsVariantComparison::compareStringHObject(const KviKvsVariant * pV1, con
 int KviKvsVariantComparison::compareBoolString(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
 	if(pV2->isEqualToNothing())
-		return pV1->m_pData->m_u.bBoolean ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
+		return pV1->m_u.bBoolean ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 	else
-		return pV1->m_pData->m_u.bBoolean ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
+		return pV1->m_u.bBoolean ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::FirstGreater;
 }
 
 int KviKvsVariantComparison::compareBoolHash(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.bBoolean)
-		return pV2->m_pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
+	if(pV1->m_u.bBoolean)
+		return pV2->m_u.pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 	else
-		return pV2->m_pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+		return pV2->m_u.pData->m_u.pHash->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 }
 
 int KviKvsVariantComparison::compareBoolArray(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.bBoolean)
-		return pV2->m_pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
+	if(pV1->m_u.bBoolean)
+		return pV2->m_u.pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 	else
-		return pV2->m_pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+		return pV2->m_u.pData->m_u.pArray->isEmpty() ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 }
 
 int KviKvsVariantComparison::compareBoolHObject(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.bBoolean)
-		return pV2->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
+	if(pV1->m_u.bBoolean)
+		return pV2->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 	else
-		return pV2->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+		return pV2->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
 }
 
 int KviKvsVariantComparison::compareArrayHash(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV1->m_pData->m_u.pArray->size() > pV2->m_pData->m_u.pHash->size())
+	if(pV1->m_u.pData->m_u.pArray->size() > pV2->m_u.pData->m_u.pHash->size())
 		return KviKvsVariantComparison::FirstGreater;
-	if(pV1->m_pData->m_u.pArray->size() == pV2->m_pData->m_u.pHash->size())
+	if(pV1->m_u.pData->m_u.pArray->size() == pV2->m_u.pData->m_u.pHash->size())
 		return KviKvsVariantComparison::Equal;
 	return KviKvsVariantComparison::SecondGreater;
 }
 
 int KviKvsVariantComparison::compareHObjectHash(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV2->m_pData->m_u.pHash->isEmpty())
-		return pV1->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
-	return pV1->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
+	if(pV2->m_u.pData->m_u.pHash->isEmpty())
+		return pV1->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+	return pV1->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 }
 
 int KviKvsVariantComparison::compareHObjectArray(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
-	if(pV2->m_pData->m_u.pArray->isEmpty())
-		return pV1->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
-	return pV1->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
+	if(pV2->m_u.pData->m_u.pArray->isEmpty())
+		return pV1->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::Equal : KviKvsVariantComparison::SecondGreater;
+	return pV1->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 }
 
 KviKvsVariant::KviKvsVariant()
 {
-	m_pData = nullptr;
+	m_eType = KviKvsVariantData::Nothing;
+	m_eStringNumber = StringNumberUnknown;
 }
 
 KviKvsVariant::KviKvsVariant(QString * pString, bool bEscape)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::String;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pString = pString;
+	m_eType = KviKvsVariantData::String;
+	m_eStringNumber = StringNumberUnknown;
+	m_szString = *pString;
+	delete pString;
 	if(bEscape)
-		KviQString::escapeKvs(m_pData->m_u.pString);
+		KviQString::escapeKvs(&m_szString);
 }
 
 KviKvsVariant::KviKvsVariant(const QString & szString, bool bEscape)
+    : m_szString(szString)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::String;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pString = new QString(szString);
+	m_eType = KviKvsVariantData::String;
+	m_eStringNumber = StringNumberUnknown;
 	if(bEscape)
-		KviQString::escapeKvs(m_pData->m_u.pString);
+		KviQString::escapeKvs(&m_szString);
 }
 
 KviKvsVariant::KviKvsVariant(const char * pcString, bool bEscape)
+    : m_szString(QString::fromUtf8(pcString))
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::String;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pString = new QString(QString::fromUtf8(pcString));
+	m_eType = KviKvsVariantData::String;
+	m_eStringNumber = StringNumberUnknown;
 	if(bEscape)
-		KviQString::escapeKvs(m_pData->m_u.pString);
+		KviQString::escapeKvs(&m_szString);
 }
 
 KviKvsVariant::KviKvsVariant(KviKvsArray * pArray)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::Array;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pArray = pArray;
+	m_eType = KviKvsVariantData::Array;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.pData = new KviKvsVariantData;
+	m_u.pData->m_uRefs = 1;
+	m_u.pData->m_u.pArray = pArray;
 }
 
 KviKvsVariant::KviKvsVariant(KviKvsHash * pHash)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::Hash;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pHash = pHash;
+	m_eType = KviKvsVariantData::Hash;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.pData = new KviKvsVariantData;
+	m_u.pData->m_uRefs = 1;
+	m_u.pData->m_u.pHash = pHash;
 }
 
 KviKvsVariant::KviKvsVariant(kvs_real_t * pReal)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::Real;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pReal = pReal;
+	m_eType = KviKvsVariantData::Real;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.dReal = *pReal;
+	delete pReal;
 }
 
 KviKvsVariant::KviKvsVariant(kvs_real_t dReal)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::Real;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.pReal = new kvs_real_t;
-	*(m_pData->m_u.pReal) = dReal;
+	m_eType = KviKvsVariantData::Real;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.dReal = dReal;
 }
 
 KviKvsVariant::KviKvsVariant(bool bBoolean)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::Boolean;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.bBoolean = bBoolean;
+	m_eType = KviKvsVariantData::Boolean;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.bBoolean = bBoolean;
 }
 
 KviKvsVariant::KviKvsVariant(kvs_int_t iInt, bool)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::Integer;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.iInt = iInt;
+	m_eType = KviKvsVariantData::Integer;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.iInt = iInt;
 }
 
 KviKvsVariant::KviKvsVariant(kvs_hobject_t hObject)
 {
-	m_pData = new KviKvsVariantData;
-	m_pData->m_eType = KviKvsVariantData::HObject;
-	m_pData->m_uRefs = 1;
-	m_pData->m_u.hObject = hObject;
+	m_eType = KviKvsVariantData::HObject;
+	m_eStringNumber = StringNumberUnknown;
+	m_u.hObject = hObject;
 }
 
 KviKvsVariant::KviKvsVariant(const KviKvsVariant & variant)
+    : m_szString(variant.m_szString)
 {
-	m_pData = variant.m_pData;
-	if(m_pData)
-		m_pData->m_uRefs++;
-}
-
-#define DELETE_VARIANT_CONTENTS          \
-	switch(m_pData->m_eType)             \
-	{                                    \
-		case KviKvsVariantData::Array:   \
-			delete m_pData->m_u.pArray;  \
-			break;                       \
-		case KviKvsVariantData::Hash:    \
-			delete m_pData->m_u.pHash;   \
-			break;                       \
-		case KviKvsVariantData::String:  \
-			delete m_pData->m_u.pString; \
-			break;                       \
-		case KviKvsVariantData::Real:    \
-			delete m_pData->m_u.pReal;   \
-			break;                       \
-		default: /* make gcc happy */    \
-			break;                       \
-	}
+	m_eType = variant.m_eType;
+	m_eStringNumber = variant.m_eStringNumber;
+	m_u = variant.m_u;
+	if(m_eType & (KviKvsVariantData::Array | KviKvsVariantData::Hash))
+		m_u.pData->m_uRefs++;
+}
+
+KviKvsVariant::~KviKvsVariant()
+{
+	clearData();
+}
 
-#define DETACH_CONTENTS             \
-	if(m_pData)                     \
-	{                               \
-		if(m_pData->m_uRefs <= 1)   \
-		{                           \
-			DELETE_VARIANT_CONTENTS \
-			delete m_pData;         \
-		}                           \
-		else                        \
-		{                           \
-			m_pData->m_uRefs--;     \
-		}                           \
+void KviKvsVariant::clearData()
+{
+	switch(m_eType)
+	{
+		case KviKvsVariantData::Array:
+			if(m_u.pData->m_uRefs <= 1)
+			{
+				delete m_u.pData->m_u.pArray;
+				delete m_u.pData;
+			}
+			else
+			{
+				m_u.pData->m_uRefs--;
+			}
+			break;
+		case KviKvsVariantData::Hash:
+			if(m_u.pData->m_uRefs <= 1)
+			{
+				delete m_u.pData->m_u.pHash;
+				delete m_u.pData;
+			}
+			else
+			{
+				m_u.pData->m_uRefs--;
+			}
+			break;
+		case KviKvsVariantData::String:
+			m_szString = QString();
+			break;
+		default: /* make gcc happy */
+			break;
 	}
+	m_eType = KviKvsVariantData::Nothing;
+	m_eStringNumber = StringNumberUnknown;
+}
 
-#define RENEW_VARIANT_DATA                   \
-	if(m_pData)                              \
-	{                                        \
-		if(m_pData->m_uRefs > 1)             \
-		{                                    \
-			m_pData->m_uRefs--;              \
-			m_pData = new KviKvsVariantData; \
-			m_pData->m_uRefs = 1;            \
-		}                                    \
-		else                                 \
-		{                                    \
-			DELETE_VARIANT_CONTENTS          \
-		}                                    \
-	}                                        \
-	else                                     \
-	{                                        \
-		m_pData = new KviKvsVariantData;     \
-		m_pData->m_uRefs = 1;                \
+void KviKvsVariant::detach()
+{
+	switch(m_eType)
+	{
+		case KviKvsVariantData::Array:
+			if(m_u.pData->m_uRefs > 1)
+			{
+				KviKvsVariantData * pData = new KviKvsVariantData;
+				pData->m_uRefs = 1;
+				pData->m_u.pArray = new KviKvsArray(*(m_u.pData->m_u.pArray));
+				m_u.pData->m_uRefs--;
+				m_u.pData = pData;
+			}
+			break;
+		case KviKvsVariantData::Hash:
+			if(m_u.pData->m_uRefs > 1)
+			{
+				KviKvsVariantData * pData = new KviKvsVariantData;
+				pData->m_uRefs = 1;
+				pData->m_u.pHash = new KviKvsHash(*(m_u.pData->m_u.pHash));
+				m_u.pData->m_uRefs--;
+				m_u.pData = pData;
+			}
+			break;
+		default:
+			// scalars are never shared
+			break;
 	}
+}
 
-KviKvsVariant::~KviKvsVariant()
+KviKvsVariant::StringNumber KviKvsVariant::stringNumber() const
 {
-	DETACH_CONTENTS
+	// Scripts tend to convert the same string over and over
+	// (think of sorting or comparing in loops): parse it only once.
+	if(m_eStringNumber != StringNumberUnknown)
+		return m_eStringNumber;
+
+	bool bOk;
+	m_u.iInt = (kvs_int_t)KviQString::toI64(const_cast<QString &>(m_szString), &bOk);
+	if(bOk)
+	{
+		m_eStringNumber = StringNumberInteger;
+		return m_eStringNumber;
+	}
+
+	m_u.dReal = m_szString.toDouble(&bOk);
+	m_eStringNumber = bOk ? StringNumberReal : StringNumberNone;
+	return m_eStringNumber;
 }
 
 void KviKvsVariant::setString(QString * pString)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::String;
-	m_pData->m_u.pString = pString;
+	setString(*pString);
+	delete pString;
 }
 
 void KviKvsVariant::setString(const QString & szString)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::String;
-	m_pData->m_u.pString = new QString(szString);
+	// szString might be our own string
+	QString szTmp = szString;
+	clearData();
+	m_eType = KviKvsVariantData::String;
+	m_eStringNumber = StringNumberUnknown;
+	m_szString = szTmp;
 }
 
 void KviKvsVariant::setReal(kvs_real_t dReal)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::Real;
-	m_pData->m_u.pReal = new kvs_real_t;
-	*(m_pData->m_u.pReal) = dReal;
+	clearData();
+	m_eType = KviKvsVariantData::Real;
+	m_u.dReal = dReal;
 }
 
 void KviKvsVariant::setHObject(kvs_hobject_t hObject)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::HObject;
-	m_pData->m_u.hObject = hObject;
+	clearData();
+	m_eType = KviKvsVariantData::HObject;
+	m_u.hObject = hObject;
 }
 
 void KviKvsVariant::setBoolean(bool bBoolean)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::Boolean;
-	m_pData->m_u.bBoolean = bBoolean;
+	clearData();
+	m_eType = KviKvsVariantData::Boolean;
+	m_u.bBoolean = bBoolean;
 }
 
 void KviKvsVariant::setReal(kvs_real_t * pReal)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::Real;
-	m_pData->m_u.pReal = pReal;
+	setReal(*pReal);
+	delete pReal;
 }
 
 void KviKvsVariant::setInteger(kvs_int_t iInt)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::Integer;
-	m_pData->m_u.iInt = iInt;
+	clearData();
+	m_eType = KviKvsVariantData::Integer;
+	m_u.iInt = iInt;
 }
 
 void KviKvsVariant::setArray(KviKvsArray * pArray)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::Array;
-	m_pData->m_u.pArray = pArray;
+	// pArray might be owned by us (or by one of our elements)
+	KviKvsVariantData * pData = new KviKvsVariantData;
+	pData->m_uRefs = 1;
+	pData->m_u.pArray = pArray;
+	clearData();
+	m_eType = KviKvsVariantData::Array;
+	m_u.pData = pData;
 }
 
 void KviKvsVariant::setHash(KviKvsHash * pHash)
 {
-	RENEW_VARIANT_DATA
-	m_pData->m_eType = KviKvsVariantData::Hash;
-	m_pData->m_u.pHash = pHash;
+	KviKvsVariantData * pData = new KviKvsVariantData;
+	pData->m_uRefs = 1;
+	pData->m_u.pHash = pHash;
+	clearData();
+	m_eType = KviKvsVariantData::Hash;
+	m_u.pData = pData;
 }
 
 void KviKvsVariant::setNothing()
 {
-	if(m_pData)
-	{
-		if(m_pData->m_uRefs <= 1)
-		{
-			DELETE_VARIANT_CONTENTS
-			delete m_pData;
-		}
-		else
-		{
-			// just detach
-			m_pData->m_uRefs--;
-		}
-		m_pData = nullptr;
-	}
+	clearData();
 }
 
 bool KviKvsVariant::isEmpty() const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return true;
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::String:
-			return m_pData->m_u.pString->isEmpty();
+			return m_szString.isEmpty();
 			break;
 		case KviKvsVariantData::Array:
-			return m_pData->m_u.pArray->isEmpty();
+			return m_u.pData->m_u.pArray->isEmpty();
 			break;
 		case KviKvsVariantData::Hash:
-			return m_pData->m_u.pHash->isEmpty();
+			return m_u.pData->m_u.pHash->isEmpty();
 			break;
 		case KviKvsVariantData::HObject:
-			return m_pData->m_u.hObject == nullptr;
+			return m_u.hObject == nullptr;
 			break;
 		default: /* make gcc happy */
 			break;
@@ -502,68 +528,69 @@ bool KviKvsVariant::isEmpty() const
 
 bool KviKvsVariant::asBoolean() const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return false;
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::Boolean:
-			return m_pData->m_u.bBoolean;
+			return m_u.bBoolean;
 			break;
 		case KviKvsVariantData::String:
 		{
-			if(m_pData->m_u.pString->isEmpty())
+			if(m_szString.isEmpty())
 				return false;
 
 			// check integer or real values
-			bool bOk;
-			kvs_int_t iVal = (kvs_int_t)KviQString::toI64(*(m_pData->m_u.pString), &bOk);
-			if(bOk)
-				return iVal;
-			kvs_real_t dVal = m_pData->m_u.pString->toDouble(&bOk);
-			if(bOk)
-				return (dVal != 0.0);
-			// non number, non empty
-			return true;
+			switch(stringNumber())
+			{
+				case StringNumberInteger:
+					return m_u.iInt;
+				case StringNumberReal:
+					return (m_u.dReal != 0.0);
+				default:
+					// non number, non empty
+					return true;
+			}
 		}
 		break;
 		case KviKvsVariantData::Integer:
-			return m_pData->m_u.iInt;
+			return m_u.iInt;
 			break;
 		case KviKvsVariantData::Real:
-			return *(m_pData->m_u.pReal) != 0.0;
+			return m_u.dReal != 0.0;
 			break;
 		case KviKvsVariantData::Array:
-			return !(m_pData->m_u.pArray->isEmpty());
+			return !(m_u.pData->m_u.pArray->isEmpty());
 			break;
 		case KviKvsVariantData::Hash:
-			return !(m_pData->m_u.pHash->isEmpty());
+			return !(m_u.pData->m_u.pHash->isEmpty());
 			break;
 		case KviKvsVariantData::HObject:
-			return m_pData->m_u.hObject;
+			return m_u.hObject;
 			break;
 		default: /* make gcc happy */
 			break;
 	}
-	qDebug("WARNING: invalid variant type %d in KviKvsVariant::asBoolean()", m_pData->m_eType);
+	qDebug("WARNING: invalid variant type %d in KviKvsVariant::asBoolean()", m_eType);
 	return false;
 }
 
 bool KviKvsVariant::asHObject(kvs_hobject_t & hObject) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		// nothing evaluates to a null object
 		hObject = nullptr;
 		return true;
 	}
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::HObject:
-			hObject = m_pData->m_u.hObject;
+			hObject = m_u.hObject;
 			return true;
 			break;
 		case KviKvsVariantData::Integer:
-			if(m_pData->m_u.iInt == 0)
+			if(m_u.iInt == 0)
 			{
 				hObject = nullptr;
 				return true;
@@ -571,7 +598,7 @@ bool KviKvsVariant::asHObject(kvs_hobject_t & hObject) const
 			return false;
 			break;
 		case KviKvsVariantData::String:
-			if(*(m_pData->m_u.pString) == "0")
+			if(m_szString == "0")
 			{
 				hObject = nullptr;
 				return true;
@@ -579,7 +606,7 @@ bool KviKvsVariant::asHObject(kvs_hobject_t & hObject) const
 			return false;
 			break;
 		case KviKvsVariantData::Boolean:
-			if(!(m_pData->m_u.bBoolean))
+			if(!(m_u.bBoolean))
 			{
 				hObject = nullptr;
 				return true;
@@ -592,19 +619,19 @@ bool KviKvsVariant::asHObject(kvs_hobject_t & hObject) const
 
 bool KviKvsVariant::asNumber(KviKvsNumber & number) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return false;
 
 	if(isInteger())
 	{
-		number.m_u.iInt = m_pData->m_u.iInt;
+		number.m_u.iInt = m_u.iInt;
 		number.m_type = KviKvsNumber::Integer;
 		return true;
 	}
 
 	if(isReal())
 	{
-		number.m_u.dReal = *(m_pData->m_u.pReal);
+		number.m_u.dReal = m_u.dReal;
 		number.m_type = KviKvsNumber::Real;
 		return true;
 	}
@@ -625,7 +652,7 @@ bool KviKvsVariant::asNumber(KviKvsNumber & number) const
 
 void KviKvsVariant::castToNumber(KviKvsNumber & number) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		number.m_u.iInt = 0;
 		number.m_type = KviKvsNumber::Integer;
@@ -634,14 +661,14 @@ void KviKvsVariant::castToNumber(KviKvsNumber & number) const
 
 	if(isInteger())
 	{
-		number.m_u.iInt = m_pData->m_u.iInt;
+		number.m_u.iInt = m_u.iInt;
 		number.m_type = KviKvsNumber::Integer;
 		return;
 	}
 
 	if(isReal())
 	{
-		number.m_u.dReal = *(m_pData->m_u.pReal);
+		number.m_u.dReal = m_u.dReal;
 		number.m_type = KviKvsNumber::Real;
 		return;
 	}
@@ -663,20 +690,20 @@ void KviKvsVariant::castToNumber(KviKvsNumber & number) const
 
 void KviKvsVariant::castToArray(KviKvsArrayCast * pCast) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		pCast->set(new KviKvsArray(), true);
 		return;
 	}
 
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::Array:
-			pCast->set(m_pData->m_u.pArray, false);
+			pCast->set(m_u.pData->m_u.pArray, false);
 			break;
 		case KviKvsVariantData::Hash:
 		{
-			KviPointerHashTableIterator<QString, KviKvsVariant> it(*(m_pData->m_u.pHash->dict()));
+			KviPointerHashTableIterator<QString, KviKvsVariant> it(*(m_u.pData->m_u.pHash->dict()));
 			KviKvsArray * pArray = new KviKvsArray();
 			kvs_int_t idx = 0;
 			while(KviKvsVariant * pVariant = it.current())
@@ -701,20 +728,20 @@ void KviKvsVariant::castToArray(KviKvsArrayCast * pCast) const
 
 void KviKvsVariant::convertToArray()
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		setArray(new KviKvsArray());
 		return;
 	}
 
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::Array:
 			return;
 			break;
 		case KviKvsVariantData::Hash:
 		{
-			KviPointerHashTableIterator<QString, KviKvsVariant> it(*(m_pData->m_u.pHash->dict()));
+			KviPointerHashTableIterator<QString, KviKvsVariant> it(*(m_u.pData->m_u.pHash->dict()));
 			KviKvsArray * pArray = new KviKvsArray();
 			kvs_int_t idx = 0;
 			while(KviKvsVariant * pVariant = it.current())
@@ -739,28 +766,27 @@ void KviKvsVariant::convertToArray()
 
 bool KviKvsVariant::asInteger(kvs_int_t & iVal) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return false;
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::Integer:
-			iVal = m_pData->m_u.iInt;
+			iVal = m_u.iInt;
 			return true;
 			break;
 		case KviKvsVariantData::String:
-		{
-			bool bOk;
-			iVal = (kvs_int_t)KviQString::toI64(*(m_pData->m_u.pString), &bOk);
-			return bOk;
-		}
-		break;
+			if(stringNumber() != StringNumberInteger)
+				return false;
+			iVal = m_u.iInt;
+			return true;
+			break;
 		case KviKvsVariantData::Real:
 			// FIXME: this truncates the value!
-			iVal = (kvs_int_t) * (m_pData->m_u.pReal);
+			iVal = (kvs_int_t)m_u.dReal;
 			return true;
 			break;
 		case KviKvsVariantData::Boolean:
-			iVal = m_pData->m_u.bBoolean ? 1 : 0;
+			iVal = m_u.bBoolean ? 1 : 0;
 			return true;
 			break;
 		default: /* make gcc happy */
@@ -771,40 +797,37 @@ bool KviKvsVariant::asInteger(kvs_int_t & iVal) const
 
 void KviKvsVariant::castToInteger(kvs_int_t & iVal) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		iVal = 0;
 		return;
 	}
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::Integer:
-			iVal = m_pData->m_u.iInt;
+			iVal = m_u.iInt;
 			break;
 		case KviKvsVariantData::Boolean:
-			iVal = m_pData->m_u.bBoolean ? 1 : 0;
+			iVal = m_u.bBoolean ? 1 : 0;
 			break;
 		case KviKvsVariantData::HObject:
-			iVal = m_pData->m_u.hObject ? 1 : 0;
+			iVal = m_u.hObject ? 1 : 0;
 			break;
 		case KviKvsVariantData::String:
-		{
-			bool bOk;
-			iVal = (kvs_int_t)KviQString::toI64(*(m_pData->m_u.pString), &bOk);
-			if(bOk)
-				return;
-			iVal = m_pData->m_u.pString->length();
-		}
-		break;
+			if(stringNumber() == StringNumberInteger)
+				iVal = m_u.iInt;
+			else
+				iVal = m_szString.length();
+			break;
 		case KviKvsVariantData::Real:
 			// FIXME: this truncates the value!
-			iVal = (kvs_int_t) * (m_pData->m_u.pReal);
+			iVal = (kvs_int_t)m_u.dReal;
 			break;
 		case KviKvsVariantData::Array:
-			iVal = m_pData->m_u.pArray->size();
+			iVal = m_u.pData->m_u.pArray->size();
 			break;
 		case KviKvsVariantData::Hash:
-			iVal = m_pData->m_u.pHash->size();
+			iVal = m_u.pData->m_u.pHash->size();
 			break;
 		default: /* make gcc happy */
 			iVal = 0;
@@ -814,27 +837,33 @@ void KviKvsVariant::castToInteger(kvs_int_t & iVal) const
 
 bool KviKvsVariant::asReal(kvs_real_t & dVal) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return false;
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::Integer:
-			dVal = m_pData->m_u.iInt;
+			dVal = m_u.iInt;
 			return true;
 			break;
 		case KviKvsVariantData::String:
-		{
-			bool bOk;
-			dVal = m_pData->m_u.pString->toDouble(&bOk);
-			return bOk;
-		}
-		break;
+			switch(stringNumber())
+			{
+				case StringNumberInteger:
+					dVal = (kvs_real_t)m_u.iInt;
+					return true;
+				case StringNumberReal:
+					dVal = m_u.dReal;
+					return true;
+				default:
+					return false;
+			}
+			break;
 		case KviKvsVariantData::Real:
-			dVal = *(m_pData->m_u.pReal);
+			dVal = m_u.dReal;
 			return true;
 			break;
 		case KviKvsVariantData::Boolean:
-			dVal = m_pData->m_u.bBoolean ? 1.0 : 0.0;
+			dVal = m_u.bBoolean ? 1.0 : 0.0;
 			return true;
 			break;
 		default: /* by default we make gcc happy */
@@ -845,36 +874,36 @@ bool KviKvsVariant::asReal(kvs_real_t & dVal) const
 
 void KviKvsVariant::asString(QString & szBuffer) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		szBuffer = QString();
 		return;
 	}
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::String:
-			szBuffer = *(m_pData->m_u.pString);
+			szBuffer = m_szString;
 			break;
 		case KviKvsVariantData::Array:
 			szBuffer = QString();
-			m_pData->m_u.pArray->appendAsString(szBuffer);
+			m_u.pData->m_u.pArray->appendAsString(szBuffer);
 			break;
 		case KviKvsVariantData::Hash:
 			szBuffer = QString();
-			m_pData->m_u.pHash->appendAsString(szBuffer);
+			m_u.pData->m_u.pHash->appendAsString(szBuffer);
 			break;
 		case KviKvsVariantData::Integer:
-			szBuffer.setNum(m_pData->m_u.iInt);
+			szBuffer.setNum(m_u.iInt);
 			break;
 		case KviKvsVariantData::Real:
-			szBuffer.setNum(*(m_pData->m_u.pReal));
+			szBuffer.setNum(m_u.dReal);
 			break;
 		case KviKvsVariantData::Boolean:
-			szBuffer.setNum(m_pData->m_u.bBoolean ? 1 : 0);
+			szBuffer.setNum(m_u.bBoolean ? 1 : 0);
 			break;
 		case KviKvsVariantData::HObject:
-			if(m_pData->m_u.hObject)
-				szBuffer = QString("object[%1]").arg((uintptr_t)m_pData->m_u.hObject, 0, 16);
+			if(m_u.hObject)
+				szBuffer = QString("object[%1]").arg((uintptr_t)m_u.hObject, 0, 16);
 			else
 				szBuffer = "null-object";
 			break;
@@ -885,30 +914,30 @@ void KviKvsVariant::asString(QString & szBuffer) const
 
 void KviKvsVariant::appendAsString(QString & szBuffer) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return;
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::String:
-			szBuffer.append(*(m_pData->m_u.pString));
+			szBuffer.append(m_szString);
 			break;
 		case KviKvsVariantData::Array:
-			m_pData->m_u.pArray->appendAsString(szBuffer);
+			m_u.pData->m_u.pArray->appendAsString(szBuffer);
 			break;
 		case KviKvsVariantData::Hash:
-			m_pData->m_u.pHash->appendAsString(szBuffer);
+			m_u.pData->m_u.pHash->appendAsString(szBuffer);
 			break;
 		case KviKvsVariantData::Integer:
-			KviQString::appendNumber(szBuffer, m_pData->m_u.iInt);
+			KviQString::appendNumber(szBuffer, m_u.iInt);
 			break;
 		case KviKvsVariantData::Real:
-			KviQString::appendNumber(szBuffer, *(m_pData->m_u.pReal));
+			KviQString::appendNumber(szBuffer, m_u.dReal);
 			break;
 		case KviKvsVariantData::Boolean:
-			KviQString::appendNumber(szBuffer, m_pData->m_u.bBoolean ? 1 : 0);
+			KviQString::appendNumber(szBuffer, m_u.bBoolean ? 1 : 0);
 			break;
 		case KviKvsVariantData::HObject:
-			szBuffer.append(m_pData->m_u.hObject ? "object" : "null-object");
+			szBuffer.append(m_u.hObject ? "object" : "null-object");
 			break;
 		default: /* make gcc happy */
 			break;
@@ -917,33 +946,33 @@ void KviKvsVariant::appendAsString(QString & szBuffer) const
 
 void KviKvsVariant::dump(const char * pcPrefix) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		qDebug("%s Nothing [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t) this);
 		return;
 	}
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::String:
-			qDebug("%s String(%s) [this=0x%" PRIxPTR "]", pcPrefix, m_pData->m_u.pString->toUtf8().data(), (uintptr_t) this);
+			qDebug("%s String(%s) [this=0x%" PRIxPTR "]", pcPrefix, m_szString.toUtf8().data(), (uintptr_t) this);
 			break;
 		case KviKvsVariantData::Array:
-			qDebug("%s Array(ptr=0x%" PRIxPTR ") [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t)m_pData->m_u.pArray, (uintptr_t) this);
+			qDebug("%s Array(ptr=0x%" PRIxPTR ") [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t)m_u.pData->m_u.pArray, (uintptr_t) this);
 			break;
 		case KviKvsVariantData::Hash:
-			qDebug("%s Hash(ptr=0x%" PRIxPTR ",dict=0x%" PRIxPTR ") [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t)m_pData->m_u.pHash, (uintptr_t)m_pData->m_u.pHash->dict(), (uintptr_t) this);
+			qDebug("%s Hash(ptr=0x%" PRIxPTR ",dict=0x%" PRIxPTR ") [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t)m_u.pData->m_u.pHash, (uintptr_t)m_u.pData->m_u.pHash->dict(), (uintptr_t) this);
 			break;
 		case KviKvsVariantData::Integer:
-			qDebug("%s Integer(%d) [this=0x%" PRIxPTR "]", pcPrefix, (int)m_pData->m_u.iInt, (uintptr_t) this);
+			qDebug("%s Integer(%d) [this=0x%" PRIxPTR "]", pcPrefix, (int)m_u.iInt, (uintptr_t) this);
 			break;
 		case KviKvsVariantData::Real:
-			qDebug("%s Real(%f) [this=0x%" PRIxPTR "]", pcPrefix, *(m_pData->m_u.pReal), (uintptr_t) this);
+			qDebug("%s Real(%f) [this=0x%" PRIxPTR "]", pcPrefix, m_u.dReal, (uintptr_t) this);
 			break;
 		case KviKvsVariantData::Boolean:
-			qDebug("%s Boolean(%s) [this=0x%" PRIxPTR "]", pcPrefix, m_pData->m_u.bBoolean ? "true" : "false", (uintptr_t) this);
+			qDebug("%s Boolean(%s) [this=0x%" PRIxPTR "]", pcPrefix, m_u.bBoolean ? "true" : "false", (uintptr_t) this);
 			break;
 		case KviKvsVariantData::HObject:
-			qDebug("%s HObject(%" PRIxPTR ") [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t)m_pData->m_u.hObject, (uintptr_t) this);
+			qDebug("%s HObject(%" PRIxPTR ") [this=0x%" PRIxPTR "]", pcPrefix, (uintptr_t)m_u.hObject, (uintptr_t) this);
 			break;
 		default: /* make gcc happy */
 			break;
@@ -952,42 +981,57 @@ void KviKvsVariant::dump(const char * pcPrefix) const
 
 void KviKvsVariant::copyFrom(const KviKvsVariant * pVariant)
 {
-	DETACH_CONTENTS
-	m_pData = pVariant->m_pData;
-	if(m_pData)
-		m_pData->m_uRefs++;
+	copyFrom(*pVariant);
 }
 
 void KviKvsVariant::copyFrom(const KviKvsVariant & variant)
 {
-	DETACH_CONTENTS
-	m_pData = variant.m_pData;
-	if(m_pData)
-		m_pData->m_uRefs++;
+	if(&variant == this)
+		return;
+	// grab the reference first: variant might be owned by our own array or hash
+	if(variant.m_eType & (KviKvsVariantData::Array | KviKvsVariantData::Hash))
+		variant.m_u.pData->m_uRefs++;
+	QString szString = variant.m_szString;
+	DataType u = variant.m_u;
+	KviKvsVariantData::Type eType = variant.m_eType;
+	StringNumber eStringNumber = variant.m_eStringNumber;
+	clearData();
+	m_eType = eType;
+	m_eStringNumber = eStringNumber;
+	m_u = u;
+	m_szString = szString;
 }
 
 void KviKvsVariant::takeFrom(KviKvsVariant * pVariant)
 {
-	DETACH_CONTENTS
-	m_pData = pVariant->m_pData;
-	pVariant->m_pData = nullptr;
+	takeFrom(*pVariant);
 }
 
 void KviKvsVariant::takeFrom(KviKvsVariant & variant)
 {
-	DETACH_CONTENTS
-	m_pData = variant.m_pData;
-	variant.m_pData = nullptr;
+	if(&variant == this)
+		return;
+	QString szString;
+	szString.swap(variant.m_szString);
+	DataType u = variant.m_u;
+	KviKvsVariantData::Type eType = variant.m_eType;
+	StringNumber eStringNumber = variant.m_eStringNumber;
+	variant.m_eType = KviKvsVariantData::Nothing;
+	clearData();
+	m_eType = eType;
+	m_eStringNumber = eStringNumber;
+	m_u = u;
+	m_szString.swap(szString);
 }
 
 void KviKvsVariant::getTypeName(QString & szBuffer) const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		szBuffer = "nothing";
 		return;
 	}
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::String:
 			szBuffer = "string";
@@ -1018,22 +1062,22 @@ void KviKvsVariant::getTypeName(QString & szBuffer) const
 
 bool KviKvsVariant::isEqualToNothing() const
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return true;
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::HObject:
-			return (m_pData->m_u.hObject == (kvs_hobject_t) nullptr);
+			return (m_u.hObject == (kvs_hobject_t) nullptr);
 			break;
 		case KviKvsVariantData::Integer:
-			return (m_pData->m_u.iInt == 0);
+			return (m_u.iInt == 0);
 			break;
 		case KviKvsVariantData::Real:
-			return (*(m_pData->m_u.pReal) == 0.0);
+			return (m_u.dReal == 0.0);
 			break;
 		case KviKvsVariantData::String:
 		{
-			if(m_pData->m_u.pString->isEmpty())
+			if(m_szString.isEmpty())
 				return true;
 			kvs_real_t dReal;
 			if(asReal(dReal))
@@ -1042,13 +1086,13 @@ bool KviKvsVariant::isEqualToNothing() const
 		}
 		break;
 		case KviKvsVariantData::Boolean:
-			return !m_pData->m_u.bBoolean;
+			return !m_u.bBoolean;
 			break;
 		case KviKvsVariantData::Hash:
-			return m_pData->m_u.pHash->isEmpty();
+			return m_u.pData->m_u.pHash->isEmpty();
 			break;
 		case KviKvsVariantData::Array:
-			return m_pData->m_u.pArray->isEmpty();
+			return m_u.pData->m_u.pArray->isEmpty();
 			break;
 		default:
 			break;
@@ -1065,20 +1109,20 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 {
 	if(!pOther)
 		return isEqualToNothing() ? CMP_EQUAL : CMP_THISGREATER;
-	if(!pOther->m_pData)
+	if(pOther->m_eType == KviKvsVariantData::Nothing)
 		return isEqualToNothing() ? CMP_EQUAL : CMP_THISGREATER;
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 		return pOther->isEqualToNothing() ? CMP_EQUAL : CMP_OTHERGREATER;
 
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::HObject:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::HObject:
-					if(m_pData->m_u.hObject == pOther->m_pData->m_u.hObject)
+					if(m_u.hObject == pOther->m_u.hObject)
 						return CMP_EQUAL;
-					if(m_pData->m_u.hObject == ((kvs_hobject_t) nullptr))
+					if(m_u.hObject == ((kvs_hobject_t) nullptr))
 						return CMP_OTHERGREATER;
 					return CMP_THISGREATER;
 					break;
@@ -1105,15 +1149,15 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 			}
 			break;
 		case KviKvsVariantData::Integer:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::HObject:
 					return KviKvsVariantComparison::compareIntHObject(this, pOther);
 					break;
 				case KviKvsVariantData::Integer:
-					if(m_pData->m_u.iInt == pOther->m_pData->m_u.iInt)
+					if(m_u.iInt == pOther->m_u.iInt)
 						return CMP_EQUAL;
-					if(m_pData->m_u.iInt > pOther->m_pData->m_u.iInt)
+					if(m_u.iInt > pOther->m_u.iInt)
 						return CMP_THISGREATER;
 					return CMP_OTHERGREATER;
 					break;
@@ -1137,7 +1181,7 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 			}
 			break;
 		case KviKvsVariantData::Real:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::HObject:
 					return KviKvsVariantComparison::compareRealHObject(this, pOther);
@@ -1146,9 +1190,9 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 					return -1 * KviKvsVariantComparison::compareIntReal(pOther, this);
 					break;
 				case KviKvsVariantData::Real:
-					if(*(m_pData->m_u.pReal) == *(pOther->m_pData->m_u.pReal))
+					if(m_u.dReal == pOther->m_u.dReal)
 						return CMP_EQUAL;
-					if(*(m_pData->m_u.pReal) > *(pOther->m_pData->m_u.pReal))
+					if(m_u.dReal > pOther->m_u.dReal)
 						return CMP_THISGREATER;
 					return CMP_OTHERGREATER;
 					break;
@@ -1169,7 +1213,7 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 			}
 			break;
 		case KviKvsVariantData::String:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::String:
 					if(bPreferNumeric)
@@ -1189,7 +1233,7 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 							}
 						}
 					}
-					return -1 * m_pData->m_u.pString->compare(*(pOther->m_pData->m_u.pString), Qt::CaseInsensitive);
+					return -1 * m_szString.compare(pOther->m_szString, Qt::CaseInsensitive);
 				case KviKvsVariantData::Real:
 					return -1 * KviKvsVariantComparison::compareRealString(pOther, this);
 				case KviKvsVariantData::Integer:
@@ -1211,7 +1255,7 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 			}
 			break;
 		case KviKvsVariantData::Hash:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::String:
 					return -1 * KviKvsVariantComparison::compareStringHash(pOther, this);
@@ -1225,9 +1269,9 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 					return -1 * KviKvsVariantComparison::compareBoolHash(pOther, this);
 					break;
 				case KviKvsVariantData::Hash:
-					if(m_pData->m_u.pHash->size() > pOther->m_pData->m_u.pHash->size())
+					if(m_u.pData->m_u.pHash->size() > pOther->m_u.pData->m_u.pHash->size())
 						return CMP_THISGREATER;
-					if(m_pData->m_u.pHash->size() == pOther->m_pData->m_u.pHash->size())
+					if(m_u.pData->m_u.pHash->size() == pOther->m_u.pData->m_u.pHash->size())
 						return CMP_EQUAL;
 					return CMP_OTHERGREATER;
 					break;
@@ -1242,7 +1286,7 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 			}
 			break;
 		case KviKvsVariantData::Array:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::String:
 					return -1 * KviKvsVariantComparison::compareStringArray(pOther, this);
@@ -1257,9 +1301,9 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 					return KviKvsVariantComparison::compareArrayHash(this, pOther);
 					break;
 				case KviKvsVariantData::Array:
-					if(m_pData->m_u.pArray->size() > pOther->m_pData->m_u.pArray->size())
+					if(m_u.pData->m_u.pArray->size() > pOther->m_u.pData->m_u.pArray->size())
 						return CMP_THISGREATER;
-					if(m_pData->m_u.pArray->size() == pOther->m_pData->m_u.pArray->size())
+					if(m_u.pData->m_u.pArray->size() == pOther->m_u.pData->m_u.pArray->size())
 						return CMP_EQUAL;
 					return CMP_OTHERGREATER;
 					break;
@@ -1271,7 +1315,7 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 			}
 			break;
 		case KviKvsVariantData::Boolean:
-			switch(pOther->m_pData->m_eType)
+			switch(pOther->m_eType)
 			{
 				case KviKvsVariantData::String:
 					return KviKvsVariantComparison::compareBoolString(this, pOther);
@@ -1283,9 +1327,9 @@ int KviKvsVariant::compare(const KviKvsVariant * pOther, bool bPreferNumeric) co
 					return -1 * KviKvsVariantComparison::compareIntBool(pOther, this);
 					break;
 				case KviKvsVariantData::Boolean:
-					if(m_pData->m_u.bBoolean == pOther->m_pData->m_u.bBoolean)
+					if(m_u.bBoolean == pOther->m_u.bBoolean)
 						return CMP_EQUAL;
-					if(m_pData->m_u.bBoolean)
+					if(m_u.bBoolean)
 						return CMP_THISGREATER;
 					return CMP_OTHERGREATER;
 					break;
@@ -1325,35 +1369,35 @@ void KviKvsVariant::serializeString(QString & szBuffer)
 
 void KviKvsVariant::serialize(QString & szResult)
 {
-	if(!m_pData)
+	if(m_eType == KviKvsVariantData::Nothing)
 	{
 		szResult = "null";
 		return;
 	}
 
-	switch(m_pData->m_eType)
+	switch(m_eType)
 	{
 		case KviKvsVariantData::HObject:
 			//can't serialize objects yet
 			break;
 		case KviKvsVariantData::Integer:
-			szResult.setNum(m_pData->m_u.iInt);
+			szResult.setNum(m_u.iInt);
 			break;
 		case KviKvsVariantData::Real:
-			szResult.setNum(*(m_pData->m_u.pReal));
+			szResult.setNum(m_u.dReal);
 			break;
 		case KviKvsVariantData::String:
-			szResult = *(m_pData->m_u.pString);
+			szResult = m_szString;
 			serializeString(szResult);
 			break;
 		case KviKvsVariantData::Boolean:
-			szResult = m_pData->m_u.bBoolean ? "true" : "false";
+			szResult = m_u.bBoolean ? "true" : "false";
 			break;
 		case KviKvsVariantData::Hash:
-			m_pData->m_u.pHash->serialize(szResult);
+			m_u.pData->m_u.pHash->serialize(szResult);
 			break;
 		case KviKvsVariantData::Array:
-			m_pData->m_u.pArray->serialize(szResult);
+			m_u.pData->m_u.pArray->serialize(szResult);
 			break;
 		case KviKvsVariantData::Nothing:
 			szResult = "null";
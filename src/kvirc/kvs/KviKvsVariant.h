@@ -110,6 +110,11 @@ public:
 /**
 * \class KviKvsVariantData
 * \brief The class which holds the type of the variant data
+*
+* Scalars are stored directly inside KviKvsVariant: this structure
+* is allocated only for arrays and hashes. It is shared between the
+* copies of a variant and it's detached when one of them is about
+* to be modified (see KviKvsVariant::detach()).
 */
 class KviKvsVariantData
 {
@@ -133,21 +138,15 @@ public:
 public:
 	/**
 	* \union DataType
-	* \brief Holds the value of the variant data
+	* \brief Holds the shared container
 	*/
 	union DataType {
-		kvs_int_t iInt;
-		kvs_real_t * pReal;
-		QString * pString;
 		KviKvsArray * pArray;
 		KviKvsHash * pHash;
-		bool bBoolean;
-		kvs_hobject_t hObject;
 	};
 
 public:
 	unsigned int m_uRefs;
-	Type m_eType;
 	DataType m_u;
 };
 
@@ -450,14 +449,43 @@ public:
 	~KviKvsVariant();
 
 protected:
-	KviKvsVariantData * m_pData;
+	/**
+	* \enum StringNumber
+	* \brief The cached numeric interpretation of a string variant
+	*/
+	enum StringNumber
+	{
+		StringNumberUnknown, /**< The string has not been parsed yet */
+		StringNumberNone,    /**< The string is not a number */
+		StringNumberInteger, /**< The string is an integer, cached in m_u.iInt */
+		StringNumberReal     /**< The string is a real (but not an integer), cached in m_u.dReal */
+	};
+
+	/**
+	* \union DataType
+	* \brief Holds the value of the variant data
+	*
+	* For strings it holds the cached numeric value (see StringNumber)
+	*/
+	union DataType {
+		kvs_int_t iInt;
+		kvs_real_t dReal;
+		bool bBoolean;
+		kvs_hobject_t hObject;
+		KviKvsVariantData * pData; // arrays and hashes
+	};
+
+	KviKvsVariantData::Type m_eType;
+	mutable StringNumber m_eStringNumber; // meaningful only for strings
+	mutable DataType m_u;                 // mutable only for the string number cache
+	QString m_szString;                   // implicitly shared, so copying it is cheap
 
 public:
 	/**
 	* \brief Returns the type of the variant data
 	* \return KviKvsVariantData::Type
 	*/
-	KviKvsVariantData::Type type() { return m_pData ? m_pData->m_eType : KviKvsVariantData::Nothing; };
+	KviKvsVariantData::Type type() const { return m_eType; };
 
 	/**
 	* \brief Sets the variant data as double floating point
@@ -539,61 +567,61 @@ public:
 	* \brief Returns true if the variant is empty
 	* \return bool
 	*/
-	bool isNothing() const { return !m_pData; };
+	bool isNothing() const { return m_eType == KviKvsVariantData::Nothing; };
 
 	/**
 	* \brief Returns true if the variant is an integer
 	* \return bool
 	*/
-	bool isInteger() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::Integer) : false; };
+	bool isInteger() const { return m_eType == KviKvsVariantData::Integer; };
 
 	/**
 	* \brief Returns true if the variant is a double floating point
 	* \return bool
 	*/
-	bool isReal() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::Real) : false; };
+	bool isReal() const { return m_eType == KviKvsVariantData::Real; };
 
 	/**
 	* \brief Returns true if the variant is numeric
 	* \return bool
 	*/
-	bool isNumeric() const { return m_pData ? (m_pData->m_eType & (KviKvsVariantData::Integer | KviKvsVariantData::Real)) : false; };
+	bool isNumeric() const { return m_eType & (KviKvsVariantData::Integer | KviKvsVariantData::Real); };
 
 	/**
 	* \brief Returns true if the variant is a string
 	* \return bool
 	*/
-	bool isString() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::String) : false; };
+	bool isString() const { return m_eType == KviKvsVariantData::String; };
 
 	/**
 	* \brief Returns true if the variant is a scalar
 	* \return bool
 	*/
-	bool isScalar() const { return m_pData ? (m_pData->m_eType & (KviKvsVariantData::String | KviKvsVariantData::Integer | KviKvsVariantData::Real)) : false; };
+	bool isScalar() const { return m_eType & (KviKvsVariantData::String | KviKvsVariantData::Integer | KviKvsVariantData::Real); };
 
 	/**
 	* \brief Returns true if the variant is an array
 	* \return bool
 	*/
-	bool isArray() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::Array) : false; };
+	bool isArray() const { return m_eType == KviKvsVariantData::Array; };
 
 	/**
 	* \brief Returns true if the variant is an hash
 	* \return bool
 	*/
-	bool isHash() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::Hash) : false; };
+	bool isHash() const { return m_eType == KviKvsVariantData::Hash; };
 
 	/**
 	* \brief Returns true if the variant is boolean
 	* \return bool
 	*/
-	bool isBoolean() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::Boolean) : false; };
+	bool isBoolean() const { return m_eType == KviKvsVariantData::Boolean; };
 
 	/**
 	* \brief Returns true if the variant is a hObject
 	* \return bool
 	*/
-	bool isHObject() const { return m_pData ? (m_pData->m_eType == KviKvsVariantData::HObject) : false; };
+	bool isHObject() const { return m_eType == KviKvsVariantData::HObject; };
 
 	/**
 	* \brief Returns true if the variant is empty
@@ -692,43 +720,43 @@ public:
 	* \brief Returns the integer contained in the variant data
 	* \return kvs_int_t
 	*/
-	kvs_int_t integer() const { return m_pData ? m_pData->m_u.iInt : 0; };
+	kvs_int_t integer() const { return (m_eType == KviKvsVariantData::Integer) ? m_u.iInt : 0; };
 
 	/**
 	* \brief Returns the double floating point contained in the variant data
 	* \return kvs_real_t
 	*/
-	kvs_real_t real() const { return m_pData ? *(m_pData->m_u.pReal) : 0.0; };
+	kvs_real_t real() const { return (m_eType == KviKvsVariantData::Real) ? m_u.dReal : 0.0; };
 
 	/**
 	* \brief Returns the string contained in the variant data
 	* \return const QString &
 	*/
-	const QString & string() const { return m_pData ? *(m_pData->m_u.pString) : KviQString::Empty; };
+	const QString & string() const { return m_szString; };
 
 	/**
 	* \brief Returns the boolean contained in the variant data
 	* \return bool
 	*/
-	bool boolean() const { return m_pData ? m_pData->m_u.bBoolean : false; };
+	bool boolean() const { return (m_eType == KviKvsVariantData::Boolean) ? m_u.bBoolean : false; };
 
 	/**
 	* \brief Returns the array contained in the variant data
 	* \return KviKvsArray
 	*/
-	KviKvsArray * array() const { return m_pData ? m_pData->m_u.pArray : 0; };
+	KviKvsArray * array() const { return (m_eType == KviKvsVariantData::Array) ? m_u.pData->m_u.pArray : nullptr; };
 
 	/**
 	* \brief Returns the hash contained in the variant data
 	* \return KviKvsHash
 	*/
-	KviKvsHash * hash() const { return m_pData ? m_pData->m_u.pHash : 0; };
+	KviKvsHash * hash() const { return (m_eType == KviKvsVariantData::Hash) ? m_u.pData->m_u.pHash : nullptr; };
 
 	/**
 	* \brief Returns the object handle contained in the variant data
 	* \return kvs_hobject_t
 	*/
-	kvs_hobject_t hobject() const { return m_pData ? m_pData->m_u.hObject : (kvs_hobject_t)0; };
+	kvs_hobject_t hobject() const { return (m_eType == KviKvsVariantData::HObject) ? m_u.hObject : (kvs_hobject_t)0; };
 
 	/**
 	* \brief Copies a variant from another
@@ -758,6 +786,17 @@ public:
 	*/
 	void takeFrom(KviKvsVariant & variant);
 
+	/**
+	* \brief Makes the array or hash of this variant not shared with other variants
+	*
+	* Copies of a variant share their array or hash until one of them is
+	* modified in place: this must be called before doing it.
+	* The elements of the new container are still shared and they are
+	* detached in turn when they are written.
+	* \return void
+	*/
+	void detach();
+
 	/**
 	* \brief Dumps the variant data
 	* \param pcPrefix The prefix of the data
@@ -805,6 +844,19 @@ public:
 	* \return void
 	*/
 	void operator=(const KviKvsVariant & variant) { copyFrom(variant); };
+protected:
+	/**
+	* \brief Releases the current value leaving the variant set to nothing
+	* \return void
+	*/
+	void clearData();
+
+	/**
+	* \brief Parses the string as a number once and caches the result
+	* \return StringNumber
+	*/
+	StringNumber stringNumber() const;
+
 private:
 	/**
 	* \brief Unserializes the variant data using the JSON format
@@ -25,6 +25,7 @@
 #include "KviKvsEventManager.h"
 #include "KviConfigurationFile.h"
 #include "KviKvsScript.h"
+#include "KviKvsIdleParser.h"
 #include "KviKvsVariant.h"
 #include "KviOptions.h"
 #include "KviLocale.h"
@@ -527,6 +528,8 @@ void KviKvsEventManager::loadRawEvents(const QString & szFileName)
 					szTmp = QString("Enabled%1").arg(uIdx);
 					pScript->setEnabled(cfg.readBoolEntry(szTmp, false));
 					m_rawEventTable[i]->append(pScript);
+					if(pScript->isEnabled())
+						KviKvsIdleParser::instance()->enqueue(pScript->script());
 				}
 			}
 		}
@@ -592,6 +595,8 @@ void KviKvsEventManager::loadAppEvents(const QString & szFileName)
 					QString szCntx = QString("%1::%2").arg(m_appEventTable[i].name(), szName);
 					KviKvsScriptEventHandler * pEvent = new KviKvsScriptEventHandler(szName, szCntx, szCode, bEnabled);
 					m_appEventTable[i].addHandler(pEvent);
+					if(bEnabled)
+						KviKvsIdleParser::instance()->enqueue(pEvent->script());
 				}
 			}
 		}
@@ -141,6 +141,11 @@ KviKvsRWEvaluationResult * KviKvsTreeNodeArrayElement::evaluateReadWriteInObject
 		}
 		result->result()->setArray(new KviKvsArray());
 	}
+	else
+	{
+		// the element is about to be written: don't touch the copies of the array
+		result->result()->detach();
+	}
 	return new KviKvsArrayElement(result, result->result()->array()->getAt(iVal), result->result()->array(), iVal);
 }
 
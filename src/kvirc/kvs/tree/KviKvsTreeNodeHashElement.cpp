@@ -139,6 +139,11 @@ KviKvsRWEvaluationResult * KviKvsTreeNodeHashElement::evaluateReadWriteInObjectS
 		}
 		result->result()->setHash(new KviKvsHash());
 	}
+	else
+	{
+		// the element is about to be written: don't touch the copies of the hash
+		result->result()->detach();
+	}
 
 	return new KviKvsHashElement(result, result->result()->hash()->get(szKey), result->result()->hash(), szKey);
 }
@@ -958,6 +958,7 @@ bool KviKvsTreeNodeOperationArrayAppend::execute(KviKvsRunTimeContext * c)
 		return false;
 
 	target->result()->convertToArray();
+	target->result()->detach();
 	KviKvsArray * a = target->result()->array();
 
 	switch(v.type())
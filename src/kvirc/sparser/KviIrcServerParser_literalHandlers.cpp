@@ -201,27 +201,24 @@ void KviIrcServerParser::parseLiteralChghost(KviIrcMessage * msg)
 	if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnHostChange, console, szNick, szUser, szHost, szNewUser, szNewHost))
 		msg->setHaltOutput();
 
-	for(auto & c : console->connection()->channelList())
+	if(!msg->haltOutput())
 	{
-		if(c->isOn(szNick))
+		for(auto & c : console->connection()->commonChannels(szNick))
 		{
-			if(!msg->haltOutput())
+			if(szHost == szNewHost)
 			{
-				if(szHost == szNewHost)
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user %Q"),
-					    &szNick, &szUser, &szHost, &szNewUser);
-				}
-				else if(szUser == szNewUser)
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has host \r!h\r%Q\r"),
-					    &szNick, &szUser, &szHost, &szNewHost);
-				}
-				else
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user@host %Q@\r!h\r%Q\r"),
-					    &szNick, &szUser, &szHost, &szNewUser, &szNewHost);
-				}
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user %Q"),
+				    &szNick, &szUser, &szHost, &szNewUser);
+			}
+			else if(szUser == szNewUser)
+			{
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has host \r!h\r%Q\r"),
+				    &szNick, &szUser, &szHost, &szNewHost);
+			}
+			else
+			{
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user@host %Q@\r!h\r%Q\r"),
+				    &szNick, &szUser, &szHost, &szNewUser, &szNewHost);
 			}
 		}
 	}
@@ -603,17 +600,14 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 
 		if(console->connection())
 		{
-			for(auto & c : console->connection()->channelList())
+			for(auto & c : console->connection()->commonChannels(szNick))
 			{
-				if(c->isOn(szNick))
+				if(chanlist.isEmpty())
+					chanlist = c->windowName();
+				else
 				{
-					if(chanlist.isEmpty())
-						chanlist = c->windowName();
-					else
-					{
-						chanlist.append(',');
-						chanlist.append(c->windowName());
-					}
+					chanlist.append(',');
+					chanlist.append(c->windowName());
 				}
 			}
 		}
@@ -629,7 +623,8 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 			msg->setHaltOutput();
 	}
 
-	for(auto & c : console->connection()->channelList())
+	// commonChannels() returns a copy: parting is safe
+	for(auto & c : console->connection()->commonChannels(szNick))
 	{
 		if(c->part(szNick))
 		{
@@ -1144,14 +1139,9 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 						pOut = aWin;
 					else
 					{
-						for(auto & c : pConnection->channelList())
-						{
-							if(c->isOn(szOtherNick))
-							{
-								pOut = c;
-								break;
-							}
-						}
+						std::vector<KviChannelWindow *> lChannels = pConnection->commonChannels(szOtherNick);
+						if(!lChannels.empty())
+							pOut = lChannels.front();
 					}
 				}
 
@@ -1564,12 +1554,9 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 						pOut = aWin;
 					else
 					{
-						for(auto & c : pConnection->channelList())
-							if(c->isOn(szNick))
-							{
-								pOut = c;
-								break;
-							}
+						std::vector<KviChannelWindow *> lChannels = pConnection->commonChannels(szNick);
+						if(!lChannels.empty())
+							pOut = lChannels.front();
 					}
 				}
 
@@ -1774,7 +1761,8 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 	if(pUserEntry)
 		pUserEntry->setSmartNickColor(-1);
 
-	for(auto & c : console->connection()->channelList())
+	// commonChannels() returns a copy: the nick change re-indexes the user
+	for(auto & c : console->connection()->commonChannels(szNick))
 	{
 		if(c->nickChange(szNick, szNewNick))
 		{
@@ -1783,7 +1771,11 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 				    &szNick, &szUser, &szHost, &szNewNick);
 			// FIXME if(bIsMe)output(YOU ARE now known as.. ?)
 		}
-		if(bIsMe)
+	}
+
+	if(bIsMe)
+	{
+		for(auto & c : console->connection()->channelList())
 			c->updateCaption();
 	}
 
@@ -44,6 +44,7 @@
 #include "KviIrcConnectionStateData.h"
 #include "KviIrcConnectionUserInfo.h"
 #include "KviIrcConnectionServerInfo.h"
+#include "KviIrcConnectionRequestQueue.h"
 #include "KviIrcConnectionAsyncWhoisData.h"
 #include "KviIrcConnectionTarget.h"
 #include "KviTimeUtils.h"
@@ -297,6 +298,13 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 				if(tmp.hasData())
 					msg->connection()->serverInfo()->setSupportedChannelTypes(tmp.ptr());
 			}
+			else if(kvi_strEqualCIN("CASEMAPPING=", p, 12))
+			{
+				p += 12;
+				QString tmp = p;
+				if(!tmp.isEmpty())
+					msg->connection()->setCaseMapping(tmp);
+			}
 			else if(kvi_strEqualCI("WATCH", p) || kvi_strEqualCIN("WATCH=", p, 6))
 			{
 				msg->connection()->serverInfo()->setSupportsWatchList(true);
@@ -348,6 +356,12 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 				if(bok)
 					msg->connection()->serverInfo()->setMaxModeChanges(num);
 			}
+			else if(kvi_strEqualCIN("TARGMAX=", p, 8))
+			{
+				p += 8;
+				QString tmp = p;
+				msg->connection()->serverInfo()->setMaxTargets(tmp);
+			}
 			else if(kvi_strEqualCIN("NAMESX", p, 6))
 			{
 				p += 6;
@@ -733,7 +747,10 @@ void KviIrcServerParser::parseNumericChannelModeIs(KviIrcMessage * msg)
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	KviCString modefl = msg->safeParam(2);
 	if(chan)
+	{
 		parseChannelMode(szSource, "*", "*", chan, modefl, msg, 3);
+		msg->connection()->requestQueue()->channelModeReceived(chan);
+	}
 	else
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolServerRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
@@ -1100,35 +1117,50 @@ void KviIrcServerParser::parseNumericEndOfWho(KviIrcMessage * msg)
 {
 	// 315: RPL_ENDOFWHO [I,E,U,D]
 	// :prefix 315 target <channel/nick> :End of /WHO List.
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
-	if(chan)
-	{
+	// :prefix 315 target <channel>,<channel>... :End of /WHO List. (WHO with more targets, see TARGMAX)
+	QStringList lTargets = msg->connection()->decodeText(msg->safeParam(1)).split(',', QString::SkipEmptyParts);
+	KviChannelWindow * chan = nullptr;
+	bool bShowEnd = lTargets.isEmpty();
+	foreach(QString szChan, lTargets)
+	{
+		chan = msg->connection()->findChannel(szChan);
+		if(!chan)
+		{
+			bShowEnd = true;
+			continue;
+		}
+
 		chan->userListView()->updateArea();
 		kvi_time_t tNow = kvi_unixTime();
 		msg->connection()->stateData()->setLastReceivedChannelWhoReply(tNow);
 		chan->setLastReceivedWhoReply(tNow);
-		if(msg->connection()->lagMeter())
-		{
-			KviCString tmp(KviCString::Format, "WHO %s", msg->safeParam(1));
-			msg->connection()->lagMeter()->lagCheckComplete(tmp.ptr());
-		}
 
 		if(!chan->hasWhoList())
 		{
 			// FIXME: #warning "IF VERBOSE && SHOW INTERNAL WHO REPLIES...."
 			chan->setHasWhoList();
-			return;
+			continue;
 		}
 
 		if(chan->sentSyncWhoRequest())
 		{
 			// FIXME: #warning "IF VERBOSE && SHOW INTERNAL WHO REPLIES...."
 			chan->clearSentSyncWhoRequest();
-			return;
+			continue;
 		}
+
+		bShowEnd = true;
+	}
+
+	if(chan && msg->connection()->lagMeter())
+	{
+		KviCString tmp(KviCString::Format, "WHO %s", msg->safeParam(1));
+		msg->connection()->lagMeter()->lagCheckComplete(tmp.ptr());
 	}
 
+	if(!bShowEnd)
+		return;
+
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoRepliesToActiveWindow) && chan ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
@@ -2030,6 +2030,9 @@ void KviChannelWindow::outputMessage(int iMsgType, const QString & szMsg, const
 
 void KviChannelWindow::checkChannelSync()
 {
+	// let the on-join request queue collect the replies we got
+	connection()->requestQueue()->channelStateChanged(this);
+
 	if(m_iStateFlags & Synchronized)
 		return;
 
@@ -2039,7 +2042,7 @@ void KviChannelWindow::checkChannelSync()
 			return;
 	}
 
-	// check if we're in the on-join request queue list
+	// check if the on-join requests are still running
 	if(connection()->requestQueue()->isQueued(this))
 		return;
 
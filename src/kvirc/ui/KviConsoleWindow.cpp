@@ -879,7 +879,7 @@ void KviConsoleWindow::avatarChangedUpdateWindows(const QString & nick, const QS
 	// in quiet mode avoid bugging the user about avatar changes
 	bool bOut = ((!textLine.isEmpty()) && (!(_OUTPUT_QUIET)));
 
-	for(auto & c : connection()->channelList())
+	for(auto & c : connection()->commonChannels(nick))
 	{
 		if(c->avatarChanged(nick))
 		{
@@ -1306,6 +1306,22 @@ void KviConsoleWindow::getWindowListTipText(QString & buffer)
 		buffer += tspan;
 		buffer += html_eofbold;
 
+#ifdef COMPILE_SSL_SUPPORT
+		if(connection()->statistics()->sslHandshakeTime() >= 0)
+		{
+			buffer += enr;
+			buffer += nrs;
+			buffer += __tr2qs("SSL handshake");
+			buffer += html_cln;
+			buffer += html_space;
+			buffer += html_bold;
+			buffer += connection()->statistics()->sslSessionResumed() ? __tr2qs("resumed session") : __tr2qs("new session");
+			buffer += html_eofbold;
+			buffer += html_space;
+			buffer += __tr2qs("in %1 msecs (%2 full, %3 resumed since startup)").arg(connection()->statistics()->sslHandshakeTime()).arg(KviSSL::fullHandshakeCount()).arg(KviSSL::resumedHandshakeCount());
+		}
+#endif
+
 		buffer += enr + R"(<tr><td bgcolor="#E0E0E0"><font color="#000000">)";
 
 		tspan = KviTimeUtils::formatTimeInterval((unsigned int)(kvi_secondsSince(connection()->statistics()->lastMessageTime())),
@@ -38,6 +38,7 @@
 #include "KviLocale.h"
 #include "KviScriptEditor.h"
 #include "KviHistoryWindow.h"
+#include "KviIrcSocket.h"
 #include "KviUserInput.h"
 #include "KviShortcut.h"
 #include "KviTalHBox.h"
@@ -209,7 +210,10 @@ void KviInput::toggleToolButtons()
 void KviInput::inputEditorEnterPressed()
 {
 	QString szText = m_pInputEditor->text();
+	// what the user types never waits behind script output or slow pastes
+	KviIrcSocket::OutgoingPriority eOldPriority = KviIrcSocket::setOutgoingPriority(KviIrcSocket::Interactive);
 	KviUserInput::parse(szText, m_pWindow, QString(), m_pCommandlineModeButton->isChecked());
+	KviIrcSocket::setOutgoingPriority(eOldPriority);
 	m_pInputEditor->setText("");
 	m_pInputEditor->clearUndoStack();
 }
@@ -272,7 +276,9 @@ void KviInput::keyPressEvent(QKeyEvent * e)
 						}
 					}
 					szText.replace('\t', QString(KVI_OPTION_UINT(KviOption_uintSpacesToExpandTabulationInput), ' ')); //expand tabs to spaces
+					KviIrcSocket::OutgoingPriority eOldPriority = KviIrcSocket::setOutgoingPriority(KviIrcSocket::Interactive);
 					KviUserInput::parse(szText, m_pWindow, QString(), m_pCommandlineModeButton->isChecked());
+					KviIrcSocket::setOutgoingPriority(eOldPriority);
 					m_pMultiLineEditor->setText("");
 				}
 			}
@@ -166,6 +166,9 @@ extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 
 #define KVI_IRCVIEW_PIXMAP_SIZE 16
 
+// Lines keeping their laid out block texts before the ones outside the view are dropped
+#define KVI_IRCVIEW_MAX_BLOCK_TEXT_LINES 256
+
 #define KVI_IRCVIEW_ESCAPE_TAG_URLLINK 'u'
 #define KVI_IRCVIEW_ESCAPE_TAG_NICKLINK 'n'
 #define KVI_IRCVIEW_ESCAPE_TAG_SERVERLINK 's'
@@ -243,6 +246,10 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 
 	m_iUnprocessedPaintEventRequests = 0;
 	m_bPostedPaintEventPending = false;
+	m_bFrameCacheValid = false;
+	m_bFrameCacheScrollRequested = false;
+	m_iFrameCacheAppendedLines = 0;
+	m_iFrameCacheScrolledLines = 0;
 
 	m_pLastLinkUnderMouse = nullptr;
 	m_iLastLinkRectTop = -1;
@@ -259,9 +266,15 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 
 	m_pFm = nullptr; // will be updated in the first paint event
 	m_iFontDescent = 0;
+	m_iFontAscent = 0;
 	m_iFontLineSpacing = 0;
 	m_iFontLineWidth = 0;
 
+	m_uPaintStatsFrames = 0;
+	m_uBlockTextLines = 0;
+	m_iPaintStatsTotalTime = 0;
+	m_iPaintStatsMaxTime = 0;
+
 	m_pToolTip = new KviIrcViewToolTip(this);
 
 	// Create the scroll bar
@@ -332,6 +345,7 @@ static inline void delete_text_line(KviIrcViewLine * line, QHash<KviIrcViewLine
 	KviMemory::free(line->pChunks); // free attributes data
 	if(line->iBlockCount)
 		KviMemory::free(line->pBlocks);
+	delete[] line->pBlockTexts;
 	delete line;
 }
 
@@ -373,6 +387,10 @@ KviIrcView::~KviIrcView()
 
 void KviIrcView::showEvent(QShowEvent * e)
 {
+	// resume the animated smileys we're showing
+	for(auto pPix : m_hAnimatedSmiles)
+		connect(pPix, SIGNAL(frameChanged()), this, SLOT(animatedIconChange()), Qt::UniqueConnection);
+
 	QWindow * pWin = topLevelWidget()->windowHandle();
 	if(!pWin)
 		return; // huh ?
@@ -381,6 +399,17 @@ void KviIrcView::showEvent(QShowEvent * e)
 	QObject::connect(pWin,SIGNAL(screenChanged(QScreen *)),this,SLOT(screenChanged(QScreen *)));
 }
 
+void KviIrcView::hideEvent(QHideEvent *)
+{
+	// the animated smileys stop ticking when nobody visible is showing them
+	for(auto pPix : m_hAnimatedSmiles)
+		disconnect(pPix, SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
+
+	// a hidden view doesn't need its frame cache: it's rebuilt on the next show
+	m_frameCache = QPixmap();
+	m_bFrameCacheValid = false;
+}
+
 void KviIrcView::screenChanged(QScreen *)
 {
 	// Changing screen can change DPI. Reset font so metrics are recomputed.
@@ -411,7 +440,7 @@ void KviIrcView::setFont(const QFont & f)
 	newFont.setKerning(false);
 	newFont.setStyleStrategy(QFont::StyleStrategy(newFont.styleStrategy() | QFont::ForceIntegerMetrics));
 	QWidget::setFont(newFont);
-	update();
+	fullUpdate();
 }
 
 void KviIrcView::applyOptions()
@@ -477,7 +506,7 @@ void KviIrcView::setPrivateBackgroundPixmap(const QPixmap & pixmap, bool bRepain
 		m_pPrivateBackgroundPixmap = new QPixmap(pixmap);
 
 	if(bRepaint)
-		update();
+		fullUpdate();
 }
 
 void KviIrcView::emptyBuffer(bool bRepaint)
@@ -485,7 +514,7 @@ void KviIrcView::emptyBuffer(bool bRepaint)
 	while(m_pLastLine != nullptr)
 		removeHeadLine();
 	if(bRepaint)
-		update();
+		fullUpdate();
 }
 
 void KviIrcView::clearLineMark(bool bRepaint)
@@ -493,7 +522,7 @@ void KviIrcView::clearLineMark(bool bRepaint)
 	m_uLineMarkLineIndex = KVI_IRCVIEW_INVALID_LINE_MARK_INDEX;
 	clearUnreaded();
 	if(bRepaint)
-		update();
+		fullUpdate();
 }
 
 void KviIrcView::clearUnreaded()
@@ -514,7 +543,7 @@ void KviIrcView::setMaxBufferSize(int maxBufSize, bool bRepaint)
 		removeHeadLine();
 	m_pScrollBar->setRange(0, m_iNumLines);
 	if(bRepaint)
-		update();
+		fullUpdate();
 }
 
 /*
@@ -562,6 +591,7 @@ void KviIrcView::scrollBarPositionChanged(int newValue)
 {
 	if(!m_pCurLine)
 		return;
+	int iMovedLines = 0;
 	if(newValue > m_iLastScrollBarValue)
 	{
 		while(newValue > m_iLastScrollBarValue)
@@ -569,6 +599,7 @@ void KviIrcView::scrollBarPositionChanged(int newValue)
 			if(m_pCurLine->pNext)
 			{
 				m_pCurLine = m_pCurLine->pNext;
+				iMovedLines++;
 			}
 			m_iLastScrollBarValue++;
 		}
@@ -578,17 +609,49 @@ void KviIrcView::scrollBarPositionChanged(int newValue)
 		while(newValue < m_iLastScrollBarValue)
 		{
 			if(m_pCurLine->pPrev)
+			{
 				m_pCurLine = m_pCurLine->pPrev;
+				iMovedLines--;
+			}
 			m_iLastScrollBarValue--;
 		}
 	}
 	if(!m_bSkipScrollBarRepaint)
-		repaint();
+	{
+		// paintEvent() will try to shift the frame cache by the scrolled lines only
+		m_iFrameCacheScrolledLines += iMovedLines;
+		repaintScrolledFrame();
+	}
+}
+
+void KviIrcView::repaintScrolledFrame()
+{
+	m_bFrameCacheScrollRequested = true;
+	repaint();
+	if(m_bFrameCacheScrollRequested)
+	{
+		// paintEvent() didn't run (hidden?): the shift can't be replayed later
+		m_bFrameCacheScrollRequested = false;
+		m_bFrameCacheValid = false;
+	}
+}
+
+void KviIrcView::fullUpdate()
+{
+	// The contents changed in place: the frame cache can't be shifted anymore.
+	// This must be used instead of a plain update() or a pending incremental
+	// paint could consume the update and leave a stale frame on screen.
+	m_bFrameCacheValid = false;
+	update();
 }
 
 void KviIrcView::postUpdateEvent()
 {
-	// This will post a QEvent with a full repaint request
+	// Called when a line has been appended at the bottom of the view.
+	// This will post a QEvent with a repaint request: paintEvent() will
+	// then try to scroll the frame cache by the appended lines only.
+	m_iFrameCacheAppendedLines++;
+
 	if(!m_bPostedPaintEventPending)
 	{
 		m_bPostedPaintEventPending = true;
@@ -600,17 +663,19 @@ void KviIrcView::postUpdateEvent()
 
 	if(m_iUnprocessedPaintEventRequests == 3)
 	{
-// Three unprocessed paint events...do it now
+		// Three unprocessed paint events...do it now
+		repaintScrolledFrame();
+	}
+}
+
+bool KviIrcView::hasScrollableBackground()
+{
+	// The frame cache can be shifted only if the background looks the same everywhere
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
-		if(!((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap || g_pShadedChildGlobalDesktopBackground || KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency)))
-			fastScroll(3);
+	return !((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap || g_pShadedChildGlobalDesktopBackground || KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency));
 #else
-		if(!((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap))
-			fastScroll(3);
+	return !((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap);
 #endif
-		else
-			repaint();
-	}
 }
 
 void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool bRepaint)
@@ -686,6 +751,8 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 				m_pCurLine = ptr;
 				if(bRepaint)
 					postUpdateEvent();
+				else
+					m_bFrameCacheValid = false;
 			}
 			else
 			{
@@ -712,6 +779,8 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 				m_bSkipScrollBarRepaint = false;
 				if(bRepaint)
 					postUpdateEvent();
+				else
+					m_bFrameCacheValid = false;
 			}
 		}
 		m_pLastLine = ptr;
@@ -729,6 +798,8 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 		m_pScrollBar->triggerAction(QAbstractSlider::SliderSingleStepAdd);
 		if(bRepaint)
 			postUpdateEvent();
+		else
+			m_bFrameCacheValid = false;
 	}
 }
 
@@ -963,68 +1034,98 @@ void KviIrcView::getLinkEscapeCommand(QString & buffer, const QString & szPayloa
 	buffer = szPayload.mid(idx, len);
 }
 
-void KviIrcView::fastScroll(int lines)
+bool KviIrcView::scrollFrameCache()
 {
-	m_iUnprocessedPaintEventRequests = 0;
-
-#ifdef COMPILE_ON_MAC
-	// fastScroll() is currently broken for macosx, ticket #791
-	update();
-	return;
-#endif
-
-	if(!isVisible())
-		return;
+	// Either the last m_iFrameCacheAppendedLines lines are new and the view is following them
+	// or the scroll bar moved by m_iFrameCacheScrolledLines: shift the cached frame
+	// and paint only the exposed strip.
+	if(!m_bFrameCacheValid || !m_pFm || !m_pCurLine)
+		return false;
 
-	if(!m_pFm)
+	int iLines;
+	if(m_iFrameCacheScrolledLines != 0)
+	{
+		if(m_iFrameCacheAppendedLines > 0)
+			return false; // both at once: don't bother
+		iLines = m_iFrameCacheScrolledLines;
+	}
+	else
 	{
-		repaint(); // We must get the metrics from a real paint event :/
-		return;	   // must do a full repaint to get them..
+		if((m_iFrameCacheAppendedLines < 1) || (m_pCurLine != m_pLastLine))
+			return false;
+		iLines = m_iFrameCacheAppendedLines;
 	}
 
-	// Ok...the current line is the last one here
-	// It is the only one that needs to be repainted
-	int widgetWidth = width() - m_pScrollBar->width();
+	if(!hasScrollableBackground())
+		return false; // the background would move together with the text
 
-	if(widgetWidth < KVI_IRCVIEW_PIXMAP_AND_SEPARATOR + KVI_IRCVIEW_DOUBLEBORDER_WIDTH + 10)
-		return; // can't show stuff here
+	int iDpr = devicePixelRatio();
+	if(devicePixelRatioF() != (qreal)iDpr)
+		return false; // fractional scaling: the shifted pixels wouldn't match a repaint
 
-	int widgetHeight = height();
+	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
+	int widgetWidth = width() - m_pScrollBar->width();
+	int widgetHeight = height() - toolWidgetHeight;
 	int maxLineWidth = widgetWidth - KVI_IRCVIEW_DOUBLEBORDER_WIDTH;
 
 	if(KVI_OPTION_BOOL(KviOption_boolIrcViewShowImages))
-	{
 		maxLineWidth -= KVI_IRCVIEW_PIXMAP_AND_SEPARATOR;
+
+	if(maxLineWidth < m_iMinimumPaintWidth)
+		return false;
+
+	// The lines are laid out from the bottom up: scrolling forward brings
+	// in the lines up to the cur one, scrolling back pushes out the ones below it
+	int iScrollHeight = 0;
+	KviIrcViewLine * l = (iLines > 0) ? m_pCurLine : m_pCurLine->pNext;
+	for(int i = qAbs(iLines); i > 0; i--)
+	{
+		if(!l)
+			return false;
+		if(maxLineWidth != l->iMaxLineWidth)
+			calculateLineWraps(l, maxLineWidth);
+		iScrollHeight += l->uLineWraps * m_iFontLineSpacing;
+		iScrollHeight += (m_iFontLineSpacing + m_iFontDescent);
+		if(iScrollHeight >= (widgetHeight / 2))
+			return false; // most of the view changed anyway
+		l = (iLines > 0) ? l->pPrev : l->pNext;
 	}
 
-	int heightToPaint = 1;
-	KviIrcViewLine * l = m_pCurLine;
-	while(lines > 0)
+	// keep the sunken border out of the shifted area
+	QRect rctScroll(1, 1, widgetWidth - 2, widgetHeight - 2);
+	int iLineMarkBand = (hasLineMark() && KVI_OPTION_BOOL(KviOption_boolTrackLastReadTextViewLine)) ? 17 : 0;
+
+	if(iLines > 0)
 	{
-		if(l)
-		{
-			if(maxLineWidth != l->iMaxLineWidth)
-				calculateLineWraps(l, maxLineWidth);
-			heightToPaint += l->uLineWraps * m_iFontLineSpacing;
-			heightToPaint += (m_iFontLineSpacing + m_iFontDescent);
-			lines--;
-			l = l->pPrev;
-		}
-		else
-			lines = 0;
+		m_frameCache.scroll(0, -(iScrollHeight * iDpr), QRect(rctScroll.topLeft() * iDpr, rctScroll.size() * iDpr));
+
+		int iExposedTop = widgetHeight - KVI_IRCVIEW_VERTICAL_BORDER - iScrollHeight - 1;
+		paintFrame(&m_frameCache, QRect(0, iExposedTop, widgetWidth, widgetHeight - iExposedTop));
+
+		// the unread text marker lives at a fixed position at the top: it has been shifted away
+		if(iLineMarkBand)
+			paintFrame(&m_frameCache, QRect(0, 0, widgetWidth, KVI_IRCVIEW_VERTICAL_BORDER + iLineMarkBand));
 	}
+	else
+	{
+		iScrollHeight = -iScrollHeight;
+		m_frameCache.scroll(0, -(iScrollHeight * iDpr), QRect(rctScroll.topLeft() * iDpr, rctScroll.size() * iDpr));
 
-	scroll(0, -(heightToPaint - 1), QRect(1, 1, widgetWidth - 2, widgetHeight - 2));
+		// the exposed strip at the top, together with the shifted unread text marker band
+		paintFrame(&m_frameCache, QRect(0, 0, widgetWidth, KVI_IRCVIEW_VERTICAL_BORDER - iScrollHeight + iLineMarkBand + 1));
+	}
 
 	if(m_iLastLinkRectHeight > -1)
 	{	// need to kill the last highlighted link
-		m_iLastLinkRectTop -= heightToPaint;
+		m_iLastLinkRectTop -= iScrollHeight;
 		if(m_iLastLinkRectTop < 0)
 		{
 			m_iLastLinkRectHeight += m_iLastLinkRectTop;
 			m_iLastLinkRectTop = 0;
 		}
 	}
+
+	return true;
 }
 
 //
@@ -1033,8 +1134,6 @@ void KviIrcView::fastScroll(int lines)
 
 void KviIrcView::paintEvent(QPaintEvent * p)
 {
-	// THIS FUNCTION IS A MONSTER
-
 	/*
 	 * Profane description: this is ircview's most important function. It takes a lot of cpu cycles to complete, so we want to be sure
 	 * it's well optimized. First, we want to skip this method every time it's useless: it we're too short or we're covered by other windows.
@@ -1046,16 +1145,11 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 		return;                               // can't show stuff here
 	}
 
-	int scrollbarWidth = m_pScrollBar->width();
-	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
-	int widgetWidth = width() - scrollbarWidth;
-	int widgetHeight = height() - toolWidgetHeight;
-
-	static QRect r; // static: avoid calling constructor and destructor every time...
+	QRect r;
 
 	if(p)
 	{
-		r = p->rect(); // app triggered, or self triggered from fastScroll (in that case m_iUnprocessedPaintEventRequests is set to 0 there)
+		r = p->rect(); // app triggered, or self triggered from postUpdateEvent()
 		if(r == rect())
 			m_iUnprocessedPaintEventRequests = 0; // only full repaints reset
 	}
@@ -1066,6 +1160,74 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 		r = rect();
 	}
 
+	QElapsedTimer paintTimer;
+	paintTimer.start();
+
+	/*
+	 * Profane description: everything is painted in an offscreen frame that is then copied to the screen.
+	 * When lines are appended at the bottom the frame is shifted up and only the new lines are painted.
+	 * With compositing transparency the background must be painted directly on the window instead.
+	 */
+#ifdef COMPILE_PSEUDO_TRANSPARENCY
+	bool bUseFrameCache = !(KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency) && g_pApp->supportsCompositing());
+#else
+	bool bUseFrameCache = true;
+#endif
+
+	if(bUseFrameCache)
+	{
+		qreal dDpr = devicePixelRatioF();
+		QSize cacheSize = size() * dDpr;
+		if((m_frameCache.size() != cacheSize) || (m_frameCache.devicePixelRatio() != dDpr))
+		{
+			// resized or moved to a screen with a different scaling
+			m_frameCache = QPixmap(cacheSize);
+			m_frameCache.setDevicePixelRatio(dDpr);
+			m_bFrameCacheValid = false;
+		}
+
+		if(!m_bFrameCacheValid)
+		{
+			r = rect();
+			paintFrame(&m_frameCache, r);
+		}
+		else if(m_bFrameCacheScrollRequested && (r == rect()) && scrollFrameCache())
+		{
+			// only the exposed lines have been painted
+		}
+		else
+		{
+			paintFrame(&m_frameCache, r);
+		}
+
+		m_bFrameCacheValid = true;
+
+		QPainter pa(this);
+		pa.drawPixmap(QRectF(r), m_frameCache, QRectF(QPointF(r.topLeft()) * dDpr, QSizeF(r.size()) * dDpr));
+	}
+	else
+	{
+		m_frameCache = QPixmap();
+		m_bFrameCacheValid = false;
+		paintFrame(this, r);
+	}
+
+	m_bFrameCacheScrollRequested = false;
+	m_iFrameCacheAppendedLines = 0;
+	m_iFrameCacheScrolledLines = 0;
+
+	updatePaintStatistics(paintTimer.nsecsElapsed());
+}
+
+void KviIrcView::paintFrame(QPaintDevice * pDevice, const QRect & r)
+{
+	// THIS FUNCTION IS A MONSTER
+
+	int scrollbarWidth = m_pScrollBar->width();
+	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
+	int widgetWidth = width() - scrollbarWidth;
+	int widgetHeight = height() - toolWidgetHeight;
+
 	/*
 	 * Profane description: we start the real paint here: set some geometry, a font, and paint the background
 	 */
@@ -1075,7 +1237,8 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 	QFont newFont;
 
-	QPainter pa(this);
+	QPainter pa(pDevice);
+	pa.setClipRect(r);
 
 	SET_ANTI_ALIASING(pa);
 
@@ -1153,9 +1316,13 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	bool bLineMarkPainted = !KVI_OPTION_BOOL(KviOption_boolTrackLastReadTextViewLine);
 	int iLinesPerPage = 0;
 
+	KviIrcViewLine * pOldestPaintedLine = nullptr;
+
 	// And loop through lines until we not run over the upper bound of the view
 	while((curBottomCoord >= KVI_IRCVIEW_VERTICAL_BORDER) && pCurTextLine)
 	{
+		pOldestPaintedLine = pCurTextLine;
+
 		// Paint pCurTextLine
 		if(maxLineWidth != pCurTextLine->iMaxLineWidth)
 		{
@@ -1541,12 +1708,37 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 						pa.drawLine(curLeftCoord, curBottomCoord + 2, curLeftCoord + wdth, curBottomCoord + 2);
 					}
 
-					pa.drawText(curLeftCoord, curBottomCoord, pCurTextLine->szText.mid(block->block_start, block->block_len));
-
-					if (bBold && !m_bUseRealBold)
+					if(block->block_len > 0)
 					{
-						// Draw doubled font (simulate bold)
-						pa.drawText(curLeftCoord + 1, curBottomCoord, pCurTextLine->szText.mid(block->block_start, block->block_len));
+						// The laid out glyphs of each block are cached in the line and reused
+						// until the line is wrapped again (which happens also on font changes).
+						// The color comes from the pen so it's not part of the cached data.
+						if(!pCurTextLine->pBlockTexts)
+						{
+							pCurTextLine->pBlockTexts = new KviIrcViewBlockText[pCurTextLine->iBlockCount]();
+							m_uBlockTextLines++;
+						}
+
+						KviIrcViewBlockText * pText = pCurTextLine->pBlockTexts + i;
+						if((!pText->bPrepared) || (pText->bItalic != curItalic) || (pText->bBold != bBold))
+						{
+							pText->text.setTextFormat(Qt::PlainText);
+							pText->text.setPerformanceHint(QStaticText::AggressiveCaching);
+							pText->text.setText(pCurTextLine->szText.mid(block->block_start, block->block_len));
+							pText->text.prepare(QTransform(), newFont);
+							pText->bItalic = curItalic;
+							pText->bBold = bBold;
+							pText->bPrepared = true;
+						}
+
+						// drawStaticText() takes the top left corner, not the baseline
+						pa.drawStaticText(QPointF(curLeftCoord, curBottomCoord - m_iFontAscent), pText->text);
+
+						if (bBold && !m_bUseRealBold)
+						{
+							// Draw doubled font (simulate bold)
+							pa.drawStaticText(QPointF(curLeftCoord + 1, curBottomCoord - m_iFontAscent), pText->text);
+						}
 					}
 					if(curUnderline)
 					{
@@ -1598,6 +1790,9 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 		pCurTextLine = pCurTextLine->pPrev;
 		iLinesPerPage++;
+
+		if((curBottomCoord + 2) < rectTop)
+			break; // the remaining lines are above the update rect
 	}
 
 	/* REMINDER
@@ -1611,6 +1806,11 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	if(pCurTextLine && iLinesPerPage > 0 && iLinesPerPage != m_pScrollBar->pageStep() && rectHeight == rect().height())
 		m_pScrollBar->setPageStep(iLinesPerPage);
 
+	// keep the laid out texts only for the lines around the view:
+	// the scrollback can be huge and there may be hundreds of views
+	if(pOldestPaintedLine && (m_uBlockTextLines > (unsigned int)qMax(KVI_IRCVIEW_MAX_BLOCK_TEXT_LINES, 2 * iLinesPerPage)))
+		freeDistantBlockTexts(m_pCurLine, pOldestPaintedLine);
+
 	if(!bLineMarkPainted && pCurTextLine && (rectTop <= (KVI_IRCVIEW_VERTICAL_BORDER + 5)))
 	{
 		// the line mark hasn't been painted yet
@@ -1681,12 +1881,70 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	pa.drawLine(widgetWidth, 1, widgetWidth, widgetHeight);
 }
 
+void KviIrcView::updatePaintStatistics(qint64 iPaintTime)
+{
+	m_uPaintStatsFrames++;
+	m_iPaintStatsTotalTime += iPaintTime;
+	if(iPaintTime > m_iPaintStatsMaxTime)
+		m_iPaintStatsMaxTime = iPaintTime;
+
+	if(!m_PaintStatsTimer.isValid())
+	{
+		m_PaintStatsTimer.start();
+		return;
+	}
+
+	qint64 iElapsed = m_PaintStatsTimer.elapsed();
+	if(iElapsed < 2000)
+		return;
+
+#ifdef COMPILE_DEBUG_MODE
+	qDebug("KviIrcView(%s): %u frames in %lld ms (%.1f fps), paint time avg %.3f ms, max %.3f ms",
+	    m_pKviWindow ? m_pKviWindow->windowName().toUtf8().data() : "?",
+	    m_uPaintStatsFrames, (long long)iElapsed,
+	    (double)m_uPaintStatsFrames * 1000.0 / (double)iElapsed,
+	    (double)m_iPaintStatsTotalTime / (double)m_uPaintStatsFrames / 1000000.0,
+	    (double)m_iPaintStatsMaxTime / 1000000.0);
+#endif
+
+	m_uPaintStatsFrames = 0;
+	m_iPaintStatsTotalTime = 0;
+	m_iPaintStatsMaxTime = 0;
+	m_PaintStatsTimer.restart();
+}
+
 //
 // The IrcView : calculate line wraps
 //
 
 #define IRCVIEW_WCHARWIDTH(c) (((c).unicode() < 0xff) ? m_iFontCharacterWidth[(c).unicode()] : m_pFm->width(c))
 
+void KviIrcView::freeDistantBlockTexts(KviIrcViewLine * pNewest, KviIrcViewLine * pOldest)
+{
+	// pOldest...pNewest are the lines just painted: drop the texts of all the others
+	KviIrcViewLine * l;
+	for(l = m_pFirstLine; l && (l != pOldest); l = l->pNext)
+	{
+		delete[] l->pBlockTexts;
+		l->pBlockTexts = nullptr;
+	}
+
+	m_uBlockTextLines = 0;
+	for(; l; l = l->pNext)
+	{
+		if(l->pBlockTexts)
+			m_uBlockTextLines++;
+		if(l == pNewest)
+			break;
+	}
+
+	for(l = l ? l->pNext : nullptr; l; l = l->pNext)
+	{
+		delete[] l->pBlockTexts;
+		l->pBlockTexts = nullptr;
+	}
+}
+
 void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 {
 	// Another monster
@@ -1696,6 +1954,15 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 	if(ptr->iBlockCount != 0)
 		KviMemory::free(ptr->pBlocks); // free any previous wrap blocks
 
+	// the block texts are re-created at the next paint
+	if(ptr->pBlockTexts)
+	{
+		delete[] ptr->pBlockTexts;
+		ptr->pBlockTexts = nullptr;
+		if(m_uBlockTextLines > 0)
+			m_uBlockTextLines--;
+	}
+
 	ptr->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::allocate(sizeof(KviIrcViewWrappedBlock)); // alloc one block
 	ptr->iMaxLineWidth = maxWidth;                                                                // calculus for this width
 	ptr->iBlockCount = 0;                                                                         // it will be ++
@@ -2096,6 +2363,7 @@ void KviIrcView::recalcFontVariables(const QFont & font, const QFontInfo & fi)
 		m_iFontLineSpacing = KVI_IRCVIEW_PIXMAP_SIZE;
 
 	m_iFontDescent = m_pFm->descent();
+	m_iFontAscent = m_pFm->ascent();
 	m_iFontLineWidth = m_pFm->lineWidth();
 
 	// cache the first 256 characters
@@ -2977,7 +3245,7 @@ KviConsoleWindow * KviIrcView::console()
 
 void KviIrcView::animatedIconChange()
 {
-	update();
+	fullUpdate();
 }
 
 void KviIrcView::scrollToMarker()
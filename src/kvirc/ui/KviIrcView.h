@@ -32,6 +32,7 @@
 #include <QPixmap> // needed
 #include <QMultiHash>
 #include <QDateTime>
+#include <QElapsedTimer>
 
 #include <vector>
 
@@ -41,6 +42,7 @@ class QFile;
 class QFontMetrics;
 class QMenu;
 class QScreen;
+class QPaintDevice;
 
 class KviWindow;
 class KviMainWindow;
@@ -107,6 +109,7 @@ private:
 	int m_iFontLineSpacing;
 	int m_iFontLineWidth;
 	int m_iFontDescent;
+	int m_iFontAscent;
 	int m_iFontCharacterWidth[256]; //1024 bytes fixed
 	bool m_bUseRealBold;
 
@@ -136,6 +139,12 @@ private:
 	bool m_bAcceptDrops;
 	int m_iUnprocessedPaintEventRequests;
 	bool m_bPostedPaintEventPending;
+	// The last painted frame: appends shift it instead of repainting everything
+	QPixmap m_frameCache;
+	bool m_bFrameCacheValid;
+	bool m_bFrameCacheScrollRequested;
+	int m_iFrameCacheAppendedLines;
+	int m_iFrameCacheScrolledLines;
 	std::vector<KviIrcViewLine *> m_pMessagesStoppedWhileSelecting;
 	KviIrcView * m_pMasterView;
 	QFontMetrics * m_pFm; // assume this valid only inside a paint event (may be 0 in other circumstances)
@@ -149,6 +158,16 @@ private:
 
 	QMultiHash<KviIrcViewLine *, KviAnimatedPixmap *> m_hAnimatedSmiles;
 
+	// Lines that hold laid out block texts: may overestimate since the
+	// lines deleted or moved to another view aren't subtracted
+	unsigned int m_uBlockTextLines;
+
+	// Paint timing statistics (reported periodically in debug builds)
+	QElapsedTimer m_PaintStatsTimer;
+	unsigned int m_uPaintStatsFrames;
+	qint64 m_iPaintStatsTotalTime; // nsecs
+	qint64 m_iPaintStatsMaxTime;   // nsecs
+
 public:
 	void clearUnreaded();
 	void applyOptions();
@@ -222,6 +241,7 @@ protected:
 	void dragEnterEvent(QDragEnterEvent * e) override;
 	void dropEvent(QDropEvent * e) override;
 	void showEvent(QShowEvent * e) override;
+	void hideEvent(QHideEvent * e) override;
 	bool event(QEvent * e) override;
 	void wheelEvent(QWheelEvent * e) override;
 	void keyPressEvent(QKeyEvent * e) override;
@@ -237,7 +257,11 @@ private:
 	void getLinkEscapeCommand(QString & buffer, const QString & escape_cmd, const QString & escape_label);
 	void appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool bRepaint);
 	void postUpdateEvent();
-	void fastScroll(int lines = 1);
+	void repaintScrolledFrame();
+	void fullUpdate();
+	bool hasScrollableBackground();
+	bool scrollFrameCache();
+	void paintFrame(QPaintDevice * pDevice, const QRect & r);
 	const kvi_wchar_t * getTextLine(int msg_type, const kvi_wchar_t * data_ptr, KviIrcViewLine * line_ptr, bool bEnableTimeStamp = true, const QDateTime & datetime = QDateTime());
 	void calculateLineWraps(KviIrcViewLine * ptr, int maxWidth);
 	void recalcFontVariables(const QFont & font, const QFontInfo & fi);
@@ -248,6 +272,8 @@ private:
 	bool checkMarkerArea(const QPoint & mousePos);
 	void addControlCharacter(KviIrcViewLineChunk * pC, QString & szSelectionText);
 	void reapplyMessageColors();
+	void updatePaintStatistics(qint64 iPaintTime);
+	void freeDistantBlockTexts(KviIrcViewLine * pNewest, KviIrcViewLine * pOldest);
 public slots:
 	void flushLog();
 	void showToolsPopup();
@@ -806,7 +806,7 @@ void KviIrcView::leaveEvent(QEvent *)
 	if(m_pLastLinkUnderMouse)
 	{
 		m_pLastLinkUnderMouse = nullptr;
-		update();
+		fullUpdate();
 	}
 }
 
@@ -1223,7 +1223,9 @@ bool KviIrcView::event(QEvent * e)
 	{
 		KVI_ASSERT(m_bPostedPaintEventPending);
 		if(m_iUnprocessedPaintEventRequests)
-			repaint();
+		{
+			repaintScrolledFrame();
+		}
 		// else we just had a pointEvent that did the job
 		m_bPostedPaintEventPending = false;
 		return true;
@@ -736,10 +736,10 @@ found_icon_escape:
 
 						if(icon->animatedPixmap())
 						{
-							//FIXME: that's ugly
-							disconnect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
-							connect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
 							m_hAnimatedSmiles.insert(line_ptr, icon->animatedPixmap());
+							// hidden views connect when shown: the animation doesn't tick for them
+							if(isVisible())
+								connect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()), Qt::UniqueConnection);
 						}
 						data_ptr = p;
 						NEW_LINE_CHUNK(KviControlCodes::UnIcon)
@@ -1198,10 +1198,10 @@ check_emoticon_char:
 
 								if(icon->animatedPixmap())
 								{
-									//FIXME: that's ugly
-									disconnect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
-									connect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
 									m_hAnimatedSmiles.insert(line_ptr, icon->animatedPixmap());
+									// hidden views connect when shown: the animation doesn't tick for them
+									if(isVisible())
+										connect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()), Qt::UniqueConnection);
 								}
 
 								// we got an icon for this emoticon
@@ -1317,6 +1317,7 @@ void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFla
 		line_ptr->iMsgType = iMsgType;
 		line_ptr->iMaxLineWidth = -1;
 		line_ptr->iBlockCount = 0;
+		line_ptr->pBlockTexts = nullptr;
 		line_ptr->uLineWraps = 0;
 
 		data_ptr = getTextLine(iMsgType, data_ptr, line_ptr, !(iFlags & NoTimestamp), datetime);
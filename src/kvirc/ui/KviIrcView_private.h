@@ -26,6 +26,7 @@
 
 #include "kvi_settings.h"
 
+#include <QStaticText>
 #include <QString>
 
 //
@@ -105,6 +106,20 @@ struct KviIrcViewWrappedBlock
 	int block_width;              // width of the block in pixels
 } _KVI_PACKED;
 
+//
+// The laid out text of a wrapped block, kept across repaints.
+// It depends only on the block text and font style: the colors
+// are applied by the painter pen at draw time.
+//
+
+struct KviIrcViewBlockText
+{
+	QStaticText text;
+	bool bPrepared; // text has been set up for the style below
+	bool bItalic;
+	bool bBold;
+};
+
 struct KviIrcViewLine
 {
 	// this is a text line in the IrcView's memory
@@ -125,6 +140,7 @@ struct KviIrcViewLine
 	int iMaxLineWidth;                // width that the blocks were calculated for (lazy calculation)
 	int iBlockCount;                  // number of allocated paintable blocks
 	KviIrcViewWrappedBlock * pBlocks; // pointer to the re-split paintable blocks
+	KviIrcViewBlockText * pBlockTexts; // iBlockCount laid out block texts, allocated at paint time (or nullptr)
 
 	// next and previous line
 	KviIrcViewLine * pPrev;
@@ -354,36 +354,38 @@ void KviMainWindow::saveWindowProperties(KviWindow * wnd, const QString & szSect
 	while(g_pWinPropertiesConfig->groupsCount() > 80)
 	{
 		// Kill the oldest group
-		KviConfigurationFileIterator it(*(g_pWinPropertiesConfig->dict()));
+		// (the config is lazily parsed: peek the timestamps instead of parsing every group)
+		QStringList lGroups = g_pWinPropertiesConfig->groupNames();
 		QString minKey;
 		unsigned int minVal = time(nullptr);
-		while(it.current() && minVal)
+		for(auto & szGroup : lGroups)
 		{
-			QString * pVal = it.current()->find("EntryTimestamp");
-			if(pVal)
+			if(!minVal)
+				break;
+			QString szVal;
+			if(g_pWinPropertiesConfig->peekEntry(szGroup, "EntryTimestamp", szVal))
 			{
 				bool bOk;
-				unsigned int uVal = pVal->toUInt(&bOk);
+				unsigned int uVal = szVal.toUInt(&bOk);
 				if(bOk)
 				{
 					if(uVal < minVal)
 					{
 						minVal = uVal;
-						minKey = it.currentKey();
+						minKey = szGroup;
 					}
 				}
 				else
 				{
 					minVal = 0;
-					minKey = it.currentKey();
+					minKey = szGroup;
 				}
 			}
 			else
 			{
 				minVal = 0;
-				minKey = it.currentKey();
+				minKey = szGroup;
 			}
-			++it;
 		}
 
 		if(!minKey.isEmpty())
@@ -0,0 +1,104 @@
+//=============================================================================
+//
+//   File : KviThemedTreeView.cpp
+//   Creation date : Mon 19 Oct 2026 23:12:08 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviThemedTreeView.h"
+#include "KviOptions.h"
+#include "kvi_settings.h"
+#include "KviApplication.h"
+#include "KviMainWindow.h"
+#include "KviWindow.h"
+#include "kvi_out.h"
+
+#include <QPainter>
+
+#ifdef COMPILE_PSEUDO_TRANSPARENCY
+extern QPixmap * g_pShadedChildGlobalDesktopBackground;
+#endif
+
+KviThemedTreeView::KviThemedTreeView(QWidget * par, KviWindow * pWindow, const char * name)
+    : QTreeView(par)
+{
+	setObjectName(name);
+	m_pKviWindow = pWindow;
+	setAutoFillBackground(false);
+	applyOptions();
+}
+
+KviThemedTreeView::~KviThemedTreeView()
+    = default;
+
+void KviThemedTreeView::applyOptions()
+{
+	applyThemedStyle(this, "QTreeView");
+}
+
+void KviThemedTreeView::paintEvent(QPaintEvent * e)
+{
+	paintThemedBackground(this, m_pKviWindow);
+	QTreeView::paintEvent(e);
+}
+
+void KviThemedTreeView::applyThemedStyle(QAbstractItemView * pView, const char * szSelector)
+{
+#ifdef COMPILE_PSEUDO_TRANSPARENCY
+	bool bIsTrasparent = (KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency) && g_pApp->supportsCompositing()) || g_pShadedChildGlobalDesktopBackground;
+#else
+	bool bIsTrasparent = false;
+#endif
+
+	QString szStyle = QString("%1 { background: %2; background-clip: content; color: %3; font-family: %4; font-size: %5pt; font-weight: %6; font-style: %7;}")
+	                      .arg(szSelector)
+	                      .arg(bIsTrasparent ? "transparent" : KVI_OPTION_COLOR(KviOption_colorLabelBackground).name())
+	                      .arg(bIsTrasparent ? getMircColor(KVI_OPTION_MSGTYPE(KVI_OUT_NONE).fore()).name() : KVI_OPTION_COLOR(KviOption_colorLabelForeground).name())
+	                      .arg(KVI_OPTION_FONT(KviOption_fontLabel).family())
+	                      .arg(KVI_OPTION_FONT(KviOption_fontLabel).pointSize())
+	                      .arg(KVI_OPTION_FONT(KviOption_fontLabel).weight() == QFont::Bold ? "bold" : "normal")
+	                      .arg(KVI_OPTION_FONT(KviOption_fontLabel).style() == QFont::StyleItalic ? "italic" : "normal");
+
+	pView->setStyleSheet(szStyle);
+	pView->update();
+}
+
+void KviThemedTreeView::paintThemedBackground(QAbstractItemView * pView, KviWindow * pWindow)
+{
+#ifdef COMPILE_PSEUDO_TRANSPARENCY
+	QPainter * p = new QPainter(pView->viewport());
+	if(KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency) && g_pApp->supportsCompositing())
+	{
+		p->setCompositionMode(QPainter::CompositionMode_Source);
+		QColor col = KVI_OPTION_COLOR(KviOption_colorGlobalTransparencyFade);
+		col.setAlphaF((float)((float)KVI_OPTION_UINT(KviOption_uintGlobalTransparencyChildFadeFactor) / (float)100));
+		p->fillRect(pView->viewport()->contentsRect(), col);
+	}
+	else if(g_pShadedChildGlobalDesktopBackground)
+	{
+		QPoint pnt = pWindow->isDocked() ? pView->viewport()->mapTo(g_pMainWindow, pView->contentsRect().topLeft() + pView->viewport()->contentsRect().topLeft()) : pView->viewport()->mapTo(pWindow, pView->contentsRect().topLeft() + pView->viewport()->contentsRect().topLeft());
+		p->drawTiledPixmap(pView->contentsRect(), *(g_pShadedChildGlobalDesktopBackground), pnt);
+	}
+	delete p;
+#else
+	Q_UNUSED(pView);
+	Q_UNUSED(pWindow);
+#endif
+}
@@ -44,6 +44,7 @@
 #include "KviStringConversion.h"
 #include "KviIrcConnection.h"
 #include "KviIrcConnectionServerInfo.h"
+#include "KviChannelWindow.h"
 #include "KviPixmapUtils.h"
 
 #include <QLabel>
@@ -100,6 +101,7 @@ KviUserListEntry::KviUserListEntry(KviUserListView * pParent, const QString & sz
 
 	m_bSelected = false;
 	m_pAvatarPixmap = nullptr;
+	m_bAvatarStarted = false;
 
 	updateAvatarData();
 	recalcSize();
@@ -116,9 +118,26 @@ void KviUserListEntry::detachAvatarData()
 	if(!m_pAvatarPixmap)
 		return;
 
+	QObject::disconnect(m_pAvatarPixmap, nullptr, this, nullptr);
+	if(m_bAvatarStarted)
+		m_pAvatarPixmap->stop();
+	m_bAvatarStarted = false;
 	m_pAvatarPixmap = nullptr;
 }
 
+void KviUserListEntry::setAvatarAnimationActive(bool bActive)
+{
+	if(!m_pAvatarPixmap)
+		return;
+
+	// the animation ticks only while something is connected to frameChanged()
+	// (this also repaints us when the background decoding is done)
+	if(bActive)
+		QObject::connect(m_pAvatarPixmap, SIGNAL(frameChanged()), this, SLOT(avatarFrameChanged()), Qt::UniqueConnection);
+	else
+		QObject::disconnect(m_pAvatarPixmap, SIGNAL(frameChanged()), this, SLOT(avatarFrameChanged()));
+}
+
 void KviUserListEntry::updateAvatarData()
 {
 	detachAvatarData();
@@ -146,13 +165,15 @@ void KviUserListEntry::updateAvatarData()
 	if(!m_pAvatarPixmap)
 		return;
 
-	if(!KVI_OPTION_BOOL(KviOption_boolEnableAnimatedAvatars))
-		return;
-
-	QObject::connect(m_pAvatarPixmap, SIGNAL(frameChanged()), this, SLOT(avatarFrameChanged()));
 	QObject::connect(m_pAvatarPixmap, SIGNAL(destroyed()), this, SLOT(avatarDestroyed()));
 
-	m_pAvatarPixmap->start();
+	if(KVI_OPTION_BOOL(KviOption_boolEnableAnimatedAvatars))
+	{
+		m_pAvatarPixmap->start();
+		m_bAvatarStarted = true;
+	}
+
+	setAvatarAnimationActive(m_pListView->isVisible());
 }
 
 void KviUserListEntry::avatarFrameChanged()
@@ -163,6 +184,7 @@ void KviUserListEntry::avatarFrameChanged()
 void KviUserListEntry::avatarDestroyed()
 {
 	m_pAvatarPixmap = nullptr;
+	m_bAvatarStarted = false;
 }
 
 bool KviUserListEntry::color(QColor & color)
@@ -838,9 +860,13 @@ KviUserListEntry * KviUserListView::join(const QString & szNick, const QString &
 	{
 		// add an entry to the global dict
 		KviIrcUserEntry * pGlobalData = m_pIrcUserDataBase->insertUser(szNick, szUser, szHost);
+		// share the interned nickname unless the server reports it with a different case now
+		const QString & szInterned = (pGlobalData->nick() == szNick) ? pGlobalData->nick() : szNick;
 		// calculate the flags and update the counters
-		pEntry = new KviUserListEntry(this, szNick, pGlobalData, iFlags, (szUser == QString()));
-		insertUserEntry(szNick, pEntry);
+		pEntry = new KviUserListEntry(this, szInterned, pGlobalData, iFlags, (szUser == QString()));
+		insertUserEntry(szInterned, pEntry);
+		if((m_pKviWindow->type() == KviWindow::Channel) && m_pKviWindow->connection())
+			m_pKviWindow->connection()->channelUserJoined((KviChannelWindow *)m_pKviWindow, pGlobalData);
 	}
 	else
 	{
@@ -1331,6 +1357,8 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 	if(bRemoveDefinitively)
 	{
 		pUserEntry->detachAvatarData();
+		if((m_pKviWindow->type() == KviWindow::Channel) && m_pKviWindow->connection())
+			m_pKviWindow->connection()->channelUserParted((KviChannelWindow *)m_pKviWindow, pUserEntry->m_pGlobalData);
 		m_pIrcUserDataBase->removeUser(szNick, pUserEntry->m_pGlobalData);
 	}
 
@@ -1475,10 +1503,17 @@ void KviUserListView::partAllButOne(const QString & szWhoNot)
 
 void KviUserListView::removeAllEntries()
 {
+	// keep the nick -> channels index of the connection in sync
+	KviIrcConnection * pConnection = nullptr;
+	if(m_pEntryDict->count() && (m_pKviWindow->type() == KviWindow::Channel))
+		pConnection = m_pKviWindow->connection();
+
 	KviPointerHashTableIterator<QString, KviUserListEntry> it(*m_pEntryDict);
 	while(it.current())
 	{
 		//it.current()->resetAvatarConnection();
+		if(pConnection)
+			pConnection->channelUserParted((KviChannelWindow *)m_pKviWindow, it.current()->m_pGlobalData);
 		m_pIrcUserDataBase->removeUser(it.currentKey(),
 		    ((KviUserListEntry *)it.current())->m_pGlobalData);
 		++it;
@@ -1515,6 +1550,19 @@ void KviUserListView::partAll()
 	triggerUpdate();
 }
 
+void KviUserListView::showEvent(QShowEvent *)
+{
+	for(KviUserListEntry * e = m_pHeadItem; e; e = e->m_pNext)
+		e->setAvatarAnimationActive(true);
+}
+
+void KviUserListView::hideEvent(QHideEvent *)
+{
+	// pause the animated avatars
+	for(KviUserListEntry * e = m_pHeadItem; e; e = e->m_pNext)
+		e->setAvatarAnimationActive(false);
+}
+
 void KviUserListView::resizeEvent(QResizeEvent *)
 {
 	int iHeight;
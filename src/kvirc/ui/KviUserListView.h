@@ -166,6 +166,7 @@ protected:
 	KviUserListEntry * m_pNext;
 	KviUserListEntry * m_pPrev;
 	KviAnimatedPixmap * m_pAvatarPixmap;
+	bool m_bAvatarStarted;
 
 public:
 	/**
@@ -206,6 +207,13 @@ public:
 	void updateAvatarData();
 	void detachAvatarData();
 
+	/**
+	* \brief Resumes or pauses the animation of the avatar
+	* \param bActive Whether the entry is visible
+	* \return void
+	*/
+	void setAvatarAnimationActive(bool bActive);
+
 protected:
 	/**
 	* \brief Recalculates the size height for the entry
@@ -806,6 +814,8 @@ protected:
 	void updateScrollBarRange();
 
 	void resizeEvent(QResizeEvent * e) override;
+	void showEvent(QShowEvent * e) override;
+	void hideEvent(QHideEvent * e) override;
 
 public slots:
 	/**
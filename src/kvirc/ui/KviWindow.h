@@ -39,6 +39,7 @@
 #include "KviTalHBox.h"
 #include "KviTalSplitter.h"
 #include "KviIconManager.h"
+#include "KviLocale.h"
 
 #include <QFrame>
 #include <QWidget>
@@ -547,9 +548,9 @@ inline QByteArray KviWindow::encodeText(const QString & szText)
 inline QString KviWindow::decodeText(const char * pcText)
 {
 	if(m_pTextCodec)
-		return m_pTextCodec->toUnicode(pcText);
+		return KviLocale::decodeText(m_pTextCodec, pcText);
 	else
-		return defaultTextCodec()->toUnicode(pcText);
+		return KviLocale::decodeText(defaultTextCodec(), pcText);
 }
 
 #endif //_KVI_WINDOW_H_
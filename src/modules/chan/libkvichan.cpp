@@ -34,6 +34,7 @@
 #include "KviIrcUrl.h"
 #include "KviIrcConnection.h"
 #include "KviIrcConnectionTarget.h"
+#include "KviIrcConnectionRequestQueue.h"
 
 #include <QString>
 #include <vector>
@@ -178,6 +179,41 @@ static bool chan_kvs_fnc_isdead(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: chan.syncProgress
+	@type:
+		function
+	@title:
+		$chan.syncProgress
+	@short:
+		Returns the progress of the channel requests made on join
+	@syntax:
+		<integer> $chan.syncProgress
+		<integer> $chan.syncProgress(<window_id:string>)
+	@description:
+		Returns the percentage of the requests made on join (modes, ban lists and WHO)
+		that the server has already replied for the channel specified by <window_id>.[br]
+		The requests of many channels are scheduled together, so a channel may wait
+		for the others before its requests start.[br]
+		[b]100[/b] is returned when all the replies have been received: the channel is synchronized
+		as soon as the server has sent the last of them (see [event:onchannelsync]OnChannelSync[/event]).[br]
+		Dead channels return an empty value.[br]
+		The form without parameters works on the current window.[br]
+*/
+
+static bool chan_kvs_fnc_syncProgress(KviKvsModuleFunctionCall * c)
+{
+	QString szId;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("window id", KVS_PT_STRING, KVS_PF_OPTIONAL, szId)
+	KVSM_PARAMETERS_END(c)
+	KviChannelWindow * ch = chan_kvs_find_channel(c, szId);
+	// dead channels have no connection and no requests
+	if(ch && ch->connection())
+		c->returnValue()->setInteger(ch->connection()->requestQueue()->channelProgress(ch));
+	return true;
+}
+
 /*
 	@doc: chan.topic
 	@type:
@@ -1979,6 +2015,7 @@ static bool chan_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "name", chan_kvs_fnc_name);
 	KVSM_REGISTER_FUNCTION(m, "opcount", chan_kvs_fnc_opcount);
 	KVSM_REGISTER_FUNCTION(m, "ownercount", chan_kvs_fnc_ownercount);
+	KVSM_REGISTER_FUNCTION(m, "syncProgress", chan_kvs_fnc_syncProgress);
 	KVSM_REGISTER_FUNCTION(m, "topic", chan_kvs_fnc_topic);
 	KVSM_REGISTER_FUNCTION(m, "topicsetat", chan_kvs_fnc_topicsetat);
 	KVSM_REGISTER_FUNCTION(m, "topicsetby", chan_kvs_fnc_topicsetby);
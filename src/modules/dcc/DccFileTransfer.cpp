@@ -27,6 +27,7 @@
 #include "DccFileTransfer.h"
 #include "DccBroker.h"
 #include "DccMarshal.h"
+#include "DccResumeLedger.h"
 #include "DccWindow.h"
 
 #include "kvi_debug.h"
@@ -57,6 +58,7 @@
 #endif
 
 #include <QFile>
+#include <QFileInfo>
 #include <QPainter>
 #include <QDateTime>
 #include <qglobal.h>
@@ -98,6 +100,7 @@ DccRecvThread::DccRecvThread(QObject * par, kvi_socket_t fd, KviDccRecvThreadOpt
 	m_uTotalReceivedBytes = 0;
 	m_uInstantReceivedBytes = 0;
 	m_pFile = nullptr;
+	m_pLedger = nullptr;
 	m_pTimeInterval = new KviMSecTimeInterval();
 	m_uStartTime = 0;
 	m_uInstantSpeedInterval = 0;
@@ -109,6 +112,8 @@ DccRecvThread::~DccRecvThread()
 		delete m_pOpt;
 	if(m_pFile)
 		delete m_pFile;
+	if(m_pLedger)
+		delete m_pLedger;
 	delete m_pTimeInterval;
 }
 
@@ -255,6 +260,28 @@ void DccRecvThread::postMessageEvent(const char * m)
 	postEvent(parent(), e);
 }
 
+void DccRecvThread::postSuccessEvent()
+{
+	if(m_pLedger)
+	{
+		// the whole file is here: the ledger isn't needed anymore
+		m_pFile->flush();
+		QString szHash = m_pLedger->finish();
+		delete m_pLedger;
+		m_pLedger = nullptr;
+		if(!szHash.isEmpty())
+		{
+			// the message is translated in the GUI thread
+			KviThreadDataEvent<QString> * e = new KviThreadDataEvent<QString>(KVI_DCC_THREAD_EVENT_FILE_HASH);
+			e->setData(new QString(szHash));
+			postEvent(parent(), e);
+		}
+	}
+
+	KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
+	postEvent(parent(), e);
+}
+
 // FIXME: This stuff should be somewhat related to the 1448 bytes TCP basic packet size
 //#define KVI_DCC_RECV_BLOCK_SIZE 8192
 //#define KVI_DCC_RECV_75PERCENTOF_BLOCK_SIZE 6150
@@ -308,6 +335,18 @@ void DccRecvThread::run()
 		}
 	}
 
+	if(m_pOpt->bUseLedger || m_pOpt->bHashFile)
+	{
+		// on resume this reads the part of the file that the ledger doesn't cover yet
+		m_pLedger = new DccResumeLedger(QString::fromUtf8(m_pOpt->szFileName.ptr()), m_pOpt->bUseLedger, m_pOpt->bHashFile);
+		if(!m_pLedger->start(m_pFile->pos()))
+		{
+			postMessageEvent(__tr_no_lookup_ctx("WARNING: failed to set up the resume ledger, the file will not be checked", "dcc"));
+			delete m_pLedger;
+			m_pLedger = nullptr;
+		}
+	}
+
 	if(m_pOpt->bSendZeroAck && (!m_pOpt->bNoAcks))
 	{
 		if(!sendAck(m_pFile->pos(), bSend64BitAck))
@@ -381,6 +420,8 @@ void DccRecvThread::run()
 							{
 								if(m_pFile->write(buffer, readLen) != readLen)
 									postErrorEvent(KviError::FileIOError);
+								else if(m_pLedger)
+									m_pLedger->addData(buffer, readLen);
 							}
 							break;
 						}
@@ -393,6 +434,9 @@ void DccRecvThread::run()
 							}
 						}
 
+						if(m_pLedger)
+							m_pLedger->addData(buffer, readLen);
+
 						// Update stats
 						m_uTotalReceivedBytes += readLen;
 						m_uInstantReceivedBytes += readLen;
@@ -408,8 +452,7 @@ void DccRecvThread::run()
 								if((quint64)m_pFile->pos() == m_pOpt->uTotalFileSize)
 								{
 									// Received the whole file...die
-									KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-									postEvent(parent(), e);
+									postSuccessEvent();
 									break;
 								}
 							}
@@ -494,8 +537,7 @@ void DccRecvThread::run()
 							if(((quint64)m_pFile->pos() == m_pOpt->uTotalFileSize) || (m_pOpt->uTotalFileSize == 0))
 							{
 								// success if we got the whole file or if we don't know the file size (we trust the peer)
-								KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-								postEvent(parent(), e);
+								postSuccessEvent();
 								break;
 							}
 						}
@@ -548,8 +590,7 @@ void DccRecvThread::run()
 						{
 							// success if we got the whole file or if we don't know the file size (we trust the peer)
 							postMessageEvent(__tr_no_lookup_ctx("Data transfer was terminated 30 seconds ago, closing the connection", "dcc"));
-							KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-							postEvent(parent(), e);
+							postSuccessEvent();
 							break;
 						}
 					}
@@ -571,6 +612,13 @@ void DccRecvThread::run()
 	}
 
 exit_dcc:
+	if(m_pLedger)
+	{
+		// the transfer failed: the ledger stays on disk for the next resume
+		delete m_pLedger;
+		m_pLedger = nullptr;
+	}
+
 	if(m_pFile)
 	{
 		m_pFile->close();
@@ -1288,6 +1336,27 @@ void DccFileTransfer::startConnection()
 		outputAndLog(m_szStatusString);
 	}
 
+	if(m_pDescriptor->bResume && m_pDescriptor->bRecvFile && KVI_OPTION_BOOL(KviOption_boolUseDccResumeLedger))
+	{
+		// don't trust the tail of the local file blindly: keep only what the ledger confirms
+		quint64 uFileSize = QFileInfo(m_pDescriptor->szLocalFileName).size();
+		bool bMismatch = false;
+		quint64 uVerified = DccResumeLedger::verifiedLength(m_pDescriptor->szLocalFileName, uFileSize, &bMismatch);
+		if(uVerified < uFileSize)
+		{
+			if(QFile::resize(m_pDescriptor->szLocalFileName, uVerified))
+			{
+				if(bMismatch)
+					outputAndLog(__tr2qs_ctx("The last %1 bytes of the local file don't match the resume ledger and will be downloaded again", "dcc").arg(uFileSize - uVerified));
+				else
+					outputAndLog(__tr2qs_ctx("The last %1 bytes of the local file are not covered by the resume ledger and will be downloaded again", "dcc").arg(uFileSize - uVerified));
+				m_pDescriptor->szLocalFileSize.setNum(uVerified);
+				if(uVerified == 0)
+					m_pDescriptor->bResume = false;
+			}
+		}
+	}
+
 	if(m_pDescriptor->bResume && m_pDescriptor->bRecvFile)
 	{
 		QString fName;
@@ -2228,6 +2297,14 @@ bool DccFileTransfer::event(QEvent * e)
 				return true;
 			}
 			break;
+			case KVI_DCC_THREAD_EVENT_FILE_HASH:
+			{
+				QString * pszHash = ((KviThreadDataEvent<QString> *)e)->getData();
+				outputAndLog(__tr2qs_ctx("SHA-256: %1", "dcc").arg(*pszHash));
+				delete pszHash;
+				return true;
+			}
+			break;
 			default:
 				qDebug("Invalid event type %d received", ((KviThreadEvent *)e)->id());
 				break;
@@ -2276,6 +2353,8 @@ void DccFileTransfer::connected()
 		o->bSend64BitAck = KVI_OPTION_BOOL(KviOption_boolSend64BitAckInDccRecv);
 		o->bNoAcks = m_pDescriptor->bNoAcks;
 		o->uMaxBandwidth = m_uMaxBandwidth;
+		o->bUseLedger = KVI_OPTION_BOOL(KviOption_boolUseDccResumeLedger);
+		o->bHashFile = KVI_OPTION_BOOL(KviOption_boolHashReceivedDccFiles);
 		m_pSlaveRecvThread = new DccRecvThread(this, m_pMarshal->releaseSocket(), o);
 
 #ifdef COMPILE_SSL_SUPPORT
@@ -49,6 +49,7 @@ class QTimer;
 class QPainter;
 class DccFileTransfer;
 class DccMarshal;
+class DccResumeLedger;
 class QMenu;
 
 struct KviDccSendThreadOptions
@@ -110,6 +111,8 @@ struct KviDccRecvThreadOptions
 	bool bNoAcks;
 	bool bIsTdcc;
 	unsigned int uMaxBandwidth;
+	bool bUseLedger;
+	bool bHashFile;
 };
 
 class DccRecvThread : public DccThread
@@ -133,6 +136,7 @@ protected:
 	quint64 m_uInstantReceivedBytes;
 	quint64 m_uInstantSpeedInterval;
 	QFile * m_pFile;
+	DccResumeLedger * m_pLedger;
 
 public:
 	void initGetInfo();
@@ -147,6 +151,7 @@ public:
 
 protected:
 	void postMessageEvent(const char * msg);
+	void postSuccessEvent();
 	void updateStats();
 	bool sendAck(qint64 filePos, bool bUse64BitAck = false);
 	virtual void run();
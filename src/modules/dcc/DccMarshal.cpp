@@ -565,7 +565,9 @@ void DccMarshal::snActivated(int)
 	// SSL Handshake needed ?
 	if(m_bUseSSL)
 	{
-		m_pSSL = KviSSLMaster::allocSSL(m_pOutputContext->dccMarshalOutputWindow(), m_fd, m_bOutgoing ? KviSSL::Client : KviSSL::Server, m_pOutputContext->dccMarshalOutputContextString());
+		// The listening side uses a context shared by all its transfers, so any session
+		// negotiated with the same peer can be resumed, whatever port it listens on.
+		m_pSSL = KviSSLMaster::allocSSL(m_pOutputContext->dccMarshalOutputWindow(), m_fd, m_bOutgoing ? KviSSL::Client : KviSSL::Server, m_pOutputContext->dccMarshalOutputContextString(), m_bOutgoing ? QString("dcc:%1").arg(m_szIp) : QString());
 
 		if(m_pSSL)
 		{
@@ -0,0 +1,261 @@
+//=============================================================================
+//
+//   File : DccResumeLedger.cpp
+//   Creation date : Mon 19 Oct 2026 20:12:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "DccResumeLedger.h"
+
+#include <QFile>
+
+// The ledger is a text file: this line followed by the hex SHA-1 of each chunk, one per line
+#define KVI_DCC_RESUME_LEDGER_MAGIC "KVIrc DCC resume ledger 1"
+#define KVI_DCC_RESUME_LEDGER_HASH_LENGTH 40
+
+DccResumeLedger::DccResumeLedger(const QString & szLocalFileName, bool bRecordChunks, bool bHashWholeFile)
+    : m_ChunkHash(QCryptographicHash::Sha1)
+{
+	m_szLocalFileName = szLocalFileName;
+	m_bRecordChunks = bRecordChunks;
+	m_pLedgerFile = nullptr;
+	m_pFileHash = bHashWholeFile ? new QCryptographicHash(QCryptographicHash::Sha256) : nullptr;
+	m_iChunkFill = 0;
+}
+
+DccResumeLedger::~DccResumeLedger()
+{
+	if(m_pLedgerFile)
+	{
+		m_pLedgerFile->close();
+		delete m_pLedgerFile;
+	}
+	if(m_pFileHash)
+		delete m_pFileHash;
+}
+
+QString DccResumeLedger::ledgerFileName(const QString & szLocalFileName)
+{
+	return szLocalFileName + ".kvirc-ledger";
+}
+
+void DccResumeLedger::remove(const QString & szLocalFileName)
+{
+	QFile::remove(ledgerFileName(szLocalFileName));
+}
+
+bool DccResumeLedger::readLedger(const QString & szLedgerFileName, QList<QByteArray> & lChunks)
+{
+	QFile f(szLedgerFileName);
+	if(!f.open(QIODevice::ReadOnly))
+		return false;
+
+	if(f.readLine().trimmed() != KVI_DCC_RESUME_LEDGER_MAGIC)
+		return false;
+
+	while(!f.atEnd())
+	{
+		QByteArray szLine = f.readLine().trimmed();
+		// a line cut by a crash ends the ledger
+		if(szLine.length() != KVI_DCC_RESUME_LEDGER_HASH_LENGTH)
+			break;
+		lChunks.append(szLine);
+	}
+	return true;
+}
+
+bool DccResumeLedger::writeLedger(const QString & szLedgerFileName, const QList<QByteArray> & lChunks)
+{
+	QFile f(szLedgerFileName);
+	if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QByteArray szData(KVI_DCC_RESUME_LEDGER_MAGIC "\n");
+	for(auto & szChunk : lChunks)
+	{
+		szData.append(szChunk);
+		szData.append('\n');
+	}
+	return f.write(szData) == szData.size();
+}
+
+quint64 DccResumeLedger::verifiedLength(const QString & szLocalFileName, quint64 uFileSize, bool * pbMismatch)
+{
+	if(pbMismatch)
+		*pbMismatch = false;
+
+	QList<QByteArray> lChunks;
+	if(!readLedger(ledgerFileName(szLocalFileName), lChunks))
+		return uFileSize;
+
+	QFile f(szLocalFileName);
+	if(!f.open(QIODevice::ReadOnly))
+		return uFileSize;
+
+	int iChunks = lChunks.count();
+	if((quint64)iChunks > (uFileSize / KVI_DCC_RESUME_LEDGER_CHUNK_SIZE))
+		iChunks = (int)(uFileSize / KVI_DCC_RESUME_LEDGER_CHUNK_SIZE);
+
+	// A crash or a bad disk hits the end of the file: check the last chunk only,
+	// the earlier ones are covered by the SHA-256 reported when the transfer completes
+	if(iChunks > 0)
+	{
+		bool bMatches = false;
+		if(f.seek(((quint64)(iChunks - 1)) * KVI_DCC_RESUME_LEDGER_CHUNK_SIZE))
+		{
+			QByteArray data = f.read(KVI_DCC_RESUME_LEDGER_CHUNK_SIZE);
+			bMatches = (data.size() == KVI_DCC_RESUME_LEDGER_CHUNK_SIZE) && (QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() == lChunks.at(iChunks - 1));
+		}
+		if(!bMatches)
+		{
+			iChunks--;
+			if(pbMismatch)
+				*pbMismatch = true;
+		}
+	}
+
+	if(iChunks < lChunks.count())
+		writeLedger(ledgerFileName(szLocalFileName), lChunks.mid(0, iChunks));
+
+	return ((quint64)iChunks) * KVI_DCC_RESUME_LEDGER_CHUNK_SIZE;
+}
+
+bool DccResumeLedger::start(quint64 uPosition)
+{
+	// the data on disk that must be hashed goes from uChunksFrom to uPosition
+	quint64 uChunksFrom = uPosition;
+
+	if(m_bRecordChunks)
+	{
+		QString szLedgerFileName = ledgerFileName(m_szLocalFileName);
+		QList<QByteArray> lChunks;
+		// a new download throws away any old ledger
+		if(uPosition > 0)
+			readLedger(szLedgerFileName, lChunks);
+
+		int iCovered = lChunks.count();
+		if((quint64)iCovered > (uPosition / KVI_DCC_RESUME_LEDGER_CHUNK_SIZE))
+			iCovered = (int)(uPosition / KVI_DCC_RESUME_LEDGER_CHUNK_SIZE);
+		if(iCovered < lChunks.count())
+			lChunks = lChunks.mid(0, iCovered);
+
+		if(!writeLedger(szLedgerFileName, lChunks))
+			return false;
+
+		m_pLedgerFile = new QFile(szLedgerFileName);
+		if(!m_pLedgerFile->open(QIODevice::WriteOnly | QIODevice::Append))
+			return false;
+
+		uChunksFrom = ((quint64)iCovered) * KVI_DCC_RESUME_LEDGER_CHUNK_SIZE;
+	}
+
+	quint64 uReadFrom = m_pFileHash ? 0 : uChunksFrom;
+	if(uReadFrom >= uPosition)
+		return true;
+
+	QFile f(m_szLocalFileName);
+	if(!f.open(QIODevice::ReadOnly))
+		return false;
+	if(!f.seek(uReadFrom))
+		return false;
+
+	quint64 uPos = uReadFrom;
+	while(uPos < uPosition)
+	{
+		quint64 uToRead = uPosition - uPos;
+		if(uToRead > KVI_DCC_RESUME_LEDGER_CHUNK_SIZE)
+			uToRead = KVI_DCC_RESUME_LEDGER_CHUNK_SIZE;
+		QByteArray data = f.read(uToRead);
+		if(data.isEmpty())
+			return false;
+
+		if(m_pFileHash)
+			m_pFileHash->addData(data);
+
+		if(m_bRecordChunks && ((uPos + data.size()) > uChunksFrom))
+		{
+			int iSkip = (uPos < uChunksFrom) ? (int)(uChunksFrom - uPos) : 0;
+			addChunkData(data.constData() + iSkip, data.size() - iSkip);
+		}
+
+		uPos += data.size();
+	}
+	return true;
+}
+
+void DccResumeLedger::chunkCompleted()
+{
+	QByteArray szLine = m_ChunkHash.result().toHex();
+	szLine.append('\n');
+	m_ChunkHash.reset();
+	m_iChunkFill = 0;
+
+	if(!m_pLedgerFile)
+		return;
+	// if the ledger can't be written anymore it is simply left behind:
+	// the next resume will re-download the chunks it doesn't cover
+	if(m_pLedgerFile->write(szLine) != szLine.size())
+	{
+		m_pLedgerFile->close();
+		delete m_pLedgerFile;
+		m_pLedgerFile = nullptr;
+		return;
+	}
+	m_pLedgerFile->flush();
+}
+
+void DccResumeLedger::addData(const char * pcData, int iLen)
+{
+	if(m_pFileHash)
+		m_pFileHash->addData(pcData, iLen);
+
+	if(m_bRecordChunks)
+		addChunkData(pcData, iLen);
+}
+
+void DccResumeLedger::addChunkData(const char * pcData, int iLen)
+{
+	while(iLen > 0)
+	{
+		int iPart = qMin(iLen, KVI_DCC_RESUME_LEDGER_CHUNK_SIZE - m_iChunkFill);
+		m_ChunkHash.addData(pcData, iPart);
+		m_iChunkFill += iPart;
+		pcData += iPart;
+		iLen -= iPart;
+		if(m_iChunkFill == KVI_DCC_RESUME_LEDGER_CHUNK_SIZE)
+			chunkCompleted();
+	}
+}
+
+QString DccResumeLedger::finish()
+{
+	if(m_pLedgerFile)
+	{
+		m_pLedgerFile->close();
+		delete m_pLedgerFile;
+		m_pLedgerFile = nullptr;
+	}
+	if(m_bRecordChunks)
+		remove(m_szLocalFileName);
+
+	if(!m_pFileHash)
+		return QString();
+	return QString::fromLatin1(m_pFileHash->result().toHex());
+}
@@ -0,0 +1,90 @@
+#ifndef _DCCRESUMELEDGER_H_
+#define _DCCRESUMELEDGER_H_
+//=============================================================================
+//
+//   File : DccResumeLedger.h
+//   Creation date : Mon 19 Oct 2026 20:12:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QList>
+#include <QString>
+
+class QFile;
+
+// The chunk size of the ledger: a failed verification costs at most this much data
+#define KVI_DCC_RESUME_LEDGER_CHUNK_SIZE (4 * 1024 * 1024)
+
+//
+// The sidecar file that makes DCC RESUME safe.
+// While a file is received the hash of each completed chunk is appended
+// to <file>.kvirc-ledger: on resume the tail of the file is checked
+// against it and only the chunks that still match are kept.
+// The ledger can also compute the hash of the whole file while the
+// data arrives, so the file doesn't need to be read again at the end.
+// The receiving side is used by DccRecvThread only.
+//
+class DccResumeLedger
+{
+public:
+	DccResumeLedger(const QString & szLocalFileName, bool bRecordChunks, bool bHashWholeFile);
+	~DccResumeLedger();
+
+protected:
+	QString m_szLocalFileName;
+	bool m_bRecordChunks;
+	QFile * m_pLedgerFile;
+	QCryptographicHash m_ChunkHash;
+	QCryptographicHash * m_pFileHash;
+	int m_iChunkFill; // the bytes already in m_ChunkHash
+
+public:
+	static QString ledgerFileName(const QString & szLocalFileName);
+	// Returns the length of the head of the local file that can be resumed.
+	// This runs in the GUI thread, so only the last recorded chunk is hashed again:
+	// if it doesn't match it is dropped from the ledger together with the tail.
+	// The tail after the last complete chunk isn't covered by the ledger and is dropped too:
+	// pbMismatch tells if the last chunk has been dropped because its hash didn't match.
+	// Without a ledger the file size is trusted, as it has always been.
+	static quint64 verifiedLength(const QString & szLocalFileName, quint64 uFileSize, bool * pbMismatch = nullptr);
+	static void remove(const QString & szLocalFileName);
+
+	// Starts recording at uPosition (the current length of the local file).
+	// The data on disk that isn't covered by the ledger yet is hashed first:
+	// this is all the file if the hash of the whole file is requested.
+	bool start(quint64 uPosition);
+	// Must be called with the data written to the local file
+	void addData(const char * pcData, int iLen);
+	// The transfer has been completed: the ledger is removed.
+	// Returns the hex SHA-256 of the whole file or an empty string if not requested
+	QString finish();
+
+protected:
+	static bool readLedger(const QString & szLedgerFileName, QList<QByteArray> & lChunks);
+	static bool writeLedger(const QString & szLedgerFileName, const QList<QByteArray> & lChunks);
+	void addChunkData(const char * pcData, int iLen);
+	void chunkCompleted();
+};
+
+#endif //_DCCRESUMELEDGER_H_
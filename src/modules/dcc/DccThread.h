@@ -45,6 +45,8 @@
 #define KVI_DCC_THREAD_EVENT_MESSAGE (KVI_THREAD_USER_EVENT_BASE + 4)
 // KviThreadDataEvent<int>
 #define KVI_DCC_THREAD_EVENT_ACTION (KVI_THREAD_USER_EVENT_BASE + 5)
+// KviThreadDataEvent<QString>: the hex SHA-256 of a received file
+#define KVI_DCC_THREAD_EVENT_FILE_HASH (KVI_THREAD_USER_EVENT_BASE + 6)
 
 struct KviDccThreadIncomingData
 {
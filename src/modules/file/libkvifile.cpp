@@ -754,70 +754,19 @@ static bool file_kvs_fnc_ls(KviKvsModuleFunctionCall * c)
 	if(szDir.left(2) != "\\\\")
 		KviFileUtils::adjustFilePath(szDir);
 
-	QDir d(szDir);
-	if(!d.exists())
+	QStringList sl;
+	if(KviFileUtils::listDirectory(szDir, sl, szFlags, szFilter) != KviError::Success)
 	{
 		c->warning(__tr2qs("The specified directory doesn't exist '%Q'"), &szDir);
 		return true;
 	}
 
-	QFlags<QDir::Filter> iFlags = nullptr;
-	if(szFlags.isEmpty())
-		iFlags = QDir::Dirs | QDir::Files | QDir::NoSymLinks | QDir::Readable | QDir::Writable | QDir::Executable | QDir::Hidden | QDir::System;
-	else
-	{
-		if(szFlags.indexOf('d', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::Dirs;
-		if(szFlags.indexOf('f', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::Files;
-		if(szFlags.indexOf('l', Qt::CaseInsensitive) == -1)
-			iFlags |= QDir::NoSymLinks;
-		if(szFlags.indexOf('r', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::Readable;
-		if(szFlags.indexOf('w', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::Writable;
-		if(szFlags.indexOf('x', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::Executable;
-		if(szFlags.indexOf('h', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::Hidden;
-		if(szFlags.indexOf('s', Qt::CaseInsensitive) != -1)
-			iFlags |= QDir::System;
-	}
-
-	QFlags<QDir::SortFlag> iSort = nullptr;
-	if(szFlags.isEmpty())
-		iSort = QDir::Unsorted;
-	else
-	{
-		if(szFlags.indexOf('n', Qt::CaseInsensitive) != -1)
-			iSort |= QDir::Name;
-		if(szFlags.indexOf('t', Qt::CaseInsensitive) != -1)
-			iSort |= QDir::Time;
-		if(szFlags.indexOf('b', Qt::CaseInsensitive) != -1)
-			iSort |= QDir::Size;
-		if(szFlags.indexOf('z', Qt::CaseInsensitive) != -1)
-			iSort |= QDir::DirsFirst;
-		if(szFlags.indexOf('k', Qt::CaseInsensitive) != -1)
-			iSort |= QDir::Reversed;
-		if(szFlags.indexOf('i', Qt::CaseInsensitive) != -1)
-			iSort |= QDir::IgnoreCase;
-	}
-
-	QStringList sl;
-	if(!szFilter.isEmpty())
-		sl = d.entryList(QStringList(szFilter), iFlags, iSort);
-	else
-		sl = d.entryList(iFlags, iSort);
-
 	KviKvsArray * pArray = new KviKvsArray();
-	if(!sl.isEmpty())
+	int iIdx = 0;
+	for(const auto & it : sl)
 	{
-		int iIdx = 0;
-		for(const auto & it : sl)
-		{
-			pArray->set(iIdx, new KviKvsVariant(it));
-			iIdx++;
-		}
+		pArray->set(iIdx, new KviKvsVariant(it));
+		iIdx++;
 	}
 	c->returnValue()->setArray(pArray);
 
@@ -870,52 +819,27 @@ static bool file_kvs_fnc_read(KviKvsModuleFunctionCall * c)
 	if(szFileName.left(2) != "\\\\")
 		KviFileUtils::adjustFilePath(szFileName);
 
-	QFile f(szFileName);
-	if(!f.open(QIODevice::ReadOnly))
-	{
-		c->warning(__tr2qs("Can't open the file '%Q' for reading"), &szFileName);
-		return true;
-	}
-
 	if(c->params()->count() < 2)
 		uSize = 1024 * 1024; // 1 meg file default
 
-	char * pcBuf = (char *)KviMemory::allocate(sizeof(char) * (uSize + 1));
-	unsigned int uReaded = 0;
-	unsigned int uRetries = 0;
-
-	while((uReaded < uSize) && (!f.atEnd()))
+	QByteArray data;
+	switch(KviFileUtils::readFileData(szFileName, data, uSize))
 	{
-		if(uRetries > 1000)
-		{
-			// ops
-			KviMemory::free(pcBuf);
-			c->warning(__tr2qs("Read error for file '%Q' (have been unable to read the requested size in 1000 retries)"), &szFileName);
-			return true;
-		}
-
-		int iReadedNow = f.read(pcBuf + uReaded, uSize - uReaded);
-
-		if(iReadedNow < 0)
-		{
-			KviMemory::free(pcBuf);
+		case KviError::Success:
+			// the string ends at the first null byte
+			if(szFlags.indexOf('l', Qt::CaseInsensitive) == -1)
+				c->returnValue()->setString(QString::fromUtf8(data.constData()));
+			else
+				c->returnValue()->setString(QString::fromLocal8Bit(data.constData()));
+			break;
+		case KviError::CantOpenFileForReading:
+			c->warning(__tr2qs("Can't open the file '%Q' for reading"), &szFileName);
+			break;
+		default:
 			c->warning(__tr2qs("Read error for file '%Q'"), &szFileName);
-			return true;
-		}
-
-		uReaded += iReadedNow;
-		uRetries++;
+			break;
 	}
 
-	pcBuf[uReaded] = '\0';
-
-	if(szFlags.indexOf('l', Qt::CaseInsensitive) == -1)
-		c->returnValue()->setString(QString::fromUtf8(pcBuf));
-	else
-		c->returnValue()->setString(QString::fromLocal8Bit(pcBuf));
-
-	KviMemory::free(pcBuf);
-
 	return true;
 }
 
@@ -959,58 +883,29 @@ static bool file_kvs_fnc_readBytes(KviKvsModuleFunctionCall * c)
 	if(szFileName.left(2) != "\\\\")
 		KviFileUtils::adjustFilePath(szFileName);
 
-	QFile f(szFileName);
-	if(!f.open(QIODevice::ReadOnly))
-	{
-		c->warning(__tr2qs("Can't open the file '%Q' for reading"), &szFileName);
-		return true;
-	}
-
 	if(c->params()->count() < 2)
 		uSize = 1024 * 1024; // 1 meg file default
 
-	unsigned char * pcBuf = (unsigned char *)KviMemory::allocate(sizeof(char) * (uSize + 1));
-	unsigned int uReaded = 0;
-	unsigned int uRetries = 0;
-
-	while((uReaded < uSize) && (!f.atEnd()))
+	QByteArray data;
+	switch(KviFileUtils::readFileData(szFileName, data, uSize))
 	{
-		if(uRetries > 1000)
-		{
-			// ops
-			KviMemory::free(pcBuf);
-			c->warning(__tr2qs("Read error for file '%Q' (have been unable to read the requested size in 1000 retries)"), &szFileName);
+		case KviError::Success:
+			break;
+		case KviError::CantOpenFileForReading:
+			c->warning(__tr2qs("Can't open the file '%Q' for reading"), &szFileName);
 			return true;
-		}
-
-		int iReadedNow = f.read((char *)(pcBuf + uReaded), uSize - uReaded);
-
-		if(iReadedNow < 0)
-		{
-			KviMemory::free(pcBuf);
+		default:
 			c->warning(__tr2qs("Read error for file '%Q'"), &szFileName);
 			return true;
-		}
-
-		uReaded += iReadedNow;
-		uRetries++;
 	}
 
 	KviKvsArray * pArray = new KviKvsArray();
 
-	kvs_uint_t u = 0;
-	unsigned char * p = pcBuf;
-	while(u < uReaded)
-	{
-		pArray->set(u, new KviKvsVariant((kvs_int_t)(*p)));
-		u++;
-		p++;
-	}
+	for(int i = 0; i < data.size(); i++)
+		pArray->set(i, new KviKvsVariant((kvs_int_t)(unsigned char)data.at(i)));
 
 	c->returnValue()->setArray(pArray);
 
-	KviMemory::free(pcBuf);
-
 	return true;
 }
 
@@ -1060,14 +955,6 @@ static bool file_kvs_fnc_readLines(KviKvsModuleFunctionCall * c)
 	if(szFileName.left(2) != "\\\\")
 		KviFileUtils::adjustFilePath(szFileName);
 
-	QFile f(szFileName);
-
-	if(!f.open(QIODevice::ReadOnly))
-	{
-		c->warning(__tr2qs("Can't open the file '%Q' for reading"), &szFileName);
-		return true;
-	}
-
 	if(c->params()->count() < 2)
 		iStartLine = 0;
 	if(c->params()->count() < 3)
@@ -1075,44 +962,21 @@ static bool file_kvs_fnc_readLines(KviKvsModuleFunctionCall * c)
 
 	bool bLocal8Bit = szFlags.indexOf('l', 0, Qt::CaseInsensitive) != -1;
 
-	KviKvsArray * pArray = new KviKvsArray();
-
-	int iIndex = 0;
-
-	QTextStream stream(&f);
-
-	if(!bLocal8Bit)
-		stream.setCodec(QTextCodec::codecForMib(106));
-
-	for(int i = 0; i < iStartLine; i++)
-		stream.readLine();
-
-	if(iCount > 0)
+	QStringList sl;
+	if(KviFileUtils::readLines(szFileName, sl, iStartLine, iCount, !bLocal8Bit) != KviError::Success)
 	{
-		while(iCount > 0)
-		{
-			QString szLine = stream.readLine();
-			if(szLine.isNull())
-				break; // EOF (atEnd() is unreliable on files in /proc)
-			pArray->set(iIndex, new KviKvsVariant(szLine));
-			iIndex++;
-			iCount--;
-		}
+		c->warning(__tr2qs("Can't open the file '%Q' for reading"), &szFileName);
+		return true;
 	}
-	else
+
+	KviKvsArray * pArray = new KviKvsArray();
+	int iIndex = 0;
+	for(const auto & it : sl)
 	{
-		for(;;)
-		{
-			QString szLine = stream.readLine();
-			if(szLine.isNull())
-				break; // EOF (atEnd() is unreliable on files in /proc)
-			pArray->set(iIndex, new KviKvsVariant(szLine));
-			iIndex++;
-		}
+		pArray->set(iIndex, new KviKvsVariant(it));
+		iIndex++;
 	}
 
-	f.close();
-
 	c->returnValue()->setArray(pArray);
 
 	return true;
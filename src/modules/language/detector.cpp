@@ -28,6 +28,9 @@
 #include <cstring>
 #include <cctype>
 
+#include <algorithm>
+#include <vector>
+
 #include "detector.h"
 
 namespace {
@@ -18561,7 +18564,7 @@ static char valid_char_jump_table[256] = {
 #undef k
 #undef f
 
-static double score_for_ngram(DetectorDescriptor * d, const unsigned char * ngram)
+static int ngram_hash_bucket(const unsigned char * ngram)
 {
 	const unsigned char * p = ngram;
 	int xhash = *p * 31;
@@ -18577,7 +18580,16 @@ static double score_for_ngram(DetectorDescriptor * d, const unsigned char * ngra
 			xhash += *p * 3;
 		}
 	}
-	DetectorNGram * g = d->ngram_hash[xhash % 256];
+	return xhash % 256;
+}
+
+//
+// REFERENCE SCORING: one descriptor at a time
+//
+
+static double score_for_ngram(DetectorDescriptor * d, const unsigned char * ngram)
+{
+	DetectorNGram * g = d->ngram_hash[ngram_hash_bucket(ngram)];
 	while(g->szNGram)
 	{
 		if(strcmp((const char *)ngram, (const char *)g->szNGram) == 0)
@@ -18653,6 +18665,233 @@ static DetectorDescriptor * all_descriptors[NUM_DESCRIPTORS] = {
 	&l30_d, &l31_d, &l32_d, &l33_d, &l34_d, &l35_d, &l36_d, &l37_d, &l38_d, &l39_d
 };
 
+//
+// SINGLE PASS SCORING
+//
+// At first use the tables of all the descriptors are merged in one index.
+// The single char tables become a matrix with one row per character and
+// the ngrams are stored once in an open addressing hash, each one with the
+// scores of all the descriptors that know it.
+// The text is then tokenized once and every ngram is looked up once for all
+// the descriptors. The scores are summed in the same order used by
+// compute_descriptor_score() so the results are exactly the same.
+//
+
+struct DetectorIndexScore
+{
+	int iDescriptor;
+	double dScore;
+};
+
+struct DetectorIndexSlot
+{
+	unsigned int uKey; // the ngram packed with its first char in the lowest byte, 0 if the slot is free
+	unsigned int uFirstScore;
+	unsigned int uScoreCount;
+};
+
+static unsigned int pack_ngram(const unsigned char * ngram)
+{
+	unsigned int uKey = 0;
+	for(int i = 0; (i < 4) && ngram[i]; i++)
+		uKey |= ((unsigned int)ngram[i]) << (8 * i);
+	return uKey;
+}
+
+static inline unsigned int index_slot_hash(unsigned int uKey)
+{
+	unsigned int uHash = uKey * 2654435761U;
+	return uHash ^ (uHash >> 16);
+}
+
+struct DetectorIndexEntry
+{
+	unsigned int uKey;
+	DetectorIndexScore score;
+};
+
+static bool index_entry_less_than(const DetectorIndexEntry & a1, const DetectorIndexEntry & a2)
+{
+	return a1.uKey < a2.uKey;
+}
+
+class DetectorIndex
+{
+public:
+	DetectorIndex();
+
+public:
+	double m_dCharRows[256][NUM_DESCRIPTORS];
+	bool m_bIsUtf8[NUM_DESCRIPTORS];
+	unsigned int m_uSlotMask;
+	std::vector<DetectorIndexSlot> m_vSlots;
+	std::vector<DetectorIndexScore> m_vScores;
+
+public:
+	inline const DetectorIndexSlot * find(unsigned int uKey) const
+	{
+		unsigned int uSlot = index_slot_hash(uKey) & m_uSlotMask;
+		for(;;)
+		{
+			const DetectorIndexSlot * pSlot = &(m_vSlots[uSlot]);
+			if(pSlot->uKey == uKey)
+				return pSlot;
+			if(pSlot->uKey == 0)
+				return nullptr;
+			uSlot = (uSlot + 1) & m_uSlotMask;
+		}
+	}
+};
+
+DetectorIndex::DetectorIndex()
+{
+	int i;
+	for(i = 0; i < NUM_DESCRIPTORS; i++)
+	{
+		for(int iChar = 0; iChar < 256; iChar++)
+			m_dCharRows[iChar][i] = all_descriptors[i]->single_char_data[iChar];
+		m_bIsUtf8[i] = ((strcmp(all_descriptors[i]->szEncoding, "utf8") == 0) || (strcmp(all_descriptors[i]->szEncoding, "utf-8") == 0));
+	}
+
+	// collect the (ngram, descriptor) pairs
+	std::vector<DetectorIndexEntry> vEntries;
+	for(i = 0; i < NUM_DESCRIPTORS; i++)
+	{
+		for(int iBucket = 0; iBucket < 256; iBucket++)
+		{
+			for(DetectorNGram * g = all_descriptors[i]->ngram_hash[iBucket]; g->szNGram; g++)
+			{
+				// the reference scorer looks up only ngrams of 2 to 4 chars in their own bucket:
+				// anything else can never be matched
+				size_t uLen = strlen((const char *)g->szNGram);
+				if((uLen < 2) || (uLen > 4) || (ngram_hash_bucket(g->szNGram) != iBucket))
+					continue;
+				DetectorIndexEntry entry;
+				entry.uKey = pack_ngram(g->szNGram);
+				entry.score.iDescriptor = i;
+				entry.score.dScore = g->dScore;
+				vEntries.push_back(entry);
+			}
+		}
+	}
+
+	// group them by ngram keeping the descriptor order: if a descriptor
+	// has the same ngram twice only the first one is found by the reference scorer
+	std::stable_sort(vEntries.begin(), vEntries.end(), index_entry_less_than);
+
+	std::vector<DetectorIndexSlot> vNGrams;
+	m_vScores.reserve(vEntries.size());
+	for(size_t uEntry = 0; uEntry < vEntries.size(); uEntry++)
+	{
+		const DetectorIndexEntry & entry = vEntries[uEntry];
+		if(vNGrams.empty() || (vNGrams.back().uKey != entry.uKey))
+		{
+			DetectorIndexSlot ngram;
+			ngram.uKey = entry.uKey;
+			ngram.uFirstScore = (unsigned int)m_vScores.size();
+			ngram.uScoreCount = 0;
+			vNGrams.push_back(ngram);
+		}
+		else if(m_vScores.back().iDescriptor == entry.score.iDescriptor)
+		{
+			continue;
+		}
+		m_vScores.push_back(entry.score);
+		vNGrams.back().uScoreCount++;
+	}
+
+	// keep the table at most half full
+	unsigned int uSize = 16;
+	while(uSize < (vNGrams.size() * 2))
+		uSize <<= 1;
+	m_uSlotMask = uSize - 1;
+
+	DetectorIndexSlot empty;
+	empty.uKey = 0;
+	empty.uFirstScore = 0;
+	empty.uScoreCount = 0;
+	m_vSlots.assign(uSize, empty);
+
+	for(size_t uNGram = 0; uNGram < vNGrams.size(); uNGram++)
+	{
+		unsigned int uSlot = index_slot_hash(vNGrams[uNGram].uKey) & m_uSlotMask;
+		while(m_vSlots[uSlot].uKey != 0)
+			uSlot = (uSlot + 1) & m_uSlotMask;
+		m_vSlots[uSlot] = vNGrams[uNGram];
+	}
+}
+
+static const DetectorIndex & detector_index()
+{
+	static DetectorIndex table;
+	return table;
+}
+
+static inline void add_ngram_scores(const DetectorIndex & table, unsigned int uKey, double * pScores)
+{
+	const DetectorIndexSlot * pSlot = table.find(uKey);
+	if(!pSlot)
+		return;
+	const DetectorIndexScore * pScore = &(table.m_vScores[pSlot->uFirstScore]);
+	const DetectorIndexScore * pEnd = pScore + pSlot->uScoreCount;
+	while(pScore < pEnd)
+	{
+		pScores[pScore->iDescriptor] += pScore->dScore;
+		pScore++;
+	}
+}
+
+static void compute_all_descriptor_scores(const unsigned char * data, double * pScores)
+{
+	const DetectorIndex & table = detector_index();
+	int i;
+
+	for(i = 0; i < NUM_DESCRIPTORS; i++)
+		pScores[i] = 0.0;
+
+	const unsigned char * p = data;
+	while(*p)
+	{
+		unsigned char z = (unsigned char)tolower((char)*p);
+		if(valid_char_jump_table[z])
+		{
+			const double * pRow = table.m_dCharRows[z];
+			for(i = 0; i < NUM_DESCRIPTORS; i++)
+				pScores[i] += pRow[i];
+		}
+		p++;
+	}
+
+	// the words are framed exactly like in compute_descriptor_score()
+	p = data;
+	unsigned char buffer[1024];
+	buffer[0] = ' ';
+	while(*p)
+	{
+		while(*p && !valid_char_jump_table[*p])
+			p++;
+		int idx = 1;
+		while(valid_char_jump_table[*p] && (idx < 1022))
+		{
+			buffer[idx] = (unsigned char)tolower((char)*p);
+			p++;
+			idx++;
+		}
+		buffer[idx] = ' ';
+		idx++;
+		// each ngram ends right before position k: the closing space is never part of one
+		for(int k = 2; k < idx; k++)
+		{
+			unsigned int uKey2 = ((unsigned int)buffer[k - 2]) | (((unsigned int)buffer[k - 1]) << 8);
+			if(k >= 4)
+				add_ngram_scores(table, ((unsigned int)buffer[k - 4]) | (((unsigned int)buffer[k - 3]) << 8) | (uKey2 << 16), pScores);
+			if(k >= 3)
+				add_ngram_scores(table, ((unsigned int)buffer[k - 3]) | (uKey2 << 8), pScores);
+			add_ngram_scores(table, uKey2, pScores);
+		}
+	}
+}
+
 #define NEED_ONE_CHAR             \
 	p++;                          \
 	if(*p < 0x80)                 \
@@ -18728,14 +18967,20 @@ void detect_language_and_encoding(const char * data, LanguageAndEncodingResult *
 	}
 	retBuffer->dAccuracy = 0.0;
 
+	const DetectorIndex & table = detector_index();
+	bool bReference = (iFlags & DLE_REFERENCE_SCORING);
+	double dScores[NUM_DESCRIPTORS];
+	if(!bReference)
+		compute_all_descriptor_scores((const unsigned char *)data, dScores);
+
 	int utf8 = utf8score((const unsigned char *)data);
 	i = 0;
 	while(i < NUM_DESCRIPTORS)
 	{
-		bool bIsUtf8 = ((strcmp(all_descriptors[i]->szEncoding, "utf8") == 0) || (strcmp(all_descriptors[i]->szEncoding, "utf-8") == 0));
+		bool bIsUtf8 = table.m_bIsUtf8[i];
 		if((!bIsUtf8) || (!(iFlags & DLE_STRICT_UTF8_CHECKING)))
 		{
-			double dThis = compute_descriptor_score((const unsigned char *)data, all_descriptors[i]);
+			double dThis = bReference ? compute_descriptor_score((const unsigned char *)data, all_descriptors[i]) : dScores[i];
 			if(bIsUtf8)
 			{
 				dThis *= 1.0 + (((double)utf8) * 0.01);
@@ -26,6 +26,7 @@
 
 #define DLE_NUM_BEST_MATCHES 4
 #define DLE_STRICT_UTF8_CHECKING 1
+#define DLE_REFERENCE_SCORING 2 // score one descriptor at a time (slow, for testing)
 
 struct LanguageAndEncodingMatch
 {
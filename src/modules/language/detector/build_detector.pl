@@ -100,6 +100,9 @@ print OUTPUT "#include <cstdio>\n";
 print OUTPUT "#include <cstring>\n";
 print OUTPUT "#include <cctype>\n";
 print OUTPUT "\n";
+print OUTPUT "#include <algorithm>\n";
+print OUTPUT "#include <vector>\n";
+print OUTPUT "\n";
 print OUTPUT "#include \"detector.h\"\n";
 print OUTPUT "\n";
 print OUTPUT "namespace {\n";
@@ -602,7 +605,7 @@ print OUTPUT "#undef k\n";
 print OUTPUT "#undef f\n";
 
 print OUTPUT "\n";
-print OUTPUT "static double score_for_ngram(DetectorDescriptor * d,const unsigned char * ngram)\n";
+print OUTPUT "static int ngram_hash_bucket(const unsigned char * ngram)\n";
 print OUTPUT "{\n";
 print OUTPUT "		const unsigned char * p = ngram;\n";
 print OUTPUT "		int xhash = *p * 31;\n";
@@ -618,7 +621,16 @@ print OUTPUT "			{\n";
 print OUTPUT "				xhash += *p * 3;\n";
 print OUTPUT "			}\n";
 print OUTPUT "		}\n";
-print OUTPUT "		DetectorNGram * g = d->ngram_hash[xhash % 256];\n";
+print OUTPUT "		return xhash % 256;\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "//\n";
+print OUTPUT "// REFERENCE SCORING: one descriptor at a time\n";
+print OUTPUT "//\n";
+print OUTPUT "\n";
+print OUTPUT "static double score_for_ngram(DetectorDescriptor * d,const unsigned char * ngram)\n";
+print OUTPUT "{\n";
+print OUTPUT "		DetectorNGram * g = d->ngram_hash[ngram_hash_bucket(ngram)];\n";
 print OUTPUT "		while(g->szNGram)\n";
 print OUTPUT "		{\n";
 print OUTPUT "			if(strcmp((const char *)ngram,(const char *)g->szNGram) == 0){ /*printf(\"GOT NGRAM %s SCORE %f\\n\",ngram,g->dScore);*/ return g->dScore; }\n";
@@ -730,6 +742,233 @@ for($i=0;$i<$descriptorCnt;$i++)
 print OUTPUT "};\n";
 print OUTPUT "\n";
 
+print OUTPUT "//\n";
+print OUTPUT "// SINGLE PASS SCORING\n";
+print OUTPUT "//\n";
+print OUTPUT "// At first use the tables of all the descriptors are merged in one index.\n";
+print OUTPUT "// The single char tables become a matrix with one row per character and\n";
+print OUTPUT "// the ngrams are stored once in an open addressing hash, each one with the\n";
+print OUTPUT "// scores of all the descriptors that know it.\n";
+print OUTPUT "// The text is then tokenized once and every ngram is looked up once for all\n";
+print OUTPUT "// the descriptors. The scores are summed in the same order used by\n";
+print OUTPUT "// compute_descriptor_score() so the results are exactly the same.\n";
+print OUTPUT "//\n";
+print OUTPUT "\n";
+print OUTPUT "struct DetectorIndexScore\n";
+print OUTPUT "{\n";
+print OUTPUT "	int iDescriptor;\n";
+print OUTPUT "	double dScore;\n";
+print OUTPUT "};\n";
+print OUTPUT "\n";
+print OUTPUT "struct DetectorIndexSlot\n";
+print OUTPUT "{\n";
+print OUTPUT "	unsigned int uKey; // the ngram packed with its first char in the lowest byte, 0 if the slot is free\n";
+print OUTPUT "	unsigned int uFirstScore;\n";
+print OUTPUT "	unsigned int uScoreCount;\n";
+print OUTPUT "};\n";
+print OUTPUT "\n";
+print OUTPUT "static unsigned int pack_ngram(const unsigned char * ngram)\n";
+print OUTPUT "{\n";
+print OUTPUT "	unsigned int uKey = 0;\n";
+print OUTPUT "	for(int i = 0; (i < 4) && ngram[i]; i++)\n";
+print OUTPUT "		uKey |= ((unsigned int)ngram[i]) << (8 * i);\n";
+print OUTPUT "	return uKey;\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "static inline unsigned int index_slot_hash(unsigned int uKey)\n";
+print OUTPUT "{\n";
+print OUTPUT "	unsigned int uHash = uKey * 2654435761U;\n";
+print OUTPUT "	return uHash ^ (uHash >> 16);\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "struct DetectorIndexEntry\n";
+print OUTPUT "{\n";
+print OUTPUT "	unsigned int uKey;\n";
+print OUTPUT "	DetectorIndexScore score;\n";
+print OUTPUT "};\n";
+print OUTPUT "\n";
+print OUTPUT "static bool index_entry_less_than(const DetectorIndexEntry & a1, const DetectorIndexEntry & a2)\n";
+print OUTPUT "{\n";
+print OUTPUT "	return a1.uKey < a2.uKey;\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "class DetectorIndex\n";
+print OUTPUT "{\n";
+print OUTPUT "public:\n";
+print OUTPUT "	DetectorIndex();\n";
+print OUTPUT "\n";
+print OUTPUT "public:\n";
+print OUTPUT "	double m_dCharRows[256][NUM_DESCRIPTORS];\n";
+print OUTPUT "	bool m_bIsUtf8[NUM_DESCRIPTORS];\n";
+print OUTPUT "	unsigned int m_uSlotMask;\n";
+print OUTPUT "	std::vector<DetectorIndexSlot> m_vSlots;\n";
+print OUTPUT "	std::vector<DetectorIndexScore> m_vScores;\n";
+print OUTPUT "\n";
+print OUTPUT "public:\n";
+print OUTPUT "	inline const DetectorIndexSlot * find(unsigned int uKey) const\n";
+print OUTPUT "	{\n";
+print OUTPUT "		unsigned int uSlot = index_slot_hash(uKey) & m_uSlotMask;\n";
+print OUTPUT "		for(;;)\n";
+print OUTPUT "		{\n";
+print OUTPUT "			const DetectorIndexSlot * pSlot = &(m_vSlots[uSlot]);\n";
+print OUTPUT "			if(pSlot->uKey == uKey)\n";
+print OUTPUT "				return pSlot;\n";
+print OUTPUT "			if(pSlot->uKey == 0)\n";
+print OUTPUT "				return nullptr;\n";
+print OUTPUT "			uSlot = (uSlot + 1) & m_uSlotMask;\n";
+print OUTPUT "		}\n";
+print OUTPUT "	}\n";
+print OUTPUT "};\n";
+print OUTPUT "\n";
+print OUTPUT "DetectorIndex::DetectorIndex()\n";
+print OUTPUT "{\n";
+print OUTPUT "	int i;\n";
+print OUTPUT "	for(i = 0; i < NUM_DESCRIPTORS; i++)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		for(int iChar = 0; iChar < 256; iChar++)\n";
+print OUTPUT "			m_dCharRows[iChar][i] = all_descriptors[i]->single_char_data[iChar];\n";
+print OUTPUT "		m_bIsUtf8[i] = ((strcmp(all_descriptors[i]->szEncoding, \"utf8\") == 0) || (strcmp(all_descriptors[i]->szEncoding, \"utf-8\") == 0));\n";
+print OUTPUT "	}\n";
+print OUTPUT "\n";
+print OUTPUT "	// collect the (ngram, descriptor) pairs\n";
+print OUTPUT "	std::vector<DetectorIndexEntry> vEntries;\n";
+print OUTPUT "	for(i = 0; i < NUM_DESCRIPTORS; i++)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		for(int iBucket = 0; iBucket < 256; iBucket++)\n";
+print OUTPUT "		{\n";
+print OUTPUT "			for(DetectorNGram * g = all_descriptors[i]->ngram_hash[iBucket]; g->szNGram; g++)\n";
+print OUTPUT "			{\n";
+print OUTPUT "				// the reference scorer looks up only ngrams of 2 to 4 chars in their own bucket:\n";
+print OUTPUT "				// anything else can never be matched\n";
+print OUTPUT "				size_t uLen = strlen((const char *)g->szNGram);\n";
+print OUTPUT "				if((uLen < 2) || (uLen > 4) || (ngram_hash_bucket(g->szNGram) != iBucket))\n";
+print OUTPUT "					continue;\n";
+print OUTPUT "				DetectorIndexEntry entry;\n";
+print OUTPUT "				entry.uKey = pack_ngram(g->szNGram);\n";
+print OUTPUT "				entry.score.iDescriptor = i;\n";
+print OUTPUT "				entry.score.dScore = g->dScore;\n";
+print OUTPUT "				vEntries.push_back(entry);\n";
+print OUTPUT "			}\n";
+print OUTPUT "		}\n";
+print OUTPUT "	}\n";
+print OUTPUT "\n";
+print OUTPUT "	// group them by ngram keeping the descriptor order: if a descriptor\n";
+print OUTPUT "	// has the same ngram twice only the first one is found by the reference scorer\n";
+print OUTPUT "	std::stable_sort(vEntries.begin(), vEntries.end(), index_entry_less_than);\n";
+print OUTPUT "\n";
+print OUTPUT "	std::vector<DetectorIndexSlot> vNGrams;\n";
+print OUTPUT "	m_vScores.reserve(vEntries.size());\n";
+print OUTPUT "	for(size_t uEntry = 0; uEntry < vEntries.size(); uEntry++)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		const DetectorIndexEntry & entry = vEntries[uEntry];\n";
+print OUTPUT "		if(vNGrams.empty() || (vNGrams.back().uKey != entry.uKey))\n";
+print OUTPUT "		{\n";
+print OUTPUT "			DetectorIndexSlot ngram;\n";
+print OUTPUT "			ngram.uKey = entry.uKey;\n";
+print OUTPUT "			ngram.uFirstScore = (unsigned int)m_vScores.size();\n";
+print OUTPUT "			ngram.uScoreCount = 0;\n";
+print OUTPUT "			vNGrams.push_back(ngram);\n";
+print OUTPUT "		}\n";
+print OUTPUT "		else if(m_vScores.back().iDescriptor == entry.score.iDescriptor)\n";
+print OUTPUT "		{\n";
+print OUTPUT "			continue;\n";
+print OUTPUT "		}\n";
+print OUTPUT "		m_vScores.push_back(entry.score);\n";
+print OUTPUT "		vNGrams.back().uScoreCount++;\n";
+print OUTPUT "	}\n";
+print OUTPUT "\n";
+print OUTPUT "	// keep the table at most half full\n";
+print OUTPUT "	unsigned int uSize = 16;\n";
+print OUTPUT "	while(uSize < (vNGrams.size() * 2))\n";
+print OUTPUT "		uSize <<= 1;\n";
+print OUTPUT "	m_uSlotMask = uSize - 1;\n";
+print OUTPUT "\n";
+print OUTPUT "	DetectorIndexSlot empty;\n";
+print OUTPUT "	empty.uKey = 0;\n";
+print OUTPUT "	empty.uFirstScore = 0;\n";
+print OUTPUT "	empty.uScoreCount = 0;\n";
+print OUTPUT "	m_vSlots.assign(uSize, empty);\n";
+print OUTPUT "\n";
+print OUTPUT "	for(size_t uNGram = 0; uNGram < vNGrams.size(); uNGram++)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		unsigned int uSlot = index_slot_hash(vNGrams[uNGram].uKey) & m_uSlotMask;\n";
+print OUTPUT "		while(m_vSlots[uSlot].uKey != 0)\n";
+print OUTPUT "			uSlot = (uSlot + 1) & m_uSlotMask;\n";
+print OUTPUT "		m_vSlots[uSlot] = vNGrams[uNGram];\n";
+print OUTPUT "	}\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "static const DetectorIndex & detector_index()\n";
+print OUTPUT "{\n";
+print OUTPUT "	static DetectorIndex table;\n";
+print OUTPUT "	return table;\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "static inline void add_ngram_scores(const DetectorIndex & table, unsigned int uKey, double * pScores)\n";
+print OUTPUT "{\n";
+print OUTPUT "	const DetectorIndexSlot * pSlot = table.find(uKey);\n";
+print OUTPUT "	if(!pSlot)\n";
+print OUTPUT "		return;\n";
+print OUTPUT "	const DetectorIndexScore * pScore = &(table.m_vScores[pSlot->uFirstScore]);\n";
+print OUTPUT "	const DetectorIndexScore * pEnd = pScore + pSlot->uScoreCount;\n";
+print OUTPUT "	while(pScore < pEnd)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		pScores[pScore->iDescriptor] += pScore->dScore;\n";
+print OUTPUT "		pScore++;\n";
+print OUTPUT "	}\n";
+print OUTPUT "}\n";
+print OUTPUT "\n";
+print OUTPUT "static void compute_all_descriptor_scores(const unsigned char * data, double * pScores)\n";
+print OUTPUT "{\n";
+print OUTPUT "	const DetectorIndex & table = detector_index();\n";
+print OUTPUT "	int i;\n";
+print OUTPUT "\n";
+print OUTPUT "	for(i = 0; i < NUM_DESCRIPTORS; i++)\n";
+print OUTPUT "		pScores[i] = 0.0;\n";
+print OUTPUT "\n";
+print OUTPUT "	const unsigned char * p = data;\n";
+print OUTPUT "	while(*p)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		unsigned char z = (unsigned char)tolower((char)*p);\n";
+print OUTPUT "		if(valid_char_jump_table[z])\n";
+print OUTPUT "		{\n";
+print OUTPUT "			const double * pRow = table.m_dCharRows[z];\n";
+print OUTPUT "			for(i = 0; i < NUM_DESCRIPTORS; i++)\n";
+print OUTPUT "				pScores[i] += pRow[i];\n";
+print OUTPUT "		}\n";
+print OUTPUT "		p++;\n";
+print OUTPUT "	}\n";
+print OUTPUT "\n";
+print OUTPUT "	// the words are framed exactly like in compute_descriptor_score()\n";
+print OUTPUT "	p = data;\n";
+print OUTPUT "	unsigned char buffer[1024];\n";
+print OUTPUT "	buffer[0] = ' ';\n";
+print OUTPUT "	while(*p)\n";
+print OUTPUT "	{\n";
+print OUTPUT "		while(*p && !valid_char_jump_table[*p])\n";
+print OUTPUT "			p++;\n";
+print OUTPUT "		int idx = 1;\n";
+print OUTPUT "		while(valid_char_jump_table[*p] && (idx < 1022))\n";
+print OUTPUT "		{\n";
+print OUTPUT "			buffer[idx] = (unsigned char)tolower((char)*p);\n";
+print OUTPUT "			p++;\n";
+print OUTPUT "			idx++;\n";
+print OUTPUT "		}\n";
+print OUTPUT "		buffer[idx] = ' ';\n";
+print OUTPUT "		idx++;\n";
+print OUTPUT "		// each ngram ends right before position k: the closing space is never part of one\n";
+print OUTPUT "		for(int k = 2; k < idx; k++)\n";
+print OUTPUT "		{\n";
+print OUTPUT "			unsigned int uKey2 = ((unsigned int)buffer[k - 2]) | (((unsigned int)buffer[k - 1]) << 8);\n";
+print OUTPUT "			if(k >= 4)\n";
+print OUTPUT "				add_ngram_scores(table, ((unsigned int)buffer[k - 4]) | (((unsigned int)buffer[k - 3]) << 8) | (uKey2 << 16), pScores);\n";
+print OUTPUT "			if(k >= 3)\n";
+print OUTPUT "				add_ngram_scores(table, ((unsigned int)buffer[k - 3]) | (uKey2 << 8), pScores);\n";
+print OUTPUT "			add_ngram_scores(table, uKey2, pScores);\n";
+print OUTPUT "		}\n";
+print OUTPUT "	}\n";
+print OUTPUT "}\n";
+
 
 print OUTPUT "\n";
 print OUTPUT "#define NEED_ONE_CHAR p++; if(*p < 0x80){ score--; return score; /* error */ }\n";
@@ -802,6 +1041,12 @@ print OUTPUT "		match[i] = 0;\n";
 print OUTPUT "	}\n";
 print OUTPUT "	retBuffer->dAccuracy = 0.0;\n";
 print OUTPUT "	\n";
+print OUTPUT "	const DetectorIndex & table = detector_index();\n";
+print OUTPUT "	bool bReference = (iFlags & DLE_REFERENCE_SCORING);\n";
+print OUTPUT "	double dScores[NUM_DESCRIPTORS];\n";
+print OUTPUT "	if(!bReference)\n";
+print OUTPUT "		compute_all_descriptor_scores((const unsigned char *)data,dScores);\n";
+print OUTPUT "\n";
 print OUTPUT "	int utf8 = utf8score((const unsigned char *)data);\n";
 if($debug > 0)
 {
@@ -810,10 +1055,10 @@ if($debug > 0)
 print OUTPUT "	i=0;\n";
 print OUTPUT "	while(i<NUM_DESCRIPTORS)\n";
 print OUTPUT "	{\n";
-print OUTPUT "		bool bIsUtf8 = ((strcmp(all_descriptors[i]->szEncoding,\"utf8\") == 0) || (strcmp(all_descriptors[i]->szEncoding,\"utf-8\") == 0));\n";
+print OUTPUT "		bool bIsUtf8 = table.m_bIsUtf8[i];\n";
 print OUTPUT "		if((!bIsUtf8) || (!(iFlags & DLE_STRICT_UTF8_CHECKING)))\n";
 print OUTPUT "		{\n";
-print OUTPUT "			double dThis = compute_descriptor_score((const unsigned char *)data,all_descriptors[i]);\n";
+print OUTPUT "			double dThis = bReference ? compute_descriptor_score((const unsigned char *)data,all_descriptors[i]) : dScores[i];\n";
 if($debug > 0)
 {
 	print OUTPUT "			double dSave = dThis;\n";
@@ -25,9 +25,13 @@
 #include "KviModule.h"
 #include "KviApplication.h"
 #include "KviLocale.h"
+#include "kvi_out.h"
 
+#include <QElapsedTimer>
 #include <QFileInfo>
 
+#include <cstring>
+
 #include "detector.h"
 
 /*
@@ -106,9 +110,101 @@ static bool language_kvs_cmd_detect(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: language.benchmark
+	@type:
+		command
+	@title:
+		language.benchmark
+	@short:
+		Measures the speed of the language detector
+	@syntax:
+		language.benchmark [-n=<lines>]
+	@switches:
+		!sw: -n=<lines> | --lines=<lines>
+		The number of lines to process (default: 20000)
+	@description:
+		Runs the language detector on a small multilingual corpus (the lines
+		are taken from it in turn) and prints how many lines per second were
+		processed by the single pass scorer, that looks up every n-gram once
+		for all the languages, and by the reference one, that scans the text
+		once per language.[br]
+		A warning is printed if the two scorers don't give the same results.
+*/
+
+static const char * const language_benchmark_corpus[] = {
+	"I'm a lord and I speak perfect English, as everybody in this channel knows.",
+	"Questa è una frase scritta in italiano per vedere se il rilevatore funziona.",
+	"Der schnelle braune Fuchs springt über den faulen Hund und ärgert sich dabei.",
+	"Le vif renard brun saute par-dessus le chien paresseux à côté de l'église.",
+	"El veloz murciélago hindú comía feliz cardillo y kiwi mientras la cigüeña tocaba.",
+	"Zażółć gęślą jaźń, to jest bardzo dobre zdanie po polsku.",
+	"Het is een mooie dag om naar het strand te gaan met de hele familie.",
+	"Съешь же ещё этих мягких французских булок, да выпей чаю.",
+	"Θέλει αρετή και τόλμη η ελευθερία, είπε ο ποιητής.",
+	"Vi ses på kanalen i morgen, jeg har ikke tid i dag."
+};
+
+static int language_benchmark_rate(int iLines, qint64 iNSecs)
+{
+	if(iNSecs <= 0)
+		iNSecs = 1;
+	return (int)(((double)iLines * 1000000000.0) / (double)iNSecs);
+}
+
+static bool language_kvs_cmd_benchmark(KviKvsModuleCommandCall * c)
+{
+	kvs_int_t iLines = 20000;
+
+	if(KviKvsVariant * pLines = c->switches()->find('n', "lines"))
+	{
+		if(!pLines->asInteger(iLines) || (iLines < 1))
+		{
+			c->warning(__tr2qs("Invalid number of lines"));
+			return true;
+		}
+	}
+
+	const int iCorpusSize = sizeof(language_benchmark_corpus) / sizeof(language_benchmark_corpus[0]);
+
+	LanguageAndEncodingResult r;
+	LanguageAndEncodingResult rReference;
+
+	// this also builds the scoring index so it is not measured below
+	for(int i = 0; i < iCorpusSize; i++)
+	{
+		detect_language_and_encoding(language_benchmark_corpus[i], &r, 0);
+		detect_language_and_encoding(language_benchmark_corpus[i], &rReference, DLE_REFERENCE_SCORING);
+		bool bSame = (r.dAccuracy == rReference.dAccuracy);
+		for(int j = 0; bSame && (j < DLE_NUM_BEST_MATCHES); j++)
+			bSame = (r.match[j].dScore == rReference.match[j].dScore) && (strcmp(r.match[j].szLanguage, rReference.match[j].szLanguage) == 0) && (strcmp(r.match[j].szEncoding, rReference.match[j].szEncoding) == 0);
+		if(!bSame)
+		{
+			QString szLine = QString::fromUtf8(language_benchmark_corpus[i]);
+			c->warning(__tr2qs("The two scorers don't agree on the line \"%Q\""), &szLine);
+		}
+	}
+
+	for(int iPass = 0; iPass < 2; iPass++)
+	{
+		int iFlags = (iPass == 0) ? 0 : DLE_REFERENCE_SCORING;
+
+		QElapsedTimer timer;
+		timer.start();
+		for(kvs_int_t i = 0; i < iLines; i++)
+			detect_language_and_encoding(language_benchmark_corpus[i % iCorpusSize], &r, iFlags);
+		qint64 iElapsed = timer.nsecsElapsed();
+
+		QString szScorer = (iPass == 0) ? __tr2qs("Single pass") : __tr2qs("Reference");
+		c->window()->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs("%Q: %d lines/sec"), &szScorer, language_benchmark_rate((int)iLines, iElapsed));
+	}
+	return true;
+}
+
 static bool language_module_init(KviModule * m)
 {
 	KVSM_REGISTER_FUNCTION(m, "detect", language_kvs_cmd_detect);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "benchmark", language_kvs_cmd_benchmark);
 	return true;
 }
 
@@ -40,6 +40,7 @@
 #include "KviTalHBox.h"
 #include "KviHtmlGenerator.h"
 #include "KviThemedLineEdit.h"
+#include "KviThemedTreeView.h"
 #include "KviIrcMessage.h"
 
 #include <QTimer>
@@ -50,98 +51,499 @@
 #include <QDateTime>
 #include <QByteArray>
 #include <QMessageBox>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <algorithm>
 
 extern KviPointerList<ListWindow> * g_pListWindowList;
 
-ChannelTreeWidgetItemData::ChannelTreeWidgetItemData(const QString & szChan, const QString & szUsers, const QString & szTopic)
+//
+// Matches a /LIST filter against the case folded keys.
+// The plain substrings and the '*' wildcards (by far the common case) are
+// handled with a sequence of indexOf() calls, the rest goes through QRegExp.
+//
+
+class ChannelListFilterMatcher
 {
-	m_szChan = szChan;
-	m_szUsers = szUsers;
-	m_szTopic = szTopic;
+public:
+	ChannelListFilterMatcher(const QString & szFilter)
+	{
+		QString szFolded = szFilter.toLower();
+		m_bUseRegExp = szFolded.contains(QChar('?')) || szFolded.contains(QChar('['));
+		if(m_bUseRegExp)
+			m_RegExp = QRegExp(szFolded, Qt::CaseSensitive, QRegExp::Wildcard);
+		else
+			m_lFragments = szFolded.split(QChar('*'), QString::SkipEmptyParts);
+	}
+
+protected:
+	bool m_bUseRegExp;
+	QRegExp m_RegExp;
+	QStringList m_lFragments;
+
+public:
+	bool matches(const QString & szKey) const
+	{
+		if(m_bUseRegExp)
+			return szKey.contains(m_RegExp);
+
+		int iIdx = 0;
+		for(const auto & szFragment : m_lFragments)
+		{
+			iIdx = szKey.indexOf(szFragment, iIdx);
+			if(iIdx < 0)
+				return false;
+			iIdx += szFragment.length();
+		}
+		return true;
+	}
+};
+
+//
+// The job runs on the model's private pool: the model waits for it before dying.
+// It owns copies of the key vectors so the GUI thread can keep appending rows.
+//
+
+class ChannelListFilterJob : public QRunnable
+{
+public:
+	ChannelListFilterJob(ChannelListModel * pModel, const QVector<int> & vCandidates, bool bNewRows)
+	    : QRunnable(),
+	      m_pModel(pModel),
+	      m_uGeneration(pModel->m_uFilterGeneration),
+	      m_szFilter(pModel->m_szFilter),
+	      m_vCandidates(vCandidates),
+	      m_bNewRows(bNewRows),
+	      m_vChannelKeys(pModel->m_vChannelKeys),
+	      m_vTopicKeys(pModel->m_vTopicKeys)
+	{
+		setAutoDelete(false);
+	}
+
+public:
+	ChannelListModel * m_pModel;
+	unsigned int m_uGeneration;
+	QString m_szFilter;
+	QVector<int> m_vCandidates;
+	bool m_bNewRows; // true if the candidates have just been appended, false if they replace all the visible rows
+	QVector<QString> m_vChannelKeys;
+	QVector<QString> m_vTopicKeys;
+	QVector<int> m_vMatches;
+
+public:
+	void run() override
+	{
+		ChannelListFilterMatcher matcher(m_szFilter);
+
+		for(int iId : m_vCandidates)
+		{
+			if(matcher.matches(m_vChannelKeys.at(iId)) || matcher.matches(m_vTopicKeys.at(iId)))
+				m_vMatches.append(iId);
+		}
+
+		// release the copies now so the next append does not have to detach the vectors
+		m_vChannelKeys.clear();
+		m_vTopicKeys.clear();
+
+		QMutexLocker locker(&(m_pModel->m_FinishedJobsMutex));
+		m_pModel->m_lFinishedJobs.append(this);
+		QMetaObject::invokeMethod(m_pModel, "processFinishedJobs", Qt::QueuedConnection);
+	}
+};
+
+// packs three characters of a case folded key
+static inline quint64 channel_list_trigram(const QString & szKey, int iIdx)
+{
+	return (((quint64)szKey.at(iIdx).unicode()) << 32) | (((quint64)szKey.at(iIdx + 1).unicode()) << 16) | ((quint64)szKey.at(iIdx + 2).unicode());
 }
 
-ChannelTreeWidgetItemData::~ChannelTreeWidgetItemData()
-    = default;
+ChannelListModel::ChannelListModel(QObject * pParent)
+    : QAbstractTableModel(pParent)
+{
+	m_iSortColumn = 0;
+	m_eSortOrder = Qt::AscendingOrder;
+	m_uFilterGeneration = 0;
+	m_uPendingJobs = 0;
+	m_FilterPool.setMaxThreadCount(1); // jobs must complete in the order they were started
+}
 
-ChannelTreeWidgetItem::ChannelTreeWidgetItem(ChannelTreeWidgetItemData * pData)
-    : QTreeWidgetItem(), m_pData(pData)
+ChannelListModel::~ChannelListModel()
 {
-	setToolTip(0, KviQString::toHtmlEscaped(m_pData->m_szChan));
-	setToolTip(1, KviQString::toHtmlEscaped(m_pData->m_szUsers));
-	setToolTip(2, KviHtmlGenerator::convertToHtml(KviQString::toHtmlEscaped(m_pData->m_szTopic)));
+	m_FilterPool.waitForDone();
+	qDeleteAll(m_lFinishedJobs);
 }
 
-ChannelTreeWidgetItem::~ChannelTreeWidgetItem()
-    = default;
+int ChannelListModel::rowCount(const QModelIndex & parent) const
+{
+	if(parent.isValid())
+		return 0;
+	return m_vVisible.count();
+}
 
-bool ChannelTreeWidgetItem::operator<(const QTreeWidgetItem & other) const
+int ChannelListModel::columnCount(const QModelIndex & parent) const
 {
-	switch(treeWidget()->sortColumn())
+	if(parent.isValid())
+		return 0;
+	return 3;
+}
+
+QVariant ChannelListModel::data(const QModelIndex & index, int iRole) const
+{
+	if(!index.isValid() || (index.row() >= m_vVisible.count()))
+		return QVariant();
+
+	int iId = m_vVisible.at(index.row());
+
+	switch(iRole)
 	{
-		case 0:
-			//channel
-			return m_pData->m_szChan.toUpper() < ((ChannelTreeWidgetItem *)&other)->itemData()->m_szChan.toUpper();
+		case Qt::DisplayRole:
+			switch(index.column())
+			{
+				case 0:
+					return m_vChannels.at(iId);
+				case 1:
+					return m_vUsers.at(iId);
+				default:
+					return m_vTopicTexts.at(iId);
+			}
+			break;
+		case Qt::ToolTipRole:
+			switch(index.column())
+			{
+				case 0:
+					return KviQString::toHtmlEscaped(m_vChannels.at(iId));
+				case 1:
+					return QString::number(m_vUsers.at(iId));
+				default:
+					return KviHtmlGenerator::convertToHtml(KviQString::toHtmlEscaped(m_vTopics.at(iId)));
+			}
 			break;
+		case RawTopicRole:
+			return m_vTopics.at(iId);
+	}
+	return QVariant();
+}
+
+QVariant ChannelListModel::headerData(int iSection, Qt::Orientation eOrientation, int iRole) const
+{
+	if((eOrientation != Qt::Horizontal) || (iRole != Qt::DisplayRole))
+		return QVariant();
+
+	switch(iSection)
+	{
+		case 0:
+			return __tr2qs("Channel");
+		case 1:
+			return __tr2qs("Users");
+		case 2:
+			return __tr2qs("Topic");
+	}
+	return QVariant();
+}
+
+bool ChannelListModel::lessThan(int iId1, int iId2) const
+{
+	if(m_eSortOrder == Qt::DescendingOrder)
+		std::swap(iId1, iId2);
+
+	switch(m_iSortColumn)
+	{
 		case 1:
 			//users
-			return m_pData->m_szUsers.toInt() < ((ChannelTreeWidgetItem *)&other)->itemData()->m_szUsers.toInt();
+			if(m_vUsers.at(iId1) != m_vUsers.at(iId2))
+				return m_vUsers.at(iId1) < m_vUsers.at(iId2);
 			break;
 		case 2:
-		default:
+		{
 			//topic
-			return KviControlCodes::stripControlBytes(m_pData->m_szTopic.toUpper()) < KviControlCodes::stripControlBytes(((ChannelTreeWidgetItem *)&other)->itemData()->m_szTopic.toUpper());
-			break;
+			int iCmp = QString::compare(m_vTopicKeys.at(iId1), m_vTopicKeys.at(iId2));
+			if(iCmp != 0)
+				return iCmp < 0;
+		}
+		break;
+		default:
+		{
+			//channel
+			int iCmp = QString::compare(m_vChannelKeys.at(iId1), m_vChannelKeys.at(iId2));
+			if(iCmp != 0)
+				return iCmp < 0;
+		}
+		break;
 	}
+	// keep the order stable
+	return iId1 < iId2;
 }
 
-ChannelTreeWidgetItemDelegate::ChannelTreeWidgetItemDelegate(QTreeWidget * pWidget)
-    : QItemDelegate(pWidget)
+void ChannelListModel::sortVisible(int iFrom)
 {
+	auto cmp = [this](int iId1, int iId2) { return lessThan(iId1, iId2); };
+	std::sort(m_vVisible.begin() + iFrom, m_vVisible.end(), cmp);
+	if(iFrom > 0)
+		std::inplace_merge(m_vVisible.begin(), m_vVisible.begin() + iFrom, m_vVisible.end(), cmp);
 }
 
-ChannelTreeWidgetItemDelegate::~ChannelTreeWidgetItemDelegate()
-    = default;
+void ChannelListModel::changeLayout(int iFrom)
+{
+	if(iFrom >= m_vVisible.count())
+		return;
 
-#define BORDER 2
+	emit layoutAboutToBeChanged();
+
+	QModelIndexList lOld = persistentIndexList();
+	QVector<int> vOldIds;
+	vOldIds.reserve(lOld.count());
+	for(const auto & idx : lOld)
+		vOldIds.append(m_vVisible.at(idx.row()));
 
-QSize ChannelTreeWidgetItemDelegate::sizeHint(const QStyleOptionViewItem & sovItem, const QModelIndex & index) const
+	sortVisible(iFrom);
+
+	if(!lOld.isEmpty())
+	{
+		QVector<int> vRows(m_vChannels.count(), -1);
+		for(int i = 0; i < m_vVisible.count(); i++)
+			vRows[m_vVisible.at(i)] = i;
+
+		QModelIndexList lNew;
+		lNew.reserve(lOld.count());
+		for(int i = 0; i < lOld.count(); i++)
+			lNew.append(index(vRows.at(vOldIds.at(i)), lOld.at(i).column()));
+		changePersistentIndexList(lOld, lNew);
+	}
+
+	emit layoutChanged();
+}
+
+void ChannelListModel::sort(int iColumn, Qt::SortOrder eOrder)
 {
-	ChannelTreeWidget * treeWidget = (ChannelTreeWidget *)parent();
+	m_iSortColumn = iColumn;
+	m_eSortOrder = eOrder;
+	changeLayout(0);
+}
 
-	int iHeight = treeWidget->fontMetrics().lineSpacing() + BORDER + BORDER;
+void ChannelListModel::appendEntries(const QVector<ChannelListEntry> & vEntries)
+{
+	if(vEntries.isEmpty())
+		return;
 
-	ChannelTreeWidgetItem * item = dynamic_cast<ChannelTreeWidgetItem *>(treeWidget->itemFromIndex(index));
+	int iFirst = m_vChannels.count();
+	int iCount = iFirst + vEntries.count();
 
-	if(!item)
-		return { 100, iHeight };
+	m_vChannels.reserve(iCount);
+	m_vChannelKeys.reserve(iCount);
+	m_vUsers.reserve(iCount);
+	m_vTopics.reserve(iCount);
+	m_vTopicTexts.reserve(iCount);
+	m_vTopicKeys.reserve(iCount);
 
-	QFontMetrics fm(sovItem.font);
-	switch(index.column())
+	for(const auto & e : vEntries)
 	{
-		case 0:
-			//channel
-			return QSize(fm.width(item->itemData()->m_szChan), iHeight);
-			break;
-		case 1:
-			//users
-			return QSize(fm.width(item->itemData()->m_szUsers.toInt()), iHeight);
-			break;
-		case 2:
-		default:
-			//topic
-			if(item->itemData()->m_szStrippedTopic.isEmpty())
-				item->itemData()->m_szStrippedTopic = KviControlCodes::stripControlBytes(item->itemData()->m_szTopic);
-			return QSize(fm.width(item->itemData()->m_szStrippedTopic), iHeight);
-			break;
+		m_vChannels.append(e.szChan);
+		m_vChannelKeys.append(e.szChan.toLower());
+		m_vUsers.append(e.iUsers);
+
+		QHash<QString, QPair<QString, QString>>::const_iterator it = m_hTopicPool.constFind(e.szTopic);
+		if(it == m_hTopicPool.constEnd())
+		{
+			QString szText = KviControlCodes::stripControlBytes(e.szTopic);
+			it = m_hTopicPool.insert(e.szTopic, qMakePair(szText, szText.toLower()));
+		}
+		m_vTopics.append(it.key());
+		m_vTopicTexts.append(it.value().first);
+		m_vTopicKeys.append(it.value().second);
+
+		int iId = m_vChannels.count() - 1;
+		addToTrigramIndex(iId, m_vChannelKeys.last());
+		addToTrigramIndex(iId, m_vTopicKeys.last());
 	}
-	//make gcc happy
-	return QSize();
+
+	QVector<int> vNew;
+	vNew.reserve(vEntries.count());
+	for(int i = iFirst; i < iCount; i++)
+		vNew.append(i);
+
+	if(!m_szFilter.isEmpty())
+	{
+		startFilterJob(vNew, true);
+		return;
+	}
+
+	int iRow = m_vVisible.count();
+	beginInsertRows(QModelIndex(), iRow, iRow + vNew.count() - 1);
+	m_vVisible += vNew;
+	endInsertRows();
+	changeLayout(iRow);
 }
 
-void ChannelTreeWidgetItemDelegate::paint(QPainter * p, const QStyleOptionViewItem & option, const QModelIndex & index) const
+void ChannelListModel::clear()
 {
-	ChannelTreeWidgetItem * obj = static_cast<ChannelTreeWidgetItem *>(index.internalPointer());
+	beginResetModel();
+	m_vChannels.clear();
+	m_vChannelKeys.clear();
+	m_vUsers.clear();
+	m_vTopics.clear();
+	m_vTopicTexts.clear();
+	m_vTopicKeys.clear();
+	m_hTopicPool.clear();
+	m_hTrigramIndex.clear();
+	m_vVisible.clear();
+	m_uFilterGeneration++; // whatever is running now refers to rows that are gone
+	endResetModel();
+}
+
+void ChannelListModel::setFilter(const QString & szFilter)
+{
+	if(szFilter == m_szFilter)
+		return;
+
+	QString szOld = m_szFilter;
+	m_szFilter = szFilter;
+	m_uFilterGeneration++;
 
+	if(m_szFilter.isEmpty())
+	{
+		beginResetModel();
+		m_vVisible.resize(m_vChannels.count());
+		for(int i = 0; i < m_vVisible.count(); i++)
+			m_vVisible[i] = i;
+		sortVisible(0);
+		endResetModel();
+		return;
+	}
+
+	// A plain string contained in the new filter (which can't have character
+	// sets) matches a superset of its rows: then only the visible ones need to
+	// be checked again. This holds only if no job is still working on new rows.
+	bool bNarrowing = (m_uPendingJobs == 0) && !szOld.isEmpty() && !szOld.contains(QChar('*')) && !szOld.contains(QChar('?')) && !szOld.contains(QChar('[')) && !m_szFilter.contains(QChar('[')) && m_szFilter.contains(szOld, Qt::CaseInsensitive);
+
+	const QVector<int> * pCandidates = filterCandidates(m_szFilter);
+
+	if(bNarrowing && (!pCandidates || (m_vVisible.count() <= pCandidates->count())))
+	{
+		startFilterJob(m_vVisible, false);
+		return;
+	}
+
+	if(pCandidates)
+	{
+		startFilterJob(*pCandidates, false);
+		return;
+	}
+
+	QVector<int> vAll(m_vChannels.count());
+	for(int i = 0; i < vAll.count(); i++)
+		vAll[i] = i;
+	startFilterJob(vAll, false);
+}
+
+void ChannelListModel::addToTrigramIndex(int iId, const QString & szKey)
+{
+	for(int i = 0; i + 3 <= szKey.length(); i++)
+	{
+		QVector<int> & vIds = m_hTrigramIndex[channel_list_trigram(szKey, i)];
+		// the trigram may be repeated in the key or be both in the channel and in the topic
+		if(vIds.isEmpty() || (vIds.last() != iId))
+			vIds.append(iId);
+	}
+}
+
+const QVector<int> * ChannelListModel::filterCandidates(const QString & szFilter) const
+{
+	static const QVector<int> vNone;
+
+	if(szFilter.contains(QChar('[')))
+		return nullptr; // character sets: no literal parts to look up
+
+	// a matching row contains every literal part of the filter either in the
+	// channel or in the topic, so it has all their trigrams: check the rows
+	// of the rarest one
+	const QVector<int> * pCandidates = nullptr;
+	QStringList lFragments = szFilter.toLower().split(QRegExp("[*?]"), QString::SkipEmptyParts);
+	for(const auto & szFragment : lFragments)
+	{
+		for(int i = 0; i + 3 <= szFragment.length(); i++)
+		{
+			QHash<quint64, QVector<int>>::const_iterator it = m_hTrigramIndex.constFind(channel_list_trigram(szFragment, i));
+			if(it == m_hTrigramIndex.constEnd())
+				return &vNone; // no row has this trigram
+			if(!pCandidates || (it.value().count() < pCandidates->count()))
+				pCandidates = &(it.value());
+		}
+	}
+	return pCandidates;
+}
+
+void ChannelListModel::startFilterJob(const QVector<int> & vCandidates, bool bNewRows)
+{
+	m_uPendingJobs++;
+	m_FilterPool.start(new ChannelListFilterJob(this, vCandidates, bNewRows));
+}
+
+void ChannelListModel::processFinishedJobs()
+{
+	QList<ChannelListFilterJob *> lJobs;
+
+	m_FinishedJobsMutex.lock();
+	lJobs.swap(m_lFinishedJobs);
+	m_FinishedJobsMutex.unlock();
+
+	for(auto pJob : lJobs)
+	{
+		applyFilterJob(pJob);
+		delete pJob;
+	}
+}
+
+void ChannelListModel::applyFilterJob(ChannelListFilterJob * pJob)
+{
+	m_uPendingJobs--;
+
+	if(pJob->m_uGeneration != m_uFilterGeneration)
+		return; // the filter (or the list) has changed in the meantime
+
+	if(pJob->m_bNewRows)
+	{
+		if(pJob->m_vMatches.isEmpty())
+			return;
+		int iRow = m_vVisible.count();
+		beginInsertRows(QModelIndex(), iRow, iRow + pJob->m_vMatches.count() - 1);
+		m_vVisible += pJob->m_vMatches;
+		endInsertRows();
+		changeLayout(iRow);
+		return;
+	}
+
+	// The jobs run in order, so the new rows of this generation are
+	// checked by jobs that come after this one: the result replaces everything.
+	beginResetModel();
+	m_vVisible = pJob->m_vMatches;
+	sortVisible(0);
+	endResetModel();
+}
+
+ChannelTreeViewItemDelegate::ChannelTreeViewItemDelegate(QTreeView * pWidget)
+    : QItemDelegate(pWidget)
+{
+}
+
+ChannelTreeViewItemDelegate::~ChannelTreeViewItemDelegate()
+    = default;
+
+#define BORDER 2
+
+QSize ChannelTreeViewItemDelegate::sizeHint(const QStyleOptionViewItem & sovItem, const QModelIndex & index) const
+{
+	QTreeView * pView = (QTreeView *)parent();
+
+	int iHeight = pView->fontMetrics().lineSpacing() + BORDER + BORDER;
+
+	// the topic display text is already stripped of the control codes
+	QFontMetrics fm(sovItem.font);
+	return QSize(fm.width(index.data().toString()), iHeight);
+}
+
+void ChannelTreeViewItemDelegate::paint(QPainter * p, const QStyleOptionViewItem & option, const QModelIndex & index) const
+{
 	if(option.state & QStyle::State_Selected)
 		p->fillRect(option.rect, option.palette.brush(QPalette::Highlight));
 
@@ -152,16 +554,16 @@ void ChannelTreeWidgetItemDelegate::paint(QPainter * p, const QStyleOptionViewIt
 	{
 		case 0:
 			//channel
-			p->drawText(option.rect, obj->itemData()->m_szChan);
+			p->drawText(option.rect, index.data().toString());
 			break;
 		case 1:
 			//users
-			p->drawText(option.rect, Qt::AlignHCenter, obj->itemData()->m_szUsers);
+			p->drawText(option.rect, Qt::AlignHCenter, index.data().toString());
 			break;
 		case 2:
 		default:
 			//topic
-			KviTopicWidget::paintColoredText(p, obj->itemData()->m_szTopic, option.palette, option.rect);
+			KviTopicWidget::paintColoredText(p, index.data(ChannelListModel::RawTopicRole).toString(), option.palette, option.rect);
 			break;
 	}
 }
@@ -173,9 +575,6 @@ ListWindow::ListWindow(KviConsoleWindow * lpConsole)
 
 	m_pFlushTimer = nullptr;
 
-	m_pItemList = new KviPointerList<ChannelTreeWidgetItemData>;
-	m_pItemList->setAutoDelete(false);
-
 	m_pSplitter = new KviTalSplitter(Qt::Horizontal, this);
 	m_pSplitter->setObjectName("splitter");
 	m_pSplitter->setChildrenCollapsible(false);
@@ -229,30 +628,30 @@ ListWindow::ListWindow(KviConsoleWindow * lpConsole)
 
 	m_pInfoLabel = new KviThemedLabel(m_pTopSplitter, this, "info_label");
 
-	m_pTreeWidget = new ChannelTreeWidget(m_pVertSplitter, this, "list_treewidget");
-	m_pTreeWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
-	m_pTreeWidget->setSelectionMode(QAbstractItemView::SingleSelection);
-	m_pTreeWidget->setItemDelegate(new ChannelTreeWidgetItemDelegate(m_pTreeWidget));
-	QStringList columnLabels;
-	columnLabels.append(__tr2qs("Channel"));
-	columnLabels.append(__tr2qs("Users"));
-	columnLabels.append(__tr2qs("Topic"));
-	m_pTreeWidget->setColumnCount(3);
-	m_pTreeWidget->setHeaderLabels(columnLabels);
-	m_pTreeWidget->setAllColumnsShowFocus(true);
-	m_pTreeWidget->setSortingEnabled(true);
-	m_pTreeWidget->sortItems(0, Qt::AscendingOrder);
-	m_pTreeWidget->setUniformRowHeights(true);
-
-	m_pTreeWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-	m_pTreeWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-	m_pTreeWidget->header()->setStretchLastSection(false);
-	m_pTreeWidget->header()->resizeSection(0, 150);
-	m_pTreeWidget->header()->resizeSection(1, 80);
-	m_pTreeWidget->header()->resizeSection(2, 450);
-	//m_pTreeWidget->header()->setResizeMode(QHeaderView::ResizeToContents); <-- this is too heavy for single-core machines...
-
-	connect(m_pTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem *, int)), this, SLOT(itemDoubleClicked(QTreeWidgetItem *, int)));
+	m_pModel = new ChannelListModel(this);
+
+	m_pTreeView = new KviThemedTreeView(m_pVertSplitter, this, "list_treewidget");
+	m_pTreeView->setModel(m_pModel);
+	m_pTreeView->setSelectionBehavior(QAbstractItemView::SelectRows);
+	m_pTreeView->setSelectionMode(QAbstractItemView::SingleSelection);
+	m_pTreeView->setItemDelegate(new ChannelTreeViewItemDelegate(m_pTreeView));
+	m_pTreeView->setRootIsDecorated(false);
+	m_pTreeView->setItemsExpandable(false);
+	m_pTreeView->setAllColumnsShowFocus(true);
+	m_pTreeView->setSortingEnabled(true);
+	m_pTreeView->sortByColumn(0, Qt::AscendingOrder);
+	// the view can then lay out only the rows it actually shows
+	m_pTreeView->setUniformRowHeights(true);
+
+	m_pTreeView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	m_pTreeView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	m_pTreeView->header()->setStretchLastSection(false);
+	m_pTreeView->header()->resizeSection(0, 150);
+	m_pTreeView->header()->resizeSection(1, 80);
+	m_pTreeView->header()->resizeSection(2, 450);
+	//m_pTreeView->header()->setResizeMode(QHeaderView::ResizeToContents); <-- this is too heavy for single-core machines...
+
+	connect(m_pTreeView, SIGNAL(doubleClicked(const QModelIndex &)), this, SLOT(itemDoubleClicked(const QModelIndex &)));
 
 	m_pIrcView = new KviIrcView(m_pVertSplitter, this);
 
@@ -269,8 +668,6 @@ ListWindow::~ListWindow()
 
 	if(m_pFlushTimer)
 		delete m_pFlushTimer;
-	m_pItemList->setAutoDelete(true);
-	delete m_pItemList;
 }
 
 void ListWindow::getBaseLogFileName(QString & szBuffer)
@@ -359,7 +756,7 @@ void ListWindow::die()
 
 void ListWindow::exportList()
 {
-	if(!m_pTreeWidget->topLevelItemCount())
+	if(!m_pModel->channelCount())
 	{
 		QMessageBox::warning(nullptr, __tr2qs("Warning While Exporting - KVIrc"), __tr2qs("You can't export an empty list!"));
 		return;
@@ -400,14 +797,12 @@ void ListWindow::exportList()
 		KviConfigurationFile cfg(szFile, KviConfigurationFile::Write);
 		cfg.clear();
 
-		ChannelTreeWidgetItem * it;
-		for(int i = 0; i < m_pTreeWidget->topLevelItemCount(); i++)
+		for(int i = 0; i < m_pModel->channelCount(); i++)
 		{
-			it = (ChannelTreeWidgetItem *)m_pTreeWidget->topLevelItem(i);
-			cfg.setGroup(it->itemData()->m_szChan);
+			cfg.setGroup(m_pModel->channel(i));
 			// Write properties
-			cfg.writeEntry("topic", it->itemData()->m_szTopic);
-			cfg.writeEntry("users", it->itemData()->m_szUsers);
+			cfg.writeEntry("topic", m_pModel->topic(i));
+			cfg.writeEntry("users", QString::number(m_pModel->users(i)));
 		}
 	}
 }
@@ -418,23 +813,17 @@ void ListWindow::importList()
 
 	if(KviFileDialog::askForOpenFileName(szFile, __tr2qs("Select a File - KVIrc"), QString(), KVI_FILTER_CONFIG, false, false, this))
 	{
-
-		m_pItemList->setAutoDelete(true);
-		m_pItemList->clear();
-		m_pItemList->setAutoDelete(false);
-
-		m_pTreeWidget->clear();
+		m_vPendingEntries.clear();
+		m_pModel->clear();
 
 		KviConfigurationFile cfg(szFile, KviConfigurationFile::Read);
 		KviConfigurationFileIterator it(*cfg.dict());
 		while(it.current())
 		{
 			cfg.setGroup(it.currentKey());
-			m_pItemList->append(
-			    new ChannelTreeWidgetItemData(
-			        it.currentKey(),
-			        cfg.readEntry("users", "0"),
-			        cfg.readEntry("topic", "")));
+			m_vPendingEntries.append({ it.currentKey(),
+			    cfg.readEntry("users", "0").toInt(),
+			    cfg.readEntry("topic", "") });
 			++it;
 		}
 		flush();
@@ -476,32 +865,16 @@ void ListWindow::endOfList()
 
 void ListWindow::startOfList()
 {
-	m_pItemList->setAutoDelete(true);
-	m_pItemList->clear();
-	m_pItemList->setAutoDelete(false);
-
-	m_pTreeWidget->clear();
+	m_vPendingEntries.clear();
+	m_pModel->clear();
 
 	m_pRequestButton->setEnabled(false);
 }
 
 void ListWindow::liveSearch(const QString & szText)
 {
-	QRegExp res(szText, Qt::CaseInsensitive, QRegExp::Wildcard);
-
-	ChannelTreeWidgetItem * pItem = nullptr;
-	for(int i = 0; i < m_pTreeWidget->topLevelItemCount(); i++)
-	{
-		pItem = (ChannelTreeWidgetItem *)m_pTreeWidget->topLevelItem(i);
-		if(pItem->itemData()->m_szChan.contains(res) || pItem->itemData()->m_szTopic.contains(res))
-		{
-			pItem->setHidden(false);
-		}
-		else
-		{
-			pItem->setHidden(true);
-		}
-	}
+	// the matching runs on the model's worker thread
+	m_pModel->setFilter(szText);
 }
 
 void ListWindow::processData(KviIrcMessage * pMsg)
@@ -514,27 +887,19 @@ void ListWindow::processData(KviIrcMessage * pMsg)
 		m_pRequestButton->setEnabled(false);
 	}
 
+	QString szChan = pMsg->connection()->decodeText(pMsg->safeParam(1));
+	QString szTopic = pMsg->connection()->decodeText(pMsg->safeTrailing());
+
 	if(m_pParamsEdit->text().isEmpty())
 	{
-		m_pItemList->append(
-		    new ChannelTreeWidgetItemData(
-		        pMsg->connection()->decodeText(pMsg->safeParam(1)),
-		        pMsg->connection()->decodeText(pMsg->safeParam(2)),
-		        pMsg->connection()->decodeText(pMsg->safeTrailing())));
+		m_vPendingEntries.append({ szChan, pMsg->connection()->decodeText(pMsg->safeParam(2)).toInt(), szTopic });
 	}
 	else
 	{
 		//rfc2812 permits wildcards here (section 3.2.6)
 		QRegExp res(m_pParamsEdit->text(), Qt::CaseInsensitive, QRegExp::Wildcard);
-		if(
-		    res.exactMatch(pMsg->connection()->decodeText(pMsg->safeParam(1))) || res.exactMatch(pMsg->connection()->decodeText(pMsg->safeTrailing())))
-		{
-			m_pItemList->append(
-			    new ChannelTreeWidgetItemData(
-			        pMsg->connection()->decodeText(pMsg->safeParam(1)),
-			        pMsg->connection()->decodeText(pMsg->safeParam(2)),
-			        pMsg->connection()->decodeText(pMsg->safeTrailing())));
-		}
+		if(res.exactMatch(szChan) || res.exactMatch(szTopic))
+			m_vPendingEntries.append({ szChan, pMsg->connection()->decodeText(pMsg->safeParam(2)).toInt(), szTopic });
 	}
 
 	if(_OUTPUT_VERBOSE)
@@ -546,27 +911,20 @@ void ListWindow::processData(KviIrcMessage * pMsg)
 
 void ListWindow::flush()
 {
-	m_pTreeWidget->setUpdatesEnabled(false); /* for v_scroolbar */
-	while(ChannelTreeWidgetItemData * d = m_pItemList->first())
-	{
-		// Model-View-Delegate-Crappiness...
-		//
-		// Don't use the constructor that takes QTreeWidget as parent
-		// as it will insert the item and call the delegate's sizeHint()
-		// function when the item is not yet fully constructed.
-
-		m_pTreeWidget->addTopLevelItem(new ChannelTreeWidgetItem(d));
+	if(m_vPendingEntries.isEmpty())
+		return;
 
-		m_pItemList->removeFirst();
-	}
-	m_pTreeWidget->setUpdatesEnabled(true);
-	m_pTreeWidget->resizeColumnToContents(2);
-	m_pTreeWidget->viewport()->update();
+	m_pModel->appendEntries(m_vPendingEntries);
+	m_vPendingEntries.clear();
+	m_pTreeView->resizeColumnToContents(2);
 }
 
-void ListWindow::itemDoubleClicked(QTreeWidgetItem * it, int)
+void ListWindow::itemDoubleClicked(const QModelIndex & index)
 {
-	QString szText = ((ChannelTreeWidgetItem *)it)->itemData()->m_szChan;
+	if(!index.isValid())
+		return;
+
+	QString szText = m_pModel->channel(m_pModel->idForRow(index.row()));
 
 	if(szText.isEmpty())
 		return;
@@ -582,7 +940,7 @@ void ListWindow::itemDoubleClicked(QTreeWidgetItem * it, int)
 
 void ListWindow::applyOptions()
 {
-	m_pTreeWidget->applyOptions();
+	m_pTreeView->applyOptions();
 	m_pIrcView->applyOptions();
 	m_pParamsEdit->applyOptions();
 	m_pInfoLabel->applyOptions();
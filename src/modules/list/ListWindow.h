@@ -31,67 +31,124 @@
 #include "KviIrcServerParser.h"
 #include "KviConsoleWindow.h"
 #include "KviIrcContext.h"
-#include "KviThemedTreeWidget.h"
 
 #include <QToolButton>
 #include <QLineEdit>
 #include <QItemDelegate>
 #include <QMenu>
+#include <QTreeView>
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
 
 class KviThemedLabel;
 class KviThemedLineEdit;
+class KviThemedTreeView;
+class ChannelListFilterJob;
 
-class ChannelTreeWidgetItemDelegate : public QItemDelegate
+// A single RPL_LIST reply waiting to be flushed to the model
+struct ChannelListEntry
 {
-public:
-	ChannelTreeWidgetItemDelegate(QTreeWidget * pWidget = nullptr);
-	~ChannelTreeWidgetItemDelegate();
-	void paint(QPainter * pPainter, const QStyleOptionViewItem & option, const QModelIndex & index) const;
-	QSize sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const;
+	QString szChan;
+	int iUsers;
+	QString szTopic;
 };
 
-class ChannelTreeWidgetItemData
+//
+// The channel list.
+//
+// The rows are kept in a columnar store (one vector per field) that is only ever
+// appended to: a row is identified by its index in the store. What the view
+// sees is m_vVisible, the list of row ids that pass the current filter,
+// sorted by the current sort column.
+//
+// Topics are interned, so the channels sharing a topic share its data, and
+// the case folded keys used to sort and to filter are computed once per row.
+// Filtering runs on a private single threaded pool: a job gets a copy of the
+// keys (which is just a reference count bump) and a list of candidate rows.
+// New rows arriving while a filter is set are checked by a job of their own.
+// The candidates of a new filter come from a trigram index of the keys, built
+// as the rows arrive: a row can match only if it has all the trigrams of the
+// literal parts of the filter. When the filter is narrowed, the rows that are
+// already visible are used instead if there are fewer of them.
+//
+class ChannelListModel : public QAbstractTableModel
 {
-	friend class ChannelTreeWidgetItem;
-	friend class ListWindow;
-	friend class ChannelTreeWidgetItemDelegate;
-
+	friend class ChannelListFilterJob;
+	Q_OBJECT
 public:
-	ChannelTreeWidgetItemData(const QString & szChan, const QString & szUsers, const QString & szTopic);
-	~ChannelTreeWidgetItemData();
+	enum Role
+	{
+		RawTopicRole = Qt::UserRole // the topic, with the mIRC control codes
+	};
 
-protected:
-	QString m_szChan;
-	QString m_szUsers;
-	QString m_szTopic;
-	QString m_szStrippedTopic;
-};
+	ChannelListModel(QObject * pParent);
+	~ChannelListModel();
 
-class ChannelTreeWidgetItem : public QTreeWidgetItem
-{
-	friend class ListWindow;
+protected:
+	QVector<QString> m_vChannels;
+	QVector<int> m_vUsers;
+	QVector<QString> m_vTopics;
+	QVector<QString> m_vTopicTexts;  // stripped of the control codes, for display
+	QVector<QString> m_vChannelKeys; // case folded
+	QVector<QString> m_vTopicKeys;   // stripped and case folded
+	QHash<QString, QPair<QString, QString>> m_hTopicPool; // interned topic -> topic text and key
+	QHash<quint64, QVector<int>> m_hTrigramIndex;         // trigram of the keys -> ids of the rows having it (ascending)
+
+	QVector<int> m_vVisible;
+	int m_iSortColumn;
+	Qt::SortOrder m_eSortOrder;
+
+	QString m_szFilter;
+	unsigned int m_uFilterGeneration;
+	unsigned int m_uPendingJobs;
+	QThreadPool m_FilterPool;
+	QMutex m_FinishedJobsMutex;
+	QList<ChannelListFilterJob *> m_lFinishedJobs; // protected by m_FinishedJobsMutex
 
 public:
-	ChannelTreeWidgetItem(ChannelTreeWidgetItemData * pData);
-	~ChannelTreeWidgetItem();
-
-private:
-	ChannelTreeWidgetItemData * m_pData;
+	int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex & index, int iRole = Qt::DisplayRole) const override;
+	QVariant headerData(int iSection, Qt::Orientation eOrientation, int iRole = Qt::DisplayRole) const override;
+	void sort(int iColumn, Qt::SortOrder eOrder = Qt::AscendingOrder) override;
+
+	// the number of channels in the store (visible or not)
+	int channelCount() const { return m_vChannels.count(); }
+	// these take a store row id
+	const QString & channel(int iId) const { return m_vChannels.at(iId); }
+	int users(int iId) const { return m_vUsers.at(iId); }
+	const QString & topic(int iId) const { return m_vTopics.at(iId); }
+	// maps a view row to a store row id
+	int idForRow(int iRow) const { return m_vVisible.at(iRow); }
+
+	void appendEntries(const QVector<ChannelListEntry> & vEntries);
+	void clear();
+	void setFilter(const QString & szFilter);
 
-public:
-	bool operator<(const QTreeWidgetItem & other) const;
-	ChannelTreeWidgetItemData * itemData() const { return m_pData; }
+protected:
+	void addToTrigramIndex(int iId, const QString & szKey);
+	// the rows having the rarest trigram of the filter or nullptr if the filter has none
+	const QVector<int> * filterCandidates(const QString & szFilter) const;
+	void startFilterJob(const QVector<int> & vCandidates, bool bNewRows);
+	void applyFilterJob(ChannelListFilterJob * pJob);
+	// sorts m_vVisible[iFrom..] and merges it with the (already sorted) head
+	void sortVisible(int iFrom);
+	void changeLayout(int iFrom);
+	bool lessThan(int iId1, int iId2) const;
+protected slots:
+	void processFinishedJobs();
 };
 
-class ChannelTreeWidget : public KviThemedTreeWidget
+class ChannelTreeViewItemDelegate : public QItemDelegate
 {
-	friend class ChannelTreeWidgetItem;
-	friend class ChannelTreeWidgetItemData;
-	Q_OBJECT
 public:
-	ChannelTreeWidget(QWidget * par, KviWindow * pWindow, const char * name) : KviThemedTreeWidget(par, pWindow, name){};
-	~ChannelTreeWidget(){};
-	ChannelTreeWidgetItem * itemFromIndex(const QModelIndex & index) const { return (ChannelTreeWidgetItem *)KviThemedTreeWidget::itemFromIndex(index); };
+	ChannelTreeViewItemDelegate(QTreeView * pWidget = nullptr);
+	~ChannelTreeViewItemDelegate();
+	void paint(QPainter * pPainter, const QStyleOptionViewItem & option, const QModelIndex & index) const override;
+	QSize sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const override;
 };
 
 class ListWindow : public KviWindow, public KviExternalServerDataParser
@@ -104,7 +161,8 @@ public:
 protected:
 	QSplitter * m_pVertSplitter;
 	QSplitter * m_pTopSplitter;
-	ChannelTreeWidget * m_pTreeWidget;
+	KviThemedTreeView * m_pTreeView;
+	ChannelListModel * m_pModel;
 	KviThemedLineEdit * m_pParamsEdit;
 	QToolButton * m_pRequestButton;
 	QToolButton * m_pStopListDownloadButton;
@@ -112,7 +170,7 @@ protected:
 	QToolButton * m_pSaveButton;
 	KviThemedLabel * m_pInfoLabel;
 	QTimer * m_pFlushTimer;
-	KviPointerList<ChannelTreeWidgetItemData> * m_pItemList;
+	QVector<ChannelListEntry> m_vPendingEntries;
 
 public: // Methods
 	void control(int iMsg) override;
@@ -128,7 +186,7 @@ protected:
 	void getBaseLogFileName(QString & szBuffer) override;
 protected slots:
 	void flush();
-	void itemDoubleClicked(QTreeWidgetItem * it, int);
+	void itemDoubleClicked(const QModelIndex & index);
 	void requestList();
 	void stoplistdownload();
 	void connectionStateChange();
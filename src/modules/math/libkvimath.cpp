@@ -25,6 +25,9 @@
 #include "kvi_settings.h"
 #include "KviModule.h"
 #include "KviCString.h"
+#include "KviKvsArray.h"
+#include "KviKvsArrayCast.h"
+#include "KviLocale.h"
 
 #include <cmath>
 
@@ -357,6 +360,112 @@ static bool math_kvs_fnc_pow(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: math.sum
+	@type:
+		function
+	@title:
+		$math.sum
+	@short:
+		Returns the sum of the items of an array
+	@syntax:
+		<number> $math.sum(<data:array>)
+	@description:
+		Returns the sum of the numeric items of the <data> array.
+		The result is an integer if all the items are integers and a real otherwise.
+		Empty items are skipped. If <data> contains an item that
+		is not a number, a warning is printed and nothing is returned.
+	@seealso:
+		[fnc]$math.min[/fnc], [fnc]$math.max[/fnc]
+*/
+
+static bool math_kvs_fnc_sum(KviKvsModuleFunctionCall * c)
+{
+	KviKvsArrayCast ac;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("data", KVS_PT_ARRAYCAST, 0, ac)
+	KVSM_PARAMETERS_END(c)
+
+	if(!ac.array())
+	{
+		c->returnValue()->setInteger(0);
+		return true;
+	}
+
+	if(!ac.array()->sum(c->returnValue()))
+	{
+		c->warning(__tr2qs("The array contains items that are not numbers"));
+		c->returnValue()->setNothing();
+	}
+	return true;
+}
+
+/*
+	@doc: math.min
+	@type:
+		function
+	@title:
+		$math.min
+	@short:
+		Returns the smallest item of an array
+	@syntax:
+		<variant> $math.min(<data:array>)
+	@description:
+		Returns the smallest item of the <data> array.
+		The items are compared like the < operator does.
+		If the array is empty, nothing is returned.
+	@seealso:
+		[fnc]$math.max[/fnc], [fnc]$math.sum[/fnc]
+*/
+
+static bool math_kvs_fnc_min(KviKvsModuleFunctionCall * c)
+{
+	KviKvsArrayCast ac;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("data", KVS_PT_ARRAYCAST, 0, ac)
+	KVSM_PARAMETERS_END(c)
+
+	KviKvsVariant * v = ac.array() ? ac.array()->minimum() : nullptr;
+	if(v)
+		c->returnValue()->copyFrom(v);
+	else
+		c->returnValue()->setNothing();
+	return true;
+}
+
+/*
+	@doc: math.max
+	@type:
+		function
+	@title:
+		$math.max
+	@short:
+		Returns the greatest item of an array
+	@syntax:
+		<variant> $math.max(<data:array>)
+	@description:
+		Returns the greatest item of the <data> array.
+		The items are compared like the > operator does.
+		If the array is empty, nothing is returned.
+	@seealso:
+		[fnc]$math.min[/fnc], [fnc]$math.sum[/fnc]
+*/
+
+static bool math_kvs_fnc_max(KviKvsModuleFunctionCall * c)
+{
+	KviKvsArrayCast ac;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("data", KVS_PT_ARRAYCAST, 0, ac)
+	KVSM_PARAMETERS_END(c)
+
+	KviKvsVariant * v = ac.array() ? ac.array()->maximum() : nullptr;
+	if(v)
+		c->returnValue()->copyFrom(v);
+	else
+		c->returnValue()->setNothing();
+	return true;
+}
+
 /*
 	@doc: math.pi
 	@type:
@@ -434,6 +543,9 @@ static bool math_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "e", math_kvs_fnc_e);
 	KVSM_REGISTER_FUNCTION(m, "isnan", math_kvs_fnc_isnan);
 	KVSM_REGISTER_FUNCTION(m, "isinf", math_kvs_fnc_isinf);
+	KVSM_REGISTER_FUNCTION(m, "sum", math_kvs_fnc_sum);
+	KVSM_REGISTER_FUNCTION(m, "min", math_kvs_fnc_min);
+	KVSM_REGISTER_FUNCTION(m, "max", math_kvs_fnc_max);
 	return true;
 }
 
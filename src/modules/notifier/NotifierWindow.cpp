@@ -34,6 +34,7 @@
 #include "KviLocale.h"
 #include "KviMainWindow.h"
 #include "KviOptions.h"
+#include "KviIrcSocket.h"
 #include "KviUserInput.h"
 #include "KviThemedLineEdit.h"
 
@@ -1083,7 +1084,9 @@ void NotifierWindow::returnPressed()
 
 	addMessage(pTab->wnd(), szTmp.ptr(), szHtml, 0);
 	m_pLineEdit->setText("");
+	KviIrcSocket::OutgoingPriority eOldPriority = KviIrcSocket::setOutgoingPriority(KviIrcSocket::Interactive);
 	KviUserInput::parse(szTxt, pTab->wnd(), QString(), true);
+	KviIrcSocket::setOutgoingPriority(eOldPriority);
 }
 
 void NotifierWindow::progressUpdate()
@@ -117,11 +117,11 @@ OptionsWidget_channelAdvanced::OptionsWidget_channelAdvanced(QWidget * pParent)
 	m_pBanTypeCombo->setCurrentIndex(KVI_OPTION_UINT(KviOption_uintDefaultBanType));
 
 	g = addGroupBox(0, 2, 4, 2, Qt::Horizontal, __tr2qs_ctx("On Channel Join", "options"));
-	u = addUIntSelector(g, __tr2qs_ctx("Minimum delay between two channel requests:", "options"), KviOption_uintOnJoinRequestsDelay, 0, 10, 1);
+	u = addUIntSelector(g, __tr2qs_ctx("Delay before the channel requests:", "options"), KviOption_uintOnJoinRequestsDelay, 0, 10, 1);
 	u->setSuffix(__tr2qs_ctx(" sec", "options"));
-	mergeTip(u, __tr2qs_ctx("This is an artificial delay for the channel requests made on join.<br>"
-	                        "You may increase it if your server complains about flooding when joining "
-	                        "many channels at once.<br>Minimum value: <b>0 secs</b><br>Maximum value: <b>10 secs</b>",
+	mergeTip(u, __tr2qs_ctx("This is an artificial delay before the channel requests made on join are started.<br>"
+	                        "The requests are then paced by the server replies and by the flood protection "
+	                        "of the connection.<br>Minimum value: <b>0 secs</b><br>Maximum value: <b>10 secs</b>",
 	                "options"));
 
 	addBoolSelector(g, __tr2qs_ctx("Do not send /WHO request", "options"), KviOption_boolDisableWhoRequestOnJoin);
@@ -156,13 +156,28 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	u = addUIntSelector(g, __tr2qs_ctx("Outgoing data queue flush timeout:", "options"), KviOption_uintSocketQueueFlushTimeout, 100, 2000, 500);
 	u->setSuffix(__tr2qs_ctx(" msec", "options"));
 	b = addBoolSelector(0, 1, 0, 1, __tr2qs_ctx("Limit outgoing traffic per connection", "options"), KviOption_boolLimitOutgoingTraffic);
-	u = addUIntSelector(0, 2, 0, 2, __tr2qs_ctx("Limit to 1 message every:", "options"),
-	    KviOption_uintOutgoingTrafficLimitUSeconds, 10000, 2000000, 10000001, KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic));
+	mergeTip(b, __tr2qs_ctx("<center>KVIrc keeps track of the penalty that the server gives to each message and "
+	                        "never sends more than the flood budget allows.<br>"
+	                        "Your own input and the replies to the server go first, then the script output and "
+	                        "finally slow pastes and the channel requests sent on join.</center>",
+	    "options"));
+	u = addUIntSelector(0, 2, 0, 2, __tr2qs_ctx("Penalty of a message:", "options"),
+	    KviOption_uintOutgoingTrafficLimitUSeconds, 10000, 10000000, 2000000, KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic));
 	u->setSuffix(__tr2qs_ctx(" usec", "options"));
-	mergeTip(u, __tr2qs_ctx("Minimum value: <b>10000 usec</b><br>Maximum value: <b>10000000 usec</b>", "options"));
+	mergeTip(u, __tr2qs_ctx("<center>Long messages and commands like WHO cost more.<br>"
+	                        "Minimum value: <b>10000 usec</b><br>Maximum value: <b>10000000 usec</b></center>",
+	    "options"));
+	connect(b, SIGNAL(toggled(bool)), u, SLOT(setEnabled(bool)));
+	u = addUIntSelector(0, 3, 0, 3, __tr2qs_ctx("Flood budget:", "options"),
+	    KviOption_uintOutgoingTrafficBurstUSeconds, 0, 60000000, 8000000, KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic));
+	u->setSuffix(__tr2qs_ctx(" usec", "options"));
+	mergeTip(u, __tr2qs_ctx("<center>The penalty that may be accumulated before waiting: most servers "
+	                        "disconnect a client at 10 seconds.<br>"
+	                        "With <b>0</b> the messages are sent one every penalty period.</center>",
+	    "options"));
 	connect(b, SIGNAL(toggled(bool)), u, SLOT(setEnabled(bool)));
 
-	g = addGroupBox(0, 3, 0, 3, Qt::Horizontal, __tr2qs_ctx("Network Interfaces", "options"));
+	g = addGroupBox(0, 4, 0, 4, Qt::Horizontal, __tr2qs_ctx("Network Interfaces", "options"));
 
 	b = addBoolSelector(g, __tr2qs_ctx("Bind IPv4 connections to:", "options"), KviOption_boolBindIrcIPv4ConnectionsToSpecifiedAddress);
 	s = addStringSelector(g, "", KviOption_stringIPv4ConnectionBindAddress, KVI_OPTION_BOOL(KviOption_boolBindIrcIPv4ConnectionsToSpecifiedAddress));
@@ -173,7 +188,7 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	connect(b, SIGNAL(toggled(bool)), s, SLOT(setEnabled(bool)));
 #endif //!COMPILE_IPV6_SUPPORT
 
-	b = addBoolSelector(0, 4, 0, 4, __tr2qs_ctx("Pick random IP address for round-robin servers", "options"), KviOption_boolPickRandomIpAddressForRoundRobinServers);
+	b = addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Pick random IP address for round-robin servers", "options"), KviOption_boolPickRandomIpAddressForRoundRobinServers);
 	mergeTip(b, __tr2qs_ctx("This option will cause the KVIrc networking stack to pick up "
 	                        "a random entry when multiple IP address are retrieved for a server "
 	                        "DNS lookup. This is harmless and can fix some problems with caching "
@@ -182,10 +197,10 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	                        "you want to rely on the DNS server to provide the best choice.",
 	                "options"));
 
-	b = addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Drop connection on SASL authentication failure", "options"), KviOption_boolDropConnectionOnSaslFailure);
+	b = addBoolSelector(0, 6, 0, 6, __tr2qs_ctx("Drop connection on SASL authentication failure", "options"), KviOption_boolDropConnectionOnSaslFailure);
 	mergeTip(b, __tr2qs_ctx("This option will close the socket if no SASL authentication or any SASL fallback had succeeded.", "options"));
 
-	addRowSpacer(0, 6, 0, 6);
+	addRowSpacer(0, 7, 0, 7);
 }
 
 OptionsWidget_connectionSocket::~OptionsWidget_connectionSocket()
@@ -287,6 +287,16 @@ OptionsWidget_dccSendAdvanced::OptionsWidget_dccSendAdvanced(QWidget * parent)
 	                        "add load to your CPU, disk and network interface.<br>"
 	                        "Reasonable values are from 5 to 50 milliseconds.", "options"));
 
+	b = addBoolSelector(g, __tr2qs_ctx("Keep a resume ledger for incoming files", "options"), KviOption_boolUseDccResumeLedger);
+	mergeTip(b, __tr2qs_ctx("This option causes KVIrc to record a hash of every 4 MiB of an incoming file "
+	                        "in a file.kvirc-ledger file next to it.<br>"
+	                        "When a transfer is resumed the end of the partial file is checked against it "
+	                        "and the data that doesn't match is downloaded again.", "options"));
+
+	b = addBoolSelector(g, __tr2qs_ctx("Compute the SHA-256 hash of incoming files", "options"), KviOption_boolHashReceivedDccFiles);
+	mergeTip(b, __tr2qs_ctx("This option causes KVIrc to compute the SHA-256 hash of an incoming file "
+	                        "while it is received and to show it when the transfer is completed.", "options"));
+
 	u = addUIntSelector(g, __tr2qs_ctx("Packet size:", "options"), KviOption_uintDccSendPacketSize, 16, 65536, 1024);
 	u->setSuffix(__tr2qs_ctx(" bytes", "options"));
 	mergeTip(u, __tr2qs_ctx("This parameter controls the packet size used for DCC SEND.<br>"
@@ -34,6 +34,8 @@
 #include "KviPointerHashTable.h"
 
 #include <QByteArray>
+#include <QHash>
+#include <QRegExp>
 
 #ifdef DEBUG
 #undef DEBUG
@@ -112,6 +114,15 @@ public:
 protected:
 	QString m_szContextName;
 	PerlInterpreter * m_pInterpreter;
+	// source code -> reference to the compiled anonymous sub
+	// (null if the code must be run by eval_pv() every time)
+	struct CompiledCode
+	{
+		SV * pSub;
+		quint64 uLastUse;
+	};
+	QHash<QString, CompiledCode> m_hCompiledCode;
+	quint64 m_uCompiledCodeUses;
 
 public:
 	bool init(); // if this fails then well.. :D
@@ -120,12 +131,20 @@ public:
 	const QString & contextName() const { return m_szContextName; };
 protected:
 	QString svToQString(SV * sv);
+	SV * compiledCode(const QString & szCode);
+	void clearCompiledCode();
+	void evalCode(const QString & szCode, QStringList & args, QString & szRetVal);
+	void callCode(SV * pSub, QStringList & args, QString & szRetVal);
 };
 
+// maximum number of compiled code snippets kept for each interpreter
+#define KVI_PERL_MAX_CACHED_CODE_SNIPPETS 128
+
 KviPerlInterpreter::KviPerlInterpreter(const QString & szContextName)
 {
 	m_szContextName = szContextName;
 	m_pInterpreter = nullptr;
+	m_uCompiledCodeUses = 0;
 }
 
 KviPerlInterpreter::~KviPerlInterpreter()
@@ -218,6 +237,7 @@ void KviPerlInterpreter::done()
 	if(!m_pInterpreter)
 		return;
 	PERL_SET_CONTEXT(m_pInterpreter);
+	clearCompiledCode();
 	PL_perl_destruct_level = 1;
 	perl_destruct(m_pInterpreter);
 	perl_free(m_pInterpreter);
@@ -236,42 +256,135 @@ QString KviPerlInterpreter::svToQString(SV * sv)
 	return ret;
 }
 
-bool KviPerlInterpreter::execute(
-    const QString & szCode,
-    QStringList & args,
-    QString & szRetVal,
-    QString & szError,
-    QStringList & lWarnings)
+void KviPerlInterpreter::clearCompiledCode()
 {
-	if(!m_pInterpreter)
+	// the perl context must be already set
+	for(auto & code : m_hCompiledCode)
 	{
-		szError = __tr2qs_ctx("Internal error: Perl interpreter not initialized", "perl");
-		return false;
+		if(code.pSub)
+			SvREFCNT_dec(code.pSub);
 	}
+	m_hCompiledCode.clear();
+}
 
-	g_lWarningList.clear();
+SV * KviPerlInterpreter::compiledCode(const QString & szCode)
+{
+	// the perl context must be already set
+	QHash<QString, CompiledCode>::iterator it = m_hCompiledCode.find(szCode);
+	if(it != m_hCompiledCode.end())
+	{
+		it.value().uLastUse = ++m_uCompiledCodeUses;
+		return it.value().pSub;
+	}
+
+	// Wrapping the code in a sub changes what some constructs mean:
+	// named subs would close over the file level lexicals only once
+	// and __END__, __DATA__ and POD can't appear inside a block.
+	// This code is run by eval_pv() as it has always been.
+	static QRegExp rxNotWrappable("\\bsub\\s+[A-Za-z_:']|\\b__(END|DATA)__\\b|(^|\\n)=[A-Za-z]");
+
+	SV * pSub = nullptr;
+	if(rxNotWrappable.indexIn(szCode) == -1)
+	{
+		// Compile the snippet once as an anonymous sub.
+		// The opening brace is on the first line so the line
+		// numbers in the warnings still match the user code.
+		int iWarnings = g_lWarningList.count();
+		QByteArray szUtf8 = (QString("sub {") + szCode + QString("\n}")).toUtf8();
+		pSub = eval_pv(szUtf8.data(), false);
+
+		// Anything but a clean compilation goes to eval_pv() too:
+		// it reports the errors and the warnings against the real code
+		bool bClean = pSub && SvROK(pSub) && (SvTYPE(SvRV(pSub)) == SVt_PVCV) && (g_lWarningList.count() == iWarnings);
+		SV * pErr = get_sv("@", false);
+		if(pErr && SvOK(pErr) && SvTRUE(pErr))
+			bClean = false;
+
+		while(g_lWarningList.count() > iWarnings)
+			g_lWarningList.removeLast();
+
+		// eval_pv() returns a temporary: keep our own reference to the sub
+		pSub = bClean ? newSVsv(pSub) : nullptr;
+	}
+
+	// don't let a script generating code on the fly eat up all the memory:
+	// drop the snippet that has not been used for the longest time
+	if(m_hCompiledCode.count() >= KVI_PERL_MAX_CACHED_CODE_SNIPPETS)
+	{
+		QHash<QString, CompiledCode>::iterator oldest = m_hCompiledCode.begin();
+		for(it = m_hCompiledCode.begin(); it != m_hCompiledCode.end(); ++it)
+		{
+			if(it.value().uLastUse < oldest.value().uLastUse)
+				oldest = it;
+		}
+		if(oldest.value().pSub)
+			SvREFCNT_dec(oldest.value().pSub);
+		m_hCompiledCode.erase(oldest);
+	}
+
+	CompiledCode code;
+	code.pSub = pSub;
+	code.uLastUse = ++m_uCompiledCodeUses;
+	m_hCompiledCode.insert(szCode, code);
+	return pSub;
+}
+
+void KviPerlInterpreter::callCode(SV * pSub, QStringList & args, QString & szRetVal)
+{
+	// the code may call back into KVS which may drop it from the cache
+	SvREFCNT_inc(pSub);
+
+	dSP;
+	ENTER;
+	SAVETMPS;
+
+	// the args are passed directly in @_
+	PUSHMARK(SP);
+	EXTEND(SP, args.count());
+	for(auto & tmp : args)
+	{
+		QByteArray szVal = tmp.toUtf8();
+		PUSHs(sv_2mortal(newSVpvn(szVal.data(), szVal.length())));
+	}
+	PUTBACK;
+
+	// call the code
+	I32 iCount = call_sv(pSub, G_SCALAR | G_EVAL);
+
+	SPAGAIN;
 
+	// get the ret value
+	if(iCount > 0)
+	{
+		SV * pRet = POPs;
+		if(pRet && SvOK(pRet))
+			szRetVal = svToQString(pRet);
+	}
+
+	PUTBACK;
+	FREETMPS;
+	LEAVE;
+
+	SvREFCNT_dec(pSub);
+}
+
+void KviPerlInterpreter::evalCode(const QString & szCode, QStringList & args, QString & szRetVal)
+{
 	QByteArray szUtf8 = szCode.toUtf8();
-	PERL_SET_CONTEXT(m_pInterpreter);
 
 	// clear the _ array
 	AV * pArgs = get_av("_", 1);
-	SV * pArg = av_shift(pArgs);
-	while(SvOK(pArg))
-	{
-		SvREFCNT_dec(pArg);
-		pArg = av_shift(pArgs);
-	}
+	av_clear(pArgs);
 
 	if(args.count() > 0)
 	{
-		// set the args in the _ arry
+		// set the args in the _ array
 		av_unshift(pArgs, (I32)args.count());
 		int idx = 0;
-		for(auto tmp : args)
+		for(auto & tmp : args)
 		{
 			QByteArray szVal = tmp.toUtf8();
-			pArg = newSVpv(szVal.data(), tmp.length());
+			SV * pArg = newSVpvn(szVal.data(), szVal.length());
 			if(!av_store(pArgs, idx, pArg))
 				SvREFCNT_dec(pArg);
 			idx++;
@@ -283,31 +396,46 @@ bool KviPerlInterpreter::execute(
 
 	// clear the _ array again
 	pArgs = get_av("_", 1);
-	pArg = av_shift(pArgs);
-	while(SvOK(pArg))
-	{
-		SvREFCNT_dec(pArg);
-		pArg = av_shift(pArgs);
-	}
 	av_undef(pArgs);
 
 	// get the ret value
-	if(pRet)
+	if(pRet && SvOK(pRet))
+		szRetVal = svToQString(pRet);
+}
+
+bool KviPerlInterpreter::execute(
+    const QString & szCode,
+    QStringList & args,
+    QString & szRetVal,
+    QString & szError,
+    QStringList & lWarnings)
+{
+	if(!m_pInterpreter)
 	{
-		if(SvOK(pRet))
-			szRetVal = svToQString(pRet);
+		szError = __tr2qs_ctx("Internal error: Perl interpreter not initialized", "perl");
+		return false;
 	}
 
+	g_lWarningList.clear();
+
+	PERL_SET_CONTEXT(m_pInterpreter);
+
+	SV * pSub = compiledCode(szCode);
+	if(pSub)
+		callCode(pSub, args, szRetVal);
+	else
+		evalCode(szCode, args, szRetVal);
+
 	if(!g_lWarningList.isEmpty())
 		lWarnings = g_lWarningList;
 
-	// and the eventual error string
-	pRet = get_sv("@", false);
-	if(pRet)
+	// and the eventual error string (either from the compilation or the execution)
+	SV * pErr = get_sv("@", false);
+	if(pErr)
 	{
-		if(SvOK(pRet))
+		if(SvOK(pErr))
 		{
-			szError = svToQString(pRet);
+			szError = svToQString(pErr);
 			if(!szError.isEmpty())
 				return false;
 		}
@@ -65,11 +65,28 @@ struct KviPythonInterpreterDeleter
 	}
 };
 
+struct KviQStringHash
+{
+	std::size_t operator()(const QString & s) const
+	{
+		return static_cast<std::size_t>(qHash(s));
+	}
+};
+
+// maximum number of compiled code objects kept for each interpreter
+#define KVI_PYTHON_MAX_CACHED_CODE_OBJECTS 128
+
 struct KviPythonInterpreter
 {
 	KviPythonInterpreter();
+	~KviPythonInterpreter();
 	bool execute(QString, QStringList &, QString &, QString &, QStringList &);
+	PyObject * compiledCode(const QString &);
+	void clearCompiledCode();
 	std::unique_ptr<PyThreadState, KviPythonInterpreterDeleter> m_uptrThreadState;
+	// source code -> code object (strong references) and the time it was last used
+	std::unordered_map<QString, std::pair<PyObject *, quint64>, KviQStringHash> m_CompiledCode;
+	quint64 m_uCompiledCodeUses = 0;
 };
 
 struct KviCaseInsensitiveQStringHash
@@ -105,6 +122,59 @@ KviPythonInterpreter::KviPythonInterpreter()
 	PyRun_SimpleString(szPreCode.toUtf8().data());
 }
 
+KviPythonInterpreter::~KviPythonInterpreter()
+{
+	if(!m_uptrThreadState || m_CompiledCode.empty())
+		return;
+
+	KviPythonLock lock{ m_uptrThreadState.get() };
+	clearCompiledCode();
+}
+
+void KviPythonInterpreter::clearCompiledCode()
+{
+	// the interpreter lock must be held by the caller
+	for(auto & i : m_CompiledCode)
+		Py_DECREF(i.second.first);
+	m_CompiledCode.clear();
+}
+
+PyObject * KviPythonInterpreter::compiledCode(const QString & szCode)
+{
+	// the interpreter lock must be held by the caller
+	const auto i = m_CompiledCode.find(szCode);
+	if(i != m_CompiledCode.end())
+	{
+		i->second.second = ++m_uCompiledCodeUses;
+		return i->second.first;
+	}
+
+	// clean "cr" from the python code (ticket #1028)
+	QString szClean = szCode;
+	szClean.replace(QRegExp("\r\n?"), "\n");
+
+	PyObject * pCode = Py_CompileString(szClean.toUtf8().data(), "<kvirc>", Py_file_input);
+	if(!pCode)
+		return nullptr;
+
+	// don't let a script generating code on the fly eat up all the memory:
+	// drop the code that has not been used for the longest time
+	if(m_CompiledCode.size() >= KVI_PYTHON_MAX_CACHED_CODE_OBJECTS)
+	{
+		auto oldest = m_CompiledCode.begin();
+		for(auto j = m_CompiledCode.begin(); j != m_CompiledCode.end(); ++j)
+		{
+			if(j->second.second < oldest->second.second)
+				oldest = j;
+		}
+		Py_DECREF(oldest->second.first);
+		m_CompiledCode.erase(oldest);
+	}
+
+	m_CompiledCode.emplace(szCode, std::make_pair(pCode, ++m_uCompiledCodeUses));
+	return pCode;
+}
+
 bool KviPythonInterpreter::execute(QString szCode, QStringList & lArgs,
     QString & szRetVal, QString & szError, QStringList &)
 {
@@ -118,27 +188,49 @@ bool KviPythonInterpreter::execute(QString szCode, QStringList & lArgs,
 
 	KviPythonLock lock{ m_uptrThreadState.get() };
 
-	QString szVarCode = "aArgs = [";
-
-	bool bFirst = true;
-	foreach(QString szArg, lArgs)
+	// this is a borrowed reference, as is the dictionary
+	PyObject * pMain = PyImport_AddModule("__main__");
+	if(!pMain)
 	{
-		if(!bFirst)
-			szVarCode += ",";
-		else
-			bFirst = false;
+		PyErr_Print();
+		szRetVal.setNum(-1);
+		szError = g_lError;
+		return false;
+	}
 
-		szVarCode += QString::fromLatin1("\"%1\"").arg(szArg);
+	PyObject * pGlobals = PyModule_GetDict(pMain);
+
+	// pass the arguments as a real list instead of generating source for it
+	PyObject * pArgs = PyList_New(lArgs.count());
+	Py_ssize_t idx = 0;
+	for(auto & szArg : lArgs)
+	{
+		QByteArray szUtf8 = szArg.toUtf8();
+		PyList_SET_ITEM(pArgs, idx++, PyUnicode_DecodeUTF8(szUtf8.data(), szUtf8.size(), "replace"));
 	}
+	PyDict_SetItemString(pGlobals, "aArgs", pArgs);
+	Py_DECREF(pArgs);
 
-	szVarCode += "]";
+	int retVal = -1;
 
-	PyRun_SimpleString(szVarCode.toUtf8().data());
+	PyObject * pCode = compiledCode(szCode);
+	if(pCode)
+	{
+		// the code may call back into KVS which may drop it from the cache
+		Py_INCREF(pCode);
+		PyObject * pResult = PyEval_EvalCode(pCode, pGlobals, pGlobals);
+		Py_DECREF(pCode);
 
-	// clean "cr" from the python code (ticket #1028)
-	szCode.replace(QRegExp("\r\n?"), "\n");
+		if(pResult)
+		{
+			Py_DECREF(pResult);
+			retVal = 0;
+		}
+	}
 
-	int retVal = PyRun_SimpleString(szCode.toUtf8().data());
+	// this is what PyRun_SimpleString() does: the error ends up in g_lError
+	if(retVal)
+		PyErr_Print();
 
 	szRetVal.setNum(retVal);
 
@@ -0,0 +1,136 @@
+//=============================================================================
+//
+//   File : ReplayCapture.cpp
+//   Creation date : Mon 19 Oct 2026 21:04:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ReplayCapture.h"
+
+#include "KviLocale.h"
+
+#include <QDataStream>
+
+#include <unordered_set>
+
+extern std::unordered_set<ReplayRecorder *> g_pReplayRecorderList;
+
+bool ReplayCapture::load(const QString & szFileName, QVector<ReplayRecord> & lRecords, QString & szError, bool bIncomingOnly)
+{
+	QFile f(szFileName);
+	if(!f.open(QFile::ReadOnly))
+	{
+		szError = __tr2qs_ctx("Can't open the capture file '%1' for reading", "replay").arg(szFileName);
+		return false;
+	}
+
+	char magic[8];
+	QDataStream s(&f);
+	quint32 uVersion = 0;
+	if((s.readRawData(magic, 8) != 8) || (qstrncmp(magic, REPLAY_CAPTURE_MAGIC, 8) != 0))
+	{
+		szError = __tr2qs_ctx("The file '%1' is not a KVIrc capture", "replay").arg(szFileName);
+		return false;
+	}
+	s >> uVersion;
+	if(uVersion != REPLAY_CAPTURE_VERSION)
+	{
+		szError = __tr2qs_ctx("Unsupported capture version %1", "replay").arg(uVersion);
+		return false;
+	}
+
+	while(!s.atEnd())
+	{
+		ReplayRecord r;
+		quint16 uLength;
+		s >> r.uDirection >> r.uMsecs >> uLength;
+		if(s.status() != QDataStream::Ok)
+			break; // truncated (the recording client crashed?): keep what we have
+		r.szLine.resize(uLength);
+		if(s.readRawData(r.szLine.data(), uLength) != uLength)
+			break;
+		if(bIncomingOnly && (r.uDirection != ReplayRecord::Incoming))
+			continue;
+		lRecords.append(r);
+	}
+	return true;
+}
+
+ReplayRecorder::ReplayRecorder(KviIrcContext * pContext)
+    : KviIrcDataStreamMonitor(pContext)
+{
+	g_pReplayRecorderList.insert(this);
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+	g_pReplayRecorderList.erase(this);
+	if(m_File.isOpen())
+		m_File.close();
+}
+
+bool ReplayRecorder::open(const QString & szFileName, QString & szError)
+{
+	m_File.setFileName(szFileName);
+	if(!m_File.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		szError = __tr2qs_ctx("Can't open the capture file '%1' for writing", "replay").arg(szFileName);
+		return false;
+	}
+	QDataStream s(&m_File);
+	s.writeRawData(REPLAY_CAPTURE_MAGIC, 8);
+	s << (quint32)REPLAY_CAPTURE_VERSION;
+	m_Timer.start();
+	return true;
+}
+
+void ReplayRecorder::write(ReplayRecord::Direction eDirection, const char * pcMessage)
+{
+	if(!m_File.isOpen())
+		return;
+	int iLength = qstrlen(pcMessage);
+	while((iLength > 0) && ((pcMessage[iLength - 1] == '\r') || (pcMessage[iLength - 1] == '\n')))
+		iLength--;
+	if(iLength > 0xffff)
+		iLength = 0xffff; // proxy binary junk, most likely
+	QDataStream s(&m_File);
+	s << (quint8)eDirection << (quint32)m_Timer.elapsed() << (quint16)iLength;
+	s.writeRawData(pcMessage, iLength);
+}
+
+bool ReplayRecorder::incomingMessage(const char * pcMessage)
+{
+	write(ReplayRecord::Incoming, pcMessage);
+	m_uIncoming++;
+	return false;
+}
+
+bool ReplayRecorder::outgoingMessage(const char * pcMessage)
+{
+	write(ReplayRecord::Outgoing, pcMessage);
+	m_uOutgoing++;
+	return false;
+}
+
+void ReplayRecorder::die()
+{
+	// the context is going away
+	delete this;
+}
@@ -0,0 +1,97 @@
+#ifndef _REPLAYCAPTURE_H_
+#define _REPLAYCAPTURE_H_
+//=============================================================================
+//
+//   File : ReplayCapture.h
+//   Creation date : Mon 19 Oct 2026 21:04:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcDataStreamMonitor.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+class KviIrcContext;
+
+//
+// Capture file format
+//
+// "KVIRCRAW" | quint32 version | records...
+//
+// record: quint8 direction | quint32 msecs since the capture start | quint16 length | length bytes
+//
+// All the integers are big endian (QDataStream default).
+// The lines are stored raw (not decoded) and without the CRLF terminator.
+//
+
+#define REPLAY_CAPTURE_MAGIC "KVIRCRAW"
+#define REPLAY_CAPTURE_VERSION 1
+
+struct ReplayRecord
+{
+	enum Direction
+	{
+		Incoming = 0,
+		Outgoing = 1
+	};
+	quint8 uDirection;
+	quint32 uMsecs;
+	QByteArray szLine;
+};
+
+class ReplayCapture
+{
+public:
+	// Loads the incoming lines of the capture file. Returns false and sets szError on failure.
+	static bool load(const QString & szFileName, QVector<ReplayRecord> & lRecords, QString & szError, bool bIncomingOnly = true);
+};
+
+class ReplayRecorder : public KviIrcDataStreamMonitor
+{
+public:
+	ReplayRecorder(KviIrcContext * pContext);
+	~ReplayRecorder();
+
+protected:
+	QFile m_File;
+	QElapsedTimer m_Timer;
+	unsigned int m_uIncoming = 0;
+	unsigned int m_uOutgoing = 0;
+
+public:
+	KviIrcContext * context() const { return m_pMyContext; }
+	bool open(const QString & szFileName, QString & szError);
+	QString fileName() const { return m_File.fileName(); }
+	unsigned int incomingCount() const { return m_uIncoming; }
+	unsigned int outgoingCount() const { return m_uOutgoing; }
+
+	bool incomingMessage(const char * pcMessage) override;
+	bool outgoingMessage(const char * pcMessage) override;
+	void die() override;
+
+protected:
+	void write(ReplayRecord::Direction eDirection, const char * pcMessage);
+};
+
+#endif //_REPLAYCAPTURE_H_
@@ -0,0 +1,358 @@
+//=============================================================================
+//
+//   File : ReplayServer.cpp
+//   Creation date : Mon 19 Oct 2026 21:04:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ReplayServer.h"
+
+#include "KviConsoleWindow.h"
+#include "KviIrcContext.h"
+#include "KviLocale.h"
+#include "kvi_out.h"
+
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+#include <sys/resource.h>
+#endif
+
+// in max speed mode we keep at most this much data in the socket buffers
+#define REPLAY_MAX_PENDING_BYTES 262144
+
+extern ReplayServer * g_pReplayServer;
+
+// returns the peak resident set size of the process in KiB or -1 if it's not known
+static qint64 replay_peak_rss()
+{
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+	return -1; // would need psapi
+#else
+	struct rusage ru;
+	if(getrusage(RUSAGE_SELF, &ru) != 0)
+		return -1;
+#ifdef COMPILE_ON_MAC
+	return ru.ru_maxrss / 1024; // in bytes here
+#else
+	return ru.ru_maxrss;
+#endif
+#endif
+}
+
+ReplayHistogram::ReplayHistogram()
+{
+	for(auto & u : m_uBuckets)
+		u = 0;
+	m_uCount = 0;
+	m_iTotalNs = 0;
+	m_iMaxNs = 0;
+}
+
+void ReplayHistogram::add(qint64 iNanoseconds)
+{
+	if(iNanoseconds < 0)
+		iNanoseconds = 0;
+	// bucket i holds values in [2^(i-1),2^i) microseconds, bucket 0 is below 1 us
+	quint64 uMicros = iNanoseconds / 1000;
+	int i = 0;
+	while(uMicros && (i < (BucketCount - 1)))
+	{
+		uMicros >>= 1;
+		i++;
+	}
+	m_uBuckets[i]++;
+	m_uCount++;
+	m_iTotalNs += iNanoseconds;
+	if(iNanoseconds > m_iMaxNs)
+		m_iMaxNs = iNanoseconds;
+}
+
+quint64 ReplayHistogram::percentile(double dPercentile) const
+{
+	quint64 uThreshold = (quint64)(m_uCount * dPercentile);
+	quint64 uSeen = 0;
+	for(int i = 0; i < BucketCount; i++)
+	{
+		uSeen += m_uBuckets[i];
+		if(uSeen > uThreshold)
+			return ((quint64)1) << i;
+	}
+	return ((quint64)1) << (BucketCount - 1);
+}
+
+QString ReplayHistogram::summary() const
+{
+	if(!m_uCount)
+		return __tr2qs_ctx("no samples", "replay");
+
+	QString szRet = __tr2qs_ctx("avg %1 us, p50 < %2 us, p90 < %3 us, p99 < %4 us, max %5 us", "replay")
+	                    .arg(m_iTotalNs / (qint64)m_uCount / 1000)
+	                    .arg(percentile(0.5))
+	                    .arg(percentile(0.9))
+	                    .arg(percentile(0.99))
+	                    .arg(m_iMaxNs / 1000);
+
+	szRet += " |";
+	for(int i = 0; i < BucketCount; i++)
+	{
+		if(m_uBuckets[i])
+			szRet += QString(" <%1:%2").arg(((quint64)1) << i).arg(m_uBuckets[i]);
+	}
+	return szRet;
+}
+
+ReplayBenchmark::ReplayBenchmark(KviIrcContext * pContext, ReplayServer * pServer)
+    : KviIrcDataStreamMonitor(pContext), m_pServer(pServer)
+{
+	m_Timer.start();
+}
+
+ReplayBenchmark::~ReplayBenchmark()
+{
+	if(m_pServer)
+		m_pServer->benchmarkDestroyed();
+}
+
+void ReplayBenchmark::reset()
+{
+	m_iFirstLineNs = -1;
+	m_iLastLineNs = 0;
+	m_uLines = 0;
+	m_uBytes = 0;
+	m_Delivery = ReplayHistogram();
+	m_Processing = ReplayHistogram();
+}
+
+bool ReplayBenchmark::incomingMessage(const char * pcMessage)
+{
+	qint64 iNow = m_Timer.nsecsElapsed();
+	if(m_iFirstLineNs < 0)
+		m_iFirstLineNs = iNow;
+	m_uLines++;
+	m_uBytes += qstrlen(pcMessage) + 2;
+
+	if(m_pServer)
+	{
+		qint64 iSentAt = m_pServer->takeSentTime();
+		if(iSentAt >= 0)
+			m_Delivery.add(m_pServer->m_Clock.nsecsElapsed() - iSentAt);
+	}
+	return false;
+}
+
+void ReplayBenchmark::incomingMessageProcessed(const char *, qint64 iNanoseconds)
+{
+	m_Processing.add(iNanoseconds);
+	m_iLastLineNs = m_Timer.nsecsElapsed();
+}
+
+void ReplayBenchmark::connectionTerminated()
+{
+	// the client has seen the end of the stream (or has given up): everything has been processed
+	if(m_pServer)
+		m_pServer->finish();
+}
+
+void ReplayBenchmark::report(KviConsoleWindow * pOut)
+{
+	double dSeconds = (m_iFirstLineNs >= 0) ? (m_iLastLineNs - m_iFirstLineNs) / 1000000000.0 : 0.0;
+	double dRate = (dSeconds > 0.0) ? m_uLines / dSeconds : 0.0;
+
+	pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Replay: %1 lines (%2 bytes) in %3 s, %4 lines/s", "replay").arg(m_uLines).arg(m_uBytes).arg(dSeconds, 0, 'f', 3).arg(dRate, 0, 'f', 0));
+	pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Replay delivery latency (socket to dispatch): %1", "replay").arg(m_Delivery.summary()));
+	pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Replay processing time (parser, events, output): %1", "replay").arg(m_Processing.summary()));
+
+	qint64 iRss = replay_peak_rss();
+	if(iRss >= 0)
+		pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Replay peak RSS: %1 KiB", "replay").arg(iRss));
+}
+
+void ReplayBenchmark::die()
+{
+	// the context is going away
+	delete this;
+}
+
+ReplayServer::ReplayServer(KviConsoleWindow * pConsole, bool bRealTime)
+    : QObject(), m_pConsole(pConsole), m_bRealTime(bRealTime)
+{
+	g_pReplayServer = this;
+	m_pListener = new QTcpServer(this);
+	connect(m_pListener, SIGNAL(newConnection()), this, SLOT(newConnection()));
+	m_pTimer = new QTimer(this);
+	m_pTimer->setSingleShot(true);
+	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(feed()));
+}
+
+ReplayServer::~ReplayServer()
+{
+	if(m_pBenchmark)
+	{
+		m_pBenchmark->serverDestroyed();
+		delete m_pBenchmark;
+	}
+	if(g_pReplayServer == this)
+		g_pReplayServer = nullptr;
+}
+
+bool ReplayServer::load(const QString & szFileName, QString & szError)
+{
+	if(!ReplayCapture::load(szFileName, m_lRecords, szError))
+		return false;
+	if(m_lRecords.isEmpty())
+	{
+		szError = __tr2qs_ctx("The capture '%1' contains no incoming data", "replay").arg(szFileName);
+		return false;
+	}
+	return true;
+}
+
+bool ReplayServer::listen(quint16 uPort, QString & szError)
+{
+	if(!m_pListener->listen(QHostAddress::LocalHost, uPort))
+	{
+		szError = m_pListener->errorString();
+		return false;
+	}
+	return true;
+}
+
+quint16 ReplayServer::port() const
+{
+	return m_pListener->serverPort();
+}
+
+qint64 ReplayServer::takeSentTime()
+{
+	if(m_lSentAt.empty())
+		return -1;
+	qint64 iRet = m_lSentAt.front();
+	m_lSentAt.pop_front();
+	return iRet;
+}
+
+void ReplayServer::newConnection()
+{
+	QTcpSocket * pSocket = m_pListener->nextPendingConnection();
+	if(!pSocket)
+		return;
+	if(m_pClient || !m_pConsole)
+	{
+		// a single playback per server
+		pSocket->abort();
+		pSocket->deleteLater();
+		return;
+	}
+
+	m_pClient = pSocket;
+	m_pListener->close(); // don't accept anyone else
+	connect(m_pClient, SIGNAL(readyRead()), this, SLOT(discardClientData()));
+	connect(m_pClient, SIGNAL(bytesWritten(qint64)), this, SLOT(feed()));
+	connect(m_pClient, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+
+	m_pBenchmark = new ReplayBenchmark(m_pConsole->context(), this);
+	m_Clock.start();
+	feed();
+}
+
+void ReplayServer::discardClientData()
+{
+	// we don't care about what the client says: the capture goes on anyway
+	if(m_pClient)
+		m_pClient->readAll();
+}
+
+void ReplayServer::feed()
+{
+	if(!m_pClient)
+		return;
+
+	qint64 iBaseMsecs = m_lRecords.first().uMsecs;
+
+	while(m_iNextRecord < m_lRecords.count())
+	{
+		const ReplayRecord & r = m_lRecords.at(m_iNextRecord);
+		if(m_bRealTime)
+		{
+			qint64 iDue = (qint64)r.uMsecs - iBaseMsecs;
+			qint64 iNow = m_Clock.elapsed();
+			if(iDue > iNow)
+			{
+				m_pTimer->start(iDue - iNow);
+				return;
+			}
+		}
+		else
+		{
+			if(m_pClient->bytesToWrite() > REPLAY_MAX_PENDING_BYTES)
+				return; // wait for bytesWritten()
+		}
+
+		m_pClient->write(r.szLine);
+		m_pClient->write("\r\n", 2);
+		m_lSentAt.push_back(m_Clock.nsecsElapsed());
+		m_iNextRecord++;
+	}
+
+	// all sent: close when flushed
+	if(m_pClient->bytesToWrite() == 0)
+		m_pClient->disconnectFromHost();
+}
+
+void ReplayServer::clientDisconnected()
+{
+	// our side of the link is closed: the client may still be chewing the data,
+	// the report is printed when it sees the end of the stream.
+	m_pTimer->stop();
+	if(m_pClient)
+	{
+		m_pClient->disconnect(this);
+		m_pClient->deleteLater();
+		m_pClient = nullptr;
+	}
+}
+
+void ReplayServer::benchmarkDestroyed()
+{
+	// the IRC context died
+	m_pBenchmark = nullptr;
+	finish();
+}
+
+void ReplayServer::finish()
+{
+	if(m_bFinished)
+		return;
+	m_bFinished = true;
+
+	if(m_pBenchmark && m_pConsole)
+	{
+		if(m_iNextRecord < m_lRecords.count())
+			m_pConsole->output(KVI_OUT_SYSTEMWARNING, __tr2qs_ctx("Replay interrupted after %1 of %2 lines", "replay").arg(m_iNextRecord).arg(m_lRecords.count()));
+		m_pBenchmark->report(m_pConsole);
+	}
+	clientDisconnected();
+	m_pListener->close();
+	deleteLater();
+}
@@ -0,0 +1,144 @@
+#ifndef _REPLAYSERVER_H_
+#define _REPLAYSERVER_H_
+//=============================================================================
+//
+//   File : ReplayServer.h
+//   Creation date : Mon 19 Oct 2026 21:04:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ReplayCapture.h"
+#include "KviIrcDataStreamMonitor.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+
+#include <deque>
+
+class KviConsoleWindow;
+class KviIrcContext;
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+class ReplayServer;
+
+//
+// Latency histogram with power of two buckets (in microseconds)
+//
+class ReplayHistogram
+{
+public:
+	ReplayHistogram();
+
+protected:
+	enum
+	{
+		BucketCount = 32
+	};
+	quint64 m_uBuckets[BucketCount];
+	quint64 m_uCount;
+	qint64 m_iTotalNs;
+	qint64 m_iMaxNs;
+
+public:
+	void add(qint64 iNanoseconds);
+	quint64 count() const { return m_uCount; }
+	// upper bound of the bucket containing the given percentile, in microseconds
+	quint64 percentile(double dPercentile) const;
+	QString summary() const;
+};
+
+//
+// Watches the IRC context connected to the replay server and measures the receive pipeline
+//
+class ReplayBenchmark : public KviIrcDataStreamMonitor
+{
+public:
+	ReplayBenchmark(KviIrcContext * pContext, ReplayServer * pServer);
+	~ReplayBenchmark();
+
+protected:
+	ReplayServer * m_pServer; // may be null if the server is already gone
+	QElapsedTimer m_Timer;
+	qint64 m_iFirstLineNs = -1;
+	qint64 m_iLastLineNs = 0;
+	quint64 m_uLines = 0;
+	quint64 m_uBytes = 0;
+	ReplayHistogram m_Delivery;   // server write -> client line dispatch (socket, event loop, line splitting)
+	ReplayHistogram m_Processing; // parser, events, scripts and view output
+
+public:
+	void serverDestroyed() { m_pServer = nullptr; }
+	void reset();
+	void report(KviConsoleWindow * pOut);
+
+	bool incomingMessage(const char * pcMessage) override;
+	bool outgoingMessage(const char *) override { return false; }
+	void incomingMessageProcessed(const char * pcMessage, qint64 iNanoseconds) override;
+	void connectionTerminated() override;
+	void die() override;
+};
+
+//
+// A fake IRC server on the loopback interface that plays back a capture
+//
+class ReplayServer : public QObject
+{
+	friend class ReplayBenchmark;
+	Q_OBJECT
+public:
+	ReplayServer(KviConsoleWindow * pConsole, bool bRealTime);
+	~ReplayServer();
+
+protected:
+	QPointer<KviConsoleWindow> m_pConsole;
+	ReplayBenchmark * m_pBenchmark = nullptr;
+	QTcpServer * m_pListener;
+	QTcpSocket * m_pClient = nullptr;
+	QTimer * m_pTimer;
+	bool m_bRealTime;
+	QVector<ReplayRecord> m_lRecords;
+	int m_iNextRecord = 0;
+	bool m_bFinished = false;
+	QElapsedTimer m_Clock;    // shared with the benchmark: both run in this process
+	std::deque<qint64> m_lSentAt; // write times of the lines not dispatched yet
+
+public:
+	bool load(const QString & szFileName, QString & szError);
+	bool listen(quint16 uPort, QString & szError);
+	quint16 port() const;
+	int lineCount() const { return m_lRecords.count(); }
+	void benchmarkDestroyed();
+	// prints the report and schedules the destruction of the server
+	void finish();
+
+protected:
+	qint64 takeSentTime();
+protected slots:
+	void newConnection();
+	void clientDisconnected();
+	void discardClientData();
+	void feed();
+};
+
+#endif //_REPLAYSERVER_H_
@@ -0,0 +1,246 @@
+//=============================================================================
+//
+//   File : libkvireplay.cpp
+//   Creation date : Mon 19 Oct 2026 21:04:37 by the KVIrc development team
+//
+//   This file is part of the KVIrc IRC Client distribution
+//   Copyright (C) 2026 The KVIrc development team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ReplayCapture.h"
+#include "ReplayServer.h"
+
+#include "KviModule.h"
+#include "KviConsoleWindow.h"
+#include "KviIrcContext.h"
+#include "KviKvsScript.h"
+#include "KviLocale.h"
+#include "kvi_out.h"
+
+#include <unordered_set>
+
+std::unordered_set<ReplayRecorder *> g_pReplayRecorderList;
+ReplayServer * g_pReplayServer = nullptr;
+
+static ReplayRecorder * replay_find_recorder(KviIrcContext * pContext)
+{
+	for(auto & r : g_pReplayRecorderList)
+	{
+		if(r->context() == pContext)
+			return r;
+	}
+	return nullptr;
+}
+
+/*
+	@doc: replay.record
+	@type:
+		command
+	@title:
+		replay.record
+	@short:
+		Records the IRC traffic of the current IRC context
+	@syntax:
+		replay.record <filename:string>
+	@description:
+		Starts recording the raw incoming and outgoing IRC traffic
+		of the current IRC context to <filename>. Each line is stored
+		with its direction and the time it was seen, so the capture
+		can be played back later with [cmd]replay.play[/cmd].[br]
+		The recording goes on until [cmd]replay.stop[/cmd] is called
+		or the IRC context is destroyed.[br]
+		Keep in mind that the capture contains everything, passwords included.
+	@seealso:
+		[cmd]replay.stop[/cmd], [cmd]replay.play[/cmd]
+*/
+
+static bool replay_kvs_cmd_record(KviKvsModuleCommandCall * c)
+{
+	QString szFileName;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("filename", KVS_PT_NONEMPTYSTRING, 0, szFileName)
+	KVSM_PARAMETERS_END(c)
+
+	if(!c->window()->console())
+		return c->context()->errorNoIrcContext();
+
+	KviIrcContext * pContext = c->window()->console()->context();
+	if(replay_find_recorder(pContext))
+	{
+		c->warning(__tr2qs_ctx("This IRC context is already being recorded", "replay"));
+		return true;
+	}
+
+	ReplayRecorder * r = new ReplayRecorder(pContext);
+	QString szError;
+	if(!r->open(szFileName, szError))
+	{
+		delete r;
+		c->warning(szError);
+		return true;
+	}
+
+	c->window()->console()->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Recording the IRC traffic to %1", "replay").arg(szFileName));
+	return true;
+}
+
+/*
+	@doc: replay.stop
+	@type:
+		command
+	@title:
+		replay.stop
+	@short:
+		Stops recording the IRC traffic
+	@syntax:
+		replay.stop
+	@description:
+		Stops the recording started with [cmd]replay.record[/cmd]
+		in the current IRC context.
+	@seealso:
+		[cmd]replay.record[/cmd]
+*/
+
+static bool replay_kvs_cmd_stop(KviKvsModuleCommandCall * c)
+{
+	if(!c->window()->console())
+		return c->context()->errorNoIrcContext();
+
+	ReplayRecorder * r = replay_find_recorder(c->window()->console()->context());
+	if(!r)
+	{
+		c->warning(__tr2qs_ctx("This IRC context is not being recorded", "replay"));
+		return true;
+	}
+
+	c->window()->console()->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Recorded %1 incoming and %2 outgoing lines to %3", "replay").arg(r->incomingCount()).arg(r->outgoingCount()).arg(r->fileName()));
+	delete r;
+	return true;
+}
+
+/*
+	@doc: replay.play
+	@type:
+		command
+	@title:
+		replay.play
+	@short:
+		Plays back a capture and measures the receive pipeline
+	@syntax:
+		replay.play [-r] [-p=<port:uint>] <filename:string>
+	@switches:
+		!sw: -r | --realtime
+		Send the lines with the original timing instead of as fast as possible.
+		!sw: -p=<port:uint> | --port=<port:uint>
+		Listen on the specified port instead of a random one.
+	@description:
+		Starts a fake IRC server on the loopback interface that sends
+		the incoming lines of a capture made with [cmd]replay.record[/cmd]
+		and connects the current IRC context to it.[br]
+		Whatever the client sends is ignored. When the client has
+		processed the whole capture (or the connection is closed) a report
+		is printed in the console: lines per second, the histogram of
+		the delivery latency (from the server write to the line dispatch:
+		socket, event loop and line splitting), the histogram of
+		the processing time (parser, events, scripts and output) and
+		the peak memory usage of the process.[br]
+		Run the same capture before and after a change to compare them.
+	@examples:
+		[example]
+			replay.record /tmp/freenode.kvr
+			// ...later...
+			replay.stop
+			replay.play /tmp/freenode.kvr
+		[/example]
+	@seealso:
+		[cmd]replay.record[/cmd]
+*/
+
+static bool replay_kvs_cmd_play(KviKvsModuleCommandCall * c)
+{
+	QString szFileName;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("filename", KVS_PT_NONEMPTYSTRING, 0, szFileName)
+	KVSM_PARAMETERS_END(c)
+
+	KviConsoleWindow * pConsole = c->window()->console();
+	if(!pConsole)
+		return c->context()->errorNoIrcContext();
+
+	if(g_pReplayServer)
+	{
+		c->warning(__tr2qs_ctx("Another capture is being played", "replay"));
+		return true;
+	}
+
+	kvs_int_t iPort = 0;
+	if(KviKvsVariant * pPort = c->switches()->find('p', "port"))
+	{
+		if(!pPort->asInteger(iPort) || (iPort < 0) || (iPort > 65535))
+		{
+			c->warning(__tr2qs_ctx("Invalid port number", "replay"));
+			return true;
+		}
+	}
+
+	ReplayServer * pServer = new ReplayServer(pConsole, c->switches()->find('r', "realtime"));
+	QString szError;
+	if(!pServer->load(szFileName, szError) || !pServer->listen((quint16)iPort, szError))
+	{
+		delete pServer;
+		c->warning(szError);
+		return true;
+	}
+
+	pConsole->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Playing %1 lines on 127.0.0.1 port %2", "replay").arg(pServer->lineCount()).arg(pServer->port()));
+	KviKvsScript::run(QString("server 127.0.0.1 %1").arg(pServer->port()), pConsole);
+	return true;
+}
+
+static bool replay_module_init(KviModule * m)
+{
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "record", replay_kvs_cmd_record);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "stop", replay_kvs_cmd_stop);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "play", replay_kvs_cmd_play);
+	return true;
+}
+
+static bool replay_module_cleanup(KviModule *)
+{
+	while(!g_pReplayRecorderList.empty())
+		delete *g_pReplayRecorderList.begin();
+	if(g_pReplayServer)
+		delete g_pReplayServer;
+	return true;
+}
+
+static bool replay_module_can_unload(KviModule *)
+{
+	return g_pReplayRecorderList.empty() && !g_pReplayServer;
+}
+
+KVIRC_MODULE(
+    "Replay",                                        // module name
+    "4.0.0",                                         // module version
+    "Copyright (C) 2026 The KVIrc development team", // author & (C)
+    "IRC traffic recorder and benchmark replayer",
+    replay_module_init,
+    replay_module_can_unload,
+    0,
+    replay_module_cleanup,
+    0)
@@ -64,6 +64,19 @@
 //#include <stdio.h>
 //#include <stdlib.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPILE_RIJNDAEL_AESNI
+#include <cpuid.h>
+#include <wmmintrin.h>
+// the rest of the module is not built with -maes: enable the instructions only here
+#define RIJNDAEL_AESNI_FUNCTION __attribute__((target("aes,sse2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define COMPILE_RIJNDAEL_AESNI
+#include <intrin.h>
+#include <wmmintrin.h>
+#define RIJNDAEL_AESNI_FUNCTION
+#endif
+
 static UINT8 S[256] = {
 	99, 124, 119, 123, 242, 107, 111, 197, 48, 1, 103, 43, 254, 215, 171, 118,
 	202, 130, 201, 125, 250, 89, 71, 240, 173, 212, 162, 175, 156, 164, 114, 192,
@@ -962,6 +975,115 @@ static UINT32 rcon[30] = {
 	0xb3, 0x7d, 0xfa, 0xef, 0xc5, 0x91
 };
 
+//
+// AES instructions
+//
+// The round keys computed by keySched() are stored in the standard byte order
+// and keyEncToDec() applies InvMixColumns to the inner ones: these are
+// exactly the keys that AESENC and AESDEC (the "equivalent inverse cipher") expect.
+//
+
+#ifdef COMPILE_RIJNDAEL_AESNI
+
+static bool rijndael_cpu_has_aes_instructions()
+{
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 1);
+	return (regs[2] & (1 << 25)) != 0;
+#else
+	unsigned int a, b, c, d;
+	if(!__get_cpuid(1, &a, &b, &c, &d))
+		return false;
+	return (c & bit_AES) != 0;
+#endif
+}
+
+// Four independent blocks are kept in flight: the instructions have a latency
+// of several cycles but can be issued every cycle.
+
+RIJNDAEL_AESNI_FUNCTION static void rijndael_aesni_encrypt_blocks(const UINT8 * rk, int iRounds, const UINT8 * input, UINT8 * outBuffer, int numBlocks)
+{
+	__m128i k[_MAX_ROUNDS + 1];
+	for(int r = 0; r <= iRounds; r++)
+		k[r] = _mm_loadu_si128((const __m128i *)(rk + 16 * r));
+
+	while(numBlocks >= 4)
+	{
+		__m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), k[0]);
+		__m128i b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 16)), k[0]);
+		__m128i b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 32)), k[0]);
+		__m128i b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 48)), k[0]);
+		for(int r = 1; r < iRounds; r++)
+		{
+			b0 = _mm_aesenc_si128(b0, k[r]);
+			b1 = _mm_aesenc_si128(b1, k[r]);
+			b2 = _mm_aesenc_si128(b2, k[r]);
+			b3 = _mm_aesenc_si128(b3, k[r]);
+		}
+		_mm_storeu_si128((__m128i *)outBuffer, _mm_aesenclast_si128(b0, k[iRounds]));
+		_mm_storeu_si128((__m128i *)(outBuffer + 16), _mm_aesenclast_si128(b1, k[iRounds]));
+		_mm_storeu_si128((__m128i *)(outBuffer + 32), _mm_aesenclast_si128(b2, k[iRounds]));
+		_mm_storeu_si128((__m128i *)(outBuffer + 48), _mm_aesenclast_si128(b3, k[iRounds]));
+		input += 64;
+		outBuffer += 64;
+		numBlocks -= 4;
+	}
+
+	while(numBlocks > 0)
+	{
+		__m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), k[0]);
+		for(int r = 1; r < iRounds; r++)
+			b0 = _mm_aesenc_si128(b0, k[r]);
+		_mm_storeu_si128((__m128i *)outBuffer, _mm_aesenclast_si128(b0, k[iRounds]));
+		input += 16;
+		outBuffer += 16;
+		numBlocks--;
+	}
+}
+
+RIJNDAEL_AESNI_FUNCTION static void rijndael_aesni_decrypt_blocks(const UINT8 * rk, int iRounds, const UINT8 * input, UINT8 * outBuffer, int numBlocks)
+{
+	__m128i k[_MAX_ROUNDS + 1];
+	for(int r = 0; r <= iRounds; r++)
+		k[r] = _mm_loadu_si128((const __m128i *)(rk + 16 * r));
+
+	while(numBlocks >= 4)
+	{
+		__m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), k[iRounds]);
+		__m128i b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 16)), k[iRounds]);
+		__m128i b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 32)), k[iRounds]);
+		__m128i b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 48)), k[iRounds]);
+		for(int r = iRounds - 1; r > 0; r--)
+		{
+			b0 = _mm_aesdec_si128(b0, k[r]);
+			b1 = _mm_aesdec_si128(b1, k[r]);
+			b2 = _mm_aesdec_si128(b2, k[r]);
+			b3 = _mm_aesdec_si128(b3, k[r]);
+		}
+		_mm_storeu_si128((__m128i *)outBuffer, _mm_aesdeclast_si128(b0, k[0]));
+		_mm_storeu_si128((__m128i *)(outBuffer + 16), _mm_aesdeclast_si128(b1, k[0]));
+		_mm_storeu_si128((__m128i *)(outBuffer + 32), _mm_aesdeclast_si128(b2, k[0]));
+		_mm_storeu_si128((__m128i *)(outBuffer + 48), _mm_aesdeclast_si128(b3, k[0]));
+		input += 64;
+		outBuffer += 64;
+		numBlocks -= 4;
+	}
+
+	while(numBlocks > 0)
+	{
+		__m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), k[iRounds]);
+		for(int r = iRounds - 1; r > 0; r--)
+			b0 = _mm_aesdec_si128(b0, k[r]);
+		_mm_storeu_si128((__m128i *)outBuffer, _mm_aesdeclast_si128(b0, k[0]));
+		input += 16;
+		outBuffer += 16;
+		numBlocks--;
+	}
+}
+
+#endif // COMPILE_RIJNDAEL_AESNI
+
 //
 // API
 //
@@ -969,6 +1091,51 @@ static UINT32 rcon[30] = {
 Rijndael::Rijndael()
 {
 	m_state = Invalid;
+	m_bUseHardware = false;
+}
+
+bool Rijndael::hardwareAvailable()
+{
+#ifdef COMPILE_RIJNDAEL_AESNI
+	static const bool bAvailable = rijndael_cpu_has_aes_instructions();
+	return bAvailable;
+#else
+	return false;
+#endif
+}
+
+void Rijndael::encryptBlocks(const UINT8 * input, UINT8 * outBuffer, int numBlocks)
+{
+#ifdef COMPILE_RIJNDAEL_AESNI
+	if(m_bUseHardware)
+	{
+		rijndael_aesni_encrypt_blocks((const UINT8 *)m_expandedKey, m_uRounds, input, outBuffer, numBlocks);
+		return;
+	}
+#endif
+	for(int i = numBlocks; i > 0; i--)
+	{
+		encrypt(input, outBuffer);
+		input += 16;
+		outBuffer += 16;
+	}
+}
+
+void Rijndael::decryptBlocks(const UINT8 * input, UINT8 * outBuffer, int numBlocks)
+{
+#ifdef COMPILE_RIJNDAEL_AESNI
+	if(m_bUseHardware)
+	{
+		rijndael_aesni_decrypt_blocks((const UINT8 *)m_expandedKey, m_uRounds, input, outBuffer, numBlocks);
+		return;
+	}
+#endif
+	for(int i = numBlocks; i > 0; i--)
+	{
+		decrypt(input, outBuffer);
+		input += 16;
+		outBuffer += 16;
+	}
 }
 
 Rijndael::~Rijndael()
@@ -1051,6 +1218,7 @@ int Rijndael::init(Mode mode, Direction dir, const UINT8 * key, KeyLength keyLen
 	if(m_direction == Decrypt)
 		keyEncToDec();
 
+	m_bUseHardware = hardwareAvailable();
 	m_state = Valid;
 
 	return RIJNDAEL_SUCCESS;
@@ -1171,17 +1339,14 @@ int Rijndael::padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer
 	switch(m_mode)
 	{
 		case ECB:
-			for(i = numBlocks; i > 0; i--)
-			{
-				encrypt(input, outBuffer);
-				input += 16;
-				outBuffer += 16;
-			}
+			encryptBlocks(input, outBuffer, numBlocks);
+			input += 16 * numBlocks;
+			outBuffer += 16 * numBlocks;
 			padLen = 16 - (inputOctets - 16 * numBlocks);
 			//			assert(padLen > 0 && padLen <= 16);
 			KviMemory::move(block, input, 16 - padLen);
 			KviMemory::set(block + 16 - padLen, padLen, padLen);
-			encrypt(block, outBuffer);
+			encryptBlocks(block, outBuffer, 1);
 			break;
 		case CBC:
 			iv = m_initVector;
@@ -1191,7 +1356,7 @@ int Rijndael::padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer
 				((UINT32 *)block)[1] = ((UINT32 *)input)[1] ^ ((UINT32 *)iv)[1];
 				((UINT32 *)block)[2] = ((UINT32 *)input)[2] ^ ((UINT32 *)iv)[2];
 				((UINT32 *)block)[3] = ((UINT32 *)input)[3] ^ ((UINT32 *)iv)[3];
-				encrypt(block, outBuffer);
+				encryptBlocks(block, outBuffer, 1);
 				iv = outBuffer;
 				input += 16;
 				outBuffer += 16;
@@ -1206,7 +1371,7 @@ int Rijndael::padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer
 			{
 				block[i] = (UINT8)padLen ^ iv[i];
 			}
-			encrypt(block, outBuffer);
+			encryptBlocks(block, outBuffer, 1);
 			break;
 		default:
 			return -1;
@@ -1326,10 +1491,6 @@ int Rijndael::blockDecrypt(const UINT8 * input, int inputLen, UINT8 * outBuffer,
 
 int Rijndael::padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector)
 {
-	int i, numBlocks, padLen;
-	UINT8 block[16];
-	UINT32 iv[4];
-
 	// update the init vector only if a new one has been specified
 	if(initVector)
 		updateInitVector(initVector);
@@ -1345,64 +1506,65 @@ int Rijndael::padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer
 	if((inputOctets % 16) != 0)
 		return RIJNDAEL_CORRUPTED_DATA;
 
-	numBlocks = inputOctets / 16;
+	if((m_mode != ECB) && (m_mode != CBC))
+		return -1;
 
-	switch(m_mode)
+	// CBC needs the cipher text after all the blocks have been decrypted:
+	// if it shares the memory with outBuffer work on a copy of it
+	const UINT8 * cipher = input;
+	UINT8 * cipherCopy = nullptr;
+	if((m_mode == CBC) && (outBuffer < input + inputOctets) && (input < outBuffer + inputOctets))
 	{
-		case ECB:
-			for(i = numBlocks - 1; i > 0; i--)
-			{
-				decrypt(input, outBuffer);
-				input += 16;
-				outBuffer += 16;
-			}
+		cipherCopy = (UINT8 *)KviMemory::allocate(inputOctets);
+		KviMemory::move(cipherCopy, input, inputOctets);
+		cipher = cipherCopy;
+	}
 
-			decrypt(input, block);
-			padLen = block[15];
-			if(padLen >= 16)
-				return RIJNDAEL_CORRUPTED_DATA;
-			for(i = 16 - padLen; i < 16; i++)
-			{
-				if(block[i] != padLen)
-					return RIJNDAEL_CORRUPTED_DATA;
-			}
-			KviMemory::move(outBuffer, block, 16 - padLen);
-			break;
-		case CBC:
-			KviMemory::move(iv, m_initVector, 16);
-			/* all blocks but last */
-			for(i = numBlocks - 1; i > 0; i--)
-			{
-				decrypt(input, block);
-				((UINT32 *)block)[0] ^= iv[0];
-				((UINT32 *)block)[1] ^= iv[1];
-				((UINT32 *)block)[2] ^= iv[2];
-				((UINT32 *)block)[3] ^= iv[3];
-				KviMemory::move(iv, input, 16);
-				KviMemory::move(outBuffer, block, 16);
-				input += 16;
-				outBuffer += 16;
-			}
-			/* last block */
-			decrypt(input, block);
-			((UINT32 *)block)[0] ^= iv[0];
-			((UINT32 *)block)[1] ^= iv[1];
-			((UINT32 *)block)[2] ^= iv[2];
-			((UINT32 *)block)[3] ^= iv[3];
-			padLen = block[15];
-			if(padLen <= 0 || padLen > 16)
-				return RIJNDAEL_CORRUPTED_DATA;
-			for(i = 16 - padLen; i < 16; i++)
-			{
-				if(block[i] != padLen)
-					return RIJNDAEL_CORRUPTED_DATA;
-			}
-			KviMemory::move(outBuffer, block, 16 - padLen);
-			break;
+	// outBuffer is at least inputOctets long: decrypt all the blocks there at once
+	int numBlocks = inputOctets / 16;
+	decryptBlocks(cipher, outBuffer, numBlocks);
+	int retVal = finishPadDecrypt(cipher, numBlocks, outBuffer, m_initVector);
 
-		default:
-			return -1;
-			break;
+	if(cipherCopy)
+		KviMemory::free(cipherCopy);
+	return retVal;
+}
+
+int Rijndael::finishPadDecrypt(const UINT8 * input, int numBlocks, UINT8 * outBuffer, const UINT8 * initVector)
+{
+	int i, padLen;
+
+	if(m_mode == CBC)
+	{
+		// walk backwards so each block is xored with the previous cipher block
+		for(i = numBlocks - 1; i > 0; i--)
+		{
+			for(int j = 0; j < 16; j++)
+				outBuffer[16 * i + j] ^= input[16 * (i - 1) + j];
+		}
+		for(int j = 0; j < 16; j++)
+			outBuffer[j] ^= initVector[j];
+	}
+
+	UINT8 * block = outBuffer + 16 * (numBlocks - 1);
+	padLen = block[15];
+
+	// ECB has always refused a full padding block: keep it as it is for compatibility
+	if(m_mode == ECB)
+	{
+		if(padLen >= 16)
+			return RIJNDAEL_CORRUPTED_DATA;
+	}
+	else
+	{
+		if(padLen <= 0 || padLen > 16)
+			return RIJNDAEL_CORRUPTED_DATA;
+	}
+
+	for(i = 16 - padLen; i < 16; i++)
+	{
+		if(block[i] != padLen)
+			return RIJNDAEL_CORRUPTED_DATA;
 	}
 
 	return 16 * numBlocks - padLen;
@@ -80,6 +80,13 @@
 //  else decryptError(len);
 //
 
+//
+// On x86 CPUs with the AES instructions (checked at runtime with CPUID)
+// the ECB and CBC paths run the rounds in hardware: the key schedule is still
+// computed here and fed to the instructions as is, so the output is
+// bit for bit the same as the one of the table driven code.
+//
+
 #include "kvi_settings.h"
 
 #if defined(COMPILE_CRYPT_SUPPORT) || defined(Q_MOC_RUN)
@@ -141,6 +148,7 @@ protected:
 	UINT8 m_initVector[MAX_IV_SIZE];
 	UINT32 m_uRounds;
 	UINT8 m_expandedKey[_MAX_ROUNDS + 1][4][4];
+	bool m_bUseHardware;
 
 public:
 	// Initializes the crypt session
@@ -160,15 +168,28 @@ public:
 	// Returns the decrypted buffer length in BITS and an error code < 0 in case of error
 	int blockDecrypt(const UINT8 * input, int inputLen, UINT8 * outBuffer, UINT8 * initVector = nullptr);
 	// Input len is in BYTES!
-	// outBuffer must be at least inputLen bytes long
+	// outBuffer must be at least inputLen bytes long (it may be the input buffer itself)
 	// Returns the decrypted buffer length in BYTES and an error code < 0 in case of error
 	int padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr);
 
+	// Returns true if the CPU has the AES instructions
+	static bool hardwareAvailable();
+	// init() picks the hardware implementation when available:
+	// this allows to force the table driven one (for benchmarking, mainly)
+	void setUseHardware(bool bUse) { m_bUseHardware = bUse && hardwareAvailable(); }
+	bool usingHardware() const { return m_bUseHardware; }
+
 protected:
 	void keySched(UINT8 key[_MAX_KEY_COLUMNS][4]);
 	void keyEncToDec();
 	void encrypt(const UINT8 a[16], UINT8 b[16]);
 	void decrypt(const UINT8 a[16], UINT8 b[16]);
+	// ECB on whole blocks, dispatched to the hardware or to the tables
+	void encryptBlocks(const UINT8 * input, UINT8 * outBuffer, int numBlocks);
+	void decryptBlocks(const UINT8 * input, UINT8 * outBuffer, int numBlocks);
+	// outBuffer holds numBlocks raw decrypted blocks of input: undoes the chaining
+	// and checks the padding. Returns the plain text length in BYTES or an error code
+	int finishPadDecrypt(const UINT8 * input, int numBlocks, UINT8 * outBuffer, const UINT8 * initVector);
 	void updateInitVector(UINT8 * initVector = nullptr);
 };
 
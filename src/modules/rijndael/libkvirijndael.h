@@ -55,7 +55,12 @@ private:
 public:
 	bool init(const char * encKey, int encKeyLen, const char * decKey, int decKeyLen) override;
 	KviCryptEngine::EncryptResult encrypt(const char * plainText, KviCString & outBuffer) override;
+	// The server parser and the DCC windows call this for each message as soon as
+	// it's parsed (bouncer playback included): there's never a backlog of lines
+	// to decrypt together, so there's no multi message variant.
 	KviCryptEngine::DecryptResult decrypt(const char * inBuffer, KviCString & plainText) override;
+	// Forces the table driven Rijndael implementation: used by the benchmark
+	void setUseHardware(bool bUse);
 
 protected:
 	virtual bool binaryToAscii(const char *, int, KviCString &) { return false; }
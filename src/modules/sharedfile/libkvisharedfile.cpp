@@ -196,42 +196,91 @@ static bool sharedfile_kvs_cmd_clear(KviKvsModuleCommandCall *)
 	@short:
 		Lists the active file sharedfile
 	@syntax:
-		sharedfile.list
+		sharedfile.list [-s=<size:integer>] [-p=<prefix:string>] [-f=<text:string>]
+	@switches:
+		!sw: -s=<size> | --size=<size>
+		Lists only the shared files that are exactly <size> bytes long
+		!sw: -p=<prefix> | --prefix=<prefix>
+		Lists only the shared files with a visible name starting with <prefix>
+		!sw: -f=<text> | --find=<text>
+		Lists only the shared files with a visible name containing <text>
 	@description:
-		Lists the active file sharedfile.
+		Lists the active file sharedfile.[br]
+		The switches restrict the list to the matching files: they are answered
+		by the indexes of the shared files so they stay fast even with a lot of
+		shares. The names are compared case insensitively.
+		If more than one switch is used the files must match all of them.
 	@seealso:
 		[cmd]sharedfile.add[/cmd], [cmd]sharedfile.remove[/cmd]
 */
 
 static bool sharedfile_kvs_cmd_list(KviKvsModuleCommandCall * c)
 {
-	KviPointerHashTableIterator<QString, KviSharedFileList> it(*(g_pSharedFilesManager->sharedFileListDict()));
+	KviPointerList<KviSharedFile> lFiles;
+	lFiles.setAutoDelete(false);
+
+	kvs_int_t iSize = 0;
+	bool bSize = false;
+	QString szPrefix, szText;
+
+	if(KviKvsVariant * v = c->switches()->find('s', "size"))
+	{
+		if(!v->asInteger(iSize) || (iSize < 1))
+		{
+			c->warning(__tr2qs_ctx("Invalid file size", "sharedfileswindow"));
+			return true;
+		}
+		bSize = true;
+	}
+	if(KviKvsVariant * v = c->switches()->find('p', "prefix"))
+		v->asString(szPrefix);
+	if(KviKvsVariant * v = c->switches()->find('f', "find"))
+		v->asString(szText);
+
+	// start from the most selective index
+	if(bSize)
+		g_pSharedFilesManager->findSharedFilesBySize((unsigned int)iSize, &lFiles);
+	else if(!szText.isEmpty())
+		g_pSharedFilesManager->findSharedFilesByNameSubstring(szText, &lFiles);
+	else if(!szPrefix.isEmpty())
+		g_pSharedFilesManager->findSharedFilesByNamePrefix(szPrefix, &lFiles);
+	else
+	{
+		KviPointerHashTableIterator<QString, KviSharedFileList> it(*(g_pSharedFilesManager->sharedFileListDict()));
+		while(KviSharedFileList * l = it.current())
+		{
+			for(KviSharedFile * o = l->first(); o; o = l->next())
+				lFiles.append(o);
+			++it;
+		}
+	}
 
 	int idx = 0;
 
-	while(KviSharedFileList * l = it.current())
+	for(KviSharedFile * o = lFiles.first(); o; o = lFiles.next())
 	{
-		for(KviSharedFile * o = l->first(); o; o = l->next())
+		if(!szPrefix.isEmpty() && !o->name().startsWith(szPrefix, Qt::CaseInsensitive))
+			continue;
+		if(!szText.isEmpty() && !o->name().contains(szText, Qt::CaseInsensitive))
+			continue;
+
+		c->window()->output(KVI_OUT_NONE, "%c%d. %s",
+		    KviControlCodes::Bold, idx + 1, o->name().toUtf8().data());
+		c->window()->output(KVI_OUT_NONE, __tr2qs_ctx("File: %s (%u bytes)", "sharedfileswindow"),
+		    o->absFilePath().toUtf8().data(), o->fileSize());
+		c->window()->output(KVI_OUT_NONE, __tr2qs_ctx("Mask: %s", "sharedfileswindow"),
+		    o->userMask().toUtf8().data());
+		if(o->expireTime() > 0)
 		{
-			c->window()->output(KVI_OUT_NONE, "%c%d. %s",
-			    KviControlCodes::Bold, idx + 1, it.currentKey().toUtf8().data());
-			c->window()->output(KVI_OUT_NONE, __tr2qs_ctx("File: %s (%u bytes)", "sharedfileswindow"),
-			    o->absFilePath().toUtf8().data(), o->fileSize());
-			c->window()->output(KVI_OUT_NONE, __tr2qs_ctx("Mask: %s", "sharedfileswindow"),
-			    o->userMask().toUtf8().data());
-			if(o->expireTime() > 0)
-			{
-				int secs = ((int)(o->expireTime())) - ((int)(time(nullptr)));
-				int hour = secs / 3600;
-				secs = secs % 3600;
-				int mins = secs / 60;
-				secs = secs % 60;
-				c->window()->output(KVI_OUT_NONE, __tr2qs_ctx("Expires in %d hours %d minutes %d seconds", "sharedfileswindow"),
-				    hour, mins, secs);
-			}
-			++idx;
+			int secs = ((int)(o->expireTime())) - ((int)(time(nullptr)));
+			int hour = secs / 3600;
+			secs = secs % 3600;
+			int mins = secs / 60;
+			secs = secs % 60;
+			c->window()->output(KVI_OUT_NONE, __tr2qs_ctx("Expires in %d hours %d minutes %d seconds", "sharedfileswindow"),
+			    hour, mins, secs);
 		}
-		++it;
+		++idx;
 	}
 
 	//#warning "FIND A BETTER KVI_OUT_*"
@@ -29,6 +29,7 @@
 #include "KviConsoleWindow.h"
 #include "KviControlCodes.h"
 #include "KviApplication.h"
+#include "KviIrcSocket.h"
 #include "KviOptions.h"
 
 #include <QTimer>
@@ -122,7 +123,10 @@ void SlowPasteController::pasteFile()
 		}
 		else
 		{
+			// let anything else overtake the paste
+			KviIrcSocket::OutgoingPriority eOldPriority = KviIrcSocket::setOutgoingPriority(KviIrcSocket::Bulk);
 			m_pWindow->ownMessage(line.toLatin1());
+			KviIrcSocket::setOutgoingPriority(eOldPriority);
 		}
 	}
 	else
@@ -142,6 +146,8 @@ void SlowPasteController::pasteClipboard()
 	{
 		QString line = m_pClipBuff->takeFirst();
 		line.replace('\t', QString(KVI_OPTION_UINT(KviOption_uintSpacesToExpandTabulationInput), ' ')); //expand tabs to spaces
+		KviIrcSocket::OutgoingPriority eOldPriority = KviIrcSocket::setOutgoingPriority(KviIrcSocket::Bulk);
 		m_pWindow->ownMessage(line);
+		KviIrcSocket::setOutgoingPriority(eOldPriority);
 	}
 }
@@ -33,6 +33,7 @@
 #include "kvi_settings.h"
 #include "KviMemory.h"
 #include "KviKvsArrayCast.h"
+#include "KviMiscUtils.h"
 #include "KviOptions.h"
 
 #include <QClipboard>
@@ -1385,64 +1386,22 @@ static bool str_kvs_fnc_digest(KviKvsModuleFunctionCall * c)
 	KVSM_PARAMETER("algorithm", KVS_PT_NONEMPTYSTRING, KVS_PF_OPTIONAL, szType)
 	KVSM_PARAMETERS_END(c)
 
-#if defined(COMPILE_SSL_SUPPORT)
-	if(szType.isEmpty())
-		szType = "md5";
-
-	EVP_MD_CTX *mdctx;
-	const EVP_MD * md;
-	unsigned char md_value[EVP_MAX_MD_SIZE];
-	unsigned int md_len, i;
-	char buff[3];
-	OpenSSL_add_all_digests();
-
-	md = EVP_get_digestbyname(szType.toUtf8().data());
-	if(!md)
-	{
-		c->warning(__tr2qs("%Q algorithm is not supported"), &szType);
-		return true;
-	}
-
-	mdctx = EVP_MD_CTX_new();
-	EVP_DigestInit_ex(mdctx, md, nullptr);
-	EVP_DigestUpdate(mdctx, szString.toUtf8().data(), szString.toUtf8().length());
-	EVP_DigestFinal_ex(mdctx, md_value, &md_len);
-	EVP_MD_CTX_free(mdctx);
-
-	for(i = 0; i < md_len; i++)
+	switch(KviMiscUtils::digest(szString, szType, szResult))
 	{
-#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
-		_snprintf(buff, 3, "%02x", md_value[i]);
+		case KviError::Success:
+			c->returnValue()->setString(szResult);
+			break;
+		case KviError::FeatureNotAvailable:
+#if defined(COMPILE_SSL_SUPPORT)
+			c->warning(__tr2qs("%Q algorithm is not supported"), &szType);
 #else
-		snprintf(buff, 3, "%02x", md_value[i]);
+			c->warning(__tr2qs("KVIrc is compiled without Crypto++ or SSL support. $str.digest supports only MD4, MD5 and SHA1."));
 #endif
-		szResult.append(buff);
-	}
-
-	c->returnValue()->setString(szResult);
-#else // fall back to QCryptographicHash
-	QCryptographicHash::Algorithm qAlgo;
-	if(szType.toLower() == "sha1")
-	{
-		qAlgo = QCryptographicHash::Sha1;
-	}
-	else if(szType.toLower() == "md4")
-	{
-		qAlgo = QCryptographicHash::Md4;
-	}
-	else if(szType.toLower() == "md5")
-	{
-		qAlgo = QCryptographicHash::Md5;
-	}
-	else
-	{
-		c->warning(__tr2qs("KVIrc is compiled without Crypto++ or SSL support. $str.digest supports only MD4, MD5 and SHA1."));
-		return true;
+			break;
+		default:
+			break;
 	}
 
-	c->returnValue()->setString(QString(QCryptographicHash::hash(szString.toLocal8Bit(), qAlgo).toHex()).toUpper());
-#endif
-
 	return true;
 }
 
@@ -1478,47 +1437,8 @@ static bool str_kvs_fnc_join(KviKvsModuleFunctionCall * c)
 	QString szRet;
 	bool bSkipEmpty = szFlags.contains('n', Qt::CaseInsensitive);
 
-	bool bFirst = true;
-
 	if(KviKvsArray * a = ac.array())
-	{
-		kvs_uint_t uIdx = 0;
-		kvs_uint_t uSize = a->size();
-		while(uIdx < uSize)
-		{
-			KviKvsVariant * v = a->at(uIdx);
-			if(v)
-			{
-				QString tmp;
-				v->asString(tmp);
-				if(bFirst)
-				{
-					szRet = tmp;
-					bFirst = false;
-				}
-				else
-				{
-					szRet += szSep;
-					szRet += tmp;
-				}
-			}
-			else
-			{
-				if(!bSkipEmpty)
-				{
-					if(bFirst)
-					{
-						bFirst = false;
-					}
-					else
-					{
-						szRet += szSep;
-					}
-				}
-			}
-			uIdx++;
-		}
-	}
+		a->join(szRet, szSep, bSkipEmpty);
 
 	c->returnValue()->setString(szRet);
 	return true;